@@ -0,0 +1,506 @@
+///============================================================================
+///@file	AssetPipeline.cpp
+///@brief	Offline conversion of source meshes into scene files.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "AssetPipeline.h"
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <string.h>
+#include <algorithm>
+
+static const UINT MAX_LODS = SceneShapeRecord::MAX_LODS;
+
+//same projected sizes the demo uses for its own shapes
+static const GLfloat MinSize[MAX_LODS] = {64.0f, 20.0f, 0.0f};
+
+//cells along the longest side used to simplify each coarser level and the
+//proxy of each level (depth only, so creases don't need to be kept)
+static const UINT LODGrid[MAX_LODS] = {0, 48, 16};
+static const UINT ProxyGrid[MAX_LODS] = {96, 32, 12};
+
+//a simplified mesh is only kept if it removes enough triangles
+static const GLfloat MaxLODRatio	= 0.5f;
+static const GLfloat MaxProxyRatio	= 0.75f;
+
+//the imported meshes are laid out on the demo's base plate, same as -import
+static const GLfloat AssetSize		= 1.5f;
+static const GLfloat AssetSpacing	= 2.0f;
+static const GLfloat BaseTop		= 0.15f;
+
+static const UINT64 FNVPrime = 1099511628211ULL;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+AssetPipeline::AssetPipeline() : m_ImportThreads(1), m_Next(0), m_Ms(0.0)
+{
+	m_Settings.format			= Mesh::FLOAT_VERTEX;
+	m_Settings.quantizePositions	= false;
+	m_Settings.optimize			= true;
+	m_Settings.lods				= true;
+	m_Settings.proxies			= true;
+	m_Settings.force			= false;
+	m_Settings.threads			= 0;
+	m_CacheDir[0]				= '\0';
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+AssetPipeline::~AssetPipeline()
+{
+}
+
+///----------------------------------------------------------------------------
+///Sets how the assets are converted (before Run)
+///----------------------------------------------------------------------------
+void AssetPipeline::SetSettings(const Settings &settings)
+{
+	m_Settings = settings;
+}
+
+///----------------------------------------------------------------------------
+///@returns the conversion settings
+///----------------------------------------------------------------------------
+const AssetPipeline::Settings& AssetPipeline::GetSettings() const
+{
+	return m_Settings;
+}
+
+///----------------------------------------------------------------------------
+///Adds a source mesh to convert
+///@param	path - OBJ or PLY file
+///----------------------------------------------------------------------------
+void AssetPipeline::AddSource(LPCSTR path)
+{
+	Asset asset;
+	memset(&asset, 0, sizeof(asset));
+	strncpy(asset.source, path, MAX_PATH - 1);
+	asset.status = PENDING;
+
+	m_Assets.push_back(asset);
+}
+
+///----------------------------------------------------------------------------
+///FNV-1a hash of a block of memory
+///@param	data - the block
+///@param	bytes - size of the block
+///@param	hash - hash of the previous blocks (to hash several as one)
+///@returns the 64 bit hash
+///----------------------------------------------------------------------------
+UINT64 AssetPipeline::Hash(const void *data, UINT bytes, UINT64 hash)
+{
+	const BYTE *p = (const BYTE *)data;
+
+	for(UINT i=0; i<bytes; i++)
+	{
+		hash ^= p[i];
+		hash *= FNVPrime;
+	}
+
+	return hash;
+}
+
+///----------------------------------------------------------------------------
+///@returns a hash of everything that changes the converted files, so
+///changing a setting (or the file format) misses the cache
+///----------------------------------------------------------------------------
+UINT64 AssetPipeline::GetSettingsHash() const
+{
+	UINT values[] =
+	{
+		SceneFile::VERSION, (UINT)m_Settings.format, m_Settings.quantizePositions,
+		m_Settings.optimize, m_Settings.lods, m_Settings.proxies
+	};
+
+	UINT64 hash = Hash(values, sizeof(values));
+	hash = Hash(LODGrid, sizeof(LODGrid), hash);
+	hash = Hash(ProxyGrid, sizeof(ProxyGrid), hash);
+	return Hash(MinSize, sizeof(MinSize), hash);
+}
+
+///----------------------------------------------------------------------------
+///Converts every asset that isn't in the cache, several at a time
+///@param	cacheDir - directory of the converted files (created if needed)
+///@returns false if an asset failed
+///----------------------------------------------------------------------------
+bool AssetPipeline::Run(LPCSTR cacheDir)
+{
+	double start = Profiler::GetTime();
+
+	strncpy(m_CacheDir, cacheDir, MAX_PATH - 1);
+	m_CacheDir[MAX_PATH - 1] = '\0';
+	CreateDirectory(m_CacheDir, NULL);
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	UINT cores = (std::max)((UINT)info.dwNumberOfProcessors, 1U);
+	UINT threads = m_Settings.threads ? m_Settings.threads : cores;
+	threads = (std::min)(threads, (UINT)m_Assets.size());
+
+	//with fewer assets than cores each one is parsed on several threads
+	m_ImportThreads = threads ? (std::max)(cores / threads, 1U) : 1;
+	m_Next = 0;
+
+	std::vector<HANDLE> handles;
+	for(UINT i=1; i<threads; i++)
+	{
+		HANDLE thread = CreateThread(NULL, 0, Worker, this, 0, NULL);
+		if(thread) handles.push_back(thread);
+	}
+
+	Worker(this);
+
+	//WaitForMultipleObjects takes up to MAXIMUM_WAIT_OBJECTS handles
+	for(UINT i=0; i<handles.size(); i+=MAXIMUM_WAIT_OBJECTS)
+	{
+		UINT count = (std::min)((UINT)handles.size() - i, (UINT)MAXIMUM_WAIT_OBJECTS);
+		WaitForMultipleObjects(count, &handles[i], TRUE, INFINITE);
+	}
+	for(UINT i=0; i<handles.size(); i++)
+		CloseHandle(handles[i]);
+
+	m_Ms = Profiler::GetTime() - start;
+	return GetFailedCount() == 0;
+}
+
+///----------------------------------------------------------------------------
+///Converts assets until there are none left (runs on every thread)
+///@param	param - the pipeline
+///----------------------------------------------------------------------------
+DWORD WINAPI AssetPipeline::Worker(LPVOID param)
+{
+	AssetPipeline *pipeline = (AssetPipeline *)param;
+
+	for(;;)
+	{
+		LONG next = InterlockedIncrement(&pipeline->m_Next) - 1;
+		if(next >= (LONG)pipeline->m_Assets.size()) break;
+
+		pipeline->Convert(pipeline->m_Assets[next], pipeline->m_ImportThreads);
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Converts an asset unless the cache already has it
+///@param	asset - the asset
+///@param	importThreads - threads used to parse the source
+///----------------------------------------------------------------------------
+void AssetPipeline::Convert(Asset &asset, UINT importThreads) const
+{
+	double start = Profiler::GetTime();
+	asset.status = FAILED;
+
+	//the cached file is named after the hash of the source contents
+	{
+		MappedFile file;
+		if(!file.Open(asset.source)) return;
+
+		asset.bytes = file.GetSize();
+		asset.hash = Hash(file.GetData(), file.GetSize(), GetSettingsHash());
+	}
+
+	_snprintf(asset.output, MAX_PATH - 1, "%s\\%08x%08x.smgs", m_CacheDir,
+			  (UINT)(asset.hash >> 32), (UINT)asset.hash);
+	asset.output[MAX_PATH - 1] = '\0';
+
+	if(!m_Settings.force && GetFileAttributes(asset.output) != INVALID_FILE_ATTRIBUTES)
+	{
+		SceneFile cached;
+		if(cached.Open(asset.output) && cached.GetShapeCount() == 1)
+		{
+			const SceneShapeRecord &shape = cached.GetShape(0);
+			asset.lodCount = shape.lodCount;
+
+			for(UINT i=0; i<shape.lodCount; i++)
+			{
+				Mesh::Streams streams;
+				cached.GetMesh(shape.meshes[i], streams);
+				asset.triangles[i] = streams.indexCount / 3;
+				cached.GetMesh(shape.shadowMeshes[i], streams);
+				asset.proxyTriangles[i] = streams.indexCount / 3;
+			}
+
+			asset.status = CACHED;
+			asset.ms = Profiler::GetTime() - start;
+			return;
+		}
+	}
+
+	MeshImporter importer;
+	Mesh source;
+
+	if(importer.Import(asset.source, source, importThreads))
+	{
+		//written under another name first so a cut-off conversion is
+		//never taken for a cached one; sources with the same contents
+		//share the output, so every thread has its own temporary file
+		char temp[MAX_PATH];
+		_snprintf(temp, MAX_PATH - 1, "%s.%u.tmp", asset.output, (UINT)GetCurrentThreadId());
+		temp[MAX_PATH - 1] = '\0';
+
+		if(Build(asset, source, temp))
+		{
+			if(MoveFileEx(temp, asset.output, MOVEFILE_REPLACE_EXISTING))
+				asset.status = CONVERTED;
+			else
+				DeleteFile(temp);
+		}
+	}
+
+	asset.ms = Profiler::GetTime() - start;
+}
+
+///----------------------------------------------------------------------------
+///Builds the levels of detail and proxies of an imported mesh and writes
+///them to a scene file with a single shape and instance
+///@param	asset - the asset (receives the triangle counts)
+///@param	source - the imported mesh (the finest level)
+///@param	path - scene file to write
+///@returns false if the file couldn't be written
+///----------------------------------------------------------------------------
+bool AssetPipeline::Build(Asset &asset, Mesh &source, LPCSTR path) const
+{
+	//simplified from the source so the errors don't add up
+	Mesh levels[MAX_LODS], proxies[MAX_LODS];
+	Mesh *lods[MAX_LODS], *shadows[MAX_LODS];
+	UINT count = 1;
+
+	lods[0] = &source;
+	for(UINT i=1; i<MAX_LODS && m_Settings.lods; i++)
+	{
+		levels[i].CreateSimplified(source, LODGrid[i], true);
+
+		UINT triangles = levels[i].GetTriangleCount();
+		if(triangles == 0 || triangles > lods[count-1]->GetTriangleCount() * MaxLODRatio) break;
+
+		lods[count++] = &levels[i];
+	}
+
+	for(UINT i=0; i<count; i++)
+	{
+		shadows[i] = lods[i];
+		if(!m_Settings.proxies) continue;
+
+		proxies[i].CreateSimplified(source, ProxyGrid[i], false);
+
+		UINT triangles = proxies[i].GetTriangleCount();
+		if(triangles > 0 && triangles <= lods[i]->GetTriangleCount() * MaxProxyRatio)
+			shadows[i] = &proxies[i];
+	}
+
+	//the streams are built without a rendering context, so they stay in
+	//the meshes instead of going to buffer objects
+	std::vector<Mesh*> meshes;
+	std::vector<Mesh::Streams> streams;
+	SceneShapeRecord shape;
+	memset(&shape, 0, sizeof(shape));
+	shape.lodCount = count;
+
+	for(UINT i=0; i<count; i++)
+	{
+		Mesh *level[2] = {lods[i], shadows[i]};
+
+		for(UINT j=0; j<2; j++)
+		{
+			UINT index = (UINT)(std::find(meshes.begin(), meshes.end(), level[j]) - meshes.begin());
+			if(index == meshes.size())
+			{
+				if(m_Settings.optimize)
+					level[j]->Optimize();
+				else
+					level[j]->Analyze();
+				level[j]->Upload(m_Settings.format, m_Settings.quantizePositions);
+
+				meshes.push_back(level[j]);
+				streams.push_back(Mesh::Streams());
+				level[j]->GetStreams(streams.back());
+			}
+
+			if(j == 0)
+				shape.meshes[i] = index;
+			else
+				shape.shadowMeshes[i] = index;
+		}
+
+		shape.minSize[i] = i + 1 < count ? MinSize[i] : 0.0f;
+		asset.triangles[i] = lods[i]->GetTriangleCount();
+		asset.proxyTriangles[i] = shadows[i]->GetTriangleCount();
+	}
+	asset.lodCount = count;
+
+	//a single instance at the origin, so the file can be loaded on its own
+	SceneInstanceRecord instance;
+	memset(&instance, 0, sizeof(instance));
+	const AABB &bounds = source.GetBounds();
+	Matrix4 M;
+
+	memcpy(instance.transform, M.m, sizeof(instance.transform));
+	memcpy(instance.boundsMin, bounds.min, sizeof(instance.boundsMin));
+	memcpy(instance.boundsMax, bounds.max, sizeof(instance.boundsMax));
+	memset(instance.color, 204, sizeof(instance.color));
+
+	std::vector<SceneShapeRecord> shapes(1, shape);
+	std::vector<SceneInstanceRecord> instances(1, instance);
+	return SceneFile::Write(path, streams, shapes, instances);
+}
+
+///----------------------------------------------------------------------------
+///Writes a scene with every converted asset, placed in rows on the base
+///plate of the demo scene. Only the cached files are read.
+///@param	path - scene file to write
+///@param	basePath - scene the assets are added to, i.e. saved by the demo
+///				with -savescene (NULL for the assets alone)
+///@returns false if a file couldn't be read or written
+///----------------------------------------------------------------------------
+bool AssetPipeline::WriteScene(LPCSTR path, LPCSTR basePath) const
+{
+	std::vector<SceneFile*> files;
+	std::vector<Mesh::Streams> meshes;
+	std::vector<SceneShapeRecord> shapes;
+	std::vector<SceneInstanceRecord> instances;
+	bool ok = true;
+
+	if(basePath)
+	{
+		files.push_back(new SceneFile());
+		ok = files.back()->Open(basePath);
+	}
+
+	for(UINT i=0; i<m_Assets.size() && ok; i++)
+	{
+		if(m_Assets[i].status != CONVERTED && m_Assets[i].status != CACHED) continue;
+
+		files.push_back(new SceneFile());
+		ok = files.back()->Open(m_Assets[i].output);
+	}
+
+	UINT assetCount = (UINT)files.size() - (basePath ? 1 : 0);
+	UINT columns = 1;
+	while(columns * columns < assetCount) columns++;
+
+	for(UINT i=0; i<files.size() && ok; i++)
+	{
+		const SceneFile &file = *files[i];
+		UINT firstMesh = (UINT)meshes.size();
+		UINT firstShape = (UINT)shapes.size();
+
+		for(UINT j=0; j<file.GetMeshCount(); j++)
+		{
+			meshes.push_back(Mesh::Streams());
+			file.GetMesh(j, meshes.back());
+		}
+
+		for(UINT j=0; j<file.GetShapeCount(); j++)
+		{
+			SceneShapeRecord shape = file.GetShape(j);
+			for(UINT k=0; k<shape.lodCount; k++)
+			{
+				shape.meshes[k] += firstMesh;
+				shape.shadowMeshes[k] += firstMesh;
+			}
+			shapes.push_back(shape);
+		}
+
+		for(UINT j=0; j<file.GetInstanceCount(); j++)
+		{
+			SceneInstanceRecord instance = file.GetInstance(j);
+			instance.shape += firstShape;
+
+			//the base scene keeps its layout, the assets stand on the plate
+			if(!basePath || i > 0)
+			{
+				UINT slot = basePath ? i - 1 : i;
+				GLfloat extent = 0.0f, center[3];
+				for(int k=0; k<3; k++)
+				{
+					center[k] = 0.5f * (instance.boundsMin[k] + instance.boundsMax[k]);
+					extent = (std::max)(extent, instance.boundsMax[k] - instance.boundsMin[k]);
+				}
+				GLfloat scale = extent > 0.0f ? AssetSize / extent : 1.0f;
+				GLfloat offset = 0.5f * (columns - 1) * AssetSpacing;
+
+				Matrix4 M;
+				M.Translate((slot % columns) * AssetSpacing - offset, BaseTop,
+							(slot / columns) * AssetSpacing - offset);
+				M.Scale(scale, scale, scale);
+				M.Translate(-center[0], -instance.boundsMin[1], -center[2]);
+				memcpy(instance.transform, M.m, sizeof(instance.transform));
+			}
+
+			instances.push_back(instance);
+		}
+	}
+
+	//the streams point into the mapped files, written before closing them
+	ok = ok && SceneFile::Write(path, meshes, shapes, instances);
+
+	for(UINT i=0; i<files.size(); i++)
+		delete files[i];
+
+	return ok;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of assets that couldn't be converted
+///----------------------------------------------------------------------------
+UINT AssetPipeline::GetFailedCount() const
+{
+	UINT failed = 0;
+	for(UINT i=0; i<m_Assets.size(); i++)
+		if(m_Assets[i].status == FAILED) failed++;
+
+	return failed;
+}
+
+///----------------------------------------------------------------------------
+///Writes the result of every asset and the totals of the last run
+///@param	file - output file (i.e. stdout)
+///----------------------------------------------------------------------------
+void AssetPipeline::Report(FILE *file) const
+{
+	static LPCSTR StatusNames[] = {"pending", "converted", "cached", "FAILED"};
+	UINT counts[4] = {0, 0, 0, 0};
+	double bytes = 0.0;
+
+	fprintf(file, "%-32s %-10s %10s %24s %24s %10s\n", "Asset", "Status", "Source KB",
+			"Triangles per level", "Shadow proxy triangles", "ms");
+
+	for(UINT i=0; i<m_Assets.size(); i++)
+	{
+		const Asset &asset = m_Assets[i];
+		char triangles[64] = "", proxies[64] = "";
+
+		for(UINT j=0; j<asset.lodCount; j++)
+		{
+			char number[16];
+			_snprintf(number, sizeof(number) - 1, j ? "/%u" : "%u", asset.triangles[j]);
+			number[sizeof(number) - 1] = '\0';
+			strcat(triangles, number);
+			_snprintf(number, sizeof(number) - 1, j ? "/%u" : "%u", asset.proxyTriangles[j]);
+			number[sizeof(number) - 1] = '\0';
+			strcat(proxies, number);
+		}
+
+		LPCSTR name = (std::max)(strrchr(asset.source, '\\'), strrchr(asset.source, '/'));
+		name = name ? name + 1 : asset.source;
+
+		fprintf(file, "%-32.32s %-10s %10u %24s %24s %10.1f\n", name, StatusNames[asset.status],
+				asset.bytes / 1024, triangles, proxies, asset.ms);
+
+		counts[asset.status]++;
+		if(asset.status == CONVERTED) bytes += asset.bytes;
+	}
+
+	fprintf(file, "\n%u converted, %u cached, %u failed in %.1f ms", counts[CONVERTED],
+			counts[CACHED], counts[FAILED], m_Ms);
+	if(counts[CONVERTED] && m_Ms > 0.0)
+		fprintf(file, " (%.1f MB/s of converted sources)", bytes / (1024.0 * 1024.0) / (m_Ms / 1000.0));
+	fprintf(file, "\n");
+}
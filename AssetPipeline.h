@@ -0,0 +1,105 @@
+///============================================================================
+///@file	AssetPipeline.h
+///@brief	Offline conversion of source meshes (OBJ/PLY) into scene files
+///			ready to be mapped by the demo: optimized for the vertex cache,
+///			quantized, with levels of detail and shadow proxies. Every
+///			asset is converted on its own thread and the results are kept
+///			in a cache directory named by a hash of the source contents and
+///			the settings, so unchanged assets are never processed twice.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef ASSETPIPELINE_H
+#define ASSETPIPELINE_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include "Mesh.h"
+#include "SceneFile.h"
+
+class AssetPipeline
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	struct Settings
+	{
+		Mesh::VertexFormat	format;				///> Format of the full vertices
+		bool				quantizePositions;	///> 16 bit position-only stream
+		bool				optimize;			///> Vertex cache/overdraw/fetch order
+		bool				lods;				///> Generate the coarser levels
+		bool				proxies;			///> Generate the shadow proxies
+		bool				force;				///> Ignore the cache
+		UINT				threads;			///> Conversion threads (0 for one per core)
+	};
+
+	enum Status
+	{
+		PENDING = 0,	///> Not processed yet
+		CONVERTED,		///> Converted and added to the cache
+		CACHED,			///> Found in the cache
+		FAILED			///> Couldn't be read or written
+	};
+
+	struct Asset
+	{
+		char	source[MAX_PATH];	///> Source mesh file
+		char	output[MAX_PATH];	///> Converted scene file in the cache
+		UINT64	hash;				///> Hash of the source and the settings
+		Status	status;				///> Result of the conversion
+		UINT	bytes;				///> Size of the source file
+		UINT	lodCount;			///> Generated levels
+		UINT	triangles[SceneShapeRecord::MAX_LODS];		///> Triangles of each level
+		UINT	proxyTriangles[SceneShapeRecord::MAX_LODS];	///> Triangles of each proxy
+		double	ms;					///> Time spent on the asset
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	AssetPipeline();
+	virtual ~AssetPipeline();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void SetSettings(const Settings &settings);
+	const Settings& GetSettings() const;
+	void AddSource(LPCSTR path);
+	bool Run(LPCSTR cacheDir);
+	bool WriteScene(LPCSTR path, LPCSTR basePath) const;
+	void Report(FILE *file) const;
+	UINT GetFailedCount() const;
+
+	static UINT64 Hash(const void *data, UINT bytes, UINT64 hash = HASH_SEED);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT64 HASH_SEED = 14695981039346656037ULL;	///> FNV-1a offset basis
+
+private:
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void Convert(Asset &asset, UINT importThreads) const;
+	bool Build(Asset &asset, Mesh &source, LPCSTR path) const;
+	UINT64 GetSettingsHash() const;
+
+	static DWORD WINAPI Worker(LPVOID param);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	Settings			m_Settings;		///> Conversion settings
+	std::vector<Asset>	m_Assets;		///> Assets to convert
+	char				m_CacheDir[MAX_PATH];	///> Directory of the converted files
+	UINT				m_ImportThreads;///> Parsing threads per asset
+	volatile LONG		m_Next;			///> Next asset to take by a worker
+	double				m_Ms;			///> Time of the last run
+};
+
+#endif
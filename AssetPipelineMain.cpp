@@ -0,0 +1,100 @@
+///============================================================================
+///@file	AssetPipelineMain.cpp
+///@brief	Command line tool that converts source meshes into scene files
+///			for the demo (built by the AssetPipeline project).
+///
+///			AssetPipeline [options] source.obj|source.ply ...
+///			-cache dir		directory of the converted files (default: cache)
+///			-quantize [8|16]	quantized full vertices (default: float)
+///			-quantizeshadow	16 bit position-only streams
+///			-nomeshopt		keeps the source triangle order
+///			-nolod			no coarser levels of detail
+///			-noproxy		no shadow proxies
+///			-threads n		conversion threads (default: one per core)
+///			-force			converts every asset even if it's cached
+///			-scene file		writes a scene with every converted asset
+///			-base file		scene the assets are added to (i.e. written by
+///							the demo with -savescene)
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AssetPipeline.h"
+
+int main(int argc, char *argv[])
+{
+	AssetPipeline pipeline;
+	AssetPipeline::Settings settings = pipeline.GetSettings();
+	LPCSTR cacheDir = "cache";
+	LPCSTR scenePath = NULL;
+	LPCSTR basePath = NULL;
+
+	if(argc < 2)
+	{
+		printf("Usage: AssetPipeline [options] source.obj|source.ply ...\n");
+		return 1;
+	}
+
+	for(int i=1; i<argc; i++)
+	{
+		LPCSTR arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if(strcmp(arg, "-cache") == 0 && hasValue)
+			cacheDir = argv[++i];
+		else if(strcmp(arg, "-quantize") == 0)
+		{
+			settings.format = Mesh::QUANTIZED_8;
+			if(hasValue && strcmp(argv[i+1], "16") == 0)
+				settings.format = Mesh::QUANTIZED_16;
+			if(hasValue && (strcmp(argv[i+1], "8") == 0 || strcmp(argv[i+1], "16") == 0))
+				i++;
+		}
+		else if(strcmp(arg, "-quantizeshadow") == 0)
+			settings.quantizePositions = true;
+		else if(strcmp(arg, "-nomeshopt") == 0)
+			settings.optimize = false;
+		else if(strcmp(arg, "-nolod") == 0)
+			settings.lods = false;
+		else if(strcmp(arg, "-noproxy") == 0)
+			settings.proxies = false;
+		else if(strcmp(arg, "-threads") == 0 && hasValue)
+			settings.threads = (UINT)atoi(argv[++i]);
+		else if(strcmp(arg, "-force") == 0)
+			settings.force = true;
+		else if(strcmp(arg, "-scene") == 0 && hasValue)
+			scenePath = argv[++i];
+		else if(strcmp(arg, "-base") == 0 && hasValue)
+			basePath = argv[++i];
+		else if(arg[0] == '-')
+		{
+			fprintf(stderr, "Unknown option %s\n", arg);
+			return 1;
+		}
+		else
+			pipeline.AddSource(arg);
+	}
+
+	pipeline.SetSettings(settings);
+	bool ok = pipeline.Run(cacheDir);
+	pipeline.Report(stdout);
+
+	if(scenePath)
+	{
+		if(pipeline.WriteScene(scenePath, basePath))
+		{
+			printf("Scene written to %s\n", scenePath);
+		}
+		else
+		{
+			fprintf(stderr, "Couldn't write the scene %s\n", scenePath);
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
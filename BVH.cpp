@@ -0,0 +1,460 @@
+///============================================================================
+///@file	BVH.cpp
+///@brief	Bounding volume hierarchy over the objects in the scene.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "BVH.h"
+#include <algorithm>
+#include <functional>
+#include <float.h>
+
+///----------------------------------------------------------------------------
+///Functor used to find the median object along an axis
+///----------------------------------------------------------------------------
+struct CentroidLess
+{
+	const GLfloat *centroids;
+	int axis;
+
+	bool operator()(UINT a, UINT b) const
+	{
+		return centroids[a*3+axis] < centroids[b*3+axis];
+	}
+};
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+BVH::BVH() : m_RefitStamp(0), m_RefitNodes(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Builds the hierarchy using the binned surface area heuristic.
+///@param	bounds - world space bounds of every object
+///@param	count - number of objects
+///----------------------------------------------------------------------------
+void BVH::Build(const AABB *bounds, UINT count)
+{
+	m_Nodes.clear();
+	m_Objects.resize(count);
+	m_ObjectLeaf.resize(count);
+	m_RefitStamp = 0;
+	m_RefitNodes = 0;
+
+	if(count == 0) return;
+
+	//object centroids are used to bin and partition the objects
+	std::vector<GLfloat> centroids(count * 3);
+	for(UINT i=0; i<count; i++)
+	{
+		bounds[i].GetCenter(&centroids[i*3]);
+		m_Objects[i] = i;
+	}
+
+	//a binary tree with N leaves has at most 2N-1 nodes
+	m_Nodes.reserve(count * 2);
+
+	Node root;
+	root.first	= 0;
+	root.count	= count;
+	root.parent	= 0;
+	root.stamp	= 0;
+	m_Nodes.push_back(root);
+
+	Subdivide(0, bounds, &centroids[0]);
+}
+
+///----------------------------------------------------------------------------
+///Splits the given node (and its children) until every leaf is small enough
+///or splitting is more expensive than keeping the leaf according to the SAH.
+///@param	start - node to subdivide
+///@param	bounds - object bounds
+///@param	centroids - object centroids (3 floats per object)
+///----------------------------------------------------------------------------
+void BVH::Subdivide(UINT start, const AABB *bounds, const GLfloat *centroids)
+{
+	std::vector<UINT> stack;
+	stack.push_back(start);
+
+	while(!stack.empty())
+	{
+		UINT node = stack.back();
+		stack.pop_back();
+
+		UpdateNodeBounds(node, bounds);
+
+		UINT first = m_Nodes[node].first;
+		UINT count = m_Nodes[node].count;
+
+		if(count <= MAX_LEAF_SIZE)
+			continue;
+
+		//bounds of the centroids, this is the range we bin over
+		AABB centroidBounds;
+		centroidBounds.Clear();
+		for(UINT i=first; i<first+count; i++)
+			centroidBounds.Grow(&centroids[m_Objects[i]*3]);
+
+		//evaluate the SAH for every bin boundary along every axis
+		int		bestAxis = -1;
+		UINT	bestSplit = 0;
+		GLfloat	bestCost = FLT_MAX;
+
+		for(int axis=0; axis<3; axis++)
+		{
+			GLfloat lo = centroidBounds.min[axis];
+			GLfloat extent = centroidBounds.max[axis] - lo;
+			if(extent <= 0.0f) continue;
+
+			AABB binBounds[SAH_BINS];
+			UINT binCount[SAH_BINS];
+			for(UINT b=0; b<SAH_BINS; b++)
+			{
+				binBounds[b].Clear();
+				binCount[b] = 0;
+			}
+
+			GLfloat scale = SAH_BINS / extent;
+			for(UINT i=first; i<first+count; i++)
+			{
+				UINT obj = m_Objects[i];
+				UINT b = (UINT)((centroids[obj*3+axis] - lo) * scale);
+				if(b >= SAH_BINS) b = SAH_BINS - 1;
+				binBounds[b].Grow(bounds[obj]);
+				binCount[b]++;
+			}
+
+			//sweep from the right to get the area of every right partition
+			GLfloat rightArea[SAH_BINS];
+			UINT rightCount[SAH_BINS];
+			AABB acc;
+			acc.Clear();
+			UINT n = 0;
+			for(UINT b=SAH_BINS-1; b>0; b--)
+			{
+				acc.Grow(binBounds[b]);
+				n += binCount[b];
+				rightArea[b] = acc.GetSurfaceArea();
+				rightCount[b] = n;
+			}
+
+			//sweep from the left and evaluate each split
+			acc.Clear();
+			n = 0;
+			for(UINT b=1; b<SAH_BINS; b++)
+			{
+				acc.Grow(binBounds[b-1]);
+				n += binCount[b-1];
+
+				if(n == 0 || rightCount[b] == 0) continue;
+
+				GLfloat cost = acc.GetSurfaceArea() * n + rightArea[b] * rightCount[b];
+				if(cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+
+		//compare against the cost of not splitting at all
+		//(traversal cost is taken as one intersection test)
+		GLfloat area = m_Nodes[node].bounds.GetSurfaceArea();
+		GLfloat leafCost = (GLfloat)count;
+		GLfloat splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+
+		if(bestAxis >= 0 && splitCost >= leafCost && count <= MAX_LEAF_SIZE * 4)
+			continue;
+
+		UINT mid;
+		if(bestAxis >= 0)
+		{
+			//partition the objects in place around the chosen bin
+			GLfloat lo = centroidBounds.min[bestAxis];
+			GLfloat scale = SAH_BINS / (centroidBounds.max[bestAxis] - lo);
+
+			UINT i = first;
+			UINT j = first + count;
+			while(i < j)
+			{
+				UINT b = (UINT)((centroids[m_Objects[i]*3+bestAxis] - lo) * scale);
+				if(b >= SAH_BINS) b = SAH_BINS - 1;
+
+				if(b < bestSplit)
+					i++;
+				else
+					std::swap(m_Objects[i], m_Objects[--j]);
+			}
+			mid = i;
+		}
+		else
+		{
+			//all centroids are coincident, split in half
+			CentroidLess less;
+			less.centroids = centroids;
+			less.axis = 0;
+			mid = first + count/2;
+			std::nth_element(m_Objects.begin() + first, m_Objects.begin() + mid,
+							 m_Objects.begin() + first + count, less);
+		}
+
+		//create the children, they are always allocated after the parent
+		//so iterating the node pool backwards visits children first
+		Node child;
+		child.parent = node;
+		child.stamp = 0;
+
+		UINT left = (UINT)m_Nodes.size();
+		child.first = first;
+		child.count = mid - first;
+		m_Nodes.push_back(child);
+
+		child.first = mid;
+		child.count = first + count - mid;
+		m_Nodes.push_back(child);
+
+		m_Nodes[node].first = left;
+		m_Nodes[node].count = 0;
+
+		stack.push_back(left);
+		stack.push_back(left + 1);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Recomputes the bounds of a node from its objects or children.
+///@param	node - node index
+///@param	bounds - object bounds
+///----------------------------------------------------------------------------
+void BVH::UpdateNodeBounds(UINT node, const AABB *bounds)
+{
+	Node &n = m_Nodes[node];
+	n.bounds.Clear();
+
+	if(n.count > 0)
+	{
+		for(UINT i=n.first; i<n.first+n.count; i++)
+		{
+			n.bounds.Grow(bounds[m_Objects[i]]);
+			m_ObjectLeaf[m_Objects[i]] = node;
+		}
+	}
+	else
+	{
+		n.bounds.Grow(m_Nodes[n.first].bounds);
+		n.bounds.Grow(m_Nodes[n.first+1].bounds);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Updates the bounds of the leaves holding the given objects and of all
+///their ancestors. The tree topology is left untouched.
+///@param	bounds - object bounds (all objects)
+///@param	objects - indices of the objects that moved
+///@param	count - number of moved objects
+///----------------------------------------------------------------------------
+void BVH::Refit(const AABB *bounds, const UINT *objects, UINT count)
+{
+	m_RefitNodes = 0;
+	if(m_Nodes.empty() || count == 0) return;
+
+	m_RefitStamp++;
+
+	//mark every node on the path from a dirty leaf up to the root,
+	//stop climbing as soon as we reach a path marked by another object
+	std::vector<UINT> dirty;
+	for(UINT i=0; i<count; i++)
+	{
+		UINT node = m_ObjectLeaf[objects[i]];
+		while(m_Nodes[node].stamp != m_RefitStamp)
+		{
+			m_Nodes[node].stamp = m_RefitStamp;
+			dirty.push_back(node);
+
+			if(node == 0) break;
+			node = m_Nodes[node].parent;
+		}
+	}
+
+	//children have larger indices than their parents,
+	//so updating in descending order goes bottom-up
+	std::sort(dirty.begin(), dirty.end(), std::greater<UINT>());
+	for(UINT i=0; i<dirty.size(); i++)
+		UpdateNodeBounds(dirty[i], bounds);
+
+	m_RefitNodes = (UINT)dirty.size();
+}
+
+///----------------------------------------------------------------------------
+///Collects the objects whose bounds intersect the frustum.
+///@param	frustum - culling frustum
+///@param	bounds - object bounds
+///@param	visible - returned object indices (appended)
+///----------------------------------------------------------------------------
+void BVH::CullFrustum(const Frustum &frustum, const AABB *bounds,
+					  std::vector<UINT> &visible) const
+{
+	if(m_Nodes.empty()) return;
+
+	UINT stack[64];
+	UINT top = 0;
+	stack[top++] = 0;
+
+	while(top > 0)
+	{
+		UINT node = stack[--top];
+		const Node &n = m_Nodes[node];
+
+		Frustum::Result r = frustum.Test(n.bounds);
+		if(r == Frustum::OUTSIDE) continue;
+
+		if(r == Frustum::INSIDE)
+		{
+			//the whole subtree is visible, no more plane tests needed
+			AddSubtree(node, visible);
+		}
+		else if(n.count > 0)
+		{
+			for(UINT i=n.first; i<n.first+n.count; i++)
+			{
+				UINT obj = m_Objects[i];
+				if(frustum.Test(bounds[obj]) != Frustum::OUTSIDE)
+					visible.push_back(obj);
+			}
+		}
+		else if(top + 2 <= 64)
+		{
+			stack[top++] = n.first;
+			stack[top++] = n.first + 1;
+		}
+		else
+		{
+			//pathologically deep tree, just accept the subtree
+			AddSubtree(n.first, visible);
+			AddSubtree(n.first + 1, visible);
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Appends every object below the given node.
+///----------------------------------------------------------------------------
+void BVH::AddSubtree(UINT node, std::vector<UINT> &visible) const
+{
+	std::vector<UINT> stack;
+	stack.push_back(node);
+
+	while(!stack.empty())
+	{
+		const Node &n = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		if(n.count > 0)
+		{
+			visible.insert(visible.end(), m_Objects.begin() + n.first,
+						   m_Objects.begin() + n.first + n.count);
+		}
+		else
+		{
+			stack.push_back(n.first);
+			stack.push_back(n.first + 1);
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Finds the closest object bounding box hit by a ray.
+///@param	origin - ray origin
+///@param	dir - ray direction (does not need to be normalized)
+///@param	maxT - maximum distance along dir
+///@param	bounds - object bounds
+///@param	object - returned object index
+///@param	t - returned hit distance
+///@returns true if something was hit
+///----------------------------------------------------------------------------
+bool BVH::Raycast(const GLfloat origin[3], const GLfloat dir[3], GLfloat maxT,
+				  const AABB *bounds, UINT *object, GLfloat *t) const
+{
+	if(m_Nodes.empty()) return false;
+
+	GLfloat invDir[3];
+	for(int i=0; i<3; i++)
+		invDir[i] = dir[i] != 0.0f ? 1.0f / dir[i] : FLT_MAX;
+
+	bool hit = false;
+	GLfloat closest = maxT;
+
+	std::vector<UINT> stack;
+	stack.push_back(0);
+
+	while(!stack.empty())
+	{
+		const Node &n = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		GLfloat tNode;
+		if(!n.bounds.IntersectRay(origin, invDir, closest, &tNode))
+			continue;
+
+		if(n.count > 0)
+		{
+			for(UINT i=n.first; i<n.first+n.count; i++)
+			{
+				GLfloat tObj;
+				UINT obj = m_Objects[i];
+				if(bounds[obj].IntersectRay(origin, invDir, closest, &tObj))
+				{
+					closest = tObj;
+					if(object) *object = obj;
+					hit = true;
+				}
+			}
+		}
+		else
+		{
+			//visit the nearest child first so 'closest' shrinks early
+			GLfloat tL, tR;
+			bool hitL = m_Nodes[n.first].bounds.IntersectRay(origin, invDir, closest, &tL);
+			bool hitR = m_Nodes[n.first+1].bounds.IntersectRay(origin, invDir, closest, &tR);
+
+			if(hitL && hitR)
+			{
+				if(tL < tR)
+				{
+					stack.push_back(n.first + 1);
+					stack.push_back(n.first);
+				}
+				else
+				{
+					stack.push_back(n.first);
+					stack.push_back(n.first + 1);
+				}
+			}
+			else if(hitL) stack.push_back(n.first);
+			else if(hitR) stack.push_back(n.first + 1);
+		}
+	}
+
+	if(hit && t) *t = closest;
+	return hit;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of nodes in the tree
+///----------------------------------------------------------------------------
+UINT BVH::GetNodeCount() const
+{
+	return (UINT)m_Nodes.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of nodes updated by the last refit
+///----------------------------------------------------------------------------
+UINT BVH::GetRefitNodeCount() const
+{
+	return m_RefitNodes;
+}
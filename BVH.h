@@ -0,0 +1,73 @@
+///============================================================================
+///@file	BVH.h
+///@brief	Bounding volume hierarchy over the objects in the scene.
+///			The tree is built once using the surface area heuristic (SAH);
+///			animated objects only refit the bounds of their leaf and its
+///			ancestors every frame, the topology is never rebuilt.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include "Culling.h"
+
+class BVH
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	BVH();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Build(const AABB *bounds, UINT count);
+	void Refit(const AABB *bounds, const UINT *objects, UINT count);
+	void CullFrustum(const Frustum &frustum, const AABB *bounds,
+					 std::vector<UINT> &visible) const;
+	bool Raycast(const GLfloat origin[3], const GLfloat dir[3], GLfloat maxT,
+				 const AABB *bounds, UINT *object, GLfloat *t) const;
+	UINT GetNodeCount() const;
+	UINT GetRefitNodeCount() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_LEAF_SIZE = 4;	///> Max objects per leaf
+	static const UINT SAH_BINS = 16;		///> Bins used to evaluate the SAH
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Node
+	{
+		AABB	bounds;		///> Bounds of everything below this node
+		UINT	first;		///> Leaf: first object index, interior: left child
+		UINT	count;		///> Number of objects (0 for interior nodes)
+		UINT	parent;		///> Parent node (root points to itself)
+		UINT	stamp;		///> Last refit in which this node was marked
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void Subdivide(UINT node, const AABB *bounds, const GLfloat *centroids);
+	void UpdateNodeBounds(UINT node, const AABB *bounds);
+	void AddSubtree(UINT node, std::vector<UINT> &visible) const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<Node>	m_Nodes;		///> Node pool, children follow parents
+	std::vector<UINT>	m_Objects;		///> Object indices referenced by leaves
+	std::vector<UINT>	m_ObjectLeaf;	///> Leaf node that holds each object
+	UINT				m_RefitStamp;	///> Incremented on every refit
+	UINT				m_RefitNodes;	///> Nodes touched by the last refit
+};
+
+#endif
@@ -0,0 +1,189 @@
+///============================================================================
+///@file	BVHTests.cpp
+///@brief	Checks the BVH culling and ray casts against testing every box,
+///			after the build and after refitting moved objects.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Tests.h"
+#include "BVH.h"
+#include <math.h>
+#include <algorithm>
+
+static const UINT ObjectCount = 500;	//boxes of the scene
+static const UINT ViewCount = 64;		//random views culled per tree
+static const UINT RayCount = 256;		//random rays cast per tree
+
+///----------------------------------------------------------------------------
+///Random box inside [-50, 50]^3, some of them flat or reduced to a point
+///----------------------------------------------------------------------------
+static void RandomBox(AABB &box)
+{
+	GLfloat center[3], extent[3];
+	for(int k=0; k<3; k++)
+	{
+		center[k] = RandomFloat(-50.0f, 50.0f);
+		extent[k] = RandomFloat(0.0f, 1.0f) < 0.1f ? 0.0f : RandomFloat(0.05f, 5.0f);
+		box.min[k] = center[k] - extent[k];
+		box.max[k] = center[k] + extent[k];
+	}
+}
+
+///----------------------------------------------------------------------------
+///Random perspective view placed inside the scene
+///----------------------------------------------------------------------------
+static void RandomFrustum(Frustum &frustum)
+{
+	GLdouble fovy = RandomFloat(30.0f, 90.0f) * 3.14159265358979 / 180.0;
+	GLdouble aspect = RandomFloat(0.5f, 2.0f);
+	GLdouble zNear = 0.5, zFar = RandomFloat(20.0f, 150.0f);
+	GLdouble f = 1.0 / tan(fovy * 0.5);
+
+	//same matrix as gluPerspective
+	GLdouble projection[16] = {0.0};
+	projection[0]	= f / aspect;
+	projection[5]	= f;
+	projection[10]	= (zFar + zNear) / (zNear - zFar);
+	projection[11]	= -1.0;
+	projection[14]	= 2.0 * zFar * zNear / (zNear - zFar);
+
+	Matrix4 view;
+	view.Identity();
+	view.Rotate(RandomFloat(-180.0f, 180.0f), RandomFloat(-1.0f, 1.0f),
+				RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f));
+	view.Translate(RandomFloat(-40.0f, 40.0f), RandomFloat(-40.0f, 40.0f), RandomFloat(-40.0f, 40.0f));
+
+	GLdouble modelview[16];
+	for(int i=0; i<16; i++)
+		modelview[i] = view.m[i];
+
+	frustum.Extract(projection, modelview);
+}
+
+///----------------------------------------------------------------------------
+///Culls random views with the tree and with every box and compares the
+///visible sets
+///@returns the number of views that see some but not all of the boxes
+///----------------------------------------------------------------------------
+static UINT CheckCulling(const BVH &bvh, const std::vector<AABB> &bounds)
+{
+	UINT partial = 0;
+
+	for(UINT v=0; v<ViewCount; v++)
+	{
+		Frustum frustum;
+		RandomFrustum(frustum);
+
+		std::vector<UINT> visible, expected;
+		bvh.CullFrustum(frustum, &bounds[0], visible);
+
+		for(UINT i=0; i<bounds.size(); i++)
+			if(frustum.Test(bounds[i]) != Frustum::OUTSIDE) expected.push_back(i);
+
+		//every object once, in any order
+		std::sort(visible.begin(), visible.end());
+		CHECK(std::adjacent_find(visible.begin(), visible.end()) == visible.end());
+		CHECK(visible == expected);
+
+		if(!expected.empty() && expected.size() < bounds.size()) partial++;
+	}
+
+	return partial;
+}
+
+///----------------------------------------------------------------------------
+///Casts random rays with the tree and against every box and compares the
+///nearest hits
+///----------------------------------------------------------------------------
+static void CheckRays(const BVH &bvh, const std::vector<AABB> &bounds)
+{
+	for(UINT r=0; r<RayCount; r++)
+	{
+		GLfloat origin[3], dir[3], invDir[3];
+		for(int k=0; k<3; k++)
+		{
+			origin[k] = RandomFloat(-60.0f, 60.0f);
+			dir[k] = RandomFloat(-1.0f, 1.0f);
+			invDir[k] = dir[k] != 0.0f ? 1.0f / dir[k] : 3.4e38f;
+		}
+
+		GLfloat maxT = 200.0f, expectedT = maxT;
+		bool expectedHit = false;
+		for(UINT i=0; i<bounds.size(); i++)
+		{
+			GLfloat t;
+			if(bounds[i].IntersectRay(origin, invDir, expectedT, &t))
+			{
+				expectedT = t;
+				expectedHit = true;
+			}
+		}
+
+		UINT object = ObjectCount;
+		GLfloat t = maxT;
+		bool hit = bvh.Raycast(origin, dir, maxT, &bounds[0], &object, &t);
+
+		CHECK(hit == expectedHit);
+		if(!hit || !expectedHit) continue;
+
+		//another box may be hit at the same distance, the distance must match
+		CHECK(object < bounds.size());
+		CHECK(fabsf(t - expectedT) <= 1e-4f * (1.0f + expectedT));
+		GLfloat objectT = maxT;
+		CHECK(object < bounds.size() && bounds[object].IntersectRay(origin, invDir, maxT, &objectT) &&
+			  fabsf(objectT - t) <= 1e-4f * (1.0f + t));
+	}
+}
+
+///----------------------------------------------------------------------------
+///Checks the BVH
+///----------------------------------------------------------------------------
+void TestBVH()
+{
+	std::vector<AABB> bounds(ObjectCount);
+	for(UINT i=0; i<ObjectCount; i++)
+		RandomBox(bounds[i]);
+
+	//a few objects sharing the same box can't be split by the SAH
+	for(UINT i=0; i<2*BVH::MAX_LEAF_SIZE; i++)
+		bounds[ObjectCount - 1 - i] = bounds[0];
+
+	//empty tree
+	BVH empty;
+	std::vector<UINT> none;
+	Frustum frustum;
+	RandomFrustum(frustum);
+	empty.Build(NULL, 0);
+	empty.CullFrustum(frustum, NULL, none);
+	CHECK(none.empty());
+	CHECK(empty.GetNodeCount() == 0);
+
+	BVH bvh;
+	bvh.Build(&bounds[0], ObjectCount);
+	CHECK(bvh.GetNodeCount() > 0 && bvh.GetNodeCount() < 2 * ObjectCount);
+
+	//the random views must exercise the partially visible case
+	CHECK(CheckCulling(bvh, bounds) > ViewCount / 4);
+	CheckRays(bvh, bounds);
+
+	//move a third of the objects, some of them across the scene
+	std::vector<UINT> moved;
+	for(UINT i=0; i<ObjectCount; i+=3)
+	{
+		GLfloat offset[3];
+		for(int k=0; k<3; k++)
+		{
+			offset[k] = i % 2 ? RandomFloat(-2.0f, 2.0f) : RandomFloat(-60.0f, 60.0f);
+			bounds[i].min[k] += offset[k];
+			bounds[i].max[k] += offset[k];
+		}
+		moved.push_back(i);
+	}
+
+	bvh.Refit(&bounds[0], &moved[0], (UINT)moved.size());
+	CHECK(bvh.GetRefitNodeCount() > 0 && bvh.GetRefitNodeCount() <= bvh.GetNodeCount());
+
+	CheckCulling(bvh, bounds);
+	CheckRays(bvh, bounds);
+}
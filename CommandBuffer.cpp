@@ -0,0 +1,120 @@
+///============================================================================
+///@file	CommandBuffer.cpp
+///@brief	List of draw commands recorded without touching OpenGL.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "CommandBuffer.h"
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+CommandBuffer::CommandBuffer()
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+CommandBuffer::~CommandBuffer()
+{
+}
+
+///----------------------------------------------------------------------------
+///Removes the commands, the memory is kept for the next frame
+///----------------------------------------------------------------------------
+void CommandBuffer::Reset()
+{
+	m_Commands.clear();
+}
+
+///----------------------------------------------------------------------------
+///Records a lit draw of a mesh
+///@param	key - sort key
+///@param	mesh - the mesh
+///@param	world - object to world transform
+///@param	color - object color (RGBA8)
+///----------------------------------------------------------------------------
+void CommandBuffer::DrawMesh(UINT64 key, const Mesh *mesh, const GLfloat world[16],
+							 const GLubyte color[4])
+{
+	Command command;
+	command.key		= key;
+	command.type	= DRAW_MESH;
+	command.mesh	= mesh;
+	command.world	= world;
+	command.query	= 0;
+	for(int i=0; i<4; i++)
+		command.color[i] = color[i];
+
+	m_Commands.push_back(command);
+}
+
+///----------------------------------------------------------------------------
+///Records a depth only draw of a mesh
+///@param	key - sort key
+///@param	mesh - the mesh
+///@param	world - object to world transform
+///----------------------------------------------------------------------------
+void CommandBuffer::DrawPositions(UINT64 key, const Mesh *mesh, const GLfloat world[16])
+{
+	Command command;
+	command.key		= key;
+	command.type	= DRAW_POSITIONS;
+	command.mesh	= mesh;
+	command.world	= world;
+	command.query	= 0;
+	command.color[0] = command.color[1] = command.color[2] = command.color[3] = 0;
+
+	m_Commands.push_back(command);
+}
+
+///----------------------------------------------------------------------------
+///Records the start of draws the GPU skips if the query found no samples
+///@param	query - occlusion query object
+///----------------------------------------------------------------------------
+void CommandBuffer::BeginConditional(GLuint query)
+{
+	Command command;
+	command.key		= 0;
+	command.type	= BEGIN_CONDITIONAL;
+	command.mesh	= NULL;
+	command.world	= NULL;
+	command.query	= query;
+	command.color[0] = command.color[1] = command.color[2] = command.color[3] = 0;
+
+	m_Commands.push_back(command);
+}
+
+///----------------------------------------------------------------------------
+///Records the end of the conditional draws
+///----------------------------------------------------------------------------
+void CommandBuffer::EndConditional()
+{
+	Command command;
+	command.key		= 0;
+	command.type	= END_CONDITIONAL;
+	command.mesh	= NULL;
+	command.world	= NULL;
+	command.query	= 0;
+	command.color[0] = command.color[1] = command.color[2] = command.color[3] = 0;
+
+	m_Commands.push_back(command);
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of recorded commands
+///----------------------------------------------------------------------------
+UINT CommandBuffer::GetCount() const
+{
+	return (UINT)m_Commands.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns a recorded command
+///----------------------------------------------------------------------------
+const CommandBuffer::Command& CommandBuffer::GetCommand(UINT index) const
+{
+	return m_Commands[index];
+}
@@ -0,0 +1,71 @@
+///============================================================================
+///@file	CommandBuffer.h
+///@brief	List of draw commands recorded without touching OpenGL, so any
+///			thread can build one. Worker threads record the passes in
+///			chunks and the thread owning the rendering context replays
+///			the buffers in order (see Geometry::Execute), or sorted by
+///			their keys (see DrawQueue).
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+
+class Mesh;
+
+class CommandBuffer
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum CommandType
+	{
+		DRAW_MESH = 0,		///> Draws the full vertices of a mesh
+		DRAW_POSITIONS,		///> Draws the position-only stream of a mesh
+		BEGIN_CONDITIONAL,	///> Following draws depend on a query result
+		END_CONDITIONAL		///> Ends the conditional draws
+	};
+
+	///The matrix and the mesh are not copied, they must live until the
+	///buffer is replayed (the scene keeps them for the whole frame)
+	struct Command
+	{
+		UINT64			key;		///> Sort key (see Geometry::RecordObject)
+		CommandType		type;		///> What to do
+		const Mesh*		mesh;		///> Mesh to draw
+		const GLfloat*	world;		///> Column-major object to world transform
+		GLubyte			color[4];	///> Object color (DRAW_MESH)
+		GLuint			query;		///> Query object (BEGIN_CONDITIONAL)
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	CommandBuffer();
+	virtual ~CommandBuffer();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Reset();
+	void DrawMesh(UINT64 key, const Mesh *mesh, const GLfloat world[16], const GLubyte color[4]);
+	void DrawPositions(UINT64 key, const Mesh *mesh, const GLfloat world[16]);
+	void BeginConditional(GLuint query);
+	void EndConditional();
+	UINT GetCount() const;
+	const Command& GetCommand(UINT index) const;
+
+private:
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<Command> m_Commands;	///> Recorded commands (the capacity is kept)
+};
+
+#endif
@@ -0,0 +1,216 @@
+///============================================================================
+///@file	Culling.cpp
+///@brief	Bounding volumes and view frustum used for visibility culling.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Culling.h"
+#include <math.h>
+#include <float.h>
+
+///----------------------------------------------------------------------------
+///Resets the box to an empty (inverted) box.
+///----------------------------------------------------------------------------
+void AABB::Clear()
+{
+	min[0] = min[1] = min[2] =  FLT_MAX;
+	max[0] = max[1] = max[2] = -FLT_MAX;
+}
+
+///----------------------------------------------------------------------------
+///Enlarges the box so it contains the given point.
+///----------------------------------------------------------------------------
+void AABB::Grow(const GLfloat p[3])
+{
+	for(int i=0; i<3; i++)
+	{
+		if(p[i] < min[i]) min[i] = p[i];
+		if(p[i] > max[i]) max[i] = p[i];
+	}
+}
+
+///----------------------------------------------------------------------------
+///Enlarges the box so it contains the given box.
+///----------------------------------------------------------------------------
+void AABB::Grow(const AABB &box)
+{
+	for(int i=0; i<3; i++)
+	{
+		if(box.min[i] < min[i]) min[i] = box.min[i];
+		if(box.max[i] > max[i]) max[i] = box.max[i];
+	}
+}
+
+///----------------------------------------------------------------------------
+///Computes the box enclosing this box transformed by M (Arvo's method).
+///@param	M - transform matrix
+///@param	out - returned world space box
+///----------------------------------------------------------------------------
+void AABB::Transform(const Matrix4 &M, AABB &out) const
+{
+	for(int i=0; i<3; i++)
+	{
+		out.min[i] = out.max[i] = M.m[12+i];
+
+		for(int j=0; j<3; j++)
+		{
+			GLfloat a = M.m[j*4+i] * min[j];
+			GLfloat b = M.m[j*4+i] * max[j];
+
+			if(a < b)
+			{
+				out.min[i] += a;
+				out.max[i] += b;
+			}
+			else
+			{
+				out.min[i] += b;
+				out.max[i] += a;
+			}
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Gets the center of the box.
+///----------------------------------------------------------------------------
+void AABB::GetCenter(GLfloat c[3]) const
+{
+	c[0] = 0.5f * (min[0] + max[0]);
+	c[1] = 0.5f * (min[1] + max[1]);
+	c[2] = 0.5f * (min[2] + max[2]);
+}
+
+///----------------------------------------------------------------------------
+///@returns the surface area of the box (used by the SAH cost)
+///----------------------------------------------------------------------------
+GLfloat AABB::GetSurfaceArea() const
+{
+	if(IsEmpty()) return 0.0f;
+
+	GLfloat dx = max[0] - min[0];
+	GLfloat dy = max[1] - min[1];
+	GLfloat dz = max[2] - min[2];
+
+	return 2.0f * (dx*dy + dy*dz + dz*dx);
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the box has been cleared and never grown
+///----------------------------------------------------------------------------
+bool AABB::IsEmpty() const
+{
+	return min[0] > max[0];
+}
+
+///----------------------------------------------------------------------------
+///Ray/box intersection using the slab method.
+///@param	origin - ray origin
+///@param	invDir - reciprocal of the ray direction
+///@param	maxT - maximum ray distance
+///@param	tHit - returned entry distance (0 if origin is inside)
+///@returns true if the ray hits the box before maxT
+///----------------------------------------------------------------------------
+bool AABB::IntersectRay(const GLfloat origin[3], const GLfloat invDir[3],
+						GLfloat maxT, GLfloat *tHit) const
+{
+	GLfloat tMin = 0.0f;
+	GLfloat tMax = maxT;
+
+	for(int i=0; i<3; i++)
+	{
+		GLfloat t0 = (min[i] - origin[i]) * invDir[i];
+		GLfloat t1 = (max[i] - origin[i]) * invDir[i];
+
+		if(t0 > t1)
+		{
+			GLfloat tmp = t0;
+			t0 = t1;
+			t1 = tmp;
+		}
+
+		if(t0 > tMin) tMin = t0;
+		if(t1 < tMax) tMax = t1;
+		if(tMin > tMax) return false;
+	}
+
+	if(tHit) *tHit = tMin;
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Extracts the frustum planes from the projection and modelview matrices
+///(Gribb & Hartmann method). The planes are in world space.
+///@param	projection - column-major projection matrix
+///@param	modelview - column-major modelview matrix
+///----------------------------------------------------------------------------
+void Frustum::Extract(const GLdouble projection[16], const GLdouble modelview[16])
+{
+	Matrix4 P, V, C;
+	P.Set(projection);
+	V.Set(modelview);
+	Matrix4::Multiply(P, V, C);
+
+	//rows of the clip matrix
+	const GLfloat *m = C.m;
+	for(int i=0; i<3; i++)
+	{
+		for(int j=0; j<4; j++)
+		{
+			GLfloat row3 = m[j*4+3];
+			GLfloat rowi = m[j*4+i];
+			m_Planes[i*2][j]   = row3 + rowi;
+			m_Planes[i*2+1][j] = row3 - rowi;
+		}
+	}
+
+	//normalize the planes
+	for(int i=0; i<6; i++)
+	{
+		GLfloat len = sqrtf(m_Planes[i][0]*m_Planes[i][0] +
+							m_Planes[i][1]*m_Planes[i][1] +
+							m_Planes[i][2]*m_Planes[i][2]);
+
+		if(len > 0.0f)
+		{
+			m_Planes[i][0] /= len;
+			m_Planes[i][1] /= len;
+			m_Planes[i][2] /= len;
+			m_Planes[i][3] /= len;
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Classifies a box against the frustum.
+///@param	box - world space box
+///@returns OUTSIDE, INTERSECT or INSIDE
+///----------------------------------------------------------------------------
+Frustum::Result Frustum::Test(const AABB &box) const
+{
+	Result result = INSIDE;
+
+	for(int i=0; i<6; i++)
+	{
+		const GLfloat *p = m_Planes[i];
+
+		//positive vertex: the corner farthest along the plane normal
+		GLfloat px = p[0] >= 0.0f ? box.max[0] : box.min[0];
+		GLfloat py = p[1] >= 0.0f ? box.max[1] : box.min[1];
+		GLfloat pz = p[2] >= 0.0f ? box.max[2] : box.min[2];
+
+		if(p[0]*px + p[1]*py + p[2]*pz + p[3] < 0.0f)
+			return OUTSIDE;
+
+		//negative vertex: the corner nearest along the plane normal
+		GLfloat nx = p[0] >= 0.0f ? box.min[0] : box.max[0];
+		GLfloat ny = p[1] >= 0.0f ? box.min[1] : box.max[1];
+		GLfloat nz = p[2] >= 0.0f ? box.min[2] : box.max[2];
+
+		if(p[0]*nx + p[1]*ny + p[2]*nz + p[3] < 0.0f)
+			result = INTERSECT;
+	}
+
+	return result;
+}
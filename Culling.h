@@ -0,0 +1,62 @@
+///============================================================================
+///@file	Culling.h
+///@brief	Bounding volumes and view frustum used for visibility culling.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include "Matrix4.h"
+
+///----------------------------------------------------------------------------
+///Axis aligned bounding box
+///----------------------------------------------------------------------------
+struct AABB
+{
+	GLfloat min[3];	///> Minimum corner
+	GLfloat max[3];	///> Maximum corner
+
+	void Clear();
+	void Grow(const GLfloat p[3]);
+	void Grow(const AABB &box);
+	void Transform(const Matrix4 &M, AABB &out) const;
+	void GetCenter(GLfloat c[3]) const;
+	GLfloat GetSurfaceArea() const;
+	bool IsEmpty() const;
+	bool IntersectRay(const GLfloat origin[3], const GLfloat invDir[3],
+					  GLfloat maxT, GLfloat *tHit) const;
+};
+
+///----------------------------------------------------------------------------
+///View frustum defined by six planes (ax + by + cz + d >= 0 is inside)
+///----------------------------------------------------------------------------
+class Frustum
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum Result
+	{
+		OUTSIDE = 0,	///> Box is completely outside
+		INTERSECT,		///> Box crosses at least one plane
+		INSIDE			///> Box is completely inside
+	};
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Extract(const GLdouble projection[16], const GLdouble modelview[16]);
+	Result Test(const AABB &box) const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	GLfloat m_Planes[6][4];	///> left, right, bottom, top, near, far
+};
+
+#endif
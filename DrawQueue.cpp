@@ -0,0 +1,149 @@
+///============================================================================
+///@file	DrawQueue.cpp
+///@brief	Draw commands of a pass sorted by their 64 bit key.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "DrawQueue.h"
+#include <string.h>
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+DrawQueue::DrawQueue()
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+DrawQueue::~DrawQueue()
+{
+}
+
+///----------------------------------------------------------------------------
+///Gathers the draws of the recorded buffers and sorts them. The commands
+///aren't copied, the buffers must not change until the queue is replayed.
+///Conditional commands wrap a single draw and can't be reordered, they are
+///left out (keep them in a buffer of their own).
+///@param	buffers - recorded buffers of a pass
+///@param	count - number of buffers
+///----------------------------------------------------------------------------
+void DrawQueue::Build(const CommandBuffer *buffers, UINT count)
+{
+	m_Entries.clear();
+
+	for(UINT i=0; i<count; i++)
+	{
+		for(UINT j=0; j<buffers[i].GetCount(); j++)
+		{
+			const CommandBuffer::Command &command = buffers[i].GetCommand(j);
+			if(command.type != CommandBuffer::DRAW_MESH &&
+			   command.type != CommandBuffer::DRAW_POSITIONS) continue;
+
+			Entry entry;
+			entry.key = command.key;
+			entry.command = &command;
+			m_Entries.push_back(entry);
+		}
+	}
+
+	Sort();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of sorted draws
+///----------------------------------------------------------------------------
+UINT DrawQueue::GetCount() const
+{
+	return (UINT)m_Entries.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns a draw in key order
+///----------------------------------------------------------------------------
+const CommandBuffer::Command& DrawQueue::GetCommand(UINT index) const
+{
+	return *m_Entries[index].command;
+}
+
+///----------------------------------------------------------------------------
+///Builds the sort key of a draw
+///@param	pass - render pass
+///@param	shader - program used by the draw (0 for fixed function)
+///@param	mesh - index of the vertex streams
+///@param	depth - squared distance from the eye to the object (>= 0)
+///@param	color - object color
+///@returns the key, smaller keys are drawn first
+///----------------------------------------------------------------------------
+UINT64 DrawQueue::MakeKey(UINT pass, UINT shader, UINT mesh, GLfloat depth,
+						  const GLubyte color[4])
+{
+	//the bits of a positive float sort like the float, the top 24 of its
+	//31 bits are enough to draw front to back
+	DWORD bits;
+	if(depth < 0.0f) depth = 0.0f;
+	memcpy(&bits, &depth, sizeof(bits));
+	UINT64 depthKey = bits >> (31 - DEPTH_BITS);
+
+	UINT64 material = ((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3);
+
+	UINT64 key = pass & ((1 << PASS_BITS) - 1);
+	key = (key << SHADER_BITS)		| (shader & ((1 << SHADER_BITS) - 1));
+	key = (key << MESH_BITS)		| (mesh & ((1 << MESH_BITS) - 1));
+	key = (key << DEPTH_BITS)		| depthKey;
+	key = (key << MATERIAL_BITS)	| material;
+
+	return key;
+}
+
+///----------------------------------------------------------------------------
+///Sorts the entries by key, 8 bits per pass. The histograms of every digit
+///are counted at once and the digits shared by all the keys (i.e. the pass
+///and shader bits) are skipped.
+///----------------------------------------------------------------------------
+void DrawQueue::Sort()
+{
+	UINT count = (UINT)m_Entries.size();
+	if(count < 2) return;
+
+	static const UINT DIGITS = 8;
+	UINT histogram[DIGITS][256];
+	memset(histogram, 0, sizeof(histogram));
+
+	for(UINT i=0; i<count; i++)
+	{
+		UINT64 key = m_Entries[i].key;
+		for(UINT d=0; d<DIGITS; d++)
+			histogram[d][(key >> (d * 8)) & 0xFF]++;
+	}
+
+	m_Temp.resize(count);
+	Entry *src = &m_Entries[0];
+	Entry *dst = &m_Temp[0];
+
+	for(UINT d=0; d<DIGITS; d++)
+	{
+		UINT shift = d * 8;
+		if(histogram[d][(src[0].key >> shift) & 0xFF] == count) continue;
+
+		UINT offset = 0;
+		for(UINT b=0; b<256; b++)
+		{
+			UINT n = histogram[d][b];
+			histogram[d][b] = offset;
+			offset += n;
+		}
+
+		for(UINT i=0; i<count; i++)
+			dst[histogram[d][(src[i].key >> shift) & 0xFF]++] = src[i];
+
+		Entry *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	//an odd number of passes leaves the result in the scatter buffer
+	if(src != &m_Entries[0]) m_Entries.swap(m_Temp);
+}
@@ -0,0 +1,70 @@
+///============================================================================
+///@file	DrawQueue.h
+///@brief	Draw commands of a pass sorted by their 64 bit key. The key puts
+///			the most expensive state first, so replaying the queue in order
+///			binds every shader and mesh once and draws each group front to
+///			back. The keys are sorted with an LSD radix sort, which is
+///			linear in the number of draws.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef DRAWQUEUE_H
+#define DRAWQUEUE_H
+
+#include <windows.h>
+#include <vector>
+#include "CommandBuffer.h"
+
+class DrawQueue
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	DrawQueue();
+	virtual ~DrawQueue();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Build(const CommandBuffer *buffers, UINT count);
+	UINT GetCount() const;
+	const CommandBuffer::Command& GetCommand(UINT index) const;
+
+	static UINT64 MakeKey(UINT pass, UINT shader, UINT mesh, GLfloat depth,
+						  const GLubyte color[4]);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	///Key layout from the most significant bit
+	static const UINT PASS_BITS		= 4;	///> Pass the draw belongs to
+	static const UINT SHADER_BITS	= 4;	///> Program used to draw
+	static const UINT MESH_BITS		= 16;	///> Vertex streams
+	static const UINT DEPTH_BITS	= 24;	///> Squared distance to the eye
+	static const UINT MATERIAL_BITS	= 16;	///> Color (RGB 5:6:5)
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Entry
+	{
+		UINT64							key;		///> Sort key
+		const CommandBuffer::Command*	command;	///> Command in its buffer
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void Sort();
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<Entry>	m_Entries;	///> Sorted draws
+	std::vector<Entry>	m_Temp;		///> Scatter target of the radix passes
+};
+
+#endif
@@ -0,0 +1,145 @@
+///============================================================================
+///@file	DrawQueueTests.cpp
+///@brief	Checks the layout of the draw sort keys and that the queue
+///			replays every draw once, in key order.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Tests.h"
+#include "DrawQueue.h"
+#include <algorithm>
+
+static const UINT BufferCount = 4;		//buffers recorded per pass
+static const UINT DrawCount = 2000;		//draws spread over the buffers
+
+///----------------------------------------------------------------------------
+///Checks that each field of the key outweighs every field after it
+///----------------------------------------------------------------------------
+static void CheckKeyLayout()
+{
+	static const GLubyte Black[4] = {0, 0, 0, 255};
+	static const GLubyte White[4] = {255, 255, 255, 255};
+	static const GLubyte Red[4] = {255, 0, 0, 255};
+
+	CHECK(DrawQueue::MakeKey(0, 15, 0xFFFF, 1e30f, White) < DrawQueue::MakeKey(1, 0, 0, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(2, 3, 0xFFFF, 1e30f, White) < DrawQueue::MakeKey(2, 4, 0, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(2, 3, 17, 1e30f, White) < DrawQueue::MakeKey(2, 3, 18, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(2, 3, 17, 4.0f, White) < DrawQueue::MakeKey(2, 3, 17, 9.0f, Black));
+	CHECK(DrawQueue::MakeKey(2, 3, 17, 4.0f, Black) < DrawQueue::MakeKey(2, 3, 17, 4.0f, Red));
+
+	//the fields don't spill into their neighbours
+	CHECK(DrawQueue::MakeKey(1, 0, 0, 0.0f, Black) == DrawQueue::MakeKey(0x11, 0, 0, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(0, 1, 0, 0.0f, Black) == DrawQueue::MakeKey(0, 0x11, 0, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(0, 0, 1, 0.0f, Black) == DrawQueue::MakeKey(0, 0, 0x10001, 0.0f, Black));
+	CHECK(DrawQueue::MakeKey(15, 15, 0xFFFF, 3.4e38f, White) >> 60 == 15);
+
+	//front to back, the depth behind the eye counts as 0
+	CHECK(DrawQueue::MakeKey(0, 0, 0, -5.0f, Black) == DrawQueue::MakeKey(0, 0, 0, 0.0f, Black));
+
+	UINT64 previous = 0;
+	bool ordered = true;
+	for(GLfloat depth=0.001f; depth<1e6f; depth*=1.5f)
+	{
+		UINT64 key = DrawQueue::MakeKey(0, 0, 0, depth, Black);
+		if(key <= previous) ordered = false;
+		previous = key;
+	}
+	CHECK(ordered);
+}
+
+///----------------------------------------------------------------------------
+///Records random draws (and conditional blocks the queue leaves out) in
+///several buffers, builds the queue and checks its order and contents
+///@param	passes - distinct pass values used by the draws
+///@param	shaders - distinct shader values used by the draws
+///----------------------------------------------------------------------------
+static void CheckSort(UINT passes, UINT shaders)
+{
+	static const GLubyte Colors[3][4] = {{255, 0, 0, 255}, {0, 255, 0, 255}, {40, 80, 160, 255}};
+
+	std::vector<GLfloat> worlds(DrawCount * 16, 0.0f);
+	CommandBuffer buffers[BufferCount];
+	std::vector<const GLfloat*> drawn;
+
+	for(UINT i=0; i<DrawCount; i++)
+	{
+		UINT pass = (UINT)RandomFloat(0.0f, (GLfloat)passes);
+		UINT shader = (UINT)RandomFloat(0.0f, (GLfloat)shaders);
+		UINT mesh = (UINT)RandomFloat(0.0f, 40.0f);
+		GLfloat depth = RandomFloat(0.0f, 1.0f) < 0.1f ? 25.0f : RandomFloat(0.0f, 10000.0f);
+		const GLubyte *color = Colors[i % 3];
+		UINT64 key = DrawQueue::MakeKey(pass, shader, mesh, depth, color);
+
+		CommandBuffer &buffer = buffers[i % BufferCount];
+		const GLfloat *world = &worlds[i * 16];
+
+		if(i % 7 == 0)
+		{
+			buffer.BeginConditional(i);
+			buffer.DrawPositions(key, NULL, world);
+			buffer.EndConditional();
+		}
+		else if(i % 2)
+			buffer.DrawMesh(key, NULL, world, color);
+		else
+			buffer.DrawPositions(key, NULL, world);
+
+		drawn.push_back(world);
+	}
+
+	DrawQueue queue;
+	queue.Build(buffers, BufferCount);
+	CHECK(queue.GetCount() == DrawCount);
+
+	bool ordered = true, draws = true;
+	std::vector<const GLfloat*> replayed;
+	for(UINT i=0; i<queue.GetCount(); i++)
+	{
+		const CommandBuffer::Command &command = queue.GetCommand(i);
+		if(i > 0 && queue.GetCommand(i - 1).key > command.key) ordered = false;
+		if(command.type != CommandBuffer::DRAW_MESH && command.type != CommandBuffer::DRAW_POSITIONS)
+			draws = false;
+
+		replayed.push_back(command.world);
+	}
+
+	CHECK(ordered);
+	CHECK(draws);
+
+	//every draw once
+	std::sort(drawn.begin(), drawn.end());
+	std::sort(replayed.begin(), replayed.end());
+	CHECK(replayed == drawn);
+
+	//building again starts from scratch, every buffer holds a quarter of
+	//the draws
+	queue.Build(buffers, 1);
+	CHECK(queue.GetCount() == DrawCount / BufferCount);
+}
+
+///----------------------------------------------------------------------------
+///Checks the DrawQueue
+///----------------------------------------------------------------------------
+void TestDrawQueue()
+{
+	CheckKeyLayout();
+
+	//no draws and a single draw
+	static const GLfloat World[16] = {0.0f};
+	static const GLubyte Color[4] = {0, 0, 0, 255};
+	CommandBuffer buffer;
+	DrawQueue queue;
+
+	queue.Build(&buffer, 1);
+	CHECK(queue.GetCount() == 0);
+
+	buffer.DrawMesh(42, NULL, World, Color);
+	queue.Build(&buffer, 1);
+	CHECK(queue.GetCount() == 1 && queue.GetCommand(0).key == 42);
+
+	//keys sharing their top digits (skipped by the sort) and keys that
+	//differ everywhere
+	CheckSort(1, 1);
+	CheckSort(16, 16);
+}
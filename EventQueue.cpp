@@ -0,0 +1,69 @@
+///============================================================================
+///@file	EventQueue.cpp
+///@brief	Lock-free single producer, single consumer queue.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "EventQueue.h"
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+EventQueue::EventQueue() : m_Head(0), m_Tail(0), m_Dropped(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+EventQueue::~EventQueue()
+{
+}
+
+///----------------------------------------------------------------------------
+///Adds an event (producer thread only)
+///@param	event - the event
+///@returns false if the queue is full, the event is dropped
+///----------------------------------------------------------------------------
+bool EventQueue::Push(const WindowEvent &event)
+{
+	LONG tail = m_Tail;
+
+	if(tail - m_Head == (LONG)CAPACITY)
+	{
+		InterlockedIncrement(&m_Dropped);
+		return false;
+	}
+
+	m_Events[tail & (CAPACITY - 1)] = event;
+
+	//the event must be written before the consumer can see the new tail
+	InterlockedExchange(&m_Tail, tail + 1);
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Removes the oldest event (consumer thread only)
+///@param	event - returned event
+///@returns false if the queue is empty
+///----------------------------------------------------------------------------
+bool EventQueue::Pop(WindowEvent &event)
+{
+	LONG head = m_Head;
+	if(head == m_Tail) return false;
+
+	event = m_Events[head & (CAPACITY - 1)];
+
+	//the slot must be read before the producer can reuse it
+	InterlockedExchange(&m_Head, head + 1);
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of events lost because the queue was full
+///----------------------------------------------------------------------------
+UINT EventQueue::GetDroppedCount() const
+{
+	return (UINT)m_Dropped;
+}
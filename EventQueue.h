@@ -0,0 +1,57 @@
+///============================================================================
+///@file	EventQueue.h
+///@brief	Lock-free single producer, single consumer queue used to pass the
+///			window messages from the thread running the message pump to the
+///			render thread. The producer only writes the tail and the
+///			consumer only writes the head, so no locks are needed.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <windows.h>
+
+///----------------------------------------------------------------------------
+///A window message handled by the render thread
+///----------------------------------------------------------------------------
+struct WindowEvent
+{
+	UINT	message;	///> WM_SIZE, WM_CHAR...
+	WPARAM	wParam;		///> Message parameters
+	LPARAM	lParam;
+};
+
+class EventQueue
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	EventQueue();
+	virtual ~EventQueue();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Push(const WindowEvent &event);
+	bool Pop(WindowEvent &event);
+	UINT GetDroppedCount() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT CAPACITY = 256;	///> Queued events (power of two)
+
+private:
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	WindowEvent		m_Events[CAPACITY];	///> Ring buffer
+	volatile LONG	m_Head;		///> Next event to pop (written by the consumer)
+	volatile LONG	m_Tail;		///> Next free slot (written by the producer)
+	volatile LONG	m_Dropped;	///> Events pushed while the queue was full
+};
+
+#endif
@@ -0,0 +1,244 @@
+///============================================================================
+///@file	FramePacer.cpp
+///@brief	Keeps a fixed number of frames in flight with fences.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <string.h>
+#include <algorithm>
+
+//how long a fence wait blocks before flushing again (nanoseconds)
+static const GLuint64 FenceTimeout = 1000000;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+FramePacer::FramePacer() : m_FrameCount(0), m_Frame(0), m_Timing(false), m_WaitTime(0.0),
+						   m_Stalled(false), m_GPUTime(0.0)
+{
+	memset(m_Slots, 0, sizeof(m_Slots));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+FramePacer::~FramePacer()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the context has fences
+///----------------------------------------------------------------------------
+bool FramePacer::IsSupported()
+{
+	return g_GLCaps.fenceSync;
+}
+
+///----------------------------------------------------------------------------
+///Creates the timer queries (the context must be current)
+///@param	frames - frames in flight, 1 makes the CPU wait for the previous
+///			frame (clamped to MAX_FRAMES)
+///@returns false if the context has no fences
+///----------------------------------------------------------------------------
+bool FramePacer::Create(UINT frames)
+{
+	Release();
+	if(!IsSupported()) return false;
+
+	m_FrameCount = (std::min)((std::max)(frames, 1U), MAX_FRAMES);
+	m_Frame = 0;
+
+	if(g_GLCaps.timerQuery)
+	{
+		for(UINT i=0; i<m_FrameCount; i++)
+			glGenQueriesARB(1, &m_Slots[i].query);
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the fences and the queries (the context must be current)
+///----------------------------------------------------------------------------
+void FramePacer::Release()
+{
+	if(m_Timing) glEndQueryARB(GL_TIME_ELAPSED);
+
+	for(UINT i=0; i<m_FrameCount; i++)
+	{
+		Slot &slot = m_Slots[i];
+		if(slot.fence) glDeleteSync(slot.fence);
+		if(slot.query) glDeleteQueriesARB(1, &slot.query);
+	}
+
+	memset(m_Slots, 0, sizeof(m_Slots));
+	m_FrameCount = 0;
+	m_Frame = 0;
+	m_Timing = false;
+	m_WaitTime = 0.0;
+	m_Stalled = false;
+	m_GPUTime = 0.0;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if Create succeeded
+///----------------------------------------------------------------------------
+bool FramePacer::IsValid() const
+{
+	return m_FrameCount != 0;
+}
+
+///----------------------------------------------------------------------------
+///Starts a frame: moves to the next slot and waits until the GPU is done
+///with the frame that used it last, so the slot's versions of the per-frame
+///resources can be written again
+///----------------------------------------------------------------------------
+void FramePacer::BeginFrame()
+{
+	m_WaitTime = 0.0;
+	m_Stalled = false;
+	if(!IsValid()) return;
+
+	m_Frame = (m_Frame + 1) % m_FrameCount;
+	Slot &slot = m_Slots[m_Frame];
+
+	if(slot.fence)
+	{
+		//poll first, a fence that signaled already isn't a stall
+		GLenum result = glClientWaitSync(slot.fence, 0, 0);
+		if(result == GL_TIMEOUT_EXPIRED)
+		{
+			double start = Profiler::GetTime();
+			do
+			{
+				result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+			}
+			while(result == GL_TIMEOUT_EXPIRED);
+			m_WaitTime = Profiler::GetTime() - start;
+			m_Stalled = true;
+		}
+
+		glDeleteSync(slot.fence);
+		slot.fence = NULL;
+
+		slot.waits++;
+		slot.waitTime += m_WaitTime;
+		if(m_Stalled) slot.stalls++;
+		if(m_WaitTime > slot.maxWait) slot.maxWait = m_WaitTime;
+	}
+
+	//the frame is done so its query result is there, reading it won't block
+	if(slot.timed)
+	{
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT_ARB, &ns);
+		m_GPUTime = (double)ns / 1000000.0;
+		slot.timed = false;
+	}
+
+	if(slot.query)
+	{
+		glBeginQueryARB(GL_TIME_ELAPSED, slot.query);
+		m_Timing = true;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Ends a frame, call once all its commands have been issued (before the
+///buffers are swapped)
+///----------------------------------------------------------------------------
+void FramePacer::EndFrame()
+{
+	if(!IsValid()) return;
+
+	Slot &slot = m_Slots[m_Frame];
+
+	if(m_Timing)
+	{
+		glEndQueryARB(GL_TIME_ELAPSED);
+		slot.timed = true;
+		m_Timing = false;
+	}
+
+	if(slot.fence) glDeleteSync(slot.fence);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+///----------------------------------------------------------------------------
+///@returns the slot of the current frame, the version of every per-frame
+///			resource to use (always 0 if the pacer isn't valid)
+///----------------------------------------------------------------------------
+UINT FramePacer::GetFrame() const
+{
+	return m_Frame;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of frames in flight (versions of each resource)
+///----------------------------------------------------------------------------
+UINT FramePacer::GetFrameCount() const
+{
+	return m_FrameCount;
+}
+
+///----------------------------------------------------------------------------
+///@returns the milliseconds the last BeginFrame waited on its fence
+///----------------------------------------------------------------------------
+double FramePacer::GetWaitTime() const
+{
+	return m_WaitTime;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the last BeginFrame found its fence not signaled
+///----------------------------------------------------------------------------
+bool FramePacer::HasStalled() const
+{
+	return m_Stalled;
+}
+
+///----------------------------------------------------------------------------
+///@returns the GPU milliseconds of the last frame known to be finished (0
+///			without timer queries)
+///----------------------------------------------------------------------------
+double FramePacer::GetGPUTime() const
+{
+	return m_GPUTime;
+}
+
+///----------------------------------------------------------------------------
+///Clears the wait statistics of every slot (i.e. after the benchmark warm-up)
+///----------------------------------------------------------------------------
+void FramePacer::ResetStatistics()
+{
+	for(UINT i=0; i<m_FrameCount; i++)
+	{
+		Slot &slot = m_Slots[i];
+		slot.waits = slot.stalls = 0;
+		slot.waitTime = slot.maxWait = 0.0;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Writes how long the CPU waited on the fence of each slot
+///@param	file - output file (i.e. the benchmark report)
+///----------------------------------------------------------------------------
+void FramePacer::WriteReport(FILE *file) const
+{
+	fprintf(file, "%u frames in flight\n", m_FrameCount);
+	if(!IsValid()) return;
+
+	fprintf(file, "%-6s %8s %8s %12s %12s %12s\n", "Fence", "Waits", "Stalls",
+			"Total", "Average", "Max");
+
+	for(UINT i=0; i<m_FrameCount; i++)
+	{
+		const Slot &slot = m_Slots[i];
+		fprintf(file, "%-6u %8u %8u %10.3fms %10.3fms %10.3fms\n", i, slot.waits, slot.stalls,
+				slot.waitTime, slot.waits ? slot.waitTime / slot.waits : 0.0, slot.maxWait);
+	}
+}
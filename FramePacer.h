@@ -0,0 +1,85 @@
+///============================================================================
+///@file	FramePacer.h
+///@brief	Keeps a fixed number of frames in flight. A fence is placed after
+///			the commands of every frame and, before the CPU starts a new
+///			frame, it waits for the fence of the frame that was started
+///			that many frames ago. Every per-frame resource (a part of the
+///			upload ring, a shadow map, a set of counters) has one version
+///			per frame in flight, selected with GetFrame(), so the CPU only
+///			ever writes a version the GPU is done with. The time spent
+///			waiting on each fence is recorded, and a timer query per frame
+///			measures how long the GPU took.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <GL/gl.h>
+#include "GLExtensions.h"
+
+class FramePacer
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	FramePacer();
+	virtual ~FramePacer();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(UINT frames);
+	void Release();
+	bool IsValid() const;
+	void BeginFrame();
+	void EndFrame();
+	UINT GetFrame() const;
+	UINT GetFrameCount() const;
+	double GetWaitTime() const;
+	bool HasStalled() const;
+	double GetGPUTime() const;
+	void ResetStatistics();
+	void WriteReport(FILE *file) const;
+
+	static bool IsSupported();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_FRAMES = 4;		///> Most frames the GPU may be behind
+	static const UINT DEFAULT_FRAMES = 2;	///> Frames in flight unless told otherwise
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///Synchronization and statistics of one frame in flight
+	struct Slot
+	{
+		GLsync	fence;		///> Signaled when the frame's commands are done
+		GLuint	query;		///> GPU time of the frame (0 without timer queries)
+		bool	timed;		///> query holds a result not read yet
+		UINT	waits;		///> Times the fence was waited on
+		UINT	stalls;		///> Waits that found the fence not signaled
+		double	waitTime;	///> Total milliseconds waited
+		double	maxWait;	///> Longest wait in milliseconds
+	};
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	Slot	m_Slots[MAX_FRAMES];	///> One per frame in flight
+	UINT	m_FrameCount;			///> Frames in flight (0 until created)
+	UINT	m_Frame;				///> Slot of the current frame
+	bool	m_Timing;				///> The current frame's query is active
+	double	m_WaitTime;				///> Milliseconds the last BeginFrame waited
+	bool	m_Stalled;				///> The last BeginFrame had to wait
+	double	m_GPUTime;				///> GPU milliseconds of the last finished frame
+};
+
+#endif
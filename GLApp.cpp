@@ -7,6 +7,34 @@
 ///============================================================================
 
 #include "GLApp.h"
+#include "MeshImporter.h"
+#include "GLStateCache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//objects per job of the animation, the level of detail selection and the
+//packing of the GPU culling input
+static const UINT AnimateGrain	= 256;
+static const UINT LODGrain		= 256;
+static const UINT PackGrain		= 256;
+
+//objects per command buffer, each buffer is recorded by one job
+static const UINT RecordGrain	= 128;
+
+//per-frame upload ring: the draws of both passes and the GPU culling input
+//of every object, plus the frame matrices and the alignment padding
+static const UINT RingBytesPerObject	= 512;
+static const UINT RingBytesPerFrame		= 4096;
+
+//colors of the spot lights, repeated when there are more lights
+static const GLfloat SpotColors[][4] =
+{
+	{1.0f, 0.6f, 0.3f, 1.0f}, {0.3f, 0.6f, 1.0f, 1.0f}, {0.4f, 1.0f, 0.4f, 1.0f},
+	{1.0f, 0.4f, 0.8f, 1.0f}, {1.0f, 1.0f, 0.5f, 1.0f}, {0.6f, 0.4f, 1.0f, 1.0f}
+};
+static const UINT SpotColorCount = sizeof(SpotColors) / sizeof(SpotColors[0]);
 
 ///----------------------------------------------------------------------------
 ///Default constructor.
@@ -34,6 +62,27 @@ GLApp::GLApp(LPSTR windowTitle, USHORT width, USHORT height)
 	m_WindowTitle	= windowTitle;
 	m_Width			= width;
 	m_Height		= height;
+
+	//default options, may be changed from the command line
+	m_FontBase			= 0;
+	m_ShowStats			= false;
+	m_ExtraObjects		= 0;
+	m_OcclusionMode		= OCCLUSION_OFF;
+	m_BenchmarkFrames	= 0;
+	m_FrameCount		= 0;
+	m_ScenePath[0]		= '\0';
+	m_SaveScenePath[0]	= '\0';
+	m_ImportPath[0]		= '\0';
+	m_UploadBudget		= StreamingLoader::DEFAULT_BUDGET;
+	m_JobThreads		= -1;
+	m_AnimationAngle	= 0.0f;
+	m_SortDraws			= true;
+	m_UseMultiDraw		= false;
+	m_UseGPUCulling		= false;
+	m_FramesInFlight	= FramePacer::DEFAULT_FRAMES;
+	m_SpotLightCount	= 0;
+	m_AtlasSize			= ShadowAtlas::DEFAULT_SIZE;
+	m_PointShadowSize	= 0;
 }
 
 ///----------------------------------------------------------------------------
@@ -90,14 +139,115 @@ void GLApp::InitGraphics()
 		exit(-1);
 	}
 
+	//load the extensions we may use
+	InitExtensions();
+
+	//the state cache starts from the defaults of the new context
+	g_GLState.Reset();
+
 	//initialize the viewport
 	Reshape(m_Width, m_Height);
 
+	//the per-frame resources get one version per frame in flight
+	m_Pacer.Create(m_FramesInFlight);
+	m_Profiler.SetValue("Frames in flight", m_Pacer.GetFrameCount());
+
 	//set lights, materials & textures
 	GLfloat lightPos[3] = {-5.0, 10.0, 6.0};
 	m_Geometry.SetLights(lightPos);
 	m_Geometry.SetMaterials();
 	m_Geometry.SetShadowTexture();
+	m_Profiler.SetValue("Shadow sampler objects", m_Geometry.AreShadowSamplersUsed() ? 1.0 : 0.0);
+
+	//the spot lights share one depth texture
+	if(m_SpotLightCount) m_ShadowAtlas.Create(m_AtlasSize);
+	m_Profiler.SetValue("Shadow atlas (KB)", m_ShadowAtlas.GetTextureBytes() / 1024.0);
+	m_Profiler.SetValue("Shadow atlas FBO", m_ShadowAtlas.IsRenderedDirectly() ? 1.0 : 0.0);
+
+	//the atlas updates are timed on the GPU once the pacer knows a frame
+	//is done
+	if(m_ShadowAtlas.IsValid()) m_ShadowScheduler.Create(m_Pacer.GetFrameCount());
+	m_Profiler.SetValue("Shadow update budget (ms)", m_ShadowScheduler.GetBudget());
+
+	//create the objects in the scene and the hierarchy used to cull them
+	double start = Profiler::GetTime();
+	bool loaded = m_ScenePath[0] && m_Geometry.LoadScene(m_ScenePath);
+	if(!loaded) m_Geometry.CreateScene(m_ExtraObjects);
+	m_Profiler.SetValue("Scene creation (ms)", Profiler::GetTime() - start);
+	m_Profiler.SetValue("Scene loaded from file", loaded ? 1.0 : 0.0);
+
+	//the imported model is loaded in the background and shows up when
+	//it's uploaded, the benchmark and the saved scene wait for it
+	if(m_ImportPath[0])
+	{
+		m_Loader.Start(&m_Geometry);
+		m_Loader.Load(m_ImportPath);
+		m_Profiler.SetValue("Loader threads", m_Loader.GetWorkerCount());
+
+		//the uploads are staged in a ring guarded by the frame fences
+		bool staging = m_Pacer.IsValid() && m_Loader.CreateStaging(m_UploadBudget, m_Pacer.GetFrameCount());
+		m_Profiler.SetValue("Loader staging ring", staging ? 1.0 : 0.0);
+
+		if(m_BenchmarkFrames || m_SaveScenePath[0])
+		{
+			m_Loader.Flush();
+			AddLoadedMeshes();
+		}
+	}
+
+	if(m_SaveScenePath[0]) m_Geometry.SaveScene(m_SaveScenePath);
+	m_Profiler.SetValue("Mesh memory (KB)", m_Geometry.GetMeshBytes() / 1024.0);
+
+	//the per-frame data of the GPU-driven paths is written to the ring
+	if(m_UseMultiDraw && m_Pacer.IsValid())
+	{
+		m_UploadRing.Create(m_Geometry.GetObjectCount() * RingBytesPerObject + RingBytesPerFrame,
+							m_Pacer.GetFrameCount());
+	}
+	m_Profiler.SetValue("Upload ring", m_UploadRing.IsValid() ? 1.0 : 0.0);
+	m_Profiler.SetValue("Upload ring (KB)", m_UploadRing.GetBufferBytes() / 1024.0);
+
+	//the shared buffers hold a copy of every mesh
+	if(m_UseMultiDraw) m_MultiDraw.Create(m_Geometry, &m_UploadRing);
+	m_Profiler.SetValue("Multi-draw indirect", m_MultiDraw.IsValid() ? 1.0 : 0.0);
+	m_Profiler.SetValue("Multi-draw buffers (KB)", m_MultiDraw.GetBufferBytes() / 1024.0);
+
+	//the GPU culling writes the commands of the shared buffers
+	if(m_UseGPUCulling) m_GPUCulling.Create(m_Geometry, m_MultiDraw, &m_UploadRing);
+	m_Profiler.SetValue("GPU culling", m_GPUCulling.IsValid() ? 1.0 : 0.0);
+	m_Profiler.SetValue("GPU culling buffers (KB)", m_GPUCulling.GetBufferBytes() / 1024.0);
+
+	//the main light shadows every direction from a cube map, the multi-draw
+	//shaders only know the 2D shadow map
+	if(m_PointShadowSize && !m_UseMultiDraw && m_Geometry.CreatePointShadowShader() &&
+	   m_PointShadow.Create(m_PointShadowSize))
+	{
+		m_PointShadow.SetLight(lightPos, 1.0f, 100.0f);
+	}
+	m_Profiler.SetValue("Point light shadow", m_PointShadow.IsValid() ? 1.0 : 0.0);
+	m_Profiler.SetValue("Point light shadow (KB)", m_PointShadow.GetTextureBytes() / 1024.0);
+
+	start = Profiler::GetTime();
+	m_Geometry.BuildBVH();
+	m_Profiler.SetValue("BVH build (ms)", Profiler::GetTime() - start);
+	m_Profiler.SetValue("Objects", m_Geometry.GetObjectCount());
+	m_Profiler.SetValue("Animated objects", m_Geometry.GetAnimatedCount());
+	m_Profiler.SetValue("BVH nodes", m_Geometry.GetBVH().GetNodeCount());
+
+	//hardware occlusion culling is only available with queries
+	if(!m_Occlusion.Init(m_Geometry.GetObjectCount()) && m_OcclusionMode == OCCLUSION_HARDWARE)
+		m_OcclusionMode = OCCLUSION_OFF;
+
+	if(!m_SoftOcclusion.Init(&m_Profiler) && m_OcclusionMode == OCCLUSION_SOFTWARE)
+		m_OcclusionMode = OCCLUSION_OFF;
+	m_Profiler.SetValue("SW occlusion threads", m_SoftOcclusion.GetWorkerCount());
+
+	//the GPU culling tests the camera pass against its own depth pyramid
+	if(m_GPUCulling.IsValid()) m_OcclusionMode = OCCLUSION_OFF;
+
+	//the frame stages run on the render thread and these workers
+	m_Jobs.Start(m_JobThreads < 0 ? JobSystem::GetDefaultThreadCount() : m_JobThreads, &m_Profiler);
+	m_Profiler.SetValue("Job threads", m_Jobs.GetThreadCount());
 
 	//set camera position
 	GLfloat cameraPos[3] = {5.0, 5.0, 5.0};
@@ -130,18 +280,171 @@ void GLApp::InitGraphics()
 	}
 	glPopMatrix();
 
+	CreateSpotLights();
+
+	//create bitmap font glyphs for the on-screen statistics
+	m_FontBase = glGenLists(96);
+	wglUseFontBitmaps(m_hDC, 32, 96, m_FontBase);
+
 	//enable needed states
-    glEnable(GL_DEPTH_TEST);
+	g_GLState.Enable(GL_DEPTH_TEST);
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 }
 
 ///----------------------------------------------------------------------------
-///Clean up resources.
+///Reads the demo options from the command line:
+///	-objects N		adds N objects around the base plate
+///	-benchmark [N]	renders N frames as fast as possible, writes the
+///					timings to benchmark.txt and quits
+///	-occlusion		starts with hardware occlusion culling enabled
+///	-softocclusion	starts with software occlusion culling enabled
+///	-nolod			always draws the finest level of detail
+///	-quantizeshadow	stores the shadow pass positions as 16 bit integers
+///	-nomeshopt		keeps the meshes in the generated order
+///	-quantize [N]	draws the camera passes from N bit quantized vertices
+///					(8 or 16, the default) and 16 bit indices
+///	-scene file		loads the scene from a scene file instead of generating it
+///	-savescene file	writes the scene to a scene file at start-up
+///	-import file	adds an OBJ or PLY model to the scene, loaded in the
+///					background
+///	-uploadbudget N	uploads at most N KB per frame of a loaded model
+///	-jobs N			runs the frame stages on N worker threads besides the
+///					render thread (one per core by default, 0 for none)
+///	-nosort			draws in culling order instead of sorting by state
+///	-nosamplers		sets the shadow comparison on the texture every pass
+///					instead of binding sampler objects
+///	-multidraw		draws each pass with one multi-draw indirect call from
+///					shared vertex and index buffers (float vertices only)
+///	-gpucull		culls both passes and selects their levels of detail in a
+///					compute shader, with occlusion against the previous
+///					frame's depth (implies -multidraw)
+///	-framesinflight N	lets the GPU be up to N frames behind the CPU (1 to 4,
+///					2 by default)
+///	-spotlights [N]	adds N shadowed spot lights around the scene (6 if N
+///					is omitted, none without the option)
+///	-shadowatlas N	size in texels of the shadow atlas of the spot lights
+///					(2048 by default)
+///	-shadowbudget N	spends about N ms per frame redrawing the spot lights'
+///					shadows that changed (1 by default, 0 redraws every
+///					shadow every frame)
+///	-pointshadow [N]	shadows the main light in every direction from a depth
+///					cube map of N texels per face (512 by default) drawn in
+///					one layered pass, instead of its 45 degree shadow map
+///@param	cmdLine - the command line (without the program name)
 ///----------------------------------------------------------------------------
-bool GLApp::ShutDown()
+void GLApp::ParseCommandLine(LPCTSTR cmdLine)
+{
+	LPCTSTR option;
+
+	if((option = strstr(cmdLine, "-objects")) != NULL)
+		m_ExtraObjects = atoi(option + strlen("-objects"));
+
+	if((option = strstr(cmdLine, "-benchmark")) != NULL)
+	{
+		m_BenchmarkFrames = atoi(option + strlen("-benchmark"));
+		if(m_BenchmarkFrames == 0) m_BenchmarkFrames = BENCHMARK_FRAMES;
+		m_BenchmarkFrames += BENCHMARK_WARMUP;
+	}
+
+	if(strstr(cmdLine, "-occlusion") != NULL)
+		m_OcclusionMode = OCCLUSION_HARDWARE;
+
+	if(strstr(cmdLine, "-softocclusion") != NULL)
+		m_OcclusionMode = OCCLUSION_SOFTWARE;
+
+	if(strstr(cmdLine, "-nolod") != NULL)
+		m_Geometry.SetLODEnabled(false);
+
+	if(strstr(cmdLine, "-quantizeshadow") != NULL)
+		m_Geometry.SetShadowPositionsQuantized(true);
+
+	if(strstr(cmdLine, "-nomeshopt") != NULL)
+		m_Geometry.SetMeshOptimization(false);
+
+	if((option = strstr(cmdLine, "-scene")) != NULL)
+		sscanf(option + strlen("-scene"), " %259s", m_ScenePath);
+
+	if((option = strstr(cmdLine, "-savescene")) != NULL)
+		sscanf(option + strlen("-savescene"), " %259s", m_SaveScenePath);
+
+	if((option = strstr(cmdLine, "-import")) != NULL)
+		sscanf(option + strlen("-import"), " %259s", m_ImportPath);
+
+	if((option = strstr(cmdLine, "-uploadbudget")) != NULL)
+		m_UploadBudget = atoi(option + strlen("-uploadbudget")) * 1024;
+
+	if((option = strstr(cmdLine, "-jobs")) != NULL)
+		m_JobThreads = atoi(option + strlen("-jobs"));
+
+	if(strstr(cmdLine, "-nosort") != NULL)
+		m_SortDraws = false;
+
+	if(strstr(cmdLine, "-nosamplers") != NULL)
+		m_Geometry.SetShadowSamplersEnabled(false);
+
+	if(strstr(cmdLine, "-multidraw") != NULL)
+		m_UseMultiDraw = true;
+
+	if(strstr(cmdLine, "-gpucull") != NULL)
+		m_UseGPUCulling = m_UseMultiDraw = true;
+
+	if((option = strstr(cmdLine, "-framesinflight")) != NULL)
+		m_FramesInFlight = atoi(option + strlen("-framesinflight"));
+
+	if((option = strstr(cmdLine, "-spotlights")) != NULL)
+	{
+		m_SpotLightCount = atoi(option + strlen("-spotlights"));
+		if(m_SpotLightCount == 0) m_SpotLightCount = DEFAULT_SPOT_LIGHTS;
+	}
+
+	if((option = strstr(cmdLine, "-shadowatlas")) != NULL)
+		m_AtlasSize = atoi(option + strlen("-shadowatlas"));
+
+	if((option = strstr(cmdLine, "-shadowbudget")) != NULL)
+		m_ShadowScheduler.SetBudget(atof(option + strlen("-shadowbudget")));
+
+	if((option = strstr(cmdLine, "-pointshadow")) != NULL)
+	{
+		m_PointShadowSize = atoi(option + strlen("-pointshadow"));
+		if(m_PointShadowSize == 0) m_PointShadowSize = PointShadowMap::DEFAULT_SIZE;
+	}
+
+	//-quantizeshadow also starts with -quantize, skip it
+	option = cmdLine;
+	while((option = strstr(option, "-quantize")) != NULL)
+	{
+		option += strlen("-quantize");
+		if(strncmp(option, "shadow", strlen("shadow")) == 0) continue;
+
+		m_Geometry.SetVertexFormat(atoi(option) == 8 ? Mesh::QUANTIZED_8 : Mesh::QUANTIZED_16);
+		break;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Releases the GL objects and the rendering context, called by the thread
+///that owns the context.
+///----------------------------------------------------------------------------
+void GLApp::ReleaseGraphics()
 {
 	if(m_hRC)
 	{
+		//release the query objects while the context is still alive
+		m_Loader.Stop();
+		m_Jobs.Stop();
+		m_Occlusion.Shutdown();
+		m_SoftOcclusion.Shutdown();
+		m_GPUCulling.Release();
+		m_MultiDraw.Release();
+		m_UploadRing.Release();
+		m_Graph.Release();
+		m_ShadowScheduler.Release();
+		m_ShadowAtlas.Release();
+		m_PointShadow.Release();
+		m_Pacer.Release();
+		m_Geometry.ReleaseShadowTexture();
+		m_Geometry.Release();
+
 		//make current rendering context NULL 
 		wglMakeCurrent(NULL, NULL);
 		
@@ -149,9 +452,21 @@ bool GLApp::ShutDown()
 		wglDeleteContext(m_hRC);	
 	}
 
-	//release the device context
+	//release the device context (same thread that got it)
 	if(m_hWnd && m_hDC) ReleaseDC(m_hWnd, m_hDC);
 
+	m_hDC = NULL;
+	m_hRC = NULL;
+}
+
+///----------------------------------------------------------------------------
+///Clean up resources.
+///----------------------------------------------------------------------------
+bool GLApp::ShutDown()
+{
+	//normally done by the render thread when it finishes
+	if(m_hRC) ReleaseGraphics();
+
 	//destroy window explicitly
 	if(m_hWnd) DestroyWindow(m_hWnd);
 
@@ -164,7 +479,9 @@ bool GLApp::ShutDown()
 }
 
 ///----------------------------------------------------------------------------
-///This function handles messages for the GLApp object
+///This function handles messages for the GLApp object. It runs on the
+///message pump thread, anything that touches the scene or the GL context
+///is forwarded to the render thread.
 ///@param	hWnd - handle to window
 ///@param	Msg - the message sent
 ///@param	wParam - message parameter
@@ -172,8 +489,6 @@ bool GLApp::ShutDown()
 ///----------------------------------------------------------------------------
 LRESULT GLApp::DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 {
-	GLfloat CameraPos[3];
-
 	switch(Msg)
 	{
 		case WM_CREATE:
@@ -187,16 +502,39 @@ LRESULT GLApp::DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 			PostQuitMessage(0);
 			break;
 
+		case WM_SIZE:
+		case WM_CHAR:
+			PostEvent(Msg, wParam, lParam);
+			break;
+
+		default:
+			return DefWindowProc(hWnd, Msg, wParam, lParam);
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Handles the window messages forwarded by DisplayWndProc, called by the
+///render thread between frames
+///@param	event - the message
+///----------------------------------------------------------------------------
+void GLApp::HandleEvent(const WindowEvent &event)
+{
+	m_Profiler.AddCount("Window events", 1);
+
+	switch(event.message)
+	{
 		case WM_SIZE:
 			//store new viewport sizes
-			m_Width  = LOWORD(lParam);
-			m_Height = HIWORD(lParam);
+			m_Width  = LOWORD(event.lParam);
+			m_Height = HIWORD(event.lParam);
 
-			Reshape(LOWORD(lParam), HIWORD(lParam));
+			Reshape(m_Width, m_Height);
 			break;
 
 		case WM_CHAR:
-			switch(wParam)
+			switch(event.wParam)
 			{
 				case '+':
 					Zoom(-0.1);
@@ -205,14 +543,29 @@ LRESULT GLApp::DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 				case '-':
 					Zoom(0.1);
 					break;
+
+				case 's':
+					m_ShowStats = !m_ShowStats;
+					break;
+
+				case 'o':
+					//the GPU culling does its own occlusion test
+					if(m_GPUCulling.IsValid()) break;
+
+					//cycle off, hardware (if supported) and software
+					m_OcclusionMode = (OcclusionMode)((m_OcclusionMode + 1) % 3);
+					if(m_OcclusionMode == OCCLUSION_HARDWARE && !g_GLCaps.occlusionQuery)
+						m_OcclusionMode = OCCLUSION_SOFTWARE;
+					if(m_OcclusionMode == OCCLUSION_SOFTWARE && !m_SoftOcclusion.GetWorkerCount())
+						m_OcclusionMode = OCCLUSION_OFF;
+					break;
+
+				case 'l':
+					m_Geometry.SetLODEnabled(!m_Geometry.IsLODEnabled());
+					break;
 			}
 			break;
-
-		default:
-			return DefWindowProc(hWnd, Msg, wParam, lParam);
 	}
-
-	return 0;
 }
 
 ///----------------------------------------------------------------------------
@@ -220,20 +573,201 @@ LRESULT GLApp::DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam)
 ///----------------------------------------------------------------------------
 void GLApp::RenderText(LPTSTR text)
 {
+	if(!m_FontBase || !text) return;
+
+	glPushAttrib(GL_CURRENT_BIT | GL_LIST_BIT);
+	g_GLState.Push();
+	g_GLState.Disable(GL_LIGHTING);
+	g_GLState.Disable(GL_TEXTURE_2D);
+	g_GLState.Disable(GL_DEPTH_TEST);
+	g_GLState.Disable(GL_ALPHA_TEST);
+
+	//use window coordinates
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, m_Width, 0, m_Height);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glColor3f(1.0f, 1.0f, 1.0f);
+	glListBase(m_FontBase - 32);
+
+	//draw one line at a time from the top of the window
+	GLint y = m_Height - 16;
+	while(*text)
+	{
+		LPTSTR end = text;
+		while(*end && *end != '\n') end++;
+
+		glRasterPos2i(8, y);
+		glCallLists((GLsizei)(end - text), GL_UNSIGNED_BYTE, text);
+		y -= 16;
+
+		text = *end ? end + 1 : end;
+	}
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	g_GLState.Pop();
+	glPopAttrib();
+}
+
+///----------------------------------------------------------------------------
+///Draws the frame rate and culling statistics on screen
+///----------------------------------------------------------------------------
+void GLApp::RenderStats()
+{
+	static LPCSTR OcclusionNames[3] = {"off", "hardware", "software"};
+	TCHAR text[1024];
+
+	//the GPU culling counts are the last finished frame's
+	bool gpu = m_GPUCulling.IsValid();
+	UINT cameraObjects = gpu ? m_GPUCulling.GetDrawCount(CAMERA_PASS) : (UINT)m_CameraObjects.size();
+	UINT shadowObjects = gpu ? m_GPUCulling.GetDrawCount(SHADOW_PASS) : (UINT)m_ShadowObjects.size();
+
+	sprintf(text,
+			"%lu FPS\n"
+			"Objects: %u  camera: %u  shadow casters: %u\n"
+			"BVH refit: %.3f ms (%u nodes)\n"
+			"Culling: %.3f ms\n"
+			"Occlusion culling: %s  occluded: %u  queries: %u  occluders: %u\n"
+			"LOD: %s  triangles camera: %.0f  shadow: %.0f\n"
+			"Vertex data camera: %.0f KB  shadow: %.0f KB  (%s vertices)\n"
+			"Frames in flight: %u  fence wait: %.3f ms  GPU: %.3f ms\n"
+			"Render graph: %u passes  culled: %u  transient: %.0f KB  aliased: %.0f KB\n"
+			"Spot lights: %u  shadowed: %u  atlas: %.0f%% used  repacks: %u\n"
+			"Shadow updates: %u  cached: %u  skipped: %u  stalest: %u frames  %.3f ms\n"
+			"Point light shadow: %s  face casters: %u  groups: %u",
+			m_Timer.GetFrameRate(),
+			m_Geometry.GetObjectCount(),
+			cameraObjects,
+			shadowObjects,
+			m_Profiler.GetLastFrame("BVH refit"),
+			m_Geometry.GetBVH().GetRefitNodeCount(),
+			m_Profiler.GetLastFrame("Cull camera") + m_Profiler.GetLastFrame("Cull shadow casters"),
+			gpu ? "GPU Hi-Z" : OcclusionNames[m_OcclusionMode],
+			m_OcclusionMode == OCCLUSION_HARDWARE ? m_Occlusion.GetOccludedCount() :
+			m_OcclusionMode == OCCLUSION_SOFTWARE ? m_SoftOcclusion.GetCulledCount() : 0,
+			m_OcclusionMode == OCCLUSION_HARDWARE ? m_Occlusion.GetQueryCount() : 0,
+			m_OcclusionMode == OCCLUSION_SOFTWARE ? m_SoftOcclusion.GetOccluderCount() : 0,
+			m_Geometry.IsLODEnabled() ? "on" : "off",
+			m_Profiler.GetLastFrame("Camera triangles"),
+			m_Profiler.GetLastFrame("Shadow triangles"),
+			m_Profiler.GetLastFrame("Camera vertex KB"),
+			m_Profiler.GetLastFrame("Shadow vertex KB"),
+			m_Geometry.GetVertexFormat() == Mesh::FLOAT_VERTEX ? "float" :
+			m_Geometry.GetVertexFormat() == Mesh::QUANTIZED_8 ? "8 bit" : "16 bit",
+			m_Pacer.GetFrameCount(),
+			m_Pacer.GetWaitTime(),
+			m_Pacer.GetGPUTime(),
+			m_Graph.GetPassCount() - m_Graph.GetCulledCount(),
+			m_Graph.GetCulledCount(),
+			m_Graph.GetTransientBytes() / 1024.0,
+			m_Graph.GetAllocatedBytes() / 1024.0,
+			(UINT)m_SpotLights.size(),
+			m_ShadowAtlas.GetTileCount(),
+			m_ShadowAtlas.IsValid() ? 100.0 * m_ShadowAtlas.GetUsedArea() /
+			((double)m_ShadowAtlas.GetSize() * m_ShadowAtlas.GetSize()) : 0.0,
+			m_ShadowAtlas.GetRepackCount(),
+			m_ShadowScheduler.GetUpdateCount(),
+			m_ShadowScheduler.GetCachedCount(),
+			m_ShadowScheduler.GetSkippedCount(),
+			m_ShadowScheduler.GetMaxStaleness(),
+			m_ShadowScheduler.GetMeasuredTime(),
+			m_PointShadow.IsValid() ? "cube map" : "off",
+			m_PointShadow.GetFaceCasterCount(),
+			m_PointShadow.GetGroupCount());
+
+	RenderText(text);
+}
+
+///----------------------------------------------------------------------------
+///Writes the benchmark results to benchmark.txt
+///----------------------------------------------------------------------------
+void GLApp::WriteBenchmark()
+{
+	//measure CPU ray queries: rays from the light towards a grid on the ground
+	GLfloat lightPos[3];
+	m_Geometry.GetLightPosition(lightPos);
+
+	UINT rays = 0, hits = 0;
+	double start = Profiler::GetTime();
+	for(int i=0; i<32; i++)
+	{
+		for(int j=0; j<32; j++)
+		{
+			GLfloat dir[3];
+			dir[0] = -50.0f + 100.0f * i / 31.0f - lightPos[0];
+			dir[1] = -lightPos[1];
+			dir[2] = -50.0f + 100.0f * j / 31.0f - lightPos[2];
+
+			UINT object;
+			GLfloat t;
+			if(m_Geometry.Raycast(lightPos, dir, 1.0f, &object, &t)) hits++;
+			rays++;
+		}
+	}
+	double elapsed = Profiler::GetTime() - start;
+	m_Profiler.SetValue("BVH raycast (us/ray)", 1000.0 * elapsed / rays);
+	m_Profiler.SetValue("BVH raycast hits", hits);
+
+	//import speed on a single thread, to compare with the parallel import
+	if(m_ImportPath[0])
+	{
+		MeshImporter importer;
+		Mesh mesh;
+		if(importer.Import(m_ImportPath, mesh, 1))
+			m_Profiler.SetValue("Import 1 thread (MB/s)", importer.GetThroughput());
+	}
+
+	FILE *file = fopen("benchmark.txt", "w");
+	if(!file) return;
+
+	fprintf(file, "ShadowMappingGL benchmark\n");
+	fprintf(file, "%ux%u window, %u extra objects\n\n", m_Width, m_Height, m_ExtraObjects);
+	m_Profiler.Report(file);
+
+	fprintf(file, "\n");
+	m_Pacer.WriteReport(file);
+
+	fprintf(file, "\n");
+	m_Graph.WriteReport(file);
+
+	if(m_ShadowAtlas.IsValid())
+	{
+		fprintf(file, "\n");
+		m_ShadowAtlas.WriteReport(file);
+
+		fprintf(file, "\n");
+		m_ShadowScheduler.WriteReport(file);
+	}
+
+	fprintf(file, "\n");
+	m_Geometry.WriteMeshReport(file);
+	m_Geometry.BenchmarkFormats(file);
+
+	fclose(file);
 }
 
 ///----------------------------------------------------------------------------
 ///Creates the shadow map texture based on light's point of view.
+///@param	texture - depth texture of the window's size the depth is copied
+///			to (a transient texture of the render graph)
 ///----------------------------------------------------------------------------
-void GLApp::CreateShadowMap(GLfloat angle)
+void GLApp::CreateShadowMap(GLuint texture)
 {
 	//clear the depth and color buffers
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	//disable lighting and textures
-	glShadeModel(GL_FLAT);
-	glDisable(GL_LIGHTING);
-	glDisable(GL_TEXTURE_2D);
+	g_GLState.ShadeModel(GL_FLAT);
+	g_GLState.Disable(GL_LIGHTING);
+	g_GLState.Disable(GL_TEXTURE_2D);
 
 	//render from light's point of view
 	glMatrixMode(GL_PROJECTION);
@@ -244,19 +778,19 @@ void GLApp::CreateShadowMap(GLfloat angle)
 		glPushMatrix();
 		{
 			//disable writing on frame-buffer color components
-			glColorMask(0,0,0,0);
+			g_GLState.ColorMask(0,0,0,0);
 
 			//TODO comment this line... avoid z-fighting
-			glEnable(GL_POLYGON_OFFSET_FILL);
-			glPolygonOffset(1.0, 4.0);
+			g_GLState.Enable(GL_POLYGON_OFFSET_FILL);
+			g_GLState.PolygonOffset(1.0, 4.0);
 			
 			glLoadMatrixd(m_LightViewMatrix);
-			m_Geometry.Draw(angle);
+			ExecuteCommands(SHADOW_PASS);
 			
-			glDisable(GL_POLYGON_OFFSET_FILL);
+			g_GLState.Disable(GL_POLYGON_OFFSET_FILL);
 
 			//restore color component writing
-			glColorMask(1,1,1,1);
+			g_GLState.ColorMask(1,1,1,1);
 		}
 		glPopMatrix();
 	
@@ -265,23 +799,59 @@ void GLApp::CreateShadowMap(GLfloat angle)
 	glPopMatrix();
 
 	//subsequent calls to glBindTexture activates the texture object
-	glBindTexture(GL_TEXTURE_2D, m_Geometry.GetShadowTexObj());
-
-	//Copy the depth buffer into the depth map texture object
-	glCopyTexImage2D(GL_TEXTURE_2D,			//target, must be GL_TEXTURE_2D
-					 0,						//LOD number, 0 is the base
-					 GL_DEPTH_COMPONENT,	//Internal format for texture data
-					 0,						//The window coordinates of the lower-left corner
-					 0,						//of the rectangular region of pixels to be copied
-					 m_Width,				//width of texture image (must be power of 2)
-					 m_Height,				//height of texture image (must be power of 2)
-					 0);					//border width
+	g_GLState.BindTexture(GL_TEXTURE_2D, texture);
+
+	//Copy the depth buffer into the depth map texture object (the graph
+	//already specified its image, so only the texels are replaced)
+	glCopyTexSubImage2D(GL_TEXTURE_2D,		//target, must be GL_TEXTURE_2D
+						0,					//LOD number, 0 is the base
+						0,					//offset of the copy in the texture
+						0,
+						0,					//The window coordinates of the lower-left corner
+						0,					//of the rectangular region of pixels to be copied
+						m_Width,			//width of the region
+						m_Height);			//height of the region
+
+	//restore render states
+	g_GLState.CullFace(GL_BACK);
+	g_GLState.ShadeModel(GL_SMOOTH);
+	g_GLState.Enable(GL_LIGHTING);
+	g_GLState.Enable(GL_TEXTURE_2D);
+}
+
+///----------------------------------------------------------------------------
+///Draws the main light's depth cube map, the six faces in one layered pass,
+///with the same state CreateShadowMap uses
+///----------------------------------------------------------------------------
+void GLApp::RenderPointShadow()
+{
+	DrawStats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	//disable lighting and textures
+	g_GLState.ShadeModel(GL_FLAT);
+	g_GLState.Disable(GL_LIGHTING);
+	g_GLState.Disable(GL_TEXTURE_2D);
+
+	//depth only, with the same offset against z-fighting
+	g_GLState.ColorMask(0,0,0,0);
+	g_GLState.Enable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.PolygonOffset(1.0, 4.0);
+
+	m_PointShadow.Render(m_Geometry, &stats);
+
+	g_GLState.Disable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.ColorMask(1,1,1,1);
 
 	//restore render states
-	glCullFace(GL_BACK);
-	glShadeModel(GL_SMOOTH);
-	glEnable(GL_LIGHTING);
-	glEnable(GL_TEXTURE_2D);
+	glViewport(0,0, m_Width, m_Height);
+	g_GLState.CullFace(GL_BACK);
+	g_GLState.ShadeModel(GL_SMOOTH);
+	g_GLState.Enable(GL_LIGHTING);
+	g_GLState.Enable(GL_TEXTURE_2D);
+
+	m_Profiler.AddCount("Shadow draws", stats.draws);
+	m_Profiler.AddCount("Shadow mesh changes", stats.meshChanges);
 }
 
 ///----------------------------------------------------------------------------
@@ -293,9 +863,15 @@ void GLApp::CreateShadowMap(GLfloat angle)
 ///		 V = Light's position modelview matrix
 ///		 Ci= Camera's "Inverse" view matrix
 ///The tricky part is to compute the inverse camera view matrix but OpenGL
-///will do that for us when the eye planes are specified
+///will do that for us when the eye planes are specified (the model-view
+///must hold the camera view when this is called)
+///@param	projection - light's projection matrix
+///@param	view - light's model-view matrix
+///@param	tile - offset x, offset y and scale of the light's tile in the
+///			shadow atlas (NULL if the shadow map is a whole texture)
 ///----------------------------------------------------------------------------
-void GLApp::CreateTextureMatrix()
+void GLApp::CreateTextureMatrix(const GLdouble projection[16], const GLdouble view[16],
+								const GLdouble *tile)
 {
 	GLdouble tmpMatrix[16];
 
@@ -303,10 +879,15 @@ void GLApp::CreateTextureMatrix()
 	glPushMatrix();
 	{
 		glLoadIdentity();
+		if(tile)
+		{
+			glTranslated(tile[0], tile[1], 0.0);
+			glScaled(tile[2], tile[2], 1.0);
+		}
 		glTranslated(0.5, 0.5, 0.5);
 		glScaled(0.5, 0.5, 0.5);
-		glMultMatrixd(m_LightProjectionMatrix);
-		glMultMatrixd(m_LightViewMatrix);
+		glMultMatrixd(projection);
+		glMultMatrixd(view);
 		glGetDoublev(GL_TEXTURE_MATRIX, tmpMatrix);
 	}
 	glPopMatrix();
@@ -323,59 +904,1180 @@ void GLApp::CreateTextureMatrix()
 }
 
 ///----------------------------------------------------------------------------
-///Overriden Render function (draws the scene).
+///The cube shadow map is looked up with the direction from the light, which
+///the camera passes compute from the world position. The eye planes are
+///specified under the camera view, OpenGL applies its inverse and the
+///texture coordinates come out in world space.
 ///----------------------------------------------------------------------------
-void GLApp::Render()
+void GLApp::CreatePointTextureMatrix()
 {
-	static GLfloat angle = 0.0;
+	static const GLdouble Identity[16] = {1.0, 0.0, 0.0, 0.0,
+										  0.0, 1.0, 0.0, 0.0,
+										  0.0, 0.0, 1.0, 0.0,
+										  0.0, 0.0, 0.0, 1.0};
 
-	//lock the framerate to 60 FPS
-	m_Timer.Tick(60.0f);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadMatrixd(m_CameraViewMatrix);
 
-	//update the angle for animation
-	angle += 50.0f * m_Timer.GetTimeElapsed();
+	glTexGendv(GL_S, GL_EYE_PLANE, &Identity[0]);
+	glTexGendv(GL_T, GL_EYE_PLANE, &Identity[4]);
+	glTexGendv(GL_R, GL_EYE_PLANE, &Identity[8]);
+	glTexGendv(GL_Q, GL_EYE_PLANE, &Identity[12]);
 
-	//1st pass, create shadow map & texture coordinates
-	CreateShadowMap(angle);
-	CreateTextureMatrix();
+	glPopMatrix();
+}
 
-	//2nd pass, render from camera point of view
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glViewport(0,0, m_Width, m_Height);
+///----------------------------------------------------------------------------
+///Writes the camera and light matrices of the frame for the multi-draw
+///shaders. The shadow matrix is the texture matrix of CreateTextureMatrix
+///without the inverse camera view, the shaders start from world space.
+///----------------------------------------------------------------------------
+void GLApp::UploadFrameData()
+{
+	Matrix4 projection, view, viewProjection, shadow;
+	MultiDraw::FrameData frame;
+
+	projection.Set(m_CameraProjectionMatrix);
+	view.Set(m_CameraViewMatrix);
+	Matrix4::Multiply(projection, view, viewProjection);
+	memcpy(frame.cameraView, view.m, sizeof(frame.cameraView));
+	memcpy(frame.cameraViewProjection, viewProjection.m, sizeof(frame.cameraViewProjection));
+
+	projection.Set(m_LightProjectionMatrix);
+	view.Set(m_LightViewMatrix);
+	Matrix4::Multiply(projection, view, viewProjection);
+	memcpy(frame.lightViewProjection, viewProjection.m, sizeof(frame.lightViewProjection));
+
+	shadow.Translate(0.5f, 0.5f, 0.5f);
+	shadow.Scale(0.5f, 0.5f, 0.5f);
+	shadow.Multiply(viewProjection);
+	memcpy(frame.shadowMatrix, shadow.m, sizeof(frame.shadowMatrix));
+
+	m_MultiDraw.SetFrame(frame);
+}
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixd(m_CameraProjectionMatrix);
+///----------------------------------------------------------------------------
+///Finishes the camera draws: waits for the software occlusion, selects the
+///levels of detail of what survived culling and records the draws both
+///camera passes replay
+///----------------------------------------------------------------------------
+void GLApp::PrepareCameraCommands()
+{
+	if(m_OcclusionMode == OCCLUSION_SOFTWARE)
+	{
+		{
+			ProfileScope sample(m_Profiler, "SW occlusion wait");
+			m_SoftOcclusion.Wait();
+		}
+
+		ProfileScope sample(m_Profiler, "SW occlusion test");
+		m_SoftOcclusion.Cull(m_Geometry, m_CameraObjects);
+		m_Profiler.AddCount("Objects occluded", m_SoftOcclusion.GetCulledCount());
+		m_Profiler.AddCount("SW occluders", m_SoftOcclusion.GetOccluderCount());
+	}
+
+	if(m_GPUCulling.IsValid())
+		m_Profiler.AddCount("Camera objects drawn", m_GPUCulling.GetDrawCount(CAMERA_PASS));
+	else
+		m_Profiler.AddCount("Camera objects drawn", m_OcclusionMode == OCCLUSION_HARDWARE ?
+							(double)m_Occlusion.GetDrawnCount() : (double)m_CameraObjects.size());
+
+	//level of detail of what survived culling, by size in pixels (the GPU
+	//culling selected them already)
+	if(m_GPUCulling.IsValid()) return;
+
+	LODSelection camera;
+	camera.pass = CAMERA_PASS;
+	camera.objects = &m_CameraObjects;
+	camera.pixelsPerUnit = (GLfloat)m_CameraProjectionMatrix[5] * m_Height * 0.5f;
+	m_Geometry.GetCameraPosition(camera.eye);
+
+	//the workers record the draws once the levels are known, both
+	//camera passes replay the same commands
+	JobSystem::Counter selected = 0, recorded = 0;
+	SelectLOD(camera, &selected);
+	RecordCommands(CAMERA_PASS, m_OcclusionMode == OCCLUSION_HARDWARE ?
+				   m_Occlusion.GetDrawn() : m_CameraObjects, &recorded, &selected);
+
+	m_ConditionalCommands.Reset();
+	m_Jobs.Wait(&selected);
+	if(m_OcclusionMode == OCCLUSION_HARDWARE)
+		m_Occlusion.RecordConditional(m_Geometry, m_ConditionalCommands);
+	m_Jobs.Wait(&recorded);
+
+	m_Profiler.AddCount("Camera triangles", camera.triangles);
+	m_Profiler.AddCount("Camera vertex KB", camera.bytes / 1024.0);
+}
+
+///----------------------------------------------------------------------------
+///Draws one of the camera passes with the shadow map. The lit pass goes
+///first and starts the frame's color and depth, the shadowed pass draws
+///the fragments the lit one rejected.
+///@param	shadowMap - the shadow map of the frame
+///@param	test - which fragments the pass draws
+///----------------------------------------------------------------------------
+void GLApp::RenderCamera(GLuint shadowMap, Geometry::ShadowTest test)
+{
+	if(test == Geometry::SHADOW_TEST_LIT)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0,0, m_Width, m_Height);
+
+		glMatrixMode(GL_PROJECTION);
+		glLoadMatrixd(m_CameraProjectionMatrix);
+
+		glMatrixMode(GL_MODELVIEW);
+		glLoadMatrixd(m_CameraViewMatrix);
+
+		g_GLState.Enable(GL_ALPHA_TEST);
+		g_GLState.AlphaFunc(GL_GREATER, 0.0);
+	}
+
+	//lit: depth comparison should be true if r<texture, shadowed: do the
+	//contrary, true if r >= texture
+	if(m_PointShadow.IsValid())
+	{
+		m_Geometry.BindPointShadowMap(shadowMap, test, m_PointShadow.GetLightPosition(),
+									  m_PointShadow.GetNear(), m_PointShadow.GetFar());
+	}
+	else
+		m_Geometry.BindShadowMap(shadowMap, test);
+
+	if(test == Geometry::SHADOW_TEST_LIT)
+		g_GLState.Enable(GL_LIGHT0);
+	else
+		g_GLState.Disable(GL_LIGHT0);
+
+	ExecuteCommands(CAMERA_PASS);
+}
+
+///----------------------------------------------------------------------------
+///Places the spot lights on a circle around the scene, each one aiming at
+///a point of the base plate, and computes the matrices of their shadow
+///maps. The tiles are allocated every frame by UpdateSpotLights.
+///----------------------------------------------------------------------------
+void GLApp::CreateSpotLights()
+{
+	m_SpotLights.clear();
+	if(!m_ShadowAtlas.IsValid()) return;
+
+	m_SpotLights.resize(m_SpotLightCount);
 
 	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixd(m_CameraViewMatrix);
+	glPushMatrix();
+	for(UINT i=0; i<m_SpotLightCount; i++)
+	{
+		SpotLight &light = m_SpotLights[i];
+		GLfloat angle = 6.2831853f * i / m_SpotLightCount;
+
+		light.position[0] = 9.0f * cosf(angle);
+		light.position[1] = 6.0f;
+		light.position[2] = 9.0f * sinf(angle);
+		light.position[3] = 1.0f;
+
+		light.target[0] = 3.0f * cosf(angle + 0.8f);
+		light.target[1] = 0.0f;
+		light.target[2] = 3.0f * sinf(angle + 0.8f);
+
+		GLfloat length = 0.0f;
+		for(int j=0; j<3; j++)
+		{
+			light.direction[j] = light.target[j] - light.position[j];
+			length += light.direction[j] * light.direction[j];
+		}
+		length = sqrtf(length);
+		for(int j=0; j<3; j++) light.direction[j] /= length;
+
+		memcpy(light.color, SpotColors[i % SpotColorCount], sizeof(light.color));
+		light.cutoff = 22.0f;
+		light.importance = 0.0f;
 
-	glEnable(GL_ALPHA_TEST);
-	glAlphaFunc(GL_GREATER, 0.0);
+		//the cone fits in the frustum, nothing outside the tile is lit
+		glLoadIdentity();
+		gluPerspective(50.0f, 1.0f, 1.0f, 30.0f);
+		glGetDoublev(GL_MODELVIEW_MATRIX, light.projection);
 
-	//bind and enable shadow map texture
-	glBindTexture(GL_TEXTURE_2D, m_Geometry.GetShadowTexObj());
+		glLoadIdentity();
+		gluLookAt(light.position[0], light.position[1], light.position[2],
+				  light.target[0], light.target[1], light.target[2], 0.0f, 1.0f, 0.0f);
+		glGetDoublev(GL_MODELVIEW_MATRIX, light.view);
 
-	//Tell OpenGL to perform depth comparison
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE_ARB, GL_COMPARE_R_TO_TEXTURE);
+		light.frustum.Extract(light.projection, light.view);
+	}
+	glPopMatrix();
+}
 
-	//Tell OpenGL what to do with the boolean result
-	glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE_ARB, GL_ALPHA);
+///----------------------------------------------------------------------------
+///Rates the spot lights by how much of the screen their cone covers, gives
+///them their tiles in the atlas and culls their shadow casters. The lights
+///the camera doesn't see get no tile. The casters the camera sees are the
+///receivers of the light's additive pass. The light's matrices and its
+///casters' transforms are hashed, and the scheduler picks the tiles that
+///are redrawn this frame.
+///----------------------------------------------------------------------------
+void GLApp::UpdateSpotLights()
+{
+	if(m_SpotLights.empty()) return;
 
-	//Specify the operators, depth comparison should be true (i.e. lit) if r<texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC_ARB, GL_LESS);
+	ProfileScope sample(m_Profiler, "Spot lights");
+	m_ShadowScheduler.BeginFrame(m_Pacer.GetFrame());
 
-	//render lit fragments
-	glEnable(GL_LIGHT0);
-	m_Geometry.Draw(angle);
+	GLfloat cameraPos[3];
+	m_Geometry.GetCameraPosition(cameraPos);
+	GLfloat projScale = (GLfloat)m_CameraProjectionMatrix[5];
+	UINT maxTile = m_ShadowAtlas.GetMaxTileSize(m_Width, m_Height);
 
-	//Do the contrary: depth comparison should be true if r >= texture (i.e. shadow)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC_ARB, GL_GEQUAL);
+	std::vector<ShadowAtlas::Request> requests(m_SpotLights.size());
+	for(UINT i=0; i<m_SpotLights.size(); i++)
+	{
+		SpotLight &light = m_SpotLights[i];
 
-	//render shadowed fragments
-	glDisable(GL_LIGHT0);
-	m_Geometry.Draw(angle);
+		//the lit area is roughly a sphere around the target as wide as
+		//the cone where it reaches the target
+		GLfloat toTarget = 0.0f, toCamera = 0.0f;
+		for(int j=0; j<3; j++)
+		{
+			GLfloat d = light.target[j] - light.position[j];
+			GLfloat c = light.target[j] - cameraPos[j];
+			toTarget += d * d;
+			toCamera += c * c;
+		}
+		GLfloat radius = sqrtf(toTarget) * tanf(light.cutoff * 3.1415927f / 180.0f);
+		toCamera = (std::max)(sqrtf(toCamera), 1.0f);
 
-	SwapBuffers(m_hDC);
+		AABB area;
+		for(int j=0; j<3; j++)
+		{
+			area.min[j] = light.target[j] - radius;
+			area.max[j] = light.target[j] + radius;
+		}
+
+		light.importance = 0.0f;
+		if(m_CameraFrustum.Test(area) != Frustum::OUTSIDE)
+			light.importance = (std::min)(1.0f, radius * projScale / toCamera);
+
+		requests[i].size = ShadowAtlas::GetTileSize(light.importance, maxTile,
+													m_ShadowAtlas.GetTile(i).size);
+		requests[i].importance = light.importance;
+	}
+
+	UINT repacks = m_ShadowAtlas.GetRepackCount();
+	m_ShadowAtlas.Allocate(requests);
+
+	UINT casters = 0, receivers = 0;
+	std::vector<ShadowScheduler::Request> updates(m_SpotLights.size());
+	for(UINT i=0; i<m_SpotLights.size(); i++)
+	{
+		SpotLight &light = m_SpotLights[i];
+		const ShadowAtlas::Tile &tile = m_ShadowAtlas.GetTile(i);
+
+		light.casters.clear();
+		light.receivers.clear();
+		light.casterHash = ShadowScheduler::HASH_SEED;
+
+		ShadowScheduler::Request &update = updates[i];
+		update.shadowed = tile.size != 0;
+		update.fresh = tile.fresh;
+		update.importance = light.importance;
+		update.lightHash = ShadowScheduler::Hash(light.view, sizeof(light.view));
+		update.lightHash = ShadowScheduler::Hash(light.projection, sizeof(light.projection), update.lightHash);
+		if(!tile.size) continue;
+
+		//the casters' levels are selected with the light's own level state
+		//(see Geometry::SwapLOD), a level switch changes the tile too
+		m_Geometry.Cull(light.frustum, light.casters);
+		m_Geometry.SwapLOD(SHADOW_PASS, light.casters, light.levels);
+		m_Geometry.SelectLOD(SHADOW_PASS, light.casters, light.position,
+							 (GLfloat)light.projection[5] * tile.size * 0.5f);
+
+		for(UINT j=0; j<light.casters.size(); j++)
+		{
+			UINT object = light.casters[j];
+			const SceneObject &obj = m_Geometry.GetSceneObject(object);
+			UINT mesh = obj.shape * LODChain::MAX_LODS + obj.lod[SHADOW_PASS];
+
+			light.casterHash = ShadowScheduler::Hash(&object, sizeof(object), light.casterHash);
+			light.casterHash = ShadowScheduler::Hash(&mesh, sizeof(mesh), light.casterHash);
+			light.casterHash = ShadowScheduler::Hash(obj.world.m, sizeof(Matrix4), light.casterHash);
+
+			if(m_CameraFrustum.Test(m_Geometry.GetBounds(object)) != Frustum::OUTSIDE)
+				light.receivers.push_back(object);
+		}
+		m_Geometry.SwapLOD(SHADOW_PASS, light.casters, light.levels);
+		update.casterHash = light.casterHash;
+		update.casters = (UINT)light.casters.size();
+
+		//the camera levels are selected by the camera commands, except
+		//with the GPU culling
+		if(m_GPUCulling.IsValid())
+		{
+			m_Geometry.SelectLOD(CAMERA_PASS, light.receivers, cameraPos,
+								 projScale * m_Height * 0.5f);
+		}
+
+		casters += (UINT)light.casters.size();
+		receivers += (UINT)light.receivers.size();
+	}
+
+	m_Profiler.AddCount("Spot lights shadowed", m_ShadowAtlas.GetTileCount());
+	m_Profiler.AddCount("Shadow atlas used %", m_ShadowAtlas.IsValid() ? 100.0 *
+						m_ShadowAtlas.GetUsedArea() / ((double)m_ShadowAtlas.GetSize() * m_ShadowAtlas.GetSize()) : 0.0);
+	m_Profiler.AddCount("Shadow atlas fresh tiles", m_ShadowAtlas.GetFreshCount());
+	m_Profiler.AddCount("Shadow atlas shrunk tiles", m_ShadowAtlas.GetShrunkCount());
+	m_Profiler.AddCount("Shadow atlas repacks", m_ShadowAtlas.GetRepackCount() - repacks);
+	m_Profiler.AddCount("Spot light casters", casters);
+	m_Profiler.AddCount("Spot light receivers", receivers);
+
+	m_ShadowScheduler.Schedule(updates, m_ShadowUpdates);
+	m_Profiler.AddCount("Shadow updates", m_ShadowScheduler.GetUpdateCount());
+	m_Profiler.AddCount("Shadow updates of new tiles", m_ShadowScheduler.GetForcedCount());
+	m_Profiler.AddCount("Shadow updates skipped", m_ShadowScheduler.GetSkippedCount());
+	m_Profiler.AddCount("Shadows cached", m_ShadowScheduler.GetCachedCount());
+	m_Profiler.AddCount("Shadow staleness max (frames)", m_ShadowScheduler.GetMaxStaleness());
+	m_Profiler.AddCount("Shadow update estimate (ms)", m_ShadowScheduler.GetEstimatedTime());
+	m_Profiler.AddCount("Shadow update measured (ms)", m_ShadowScheduler.GetMeasuredTime());
+}
+
+///----------------------------------------------------------------------------
+///Draws the shadow maps the scheduler picked into their tiles of the atlas,
+///with the same state CreateShadowMap uses. The other tiles keep the depth
+///of an earlier frame.
+///----------------------------------------------------------------------------
+void GLApp::RenderShadowAtlas()
+{
+	g_GLState.ShadeModel(GL_FLAT);
+	g_GLState.Disable(GL_LIGHTING);
+	g_GLState.Disable(GL_TEXTURE_2D);
+	g_GLState.ColorMask(0,0,0,0);
+	g_GLState.Enable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.PolygonOffset(1.0, 4.0);
+
+	UINT casters = 0;
+	m_ShadowScheduler.BeginUpdates(m_Pacer.GetFrame());
+	m_ShadowAtlas.BeginRender();
+	for(UINT i=0; i<m_ShadowUpdates.size(); i++)
+	{
+		UINT index = m_ShadowUpdates[i];
+		SpotLight &light = m_SpotLights[index];
+
+		//every light keeps the levels UpdateSpotLights selected for its
+		//casters, the shadow map's levels are swapped out while it draws
+		m_Geometry.SwapLOD(SHADOW_PASS, light.casters, light.levels);
+
+		m_ShadowAtlas.BeginTile(index);
+
+		glMatrixMode(GL_PROJECTION);
+		glLoadMatrixd(light.projection);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadMatrixd(light.view);
+		m_Geometry.Draw(light.casters, SHADOW_PASS);
+
+		m_ShadowAtlas.EndTile(index);
+		m_Geometry.SwapLOD(SHADOW_PASS, light.casters, light.levels);
+		casters += (UINT)light.casters.size();
+	}
+	m_ShadowAtlas.EndRender();
+	m_ShadowScheduler.EndUpdates(m_Pacer.GetFrame(), casters, (UINT)m_ShadowUpdates.size());
+
+	glViewport(0, 0, m_Width, m_Height);
+
+	//restore render states
+	g_GLState.Disable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.ColorMask(1,1,1,1);
+	g_GLState.ShadeModel(GL_SMOOTH);
+	g_GLState.Enable(GL_LIGHTING);
+	g_GLState.Enable(GL_TEXTURE_2D);
+}
+
+///----------------------------------------------------------------------------
+///Adds the light of the spot lights to what the camera passes drew. Every
+///light draws its receivers again with light0 turned into the spot light
+///and its tile of the atlas as the shadow map; the shadowed fragments are
+///rejected by the alpha test and the rest are added to the color buffer.
+///----------------------------------------------------------------------------
+void GLApp::RenderSpotLights()
+{
+	static const GLfloat black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+	//light0 is enabled through the cache before the attributes are saved,
+	//so popping them leaves it as the cache knows it
+	g_GLState.Enable(GL_LIGHT0);
+	glPushAttrib(GL_LIGHTING_BIT);
+	g_GLState.Push();
+
+	//the ambient light was added by the camera passes already
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, black);
+	glLightfv(GL_LIGHT0, GL_AMBIENT, black);
+	glLightf(GL_LIGHT0, GL_SPOT_EXPONENT, 8.0f);
+
+	g_GLState.Enable(GL_BLEND);
+	g_GLState.BlendFunc(GL_ONE, GL_ONE);
+	g_GLState.DepthMask(GL_FALSE);
+	g_GLState.DepthFunc(GL_LEQUAL);
+	g_GLState.Enable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.PolygonOffset(-1.0, -1.0);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixd(m_CameraProjectionMatrix);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixd(m_CameraViewMatrix);
+
+	for(UINT i=0; i<m_SpotLights.size(); i++)
+	{
+		const SpotLight &light = m_SpotLights[i];
+		if(light.receivers.empty()) continue;
+
+		//positions and directions are transformed by the camera view
+		glLightfv(GL_LIGHT0, GL_POSITION, light.position);
+		glLightfv(GL_LIGHT0, GL_SPOT_DIRECTION, light.direction);
+		glLightf(GL_LIGHT0, GL_SPOT_CUTOFF, light.cutoff);
+		glLightfv(GL_LIGHT0, GL_DIFFUSE, light.color);
+		glLightfv(GL_LIGHT0, GL_SPECULAR, light.color);
+
+		GLdouble tile[3];
+		m_ShadowAtlas.GetTileTransform(i, tile);
+		CreateTextureMatrix(light.projection, light.view, tile);
+		glMatrixMode(GL_MODELVIEW);
+
+		m_Geometry.BindShadowMap(m_ShadowAtlas.GetTexture(), Geometry::SHADOW_TEST_LIT);
+		m_Geometry.Draw(light.receivers, CAMERA_PASS);
+	}
+
+	//restore render states
+	g_GLState.Pop();
+	glPopAttrib();
+}
+
+///----------------------------------------------------------------------------
+///Declares the passes of the frame and what each one reads and writes, then
+///compiles the graph. The shadow map is the transient texture, the Hi-Z
+///copies the camera depth to its own texture (a shadow map's comparison
+///state doesn't suit it). The shadow atlas keeps its texture, the tiles
+///are allocated by the atlas itself.
+///----------------------------------------------------------------------------
+void GLApp::BuildRenderGraph()
+{
+	FrameResources &res = m_FrameResources;
+	m_Graph.Reset();
+
+	res.backBuffer		= m_Graph.Import("Back buffer", 0, true);
+	res.shadowMap		= m_PointShadow.IsValid() ?
+						  m_Graph.Import("Point light cube map", m_PointShadow.GetTexture()) :
+						  m_Graph.CreateTexture("Shadow map", m_Width, m_Height, GL_DEPTH_COMPONENT);
+	res.shadowMatrix	= m_Graph.Import("Shadow texgen planes");
+	res.cameraCommands	= m_Graph.Import("Camera commands");
+	res.hiZ				= m_Graph.Import("Hi-Z pyramid", 0, true);
+	res.occlusion		= m_Graph.Import("Occlusion queries", 0, true);
+	res.shadowAtlas		= m_Graph.Import("Shadow atlas", m_ShadowAtlas.GetTexture());
+
+	//1st pass, create shadow map & texture coordinates (the shadow map is
+	//drawn in the back buffer and copied, the cube map has its own
+	//framebuffer)
+	UINT pass = m_Graph.AddPass("Shadow depth", ShadowDepthPass, this);
+	if(!m_PointShadow.IsValid()) m_Graph.Write(pass, res.backBuffer);
+	m_Graph.Write(pass, res.shadowMap);
+
+	pass = m_Graph.AddPass("Shadow matrix", ShadowMatrixPass, this);
+	m_Graph.Write(pass, res.shadowMatrix);
+
+	//the spot lights' shadow maps that changed, drawn in the back buffer
+	//too when there are no framebuffer objects
+	if(!m_ShadowUpdates.empty())
+	{
+		pass = m_Graph.AddPass("Shadow atlas", ShadowAtlasPass, this);
+		if(!m_ShadowAtlas.IsRenderedDirectly()) m_Graph.Write(pass, res.backBuffer);
+		m_Graph.Write(pass, res.shadowAtlas);
+	}
+
+	//the occluders are being rasterized while the shadow map is drawn
+	pass = m_Graph.AddPass("Camera commands", CameraCommandsPass, this);
+	m_Graph.Write(pass, res.cameraCommands);
+
+	//the multi-draw shaders take the shadow matrix from the frame data, the
+	//texgen planes are only used by the draws of the fixed function path
+	bool texgen = !m_MultiDraw.IsValid() ||
+				  (!m_GPUCulling.IsValid() && m_OcclusionMode == OCCLUSION_HARDWARE);
+
+	//2nd pass, render from camera point of view
+	pass = m_Graph.AddPass("Camera lit", CameraLitPass, this);
+	m_Graph.Read(pass, res.shadowMap);
+	if(texgen) m_Graph.Read(pass, res.shadowMatrix);
+	m_Graph.Read(pass, res.cameraCommands);
+	m_Graph.Write(pass, res.backBuffer);
+
+	pass = m_Graph.AddPass("Camera shadowed", CameraShadowedPass, this);
+	m_Graph.Read(pass, res.shadowMap);
+	if(texgen) m_Graph.Read(pass, res.shadowMatrix);
+	m_Graph.Read(pass, res.cameraCommands);
+	m_Graph.Write(pass, res.backBuffer);
+
+	//the receivers' levels may be the ones the camera commands selected
+	if(m_ShadowAtlas.GetTileCount())
+	{
+		pass = m_Graph.AddPass("Spot lights", SpotLightsPass, this);
+		m_Graph.Read(pass, res.shadowAtlas);
+		m_Graph.Read(pass, res.cameraCommands);
+		m_Graph.Write(pass, res.backBuffer);
+	}
+
+	//the depth buffer is complete now, check what was hidden by it
+	if(m_OcclusionMode == OCCLUSION_HARDWARE)
+	{
+		pass = m_Graph.AddPass("Occlusion queries", OcclusionQueryPass, this);
+		m_Graph.Read(pass, res.backBuffer);
+		m_Graph.Write(pass, res.occlusion);
+	}
+
+	//the next frame's GPU culling tests against this depth buffer
+	if(m_GPUCulling.IsValid())
+	{
+		pass = m_Graph.AddPass("Hi-Z build", HiZPass, this);
+		m_Graph.Read(pass, res.backBuffer);
+		m_Graph.Write(pass, res.hiZ);
+	}
+
+	if(m_ShowStats)
+	{
+		pass = m_Graph.AddPass("Statistics", StatsPass, this);
+		m_Graph.Write(pass, res.backBuffer);
+	}
+
+	m_Graph.Compile();
+}
+
+///----------------------------------------------------------------------------
+///Overriden Render function (draws the scene).
+///----------------------------------------------------------------------------
+void GLApp::Render()
+{
+	static GLfloat angle = 0.0;
+
+	m_Profiler.BeginFrame();
+
+	if(m_BenchmarkFrames)
+	{
+		//run as fast as possible with a fixed time step
+		//so every benchmark run animates the same way
+		m_Timer.Tick();
+		angle += 50.0f / 60.0f;
+	}
+	else
+	{
+		//lock the framerate to 60 FPS
+		m_Timer.Tick(60.0f);
+
+		//update the angle for animation
+		angle += 50.0f * m_Timer.GetTimeElapsed();
+	}
+
+	//wait until the GPU is done with the frame that last used this frame's
+	//transient textures, the ring segment and the GPU counters
+	m_Pacer.BeginFrame();
+	m_Profiler.AddTime("Frame fence wait", m_Pacer.GetWaitTime());
+	m_Profiler.AddCount("Frame fence stalls", m_Pacer.HasStalled() ? 1.0 : 0.0);
+	if(m_Pacer.IsValid() && g_GLCaps.timerQuery)
+		m_Profiler.AddTime("GPU frame", m_Pacer.GetGPUTime());
+
+	m_UploadRing.BeginFrame(m_Pacer.GetFrame());
+
+	//continue uploading the models being loaded
+	if(m_Loader.GetPendingCount())
+	{
+		ProfileScope sample(m_Profiler, "Streaming upload");
+		m_Loader.Update(m_UploadBudget, m_Pacer.GetFrame());
+		m_Profiler.AddCount("Streaming upload KB", m_Loader.GetUploadedBytes() / 1024.0);
+		AddLoadedMeshes();
+	}
+
+	//move the animated objects and find what each pass has to draw
+	if(m_GPUCulling.IsValid())
+		CullSceneGPU(angle);
+	else
+		CullScene(angle);
+
+	UpdateSpotLights();
+	if(m_MultiDraw.IsValid()) UploadFrameData();
+
+	//declare the frame, the graph culls the passes whose results nobody
+	//uses, orders the rest and gives the transient textures their memory
+	{
+		ProfileScope sample(m_Profiler, "Render graph compile");
+		BuildRenderGraph();
+	}
+	m_Graph.Execute(m_Pacer.GetFrame());
+
+	m_Profiler.AddCount("Render graph passes", m_Graph.GetPassCount() - m_Graph.GetCulledCount());
+	m_Profiler.AddCount("Render graph culled passes", m_Graph.GetCulledCount());
+	m_Profiler.AddCount("Render graph transient KB", m_Graph.GetTransientBytes() / 1024.0);
+	m_Profiler.AddCount("Render graph allocated KB", m_Graph.GetAllocatedBytes() / 1024.0);
+
+	//every command of the frame has been issued, fence them
+	m_Pacer.EndFrame();
+	m_Profiler.AddCount("Upload ring KB", m_UploadRing.GetUsedBytes() / 1024.0);
+	m_Profiler.AddCount("Upload ring overflows", m_UploadRing.GetFailedCount());
+
+	SwapBuffers(m_hDC);
+
+	m_Profiler.AddCount("GL state calls issued", g_GLState.GetIssuedCount());
+	m_Profiler.AddCount("GL state calls filtered", g_GLState.GetFilteredCount());
+	g_GLState.ResetCounters();
+
+	m_Profiler.EndFrame();
+
+	if(m_BenchmarkFrames)
+	{
+		m_FrameCount++;
+
+		//don't let start-up hitches skew the results
+		if(m_FrameCount == BENCHMARK_WARMUP)
+		{
+			m_Profiler.Reset();
+			m_Pacer.ResetStatistics();
+			m_ShadowScheduler.ResetStatistics();
+		}
+
+		if(m_FrameCount == m_BenchmarkFrames)
+		{
+			WriteBenchmark();
+			Quit();
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Adds the models the loader finished to the scene, standing on the base
+///plate in front of the torus
+///----------------------------------------------------------------------------
+void GLApp::AddLoadedMeshes()
+{
+	StreamingLoader::Loaded loaded;
+	bool added = false;
+
+	while(m_Loader.PopLoaded(loaded))
+	{
+		GLfloat position[3] = {0.0f, 0.15f, 2.5f};
+		m_Geometry.AddMesh(loaded.mesh, position, 1.5f, 0.8f, 0.8f, 0.8f);
+		added = true;
+
+		const MeshImporter::Stats &stats = loaded.import;
+		m_Profiler.SetValue("Import (ms)", stats.ms);
+		m_Profiler.SetValue("Import (MB/s)", stats.ms > 0.0 ?
+							stats.bytes / (1024.0 * 1024.0) / (stats.ms / 1000.0) : 0.0);
+		m_Profiler.SetValue("Import threads", stats.threads);
+		m_Profiler.SetValue("Import triangles", stats.triangles);
+		m_Profiler.SetValue("Import vertices", stats.vertices);
+		m_Profiler.SetValue("Import decode (ms)", loaded.decodeMs);
+		m_Profiler.SetValue("Import ready after (ms)", loaded.latencyMs);
+		m_Profiler.SetValue("Import upload frames", loaded.frames);
+	}
+
+	if(!added) return;
+
+	//the new objects need a place in the hierarchy and occlusion states
+	m_Geometry.BuildBVH();
+	m_Occlusion.Shutdown();
+	m_Occlusion.Init(m_Geometry.GetObjectCount());
+
+	m_Profiler.SetValue("Objects", m_Geometry.GetObjectCount());
+	m_Profiler.SetValue("BVH nodes", m_Geometry.GetBVH().GetNodeCount());
+	m_Profiler.SetValue("Mesh memory (KB)", m_Geometry.GetMeshBytes() / 1024.0);
+
+	if(m_UseMultiDraw)
+	{
+		if(m_Pacer.IsValid())
+		{
+			m_UploadRing.Create(m_Geometry.GetObjectCount() * RingBytesPerObject + RingBytesPerFrame,
+								m_Pacer.GetFrameCount());
+			m_UploadRing.BeginFrame(m_Pacer.GetFrame());
+		}
+		m_Profiler.SetValue("Upload ring", m_UploadRing.IsValid() ? 1.0 : 0.0);
+		m_Profiler.SetValue("Upload ring (KB)", m_UploadRing.GetBufferBytes() / 1024.0);
+
+		m_MultiDraw.Create(m_Geometry, &m_UploadRing);
+		m_Profiler.SetValue("Multi-draw indirect", m_MultiDraw.IsValid() ? 1.0 : 0.0);
+		m_Profiler.SetValue("Multi-draw buffers (KB)", m_MultiDraw.GetBufferBytes() / 1024.0);
+	}
+
+	if(m_UseGPUCulling)
+	{
+		m_GPUCulling.Create(m_Geometry, m_MultiDraw, &m_UploadRing);
+		m_Profiler.SetValue("GPU culling", m_GPUCulling.IsValid() ? 1.0 : 0.0);
+		m_Profiler.SetValue("GPU culling buffers (KB)", m_GPUCulling.GetBufferBytes() / 1024.0);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Animates the scene, refits the hierarchy and culls the objects against
+///the light frustum (shadow casters) and the camera frustum. The stages run
+///as jobs: the animation is split across the threads, both frustums are
+///culled at the same time once the hierarchy is refitted and the shadow
+///casters select their level while the render thread does the occlusion
+///work of the camera pass.
+///@param	angle - animation angle
+///----------------------------------------------------------------------------
+void GLApp::CullScene(GLfloat angle)
+{
+	ProfileScope sample(m_Profiler, "Cull scene");
+	LONG stolen = (LONG)m_Jobs.GetStolenCount();
+
+	m_AnimationAngle = angle;
+	m_LightFrustum.Extract(m_LightProjectionMatrix, m_LightViewMatrix);
+	m_CameraFrustum.Extract(m_CameraProjectionMatrix, m_CameraViewMatrix);
+
+	JobSystem::Counter animated = 0, refitted = 0, shadowCulled = 0, cameraCulled = 0;
+	m_Jobs.ParallelFor("Animate", m_Geometry.GetAnimatedCount(), AnimateGrain,
+					   AnimateJob, this, &animated);
+	m_Jobs.Add("BVH refit", RefitJob, this, &refitted, &animated);
+	m_Jobs.Add("Cull shadow casters", CullShadowJob, this, &shadowCulled, &refitted);
+	m_Jobs.Add("Cull camera", CullCameraJob, this, &cameraCulled, &refitted);
+
+	//the shadow casters are sized in shadow map texels (the shadow map is
+	//copied at the window's size, the cube faces have a 90 degree field of
+	//view, P[5] is 1)
+	bool point = m_PointShadow.IsValid();
+	LODSelection shadow;
+	shadow.pass = SHADOW_PASS;
+	shadow.objects = &m_ShadowObjects;
+	shadow.pixelsPerUnit = point ? m_PointShadow.GetSize() * 0.5f :
+						   (GLfloat)m_LightProjectionMatrix[5] * m_Height * 0.5f;
+	m_Geometry.GetLightPosition(shadow.eye);
+
+	//the cube map draws its casters a group of faces at a time
+	JobSystem::Counter shadowSelected = 0, shadowRecorded = 0;
+	m_Jobs.Wait(&shadowCulled);
+	SelectLOD(shadow, &shadowSelected);
+	if(point)
+		m_Jobs.Add("Record point shadow commands", RecordPointShadowJob, this, &shadowRecorded, &shadowSelected);
+	else
+		RecordCommands(SHADOW_PASS, m_ShadowObjects, &shadowRecorded, &shadowSelected);
+
+	//the occlusion culling reads the queries, it stays on this thread
+	GLfloat cameraPos[3];
+	m_Geometry.GetCameraPosition(cameraPos);
+	m_Jobs.Wait(&cameraCulled);
+
+	if(m_OcclusionMode == OCCLUSION_HARDWARE)
+	{
+		ProfileScope sample(m_Profiler, "Occlusion select");
+		m_Occlusion.Select(m_Geometry, m_CameraObjects, cameraPos);
+		m_Profiler.AddCount("Objects occluded", m_Occlusion.GetOccludedCount());
+	}
+	else if(m_OcclusionMode == OCCLUSION_SOFTWARE)
+	{
+		//the workers rasterize the occluders while the shadow map is drawn
+		ProfileScope sample(m_Profiler, "SW occlusion setup");
+		m_SoftOcclusion.Begin(m_Geometry, m_CameraObjects, m_CameraProjectionMatrix,
+							  m_CameraViewMatrix, cameraPos);
+	}
+
+	m_Jobs.Wait(&shadowSelected);
+	m_Jobs.Wait(&shadowRecorded);
+	m_Profiler.AddCount("Shadow triangles", shadow.triangles);
+	m_Profiler.AddCount("Shadow vertex KB", shadow.bytes / 1024.0);
+
+	m_Profiler.AddCount("BVH refit nodes", m_Geometry.GetBVH().GetRefitNodeCount());
+	m_Profiler.AddCount("Shadow casters drawn", (double)m_ShadowObjects.size());
+	m_Profiler.AddCount("Jobs stolen", (double)((LONG)m_Jobs.GetStolenCount() - stolen));
+
+	if(point)
+	{
+		m_Profiler.AddCount("Point shadow face casters", m_PointShadow.GetFaceCasterCount());
+		m_Profiler.AddCount("Point shadow groups", m_PointShadow.GetGroupCount());
+	}
+}
+
+///----------------------------------------------------------------------------
+///Animates the scene and culls both passes on the GPU. The workers animate
+///the objects and pack them for the cull shader (the hierarchy is still
+///refitted for the ray queries), the render thread uploads them and runs
+///the shader, which leaves the commands of both passes on the GPU. The
+///counts are read back a frame late, they are only used for statistics.
+///@param	angle - animation angle
+///----------------------------------------------------------------------------
+void GLApp::CullSceneGPU(GLfloat angle)
+{
+	ProfileScope sample(m_Profiler, "Cull scene");
+	LONG stolen = (LONG)m_Jobs.GetStolenCount();
+
+	m_AnimationAngle = angle;
+	m_LightFrustum.Extract(m_LightProjectionMatrix, m_LightViewMatrix);
+	m_CameraFrustum.Extract(m_CameraProjectionMatrix, m_CameraViewMatrix);
+
+	JobSystem::Counter animated = 0, refitted = 0, packed = 0;
+	m_Jobs.ParallelFor("Animate", m_Geometry.GetAnimatedCount(), AnimateGrain,
+					   AnimateJob, this, &animated);
+	m_Jobs.Add("BVH refit", RefitJob, this, &refitted, &animated);
+	m_GPUCulling.BeginPack(m_Pacer.GetFrame());
+	m_Jobs.ParallelFor("Pack GPU objects", m_Geometry.GetObjectCount(), PackGrain,
+					   PackJob, this, &packed, &animated);
+
+	GLfloat cameraPos[3], lightPos[3];
+	m_Geometry.GetCameraPosition(cameraPos);
+	m_Geometry.GetLightPosition(lightPos);
+	m_Jobs.Wait(&packed);
+
+	{
+		ProfileScope sample(m_Profiler, "GPU cull dispatch");
+		m_GPUCulling.Cull(m_CameraFrustum, m_LightFrustum, cameraPos, lightPos,
+						  (GLfloat)m_CameraProjectionMatrix[5] * m_Height * 0.5f,
+						  (GLfloat)m_LightProjectionMatrix[5] * m_Height * 0.5f,
+						  m_Geometry.IsLODEnabled());
+	}
+
+	m_Jobs.Wait(&refitted);
+	m_Profiler.AddCount("Camera triangles", m_GPUCulling.GetTriangleCount(CAMERA_PASS));
+	m_Profiler.AddCount("Shadow triangles", m_GPUCulling.GetTriangleCount(SHADOW_PASS));
+	m_Profiler.AddCount("BVH refit nodes", m_Geometry.GetBVH().GetRefitNodeCount());
+	m_Profiler.AddCount("Shadow casters drawn", m_GPUCulling.GetDrawCount(SHADOW_PASS));
+	m_Profiler.AddCount("Jobs stolen", (double)((LONG)m_Jobs.GetStolenCount() - stolen));
+}
+
+///----------------------------------------------------------------------------
+///Queues the level of detail selection of a culled pass
+///@param	selection - pass, culling result and projection (the totals are
+///			valid once the counter reaches zero)
+///@param	counter - signaled when the selection is done
+///----------------------------------------------------------------------------
+void GLApp::SelectLOD(LODSelection &selection, JobSystem::Counter *counter)
+{
+	selection.app = this;
+	selection.triangles = 0;
+	selection.bytes = 0;
+
+	LPCSTR name = selection.pass == SHADOW_PASS ? "LOD select shadow" : "LOD select camera";
+	m_Jobs.ParallelFor(name, (UINT)selection.objects->size(), LODGrain,
+					   SelectLODJob, &selection, counter);
+}
+
+///----------------------------------------------------------------------------
+///Queues the recording of a pass' draws, split in command buffers of
+///RecordGrain objects, the sort of the recorded draws by key and, with
+///multi-draw, the indirect commands built from them
+///@param	pass - pass to record (its levels of detail must be selected
+///			when the jobs start)
+///@param	objects - objects drawn by the pass
+///@param	counter - signaled when the draws are recorded, sorted and built
+///@param	dependency - the recording starts when this counter reaches zero
+///----------------------------------------------------------------------------
+void GLApp::RecordCommands(RenderPass pass, const std::vector<UINT> &objects,
+						   JobSystem::Counter *counter, JobSystem::Counter *dependency)
+{
+	CommandRecording &recording = m_Recording[pass];
+	recording.app = this;
+	recording.pass = pass;
+	recording.objects = &objects;
+	recording.recorded = 0;
+	recording.sorted = 0;
+
+	UINT count = (UINT)objects.size();
+	m_Commands[pass].resize((count + RecordGrain - 1) / RecordGrain);
+
+	LPCSTR name = pass == SHADOW_PASS ? "Record shadow commands" : "Record camera commands";
+	bool indirect = m_MultiDraw.IsValid();
+	if(!m_SortDraws && !indirect)
+	{
+		m_Jobs.ParallelFor(name, count, RecordGrain, RecordJob, &recording, counter, dependency);
+		return;
+	}
+
+	m_Jobs.ParallelFor(name, count, RecordGrain, RecordJob, &recording, &recording.recorded, dependency);
+	if(m_SortDraws)
+	{
+		m_Jobs.Add(pass == SHADOW_PASS ? "Sort shadow commands" : "Sort camera commands",
+				   SortJob, &recording, indirect ? &recording.sorted : counter, &recording.recorded);
+	}
+
+	if(indirect)
+	{
+		m_Jobs.Add(pass == SHADOW_PASS ? "Build shadow indirect draws" : "Build camera indirect draws",
+				   IndirectJob, &recording, counter, m_SortDraws ? &recording.sorted : &recording.recorded);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Replays the recorded draws of a pass, sorted by key or in the recorded
+///order, or with a single indirect call (the camera pass is followed by
+///its conditional draws). With GPU culling the indirect call draws what
+///the cull shader wrote.
+///@param	pass - the pass to draw
+///----------------------------------------------------------------------------
+void GLApp::ExecuteCommands(RenderPass pass)
+{
+	DrawStats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	const std::vector<CommandBuffer> &buffers = m_Commands[pass];
+	if(m_GPUCulling.IsValid())
+	{
+		m_GPUCulling.Draw(pass, m_MultiDraw);
+		stats.draws = m_GPUCulling.GetDrawCount(pass);
+		stats.meshChanges = 1;
+	}
+	else if(m_MultiDraw.IsValid())
+		m_MultiDraw.Draw(pass, &stats);
+	else if(m_SortDraws)
+		m_Geometry.Execute(m_Queues[pass], pass, &stats);
+	else
+		m_Geometry.Execute(buffers.empty() ? NULL : &buffers[0], (UINT)buffers.size(), pass, &stats);
+
+	if(pass == CAMERA_PASS && m_ConditionalCommands.GetCount())
+		m_Geometry.Execute(&m_ConditionalCommands, 1, pass, &stats);
+
+	if(pass == SHADOW_PASS)
+	{
+		m_Profiler.AddCount("Shadow draws", stats.draws);
+		m_Profiler.AddCount("Shadow mesh changes", stats.meshChanges);
+	}
+	else
+	{
+		m_Profiler.AddCount("Camera draws", stats.draws);
+		m_Profiler.AddCount("Camera mesh changes", stats.meshChanges);
+		m_Profiler.AddCount("Camera color changes", stats.colorChanges);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: draws the depth seen from the light into the shadow map
+///@param	data - the application
+///@param	graph - gives the shadow map texture
+///----------------------------------------------------------------------------
+void GLApp::ShadowDepthPass(void *data, const RenderGraph &graph)
+{
+	GLApp *app = (GLApp *)data;
+	if(app->m_PointShadow.IsValid())
+		app->RenderPointShadow();
+	else
+		app->CreateShadowMap(graph.GetTexture(app->m_FrameResources.shadowMap));
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: sets the eye planes of the shadow texgen
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::ShadowMatrixPass(void *data, const RenderGraph &)
+{
+	GLApp *app = (GLApp *)data;
+	if(app->m_PointShadow.IsValid())
+		app->CreatePointTextureMatrix();
+	else
+		app->CreateTextureMatrix(app->m_LightProjectionMatrix, app->m_LightViewMatrix);
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: records the draws of the camera passes
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::CameraCommandsPass(void *data, const RenderGraph &)
+{
+	((GLApp *)data)->PrepareCameraCommands();
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: draws the lit fragments
+///@param	data - the application
+///@param	graph - gives the shadow map texture
+///----------------------------------------------------------------------------
+void GLApp::CameraLitPass(void *data, const RenderGraph &graph)
+{
+	GLApp *app = (GLApp *)data;
+	app->RenderCamera(graph.GetTexture(app->m_FrameResources.shadowMap), Geometry::SHADOW_TEST_LIT);
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: draws the shadowed fragments
+///@param	data - the application
+///@param	graph - gives the shadow map texture
+///----------------------------------------------------------------------------
+void GLApp::CameraShadowedPass(void *data, const RenderGraph &graph)
+{
+	GLApp *app = (GLApp *)data;
+	app->RenderCamera(graph.GetTexture(app->m_FrameResources.shadowMap), Geometry::SHADOW_TEST_SHADOWED);
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: draws the spot lights' shadow maps into the atlas
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::ShadowAtlasPass(void *data, const RenderGraph &)
+{
+	GLApp *app = (GLApp *)data;
+
+	ProfileScope sample(app->m_Profiler, "Shadow atlas");
+	app->RenderShadowAtlas();
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: adds the light of the spot lights
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::SpotLightsPass(void *data, const RenderGraph &)
+{
+	GLApp *app = (GLApp *)data;
+
+	ProfileScope sample(app->m_Profiler, "Spot light passes");
+	app->RenderSpotLights();
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: issues the hardware occlusion queries
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::OcclusionQueryPass(void *data, const RenderGraph &)
+{
+	GLApp *app = (GLApp *)data;
+	GLfloat cameraPos[3];
+	app->m_Geometry.GetCameraPosition(cameraPos);
+
+	ProfileScope sample(app->m_Profiler, "Occlusion queries");
+	app->m_Occlusion.IssueQueries(app->m_Geometry, app->m_CameraObjects, cameraPos);
+	app->m_Profiler.AddCount("Occlusion queries issued", app->m_Occlusion.GetQueryCount());
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: builds the Hi-Z from a copy of the camera depth
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::HiZPass(void *data, const RenderGraph &)
+{
+	GLApp *app = (GLApp *)data;
+
+	ProfileScope sample(app->m_Profiler, "Hi-Z build");
+	app->m_GPUCulling.BuildHiZ(app->m_Width, app->m_Height,
+							   app->m_CameraProjectionMatrix, app->m_CameraViewMatrix);
+}
+
+///----------------------------------------------------------------------------
+///Render graph pass: draws the statistics on screen
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::StatsPass(void *data, const RenderGraph &)
+{
+	((GLApp *)data)->RenderStats();
+}
+
+///----------------------------------------------------------------------------
+///Job: animates a range of the animated objects
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::AnimateJob(void *data, UINT first, UINT count)
+{
+	GLApp *app = (GLApp *)data;
+	app->m_Geometry.Animate(app->m_AnimationAngle, first, count);
+}
+
+///----------------------------------------------------------------------------
+///Job: refits the hierarchy to the animated bounds
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::RefitJob(void *data, UINT, UINT)
+{
+	((GLApp *)data)->m_Geometry.RefitBVH();
+}
+
+///----------------------------------------------------------------------------
+///Job: finds the shadow casters
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::CullShadowJob(void *data, UINT, UINT)
+{
+	GLApp *app = (GLApp *)data;
+	if(app->m_PointShadow.IsValid())
+		app->m_PointShadow.Cull(app->m_Geometry, app->m_ShadowObjects);
+	else
+		app->m_Geometry.Cull(app->m_LightFrustum, app->m_ShadowObjects);
+}
+
+///----------------------------------------------------------------------------
+///Job: finds the objects inside the camera frustum
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::CullCameraJob(void *data, UINT, UINT)
+{
+	GLApp *app = (GLApp *)data;
+	app->m_Geometry.Cull(app->m_CameraFrustum, app->m_CameraObjects);
+}
+
+///----------------------------------------------------------------------------
+///Job: selects the level of detail of a range of a pass' objects
+///@param	data - the LODSelection of the pass
+///----------------------------------------------------------------------------
+void GLApp::SelectLODJob(void *data, UINT first, UINT count)
+{
+	LODSelection *selection = (LODSelection *)data;
+	UINT bytes;
+
+	UINT triangles = selection->app->m_Geometry.SelectLOD(selection->pass,
+		&(*selection->objects)[first], count, selection->eye, selection->pixelsPerUnit, &bytes);
+
+	InterlockedExchangeAdd(&selection->triangles, (LONG)triangles);
+	InterlockedExchangeAdd(&selection->bytes, (LONG)bytes);
+}
+
+///----------------------------------------------------------------------------
+///Job: records the draws of a chunk of a pass' objects in its own buffer
+///@param	data - the CommandRecording of the pass
+///----------------------------------------------------------------------------
+void GLApp::RecordJob(void *data, UINT first, UINT count)
+{
+	CommandRecording *recording = (CommandRecording *)data;
+	CommandBuffer &buffer = recording->app->m_Commands[recording->pass][first / RecordGrain];
+
+	buffer.Reset();
+	recording->app->m_Geometry.Record(&(*recording->objects)[first], count,
+									  recording->pass, buffer);
+}
+
+///----------------------------------------------------------------------------
+///Job: records the draws of the point light's cube map, one buffer per
+///group of faces
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::RecordPointShadowJob(void *data, UINT, UINT)
+{
+	GLApp *app = (GLApp *)data;
+	app->m_PointShadow.Record(app->m_Geometry, app->m_ShadowObjects);
+}
+
+///----------------------------------------------------------------------------
+///Job: sorts the recorded draws of a pass by key
+///@param	data - the CommandRecording of the pass
+///----------------------------------------------------------------------------
+void GLApp::SortJob(void *data, UINT, UINT)
+{
+	CommandRecording *recording = (CommandRecording *)data;
+	const std::vector<CommandBuffer> &buffers = recording->app->m_Commands[recording->pass];
+
+	recording->app->m_Queues[recording->pass].Build(buffers.empty() ? NULL : &buffers[0],
+													(UINT)buffers.size());
+}
+
+///----------------------------------------------------------------------------
+///Job: builds the indirect commands of a pass from its sorted queue (or
+///its buffers when the draws aren't sorted)
+///@param	data - the CommandRecording of the pass
+///----------------------------------------------------------------------------
+void GLApp::IndirectJob(void *data, UINT, UINT)
+{
+	CommandRecording *recording = (CommandRecording *)data;
+	GLApp *app = recording->app;
+	const std::vector<CommandBuffer> &buffers = app->m_Commands[recording->pass];
+
+	if(app->m_SortDraws)
+		app->m_MultiDraw.Build(recording->pass, app->m_Queues[recording->pass]);
+	else
+		app->m_MultiDraw.Build(recording->pass, buffers.empty() ? NULL : &buffers[0],
+							   (UINT)buffers.size());
+}
+
+///----------------------------------------------------------------------------
+///Job: packs a range of the objects for the GPU culling
+///@param	data - the application
+///----------------------------------------------------------------------------
+void GLApp::PackJob(void *data, UINT first, UINT count)
+{
+	GLApp *app = (GLApp *)data;
+	app->m_GPUCulling.Pack(app->m_Geometry, first, count);
 }
 
 ///----------------------------------------------------------------------------
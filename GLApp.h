@@ -14,6 +14,23 @@
 #include "GraphicsApp.h"
 #include "Geometry.h"
 #include "Timer.h"
+#include "Profiler.h"
+#include "Culling.h"
+#include "GLExtensions.h"
+#include "OcclusionCulling.h"
+#include "SoftwareOcclusion.h"
+#include "StreamingLoader.h"
+#include "JobSystem.h"
+#include "MultiDraw.h"
+#include "GPUCulling.h"
+#include "UploadRing.h"
+#include "FramePacer.h"
+#include "RenderGraph.h"
+#include "ShadowAtlas.h"
+#include "ShadowScheduler.h"
+#include "PointShadowMap.h"
+
+#include <vector>
 
 #include <GL/gl.h>
 #include <GL/glu.h>
@@ -35,19 +52,133 @@ public:
 	//-------------------------------------------------------------------------
 	virtual void InitGraphics();
 	virtual void Render();
+	virtual void HandleEvent(const WindowEvent &event);
+	virtual void ReleaseGraphics();
 	virtual void RenderText(LPTSTR text);
 	virtual bool ShutDown();
 	virtual LRESULT DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
+	virtual void ParseCommandLine(LPCTSTR cmdLine);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT BENCHMARK_FRAMES = 1000;	///> Default benchmark length
+	static const UINT BENCHMARK_WARMUP = 30;	///> Frames ignored by the benchmark
+	static const UINT DEFAULT_SPOT_LIGHTS = 6;	///> Spot lights of -spotlights without a count
 
 private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	enum OcclusionMode
+	{
+		OCCLUSION_OFF = 0,		///> Frustum culling only
+		OCCLUSION_HARDWARE,		///> GPU occlusion queries
+		OCCLUSION_SOFTWARE		///> CPU depth buffer
+	};
+
+	///Level of detail selection of one pass, split in jobs
+	struct LODSelection
+	{
+		GLApp*				app;			///> Owner of the scene
+		RenderPass			pass;			///> Pass whose levels are selected
+		const std::vector<UINT>* objects;	///> Culling result of the pass
+		GLfloat				eye[3];			///> Camera or light position
+		GLfloat				pixelsPerUnit;	///> Projected size of one unit
+		volatile LONG		triangles;		///> Triangles of the selected levels
+		volatile LONG		bytes;			///> Vertex bytes of the selected levels
+	};
+
+	///Recording of a pass' draws, one command buffer per chunk of objects
+	struct CommandRecording
+	{
+		GLApp*				app;			///> Owner of the scene
+		RenderPass			pass;			///> Pass being recorded
+		const std::vector<UINT>* objects;	///> Objects drawn by the pass
+		JobSystem::Counter	recorded;		///> Buffers not recorded yet
+		JobSystem::Counter	sorted;			///> Queue not sorted yet
+	};
+
+	///Resources the passes of the render graph read and write
+	struct FrameResources
+	{
+		RenderGraph::Handle	backBuffer;		///> Color and depth of the window
+		RenderGraph::Handle	shadowMap;		///> Depth seen from the light (transient)
+		RenderGraph::Handle	shadowMatrix;	///> Eye planes of the shadow texgen
+		RenderGraph::Handle	cameraCommands;	///> Recorded draws of the camera passes
+		RenderGraph::Handle	hiZ;			///> Depth pyramid the next frame culls with
+		RenderGraph::Handle	occlusion;		///> Query results the next frame culls with
+		RenderGraph::Handle	shadowAtlas;	///> Shadow maps of the spot lights
+	};
+
+	///Spot light shadowed from a tile of the shadow atlas
+	struct SpotLight
+	{
+		GLfloat		position[4];		///> World position (w = 1)
+		GLfloat		target[3];			///> Point the light aims at
+		GLfloat		direction[3];		///> Normalized direction of the cone
+		GLfloat		color[4];			///> Diffuse and specular color
+		GLfloat		cutoff;				///> Half angle of the cone in degrees
+		GLdouble	projection[16];		///> Projection of the shadow map
+		GLdouble	view[16];			///> Model-view of the shadow map
+		Frustum		frustum;			///> Culls the shadow casters
+		GLfloat		importance;			///> Fraction of the screen the cone covers
+		std::vector<UINT> casters;		///> Objects drawn into the tile
+		std::vector<UINT> receivers;	///> Casters the camera sees, drawn lit
+		UINT		casterHash;			///> Casters, their levels and transforms in the frustum
+		std::vector<BYTE> levels;		///> Shadow level of every object seen from the light
+	};
+
 	//-------------------------------------------------------------------------
 	//Private methods
 	//-------------------------------------------------------------------------
-	void CreateShadowMap(GLfloat angle);
-	void CreateTextureMatrix();
+	void CreateShadowMap(GLuint texture);
+	void CreateTextureMatrix(const GLdouble projection[16], const GLdouble view[16],
+							 const GLdouble *tile = NULL);
+	void RenderPointShadow();
+	void CreatePointTextureMatrix();
+	void CreateSpotLights();
+	void UpdateSpotLights();
+	void RenderShadowAtlas();
+	void RenderSpotLights();
+	void PrepareCameraCommands();
+	void RenderCamera(GLuint shadowMap, Geometry::ShadowTest test);
+	void BuildRenderGraph();
+	void UploadFrameData();
+	void CullScene(GLfloat angle);
+	void CullSceneGPU(GLfloat angle);
+	void SelectLOD(LODSelection &selection, JobSystem::Counter *counter);
+	void RecordCommands(RenderPass pass, const std::vector<UINT> &objects,
+						JobSystem::Counter *counter, JobSystem::Counter *dependency);
+	void ExecuteCommands(RenderPass pass);
+	void AddLoadedMeshes();
+	void RenderStats();
+	void WriteBenchmark();
 	void Reshape(int w,int h);
 	void Zoom(GLfloat zoomFactor);
 
+	static void AnimateJob(void *data, UINT first, UINT count);
+	static void RefitJob(void *data, UINT first, UINT count);
+	static void CullShadowJob(void *data, UINT first, UINT count);
+	static void CullCameraJob(void *data, UINT first, UINT count);
+	static void SelectLODJob(void *data, UINT first, UINT count);
+	static void RecordJob(void *data, UINT first, UINT count);
+	static void RecordPointShadowJob(void *data, UINT first, UINT count);
+	static void SortJob(void *data, UINT first, UINT count);
+	static void IndirectJob(void *data, UINT first, UINT count);
+	static void PackJob(void *data, UINT first, UINT count);
+
+	static void ShadowDepthPass(void *data, const RenderGraph &graph);
+	static void ShadowMatrixPass(void *data, const RenderGraph &graph);
+	static void CameraCommandsPass(void *data, const RenderGraph &graph);
+	static void CameraLitPass(void *data, const RenderGraph &graph);
+	static void CameraShadowedPass(void *data, const RenderGraph &graph);
+	static void ShadowAtlasPass(void *data, const RenderGraph &graph);
+	static void SpotLightsPass(void *data, const RenderGraph &graph);
+	static void OcclusionQueryPass(void *data, const RenderGraph &graph);
+	static void HiZPass(void *data, const RenderGraph &graph);
+	static void StatsPass(void *data, const RenderGraph &graph);
+
 	//-------------------------------------------------------------------------
 	//Private members
 	//-------------------------------------------------------------------------
@@ -58,6 +189,49 @@ private:
 	GLdouble	m_CameraViewMatrix[16];			///> Camera model-view matrix
 	GLdouble	m_LightProjectionMatrix[16];	///> Light projection matrix
 	GLdouble	m_LightViewMatrix[16];			///> Light model-view matrix
+	Profiler	m_Profiler;			///> Per-frame timings and counters
+	Frustum		m_CameraFrustum;	///> Camera frustum used for culling
+	Frustum		m_LightFrustum;		///> Light frustum used for caster culling
+	std::vector<UINT> m_CameraObjects;	///> Objects visible from the camera
+	std::vector<UINT> m_ShadowObjects;	///> Objects visible from the light
+	OcclusionCuller	m_Occlusion;		///> Hardware occlusion culling
+	SoftwareOcclusion m_SoftOcclusion;	///> Software occlusion culling
+	OcclusionMode	m_OcclusionMode;	///> Occlusion culling of the camera pass
+	GLuint		m_FontBase;			///> Display lists of the font glyphs
+	bool		m_ShowStats;		///> Draw statistics on screen
+	UINT		m_ExtraObjects;		///> Additional objects in the scene
+	UINT		m_BenchmarkFrames;	///> Frames to run in benchmark mode (0=off)
+	UINT		m_FrameCount;		///> Frames rendered so far
+	char		m_ScenePath[MAX_PATH];		///> Scene file to load (empty to generate)
+	char		m_SaveScenePath[MAX_PATH];	///> Scene file to write (empty for none)
+	char		m_ImportPath[MAX_PATH];		///> OBJ/PLY model to add (empty for none)
+	StreamingLoader	m_Loader;		///> Loads the imported model in the background
+	UINT		m_UploadBudget;		///> Bytes the loader uploads per frame
+	JobSystem	m_Jobs;				///> Runs the per-frame CPU stages on every core
+	int			m_JobThreads;		///> Worker threads (-1 for one per core)
+	GLfloat		m_AnimationAngle;	///> Angle the animation jobs rotate to
+	std::vector<CommandBuffer> m_Commands[PASS_COUNT];	///> Recorded draws of each pass
+	CommandRecording m_Recording[PASS_COUNT];	///> Parameters of the recording jobs
+	CommandBuffer m_ConditionalCommands;	///> Camera draws that depend on a query
+	DrawQueue	m_Queues[PASS_COUNT];	///> Recorded draws of each pass sorted by key
+	bool		m_SortDraws;		///> Replay the sorted queues (or the buffers in order)
+	MultiDraw	m_MultiDraw;		///> Draws each pass with one indirect call
+	bool		m_UseMultiDraw;		///> Use m_MultiDraw when it's supported
+	GPUCulling	m_GPUCulling;		///> Culls both passes with a compute shader
+	bool		m_UseGPUCulling;	///> Use m_GPUCulling when it's supported
+	UploadRing	m_UploadRing;		///> Per-frame data of the GPU-driven paths
+	FramePacer	m_Pacer;			///> Keeps a fixed number of frames in flight
+	UINT		m_FramesInFlight;	///> Frames the GPU may be behind the CPU
+	RenderGraph	m_Graph;			///> Orders the passes and aliases their textures
+	FrameResources m_FrameResources;	///> Resources declared in m_Graph this frame
+	std::vector<SpotLight> m_SpotLights;	///> Lights shadowed from the atlas
+	UINT		m_SpotLightCount;	///> Spot lights to create (0 for none)
+	ShadowAtlas	m_ShadowAtlas;		///> Shadow maps of every spot light
+	UINT		m_AtlasSize;		///> Size of m_ShadowAtlas in texels
+	ShadowScheduler m_ShadowScheduler;	///> Picks the tiles redrawn each frame
+	std::vector<UINT> m_ShadowUpdates;	///> Spot lights whose tiles are drawn this frame
+	PointShadowMap m_PointShadow;	///> Shadows of the main light in every direction
+	UINT		m_PointShadowSize;	///> Face size of m_PointShadow (0 for the 2D map)
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,322 @@
+///============================================================================
+///@file	GLExtensions.cpp
+///@brief	Loads the OpenGL extension entry points used by the demo.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "GLExtensions.h"
+#include <string.h>
+#include <stdlib.h>
+
+//-----------------------------------------------------------------------------
+//Entry points
+//-----------------------------------------------------------------------------
+PFNGLGENQUERIESARBPROC				glGenQueriesARB				= NULL;
+PFNGLDELETEQUERIESARBPROC			glDeleteQueriesARB			= NULL;
+PFNGLBEGINQUERYARBPROC				glBeginQueryARB				= NULL;
+PFNGLENDQUERYARBPROC				glEndQueryARB				= NULL;
+PFNGLGETQUERYOBJECTUIVARBPROC		glGetQueryObjectuivARB		= NULL;
+PFNGLGENBUFFERSARBPROC				glGenBuffersARB				= NULL;
+PFNGLDELETEBUFFERSARBPROC			glDeleteBuffersARB			= NULL;
+PFNGLBINDBUFFERARBPROC				glBindBufferARB				= NULL;
+PFNGLBUFFERDATAARBPROC				glBufferDataARB				= NULL;
+PFNGLBUFFERSUBDATAARBPROC			glBufferSubDataARB			= NULL;
+PFNGLCREATESHADERPROC				glCreateShader				= NULL;
+PFNGLDELETESHADERPROC				glDeleteShader				= NULL;
+PFNGLSHADERSOURCEPROC				glShaderSource				= NULL;
+PFNGLCOMPILESHADERPROC				glCompileShader				= NULL;
+PFNGLGETSHADERIVPROC				glGetShaderiv				= NULL;
+PFNGLGETSHADERINFOLOGPROC			glGetShaderInfoLog			= NULL;
+PFNGLCREATEPROGRAMPROC				glCreateProgram				= NULL;
+PFNGLDELETEPROGRAMPROC				glDeleteProgram				= NULL;
+PFNGLATTACHSHADERPROC				glAttachShader				= NULL;
+PFNGLLINKPROGRAMPROC				glLinkProgram				= NULL;
+PFNGLGETPROGRAMIVPROC				glGetProgramiv				= NULL;
+PFNGLGETPROGRAMINFOLOGPROC			glGetProgramInfoLog			= NULL;
+PFNGLUSEPROGRAMPROC					glUseProgram				= NULL;
+PFNGLGETUNIFORMLOCATIONPROC			glGetUniformLocation		= NULL;
+PFNGLGETATTRIBLOCATIONPROC			glGetAttribLocation			= NULL;
+PFNGLUNIFORM1FPROC					glUniform1f					= NULL;
+PFNGLUNIFORM1IPROC					glUniform1i					= NULL;
+PFNGLUNIFORM3FVPROC					glUniform3fv				= NULL;
+PFNGLVERTEXATTRIBPOINTERPROC		glVertexAttribPointer		= NULL;
+PFNGLENABLEVERTEXATTRIBARRAYPROC	glEnableVertexAttribArray	= NULL;
+PFNGLDISABLEVERTEXATTRIBARRAYPROC	glDisableVertexAttribArray	= NULL;
+PFNGLBEGINCONDITIONALRENDERNVPROC	glBeginConditionalRenderNV	= NULL;
+PFNGLENDCONDITIONALRENDERNVPROC		glEndConditionalRenderNV	= NULL;
+PFNGLGENSAMPLERSPROC				glGenSamplers				= NULL;
+PFNGLDELETESAMPLERSPROC				glDeleteSamplers			= NULL;
+PFNGLBINDSAMPLERPROC				glBindSampler				= NULL;
+PFNGLSAMPLERPARAMETERIPROC			glSamplerParameteri			= NULL;
+PFNGLBINDBUFFERBASEPROC				glBindBufferBase			= NULL;
+PFNGLBINDBUFFERRANGEPROC			glBindBufferRange			= NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC	glMultiDrawElementsIndirect	= NULL;
+PFNGLDISPATCHCOMPUTEPROC			glDispatchCompute			= NULL;
+PFNGLMEMORYBARRIERPROC				glMemoryBarrier				= NULL;
+PFNGLBINDIMAGETEXTUREPROC			glBindImageTexture			= NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTARBPROC glMultiDrawElementsIndirectCountARB = NULL;
+PFNGLGETBUFFERSUBDATAARBPROC		glGetBufferSubDataARB		= NULL;
+PFNGLUNIFORM2FVPROC					glUniform2fv				= NULL;
+PFNGLUNIFORM4FVPROC					glUniform4fv				= NULL;
+PFNGLUNIFORMMATRIX4FVPROC			glUniformMatrix4fv			= NULL;
+PFNGLBUFFERSTORAGEPROC				glBufferStorage				= NULL;
+PFNGLMAPBUFFERRANGEPROC				glMapBufferRange			= NULL;
+PFNGLCOPYBUFFERSUBDATAPROC			glCopyBufferSubData			= NULL;
+PFNGLFENCESYNCPROC					glFenceSync					= NULL;
+PFNGLCLIENTWAITSYNCPROC				glClientWaitSync			= NULL;
+PFNGLDELETESYNCPROC					glDeleteSync				= NULL;
+PFNGLQUERYCOUNTERPROC				glQueryCounter				= NULL;
+PFNGLGETQUERYOBJECTUI64VPROC		glGetQueryObjectui64v		= NULL;
+PFNGLGENFRAMEBUFFERSPROC			glGenFramebuffers			= NULL;
+PFNGLDELETEFRAMEBUFFERSPROC			glDeleteFramebuffers		= NULL;
+PFNGLBINDFRAMEBUFFERPROC			glBindFramebuffer			= NULL;
+PFNGLFRAMEBUFFERTEXTURE2DPROC		glFramebufferTexture2D		= NULL;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC		glCheckFramebufferStatus	= NULL;
+PFNGLFRAMEBUFFERTEXTUREPROC			glFramebufferTexture		= NULL;
+
+GLCaps g_GLCaps;
+
+///----------------------------------------------------------------------------
+///Checks the extension string of the current context
+///@param	name - extension name (i.e. "GL_ARB_occlusion_query")
+///@returns true if the extension is supported
+///----------------------------------------------------------------------------
+bool IsExtensionSupported(LPCSTR name)
+{
+	const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+	if(!extensions || !name) return false;
+
+	size_t len = strlen(name);
+	const char *p = extensions;
+
+	//names are separated by spaces, make sure we match a whole word
+	while((p = strstr(p, name)) != NULL)
+	{
+		if((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+			return true;
+
+		p += len;
+	}
+
+	return false;
+}
+
+///----------------------------------------------------------------------------
+///@returns the major version number of the current context
+///----------------------------------------------------------------------------
+static int GetGLMajorVersion()
+{
+	const char *version = (const char *)glGetString(GL_VERSION);
+	return version ? atoi(version) : 1;
+}
+
+///----------------------------------------------------------------------------
+///@returns the minor version number of the current context
+///----------------------------------------------------------------------------
+static int GetGLMinorVersion()
+{
+	const char *version = (const char *)glGetString(GL_VERSION);
+	const char *dot = version ? strchr(version, '.') : NULL;
+	return dot ? atoi(dot + 1) : 0;
+}
+
+///----------------------------------------------------------------------------
+///Loads every entry point we may use, must be called with a current context.
+///Optional features which are not available are flagged off in g_GLCaps.
+///----------------------------------------------------------------------------
+void InitExtensions()
+{
+	memset(&g_GLCaps, 0, sizeof(g_GLCaps));
+
+	if(IsExtensionSupported("GL_ARB_occlusion_query"))
+	{
+		glGenQueriesARB			= (PFNGLGENQUERIESARBPROC)wglGetProcAddress("glGenQueriesARB");
+		glDeleteQueriesARB		= (PFNGLDELETEQUERIESARBPROC)wglGetProcAddress("glDeleteQueriesARB");
+		glBeginQueryARB			= (PFNGLBEGINQUERYARBPROC)wglGetProcAddress("glBeginQueryARB");
+		glEndQueryARB			= (PFNGLENDQUERYARBPROC)wglGetProcAddress("glEndQueryARB");
+		glGetQueryObjectuivARB	= (PFNGLGETQUERYOBJECTUIVARBPROC)wglGetProcAddress("glGetQueryObjectuivARB");
+
+		g_GLCaps.occlusionQuery = glGenQueriesARB && glDeleteQueriesARB && glBeginQueryARB &&
+								  glEndQueryARB && glGetQueryObjectuivARB;
+	}
+
+	if(IsExtensionSupported("GL_ARB_vertex_buffer_object"))
+	{
+		glGenBuffersARB		= (PFNGLGENBUFFERSARBPROC)wglGetProcAddress("glGenBuffersARB");
+		glDeleteBuffersARB	= (PFNGLDELETEBUFFERSARBPROC)wglGetProcAddress("glDeleteBuffersARB");
+		glBindBufferARB		= (PFNGLBINDBUFFERARBPROC)wglGetProcAddress("glBindBufferARB");
+		glBufferDataARB		= (PFNGLBUFFERDATAARBPROC)wglGetProcAddress("glBufferDataARB");
+		glBufferSubDataARB	= (PFNGLBUFFERSUBDATAARBPROC)wglGetProcAddress("glBufferSubDataARB");
+
+		g_GLCaps.vertexBufferObject = glGenBuffersARB && glDeleteBuffersARB &&
+									  glBindBufferARB && glBufferDataARB && glBufferSubDataARB;
+	}
+
+	if(GetGLMajorVersion() >= 2)
+	{
+		glCreateShader				= (PFNGLCREATESHADERPROC)wglGetProcAddress("glCreateShader");
+		glDeleteShader				= (PFNGLDELETESHADERPROC)wglGetProcAddress("glDeleteShader");
+		glShaderSource				= (PFNGLSHADERSOURCEPROC)wglGetProcAddress("glShaderSource");
+		glCompileShader				= (PFNGLCOMPILESHADERPROC)wglGetProcAddress("glCompileShader");
+		glGetShaderiv				= (PFNGLGETSHADERIVPROC)wglGetProcAddress("glGetShaderiv");
+		glGetShaderInfoLog			= (PFNGLGETSHADERINFOLOGPROC)wglGetProcAddress("glGetShaderInfoLog");
+		glCreateProgram				= (PFNGLCREATEPROGRAMPROC)wglGetProcAddress("glCreateProgram");
+		glDeleteProgram				= (PFNGLDELETEPROGRAMPROC)wglGetProcAddress("glDeleteProgram");
+		glAttachShader				= (PFNGLATTACHSHADERPROC)wglGetProcAddress("glAttachShader");
+		glLinkProgram				= (PFNGLLINKPROGRAMPROC)wglGetProcAddress("glLinkProgram");
+		glGetProgramiv				= (PFNGLGETPROGRAMIVPROC)wglGetProcAddress("glGetProgramiv");
+		glGetProgramInfoLog			= (PFNGLGETPROGRAMINFOLOGPROC)wglGetProcAddress("glGetProgramInfoLog");
+		glUseProgram				= (PFNGLUSEPROGRAMPROC)wglGetProcAddress("glUseProgram");
+		glGetUniformLocation		= (PFNGLGETUNIFORMLOCATIONPROC)wglGetProcAddress("glGetUniformLocation");
+		glGetAttribLocation			= (PFNGLGETATTRIBLOCATIONPROC)wglGetProcAddress("glGetAttribLocation");
+		glUniform1f					= (PFNGLUNIFORM1FPROC)wglGetProcAddress("glUniform1f");
+		glUniform1i					= (PFNGLUNIFORM1IPROC)wglGetProcAddress("glUniform1i");
+		glUniform3fv				= (PFNGLUNIFORM3FVPROC)wglGetProcAddress("glUniform3fv");
+		glVertexAttribPointer		= (PFNGLVERTEXATTRIBPOINTERPROC)wglGetProcAddress("glVertexAttribPointer");
+		glEnableVertexAttribArray	= (PFNGLENABLEVERTEXATTRIBARRAYPROC)wglGetProcAddress("glEnableVertexAttribArray");
+		glDisableVertexAttribArray	= (PFNGLDISABLEVERTEXATTRIBARRAYPROC)wglGetProcAddress("glDisableVertexAttribArray");
+
+		g_GLCaps.glsl = glCreateShader && glDeleteShader && glShaderSource && glCompileShader &&
+						glGetShaderiv && glGetShaderInfoLog && glCreateProgram && glDeleteProgram &&
+						glAttachShader && glLinkProgram && glGetProgramiv && glGetProgramInfoLog &&
+						glUseProgram && glGetUniformLocation && glGetAttribLocation && glUniform1f &&
+						glUniform1i && glUniform3fv && glVertexAttribPointer &&
+						glEnableVertexAttribArray && glDisableVertexAttribArray;
+	}
+
+	if(IsExtensionSupported("GL_NV_conditional_render"))
+	{
+		glBeginConditionalRenderNV	= (PFNGLBEGINCONDITIONALRENDERNVPROC)wglGetProcAddress("glBeginConditionalRenderNV");
+		glEndConditionalRenderNV	= (PFNGLENDCONDITIONALRENDERNVPROC)wglGetProcAddress("glEndConditionalRenderNV");
+	}
+	else if(GetGLMajorVersion() >= 3)
+	{
+		//same entry points and tokens, promoted to core
+		glBeginConditionalRenderNV	= (PFNGLBEGINCONDITIONALRENDERNVPROC)wglGetProcAddress("glBeginConditionalRender");
+		glEndConditionalRenderNV	= (PFNGLENDCONDITIONALRENDERNVPROC)wglGetProcAddress("glEndConditionalRender");
+	}
+
+	g_GLCaps.conditionalRender = g_GLCaps.occlusionQuery &&
+								 glBeginConditionalRenderNV && glEndConditionalRenderNV;
+
+	//the ARB extension has no suffix, drivers with OpenGL 3.3 always list it
+	if(IsExtensionSupported("GL_ARB_sampler_objects"))
+	{
+		glGenSamplers		= (PFNGLGENSAMPLERSPROC)wglGetProcAddress("glGenSamplers");
+		glDeleteSamplers	= (PFNGLDELETESAMPLERSPROC)wglGetProcAddress("glDeleteSamplers");
+		glBindSampler		= (PFNGLBINDSAMPLERPROC)wglGetProcAddress("glBindSampler");
+		glSamplerParameteri	= (PFNGLSAMPLERPARAMETERIPROC)wglGetProcAddress("glSamplerParameteri");
+
+		g_GLCaps.samplerObjects = glGenSamplers && glDeleteSamplers &&
+								  glBindSampler && glSamplerParameteri;
+	}
+
+	//the draw index is only visible to the shaders with draw parameters
+	//(core in 4.6), the per-draw data is read from a storage buffer and
+	//the per-frame matrices from a uniform buffer
+	if(g_GLCaps.glsl && g_GLCaps.vertexBufferObject &&
+	   IsExtensionSupported("GL_ARB_multi_draw_indirect") &&
+	   IsExtensionSupported("GL_ARB_shader_draw_parameters") &&
+	   IsExtensionSupported("GL_ARB_shader_storage_buffer_object") &&
+	   IsExtensionSupported("GL_ARB_uniform_buffer_object"))
+	{
+		glBindBufferBase			= (PFNGLBINDBUFFERBASEPROC)wglGetProcAddress("glBindBufferBase");
+		glBindBufferRange			= (PFNGLBINDBUFFERRANGEPROC)wglGetProcAddress("glBindBufferRange");
+		glMultiDrawElementsIndirect	= (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)wglGetProcAddress("glMultiDrawElementsIndirect");
+
+		g_GLCaps.multiDrawIndirect = glBindBufferBase && glBindBufferRange && glMultiDrawElementsIndirect;
+	}
+
+	//compute shaders write buffers and images, the storage buffers come
+	//with multi-draw above
+	if(g_GLCaps.multiDrawIndirect && IsExtensionSupported("GL_ARB_compute_shader") &&
+	   IsExtensionSupported("GL_ARB_shader_image_load_store") && IsExtensionSupported("GL_ARB_texture_rg"))
+	{
+		glDispatchCompute		= (PFNGLDISPATCHCOMPUTEPROC)wglGetProcAddress("glDispatchCompute");
+		glMemoryBarrier			= (PFNGLMEMORYBARRIERPROC)wglGetProcAddress("glMemoryBarrier");
+		glBindImageTexture		= (PFNGLBINDIMAGETEXTUREPROC)wglGetProcAddress("glBindImageTexture");
+		glGetBufferSubDataARB	= (PFNGLGETBUFFERSUBDATAARBPROC)wglGetProcAddress("glGetBufferSubDataARB");
+		glUniform2fv			= (PFNGLUNIFORM2FVPROC)wglGetProcAddress("glUniform2fv");
+		glUniform4fv			= (PFNGLUNIFORM4FVPROC)wglGetProcAddress("glUniform4fv");
+		glUniformMatrix4fv		= (PFNGLUNIFORMMATRIX4FVPROC)wglGetProcAddress("glUniformMatrix4fv");
+
+		g_GLCaps.computeShader = glDispatchCompute && glMemoryBarrier && glBindImageTexture &&
+								 glGetBufferSubDataARB && glUniform2fv && glUniform4fv &&
+								 glUniformMatrix4fv;
+	}
+
+	if(g_GLCaps.multiDrawIndirect && IsExtensionSupported("GL_ARB_indirect_parameters"))
+	{
+		glMultiDrawElementsIndirectCountARB = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTARBPROC)
+			wglGetProcAddress("glMultiDrawElementsIndirectCountARB");
+
+		g_GLCaps.indirectCount = glMultiDrawElementsIndirectCountARB != NULL;
+	}
+
+	//fences tell the CPU when the GPU is done with the commands of a frame
+	if(IsExtensionSupported("GL_ARB_sync"))
+	{
+		glFenceSync			= (PFNGLFENCESYNCPROC)wglGetProcAddress("glFenceSync");
+		glClientWaitSync	= (PFNGLCLIENTWAITSYNCPROC)wglGetProcAddress("glClientWaitSync");
+		glDeleteSync		= (PFNGLDELETESYNCPROC)wglGetProcAddress("glDeleteSync");
+
+		g_GLCaps.fenceSync = glFenceSync && glClientWaitSync && glDeleteSync;
+	}
+
+	//buffers mapped once and written while the GPU reads other parts of
+	//them, the fences tell when a part can be written again (staged data
+	//is copied from them to other buffers)
+	if(g_GLCaps.vertexBufferObject && g_GLCaps.fenceSync &&
+	   IsExtensionSupported("GL_ARB_buffer_storage") && IsExtensionSupported("GL_ARB_map_buffer_range") &&
+	   IsExtensionSupported("GL_ARB_copy_buffer"))
+	{
+		glBufferStorage		= (PFNGLBUFFERSTORAGEPROC)wglGetProcAddress("glBufferStorage");
+		glMapBufferRange	= (PFNGLMAPBUFFERRANGEPROC)wglGetProcAddress("glMapBufferRange");
+		glCopyBufferSubData	= (PFNGLCOPYBUFFERSUBDATAPROC)wglGetProcAddress("glCopyBufferSubData");
+
+		g_GLCaps.persistentMapping = glBufferStorage && glMapBufferRange && glCopyBufferSubData;
+	}
+
+	//time queries use the occlusion query entry points
+	if(g_GLCaps.occlusionQuery && IsExtensionSupported("GL_ARB_timer_query"))
+	{
+		glQueryCounter = (PFNGLQUERYCOUNTERPROC)wglGetProcAddress("glQueryCounter");
+		glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)wglGetProcAddress("glGetQueryObjectui64v");
+
+		g_GLCaps.timerQuery = glQueryCounter && glGetQueryObjectui64v;
+	}
+
+	//render targets other than the window, the EXT entry points take the
+	//same arguments
+	if(IsExtensionSupported("GL_ARB_framebuffer_object") || GetGLMajorVersion() >= 3)
+	{
+		glGenFramebuffers			= (PFNGLGENFRAMEBUFFERSPROC)wglGetProcAddress("glGenFramebuffers");
+		glDeleteFramebuffers		= (PFNGLDELETEFRAMEBUFFERSPROC)wglGetProcAddress("glDeleteFramebuffers");
+		glBindFramebuffer			= (PFNGLBINDFRAMEBUFFERPROC)wglGetProcAddress("glBindFramebuffer");
+		glFramebufferTexture2D		= (PFNGLFRAMEBUFFERTEXTURE2DPROC)wglGetProcAddress("glFramebufferTexture2D");
+		glCheckFramebufferStatus	= (PFNGLCHECKFRAMEBUFFERSTATUSPROC)wglGetProcAddress("glCheckFramebufferStatus");
+	}
+	else if(IsExtensionSupported("GL_EXT_framebuffer_object"))
+	{
+		glGenFramebuffers			= (PFNGLGENFRAMEBUFFERSPROC)wglGetProcAddress("glGenFramebuffersEXT");
+		glDeleteFramebuffers		= (PFNGLDELETEFRAMEBUFFERSPROC)wglGetProcAddress("glDeleteFramebuffersEXT");
+		glBindFramebuffer			= (PFNGLBINDFRAMEBUFFERPROC)wglGetProcAddress("glBindFramebufferEXT");
+		glFramebufferTexture2D		= (PFNGLFRAMEBUFFERTEXTURE2DPROC)wglGetProcAddress("glFramebufferTexture2DEXT");
+		glCheckFramebufferStatus	= (PFNGLCHECKFRAMEBUFFERSTATUSPROC)wglGetProcAddress("glCheckFramebufferStatusEXT");
+	}
+
+	g_GLCaps.framebufferObject = glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer &&
+								 glFramebufferTexture2D && glCheckFramebufferStatus;
+
+	//a geometry shader picks the cube map face (layer) of every triangle, so
+	//the six faces are drawn in one pass
+	int major = GetGLMajorVersion();
+	if(g_GLCaps.glsl && g_GLCaps.framebufferObject &&
+	   (major > 3 || (major == 3 && GetGLMinorVersion() >= 2)))
+	{
+		glFramebufferTexture = (PFNGLFRAMEBUFFERTEXTUREPROC)wglGetProcAddress("glFramebufferTexture");
+
+		g_GLCaps.layeredRendering = glFramebufferTexture != NULL;
+	}
+}
@@ -0,0 +1,301 @@
+///============================================================================
+///@file	GLExtensions.h
+///@brief	Loads the OpenGL extension entry points used by the demo.
+///			Windows only exports OpenGL 1.1 from opengl32.dll, everything
+///			newer has to be fetched with wglGetProcAddress once a rendering
+///			context is current. Tokens missing from our glext.h are
+///			defined here as well.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+//-----------------------------------------------------------------------------
+//GL_NV_conditional_render (also core in OpenGL 3.0)
+//-----------------------------------------------------------------------------
+#ifndef GL_NV_conditional_render
+#define GL_QUERY_WAIT_NV					0x8E13
+#define GL_QUERY_NO_WAIT_NV					0x8E14
+#define GL_QUERY_BY_REGION_WAIT_NV			0x8E15
+#define GL_QUERY_BY_REGION_NO_WAIT_NV		0x8E16
+typedef void (APIENTRYP PFNGLBEGINCONDITIONALRENDERNVPROC) (GLuint id, GLenum mode);
+typedef void (APIENTRYP PFNGLENDCONDITIONALRENDERNVPROC) (void);
+#endif
+
+//-----------------------------------------------------------------------------
+//GL_ARB_sampler_objects (also core in OpenGL 3.3)
+//-----------------------------------------------------------------------------
+#ifndef GL_ARB_sampler_objects
+#define GL_SAMPLER_BINDING					0x8919
+typedef void (APIENTRYP PFNGLGENSAMPLERSPROC) (GLsizei count, GLuint *samplers);
+typedef void (APIENTRYP PFNGLDELETESAMPLERSPROC) (GLsizei count, const GLuint *samplers);
+typedef void (APIENTRYP PFNGLBINDSAMPLERPROC) (GLuint unit, GLuint sampler);
+typedef void (APIENTRYP PFNGLSAMPLERPARAMETERIPROC) (GLuint sampler, GLenum pname, GLint param);
+#endif
+
+//-----------------------------------------------------------------------------
+//Indirect draws and shader storage buffers (core in OpenGL 4.3), the
+//per-frame matrices are read from a uniform buffer (core in 3.1)
+//-----------------------------------------------------------------------------
+#ifndef GL_VERSION_3_0
+typedef void (APIENTRYP PFNGLBINDBUFFERBASEPROC) (GLenum target, GLuint index, GLuint buffer);
+typedef void (APIENTRYP PFNGLBINDBUFFERRANGEPROC) (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+#endif
+
+#ifndef GL_ARB_uniform_buffer_object
+#define GL_UNIFORM_BUFFER					0x8A11
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT	0x8A34
+#endif
+
+#ifndef GL_ARB_draw_indirect
+#define GL_DRAW_INDIRECT_BUFFER				0x8F3F
+#endif
+
+#ifndef GL_ARB_multi_draw_indirect
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC) (GLenum mode, GLenum type, const GLvoid *indirect, GLsizei drawcount, GLsizei stride);
+#endif
+
+#ifndef GL_ARB_shader_storage_buffer_object
+#define GL_SHADER_STORAGE_BUFFER			0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+//-----------------------------------------------------------------------------
+//Compute shaders, image stores and draw counts read from a buffer
+//-----------------------------------------------------------------------------
+#ifndef GL_ARB_texture_rg
+#define GL_R32F								0x822E
+#endif
+
+#ifndef GL_ARB_shader_image_load_store
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT	0x00000020
+#define GL_COMMAND_BARRIER_BIT				0x00000040
+#define GL_TEXTURE_FETCH_BARRIER_BIT		0x00000008
+#define GL_BUFFER_UPDATE_BARRIER_BIT		0x00000200
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC) (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC) (GLbitfield barriers);
+#endif
+
+#ifndef GL_ARB_shader_storage_buffer_object
+#define GL_SHADER_STORAGE_BARRIER_BIT		0x00002000
+#endif
+
+#ifndef GL_ARB_compute_shader
+#define GL_COMPUTE_SHADER					0x91B9
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC) (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+#endif
+
+#ifndef GL_ARB_indirect_parameters
+#define GL_PARAMETER_BUFFER_ARB				0x80EE
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTARBPROC) (GLenum mode, GLenum type, const GLvoid *indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
+#endif
+
+//-----------------------------------------------------------------------------
+//Persistently mapped buffers and fences (core in OpenGL 4.4 and 3.2)
+//-----------------------------------------------------------------------------
+#ifndef GL_ARB_map_buffer_range
+#define GL_MAP_WRITE_BIT					0x0002
+typedef GLvoid* (APIENTRYP PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+#endif
+
+#ifndef GL_ARB_buffer_storage
+#define GL_MAP_PERSISTENT_BIT				0x0040
+#define GL_MAP_COHERENT_BIT					0x0080
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const GLvoid *data, GLbitfield flags);
+#endif
+
+#ifndef GL_ARB_copy_buffer
+#define GL_COPY_READ_BUFFER					0x8F36
+#define GL_COPY_WRITE_BUFFER				0x8F37
+typedef void (APIENTRYP PFNGLCOPYBUFFERSUBDATAPROC) (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+#endif
+
+#ifndef GL_ARB_sync
+#define GL_SYNC_GPU_COMMANDS_COMPLETE		0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT			0x00000001
+#define GL_ALREADY_SIGNALED					0x911A
+#define GL_TIMEOUT_EXPIRED					0x911B
+#define GL_CONDITION_SATISFIED				0x911C
+#define GL_WAIT_FAILED						0x911D
+typedef UINT64 GLuint64;
+typedef struct __GLsync *GLsync;
+typedef GLsync (APIENTRYP PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRYP PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRYP PFNGLDELETESYNCPROC) (GLsync sync);
+#endif
+
+//-----------------------------------------------------------------------------
+//GL_ARB_timer_query (also core in OpenGL 3.3)
+//-----------------------------------------------------------------------------
+#ifndef GL_ARB_timer_query
+#define GL_TIME_ELAPSED						0x88BF
+#define GL_TIMESTAMP						0x8E28
+typedef void (APIENTRYP PFNGLQUERYCOUNTERPROC) (GLuint id, GLenum target);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, GLuint64 *params);
+#endif
+
+//-----------------------------------------------------------------------------
+//GL_ARB_framebuffer_object (also core in OpenGL 3.0, same tokens and entry
+//points with an EXT suffix in GL_EXT_framebuffer_object)
+//-----------------------------------------------------------------------------
+#ifndef GL_ARB_framebuffer_object
+#define GL_FRAMEBUFFER						0x8D40
+#define GL_DEPTH_ATTACHMENT					0x8D00
+#define GL_FRAMEBUFFER_COMPLETE				0x8CD5
+typedef void (APIENTRYP PFNGLGENFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLBINDFRAMEBUFFERPROC) (GLenum target, GLuint framebuffer);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURE2DPROC) (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef GLenum (APIENTRYP PFNGLCHECKFRAMEBUFFERSTATUSPROC) (GLenum target);
+#endif
+
+//-----------------------------------------------------------------------------
+//Geometry shaders and layered framebuffer attachments (core in OpenGL 3.2)
+//-----------------------------------------------------------------------------
+#ifndef GL_VERSION_3_2
+#define GL_GEOMETRY_SHADER					0x8DD9
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTUREPROC) (GLenum target, GLenum attachment, GLuint texture, GLint level);
+#endif
+
+//-----------------------------------------------------------------------------
+//GL_ARB_occlusion_query
+//-----------------------------------------------------------------------------
+extern PFNGLGENQUERIESARBPROC			glGenQueriesARB;
+extern PFNGLDELETEQUERIESARBPROC		glDeleteQueriesARB;
+extern PFNGLBEGINQUERYARBPROC			glBeginQueryARB;
+extern PFNGLENDQUERYARBPROC				glEndQueryARB;
+extern PFNGLGETQUERYOBJECTUIVARBPROC	glGetQueryObjectuivARB;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_vertex_buffer_object
+//-----------------------------------------------------------------------------
+extern PFNGLGENBUFFERSARBPROC			glGenBuffersARB;
+extern PFNGLDELETEBUFFERSARBPROC		glDeleteBuffersARB;
+extern PFNGLBINDBUFFERARBPROC			glBindBufferARB;
+extern PFNGLBUFFERDATAARBPROC			glBufferDataARB;
+extern PFNGLBUFFERSUBDATAARBPROC		glBufferSubDataARB;
+
+//-----------------------------------------------------------------------------
+//OpenGL 2.0 shaders
+//-----------------------------------------------------------------------------
+extern PFNGLCREATESHADERPROC			glCreateShader;
+extern PFNGLDELETESHADERPROC			glDeleteShader;
+extern PFNGLSHADERSOURCEPROC			glShaderSource;
+extern PFNGLCOMPILESHADERPROC			glCompileShader;
+extern PFNGLGETSHADERIVPROC				glGetShaderiv;
+extern PFNGLGETSHADERINFOLOGPROC		glGetShaderInfoLog;
+extern PFNGLCREATEPROGRAMPROC			glCreateProgram;
+extern PFNGLDELETEPROGRAMPROC			glDeleteProgram;
+extern PFNGLATTACHSHADERPROC			glAttachShader;
+extern PFNGLLINKPROGRAMPROC				glLinkProgram;
+extern PFNGLGETPROGRAMIVPROC			glGetProgramiv;
+extern PFNGLGETPROGRAMINFOLOGPROC		glGetProgramInfoLog;
+extern PFNGLUSEPROGRAMPROC				glUseProgram;
+extern PFNGLGETUNIFORMLOCATIONPROC		glGetUniformLocation;
+extern PFNGLGETATTRIBLOCATIONPROC		glGetAttribLocation;
+extern PFNGLUNIFORM1FPROC				glUniform1f;
+extern PFNGLUNIFORM1IPROC				glUniform1i;
+extern PFNGLUNIFORM3FVPROC				glUniform3fv;
+extern PFNGLVERTEXATTRIBPOINTERPROC		glVertexAttribPointer;
+extern PFNGLENABLEVERTEXATTRIBARRAYPROC	glEnableVertexAttribArray;
+extern PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
+
+//-----------------------------------------------------------------------------
+//GL_NV_conditional_render
+//-----------------------------------------------------------------------------
+extern PFNGLBEGINCONDITIONALRENDERNVPROC	glBeginConditionalRenderNV;
+extern PFNGLENDCONDITIONALRENDERNVPROC		glEndConditionalRenderNV;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_sampler_objects
+//-----------------------------------------------------------------------------
+extern PFNGLGENSAMPLERSPROC				glGenSamplers;
+extern PFNGLDELETESAMPLERSPROC			glDeleteSamplers;
+extern PFNGLBINDSAMPLERPROC				glBindSampler;
+extern PFNGLSAMPLERPARAMETERIPROC		glSamplerParameteri;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_multi_draw_indirect
+//-----------------------------------------------------------------------------
+extern PFNGLBINDBUFFERBASEPROC				glBindBufferBase;
+extern PFNGLBINDBUFFERRANGEPROC				glBindBufferRange;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC	glMultiDrawElementsIndirect;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_compute_shader and GL_ARB_indirect_parameters
+//-----------------------------------------------------------------------------
+extern PFNGLDISPATCHCOMPUTEPROC				glDispatchCompute;
+extern PFNGLMEMORYBARRIERPROC				glMemoryBarrier;
+extern PFNGLBINDIMAGETEXTUREPROC			glBindImageTexture;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTARBPROC glMultiDrawElementsIndirectCountARB;
+extern PFNGLGETBUFFERSUBDATAARBPROC			glGetBufferSubDataARB;
+extern PFNGLUNIFORM2FVPROC					glUniform2fv;
+extern PFNGLUNIFORM4FVPROC					glUniform4fv;
+extern PFNGLUNIFORMMATRIX4FVPROC			glUniformMatrix4fv;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_buffer_storage and GL_ARB_sync
+//-----------------------------------------------------------------------------
+extern PFNGLBUFFERSTORAGEPROC				glBufferStorage;
+extern PFNGLMAPBUFFERRANGEPROC				glMapBufferRange;
+extern PFNGLCOPYBUFFERSUBDATAPROC			glCopyBufferSubData;
+extern PFNGLFENCESYNCPROC					glFenceSync;
+extern PFNGLCLIENTWAITSYNCPROC				glClientWaitSync;
+extern PFNGLDELETESYNCPROC					glDeleteSync;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_timer_query
+//-----------------------------------------------------------------------------
+extern PFNGLQUERYCOUNTERPROC				glQueryCounter;
+extern PFNGLGETQUERYOBJECTUI64VPROC			glGetQueryObjectui64v;
+
+//-----------------------------------------------------------------------------
+//GL_ARB_framebuffer_object
+//-----------------------------------------------------------------------------
+extern PFNGLGENFRAMEBUFFERSPROC				glGenFramebuffers;
+extern PFNGLDELETEFRAMEBUFFERSPROC			glDeleteFramebuffers;
+extern PFNGLBINDFRAMEBUFFERPROC				glBindFramebuffer;
+extern PFNGLFRAMEBUFFERTEXTURE2DPROC		glFramebufferTexture2D;
+extern PFNGLCHECKFRAMEBUFFERSTATUSPROC		glCheckFramebufferStatus;
+
+//-----------------------------------------------------------------------------
+//OpenGL 3.2 layered rendering
+//-----------------------------------------------------------------------------
+extern PFNGLFRAMEBUFFERTEXTUREPROC			glFramebufferTexture;
+
+///----------------------------------------------------------------------------
+///Which of the optional features are available in the current context
+///----------------------------------------------------------------------------
+struct GLCaps
+{
+	bool occlusionQuery;	///> GL_ARB_occlusion_query
+	bool conditionalRender;	///> GL_NV_conditional_render or OpenGL 3.0
+	bool vertexBufferObject;///> GL_ARB_vertex_buffer_object
+	bool glsl;				///> OpenGL 2.0 vertex and fragment shaders
+	bool samplerObjects;	///> GL_ARB_sampler_objects
+	bool multiDrawIndirect;	///> GL_ARB_multi_draw_indirect, with shader storage
+							///> buffers, uniform buffers and gl_DrawIDARB
+							///> (GL_ARB_shader_draw_parameters)
+	bool computeShader;		///> GL_ARB_compute_shader with image load/store
+	bool indirectCount;		///> GL_ARB_indirect_parameters (draw count in a buffer)
+	bool fenceSync;			///> GL_ARB_sync (fences the CPU can wait on)
+	bool persistentMapping;	///> GL_ARB_buffer_storage with fences (GL_ARB_sync)
+							///> and buffer to buffer copies (GL_ARB_copy_buffer)
+	bool timerQuery;		///> GL_ARB_timer_query (GPU time of a range of commands)
+	bool framebufferObject;	///> GL_ARB_framebuffer_object or GL_EXT_framebuffer_object
+	bool layeredRendering;	///> OpenGL 3.2 geometry shaders writing gl_Layer of a
+							///> layered (cube map) framebuffer attachment
+};
+
+extern GLCaps g_GLCaps;
+
+bool IsExtensionSupported(LPCSTR name);
+void InitExtensions();
+
+#endif
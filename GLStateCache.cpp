@@ -0,0 +1,601 @@
+///============================================================================
+///@file	GLStateCache.cpp
+///@brief	CPU copy of the OpenGL state the demo changes.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "GLStateCache.h"
+#include "GLExtensions.h"
+#include <string.h>
+
+GLStateCache g_GLState;
+
+//capabilities in the order of the Capability enum
+static const GLenum Capabilities[] =
+{
+	GL_LIGHTING, GL_LIGHT0, GL_TEXTURE_2D, GL_DEPTH_TEST, GL_ALPHA_TEST,
+	GL_CULL_FACE, GL_BLEND, GL_POLYGON_OFFSET_FILL, GL_COLOR_MATERIAL,
+	GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q,
+	GL_SCISSOR_TEST
+};
+
+///----------------------------------------------------------------------------
+///Default constructor, nothing is known until Reset is called
+///----------------------------------------------------------------------------
+GLStateCache::GLStateCache() : m_StackSize(0), m_Issued(0), m_Filtered(0)
+{
+	Invalidate();
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+GLStateCache::~GLStateCache()
+{
+}
+
+///----------------------------------------------------------------------------
+///Starts from the state of a new rendering context (call it right after
+///the context is created and made current)
+///----------------------------------------------------------------------------
+void GLStateCache::Reset()
+{
+	SetDefaults(m_State);
+	m_StackSize = 0;
+	m_TexParams.clear();
+}
+
+///----------------------------------------------------------------------------
+///Forgets everything, the next call of each kind is always sent (i.e. after
+///code which changes the state without the cache)
+///----------------------------------------------------------------------------
+void GLStateCache::Invalidate()
+{
+	for(UINT i=0; i<CAP_COUNT; i++)
+		m_State.caps[i] = UNKNOWN;
+	for(UINT i=0; i<MAX_ATTRIBS; i++)
+		m_State.attribs[i] = UNKNOWN;
+	for(UINT i=0; i<4; i++)
+		m_State.colorMask[i] = UNKNOWN;
+
+	m_State.vertexArray		= UNKNOWN;
+	m_State.normalArray		= UNKNOWN;
+	m_State.depthMask		= UNKNOWN;
+	m_State.depthFunc		= UNKNOWN_VALUE;
+	m_State.blendFunc[0]	= m_State.blendFunc[1] = UNKNOWN_VALUE;
+	m_State.texture			= UNKNOWN_VALUE;
+	m_State.sampler			= UNKNOWN_VALUE;
+	m_State.arrayBuffer		= UNKNOWN_VALUE;
+	m_State.elementBuffer	= UNKNOWN_VALUE;
+	m_State.program			= UNKNOWN_VALUE;
+	m_State.shadeModel		= UNKNOWN_VALUE;
+	m_State.cullFace		= UNKNOWN_VALUE;
+	m_State.alphaFunc		= UNKNOWN_VALUE;
+	m_State.alphaRef		= 0.0f;
+	m_State.polygonOffset[0] = m_State.polygonOffset[1] = 0.0f;
+	m_State.polygonOffsetKnown = false;
+
+	m_StackSize = 0;
+	m_TexParams.clear();
+}
+
+///----------------------------------------------------------------------------
+///Saves the current state, the cached replacement of glPushAttrib
+///----------------------------------------------------------------------------
+void GLStateCache::Push()
+{
+	if(m_StackSize < STACK_DEPTH) m_Stack[m_StackSize] = m_State;
+	m_StackSize++;
+}
+
+///----------------------------------------------------------------------------
+///Goes back to the state saved by the matching Push, only the values that
+///changed since are sent
+///----------------------------------------------------------------------------
+void GLStateCache::Pop()
+{
+	if(m_StackSize == 0) return;
+
+	m_StackSize--;
+	if(m_StackSize < STACK_DEPTH) Restore(m_Stack[m_StackSize]);
+}
+
+///----------------------------------------------------------------------------
+///glEnable
+///----------------------------------------------------------------------------
+void GLStateCache::Enable(GLenum cap)
+{
+	SetCapability(cap, ON);
+}
+
+///----------------------------------------------------------------------------
+///glDisable
+///----------------------------------------------------------------------------
+void GLStateCache::Disable(GLenum cap)
+{
+	SetCapability(cap, OFF);
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the capability was enabled through the cache (replaces
+///glIsEnabled, unknown capabilities are reported disabled)
+///----------------------------------------------------------------------------
+bool GLStateCache::IsEnabled(GLenum cap) const
+{
+	int index = GetCapability(cap);
+	return index >= 0 && m_State.caps[index] == ON;
+}
+
+///----------------------------------------------------------------------------
+///glEnableClientState
+///----------------------------------------------------------------------------
+void GLStateCache::EnableClientState(GLenum array)
+{
+	SetClientState(array, ON);
+}
+
+///----------------------------------------------------------------------------
+///glDisableClientState
+///----------------------------------------------------------------------------
+void GLStateCache::DisableClientState(GLenum array)
+{
+	SetClientState(array, OFF);
+}
+
+///----------------------------------------------------------------------------
+///glEnableVertexAttribArray
+///----------------------------------------------------------------------------
+void GLStateCache::EnableVertexAttribArray(GLuint index)
+{
+	SetAttribArray(index, ON);
+}
+
+///----------------------------------------------------------------------------
+///glDisableVertexAttribArray
+///----------------------------------------------------------------------------
+void GLStateCache::DisableVertexAttribArray(GLuint index)
+{
+	SetAttribArray(index, OFF);
+}
+
+///----------------------------------------------------------------------------
+///glBindTexture (only GL_TEXTURE_2D of the first unit is tracked)
+///----------------------------------------------------------------------------
+void GLStateCache::BindTexture(GLenum target, GLuint texture)
+{
+	if(target == GL_TEXTURE_2D)
+	{
+		if(!Changed(m_State.texture != texture)) return;
+		m_State.texture = texture;
+	}
+	else
+	{
+		Changed(true);
+	}
+
+	glBindTexture(target, texture);
+}
+
+///----------------------------------------------------------------------------
+///glTexParameteri on the bound 2D texture. The value is remembered per
+///texture object, so switching textures doesn't resend their parameters.
+///----------------------------------------------------------------------------
+void GLStateCache::TexParameteri(GLenum target, GLenum pname, GLint value)
+{
+	GLuint texture = m_State.texture;
+
+	if(target != GL_TEXTURE_2D || texture == UNKNOWN_VALUE)
+	{
+		Changed(true);
+		glTexParameteri(target, pname, value);
+		return;
+	}
+
+	TexParam *param = NULL;
+	for(UINT i=0; i<m_TexParams.size() && !param; i++)
+	{
+		if(m_TexParams[i].texture == texture && m_TexParams[i].pname == pname)
+			param = &m_TexParams[i];
+	}
+
+	if(!param)
+	{
+		TexParam p = {texture, pname, value};
+		m_TexParams.push_back(p);
+		Changed(true);
+	}
+	else
+	{
+		if(!Changed(param->value != value)) return;
+		param->value = value;
+	}
+
+	glTexParameteri(target, pname, value);
+}
+
+///----------------------------------------------------------------------------
+///Forgets a texture about to be deleted (its name may be reused)
+///----------------------------------------------------------------------------
+void GLStateCache::DeleteTexture(GLuint texture)
+{
+	for(UINT i=0; i<m_TexParams.size(); )
+	{
+		if(m_TexParams[i].texture == texture)
+		{
+			m_TexParams[i] = m_TexParams.back();
+			m_TexParams.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	//deleting the bound texture binds 0
+	if(m_State.texture == texture) m_State.texture = 0;
+}
+
+///----------------------------------------------------------------------------
+///glBindSampler on texture unit 0, the only unit the demo uses
+///----------------------------------------------------------------------------
+void GLStateCache::BindSampler(GLuint sampler)
+{
+	if(!Changed(m_State.sampler != sampler)) return;
+
+	m_State.sampler = sampler;
+	glBindSampler(0, sampler);
+}
+
+///----------------------------------------------------------------------------
+///Updates the binding of a sampler about to be deleted (deleting a bound
+///sampler binds 0)
+///----------------------------------------------------------------------------
+void GLStateCache::DeleteSampler(GLuint sampler)
+{
+	if(m_State.sampler == sampler) m_State.sampler = 0;
+}
+
+///----------------------------------------------------------------------------
+///glBindBufferARB
+///----------------------------------------------------------------------------
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint *binding = NULL;
+	if(target == GL_ARRAY_BUFFER_ARB) binding = &m_State.arrayBuffer;
+	else if(target == GL_ELEMENT_ARRAY_BUFFER_ARB) binding = &m_State.elementBuffer;
+
+	if(binding)
+	{
+		if(!Changed(*binding != buffer)) return;
+		*binding = buffer;
+	}
+	else
+	{
+		Changed(true);
+	}
+
+	glBindBufferARB(target, buffer);
+}
+
+///----------------------------------------------------------------------------
+///Updates the bindings of a buffer about to be deleted (deleting a bound
+///buffer binds 0)
+///----------------------------------------------------------------------------
+void GLStateCache::DeleteBuffer(GLuint buffer)
+{
+	if(m_State.arrayBuffer == buffer) m_State.arrayBuffer = 0;
+	if(m_State.elementBuffer == buffer) m_State.elementBuffer = 0;
+}
+
+///----------------------------------------------------------------------------
+///glUseProgram
+///----------------------------------------------------------------------------
+void GLStateCache::UseProgram(GLuint program)
+{
+	if(!Changed(m_State.program != program)) return;
+
+	m_State.program = program;
+	glUseProgram(program);
+}
+
+///----------------------------------------------------------------------------
+///glColorMask
+///----------------------------------------------------------------------------
+void GLStateCache::ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+	int mask[4] = {r ? ON : OFF, g ? ON : OFF, b ? ON : OFF, a ? ON : OFF};
+	if(!Changed(memcmp(mask, m_State.colorMask, sizeof(mask)) != 0)) return;
+
+	memcpy(m_State.colorMask, mask, sizeof(mask));
+	glColorMask(r, g, b, a);
+}
+
+///----------------------------------------------------------------------------
+///glDepthMask
+///----------------------------------------------------------------------------
+void GLStateCache::DepthMask(GLboolean flag)
+{
+	int value = flag ? ON : OFF;
+	if(!Changed(m_State.depthMask != value)) return;
+
+	m_State.depthMask = value;
+	glDepthMask(flag);
+}
+
+///----------------------------------------------------------------------------
+///glDepthFunc
+///----------------------------------------------------------------------------
+void GLStateCache::DepthFunc(GLenum func)
+{
+	if(!Changed(m_State.depthFunc != func)) return;
+
+	m_State.depthFunc = func;
+	glDepthFunc(func);
+}
+
+///----------------------------------------------------------------------------
+///glBlendFunc
+///----------------------------------------------------------------------------
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	if(!Changed(m_State.blendFunc[0] != source || m_State.blendFunc[1] != destination)) return;
+
+	m_State.blendFunc[0] = source;
+	m_State.blendFunc[1] = destination;
+	glBlendFunc(source, destination);
+}
+
+///----------------------------------------------------------------------------
+///glShadeModel
+///----------------------------------------------------------------------------
+void GLStateCache::ShadeModel(GLenum mode)
+{
+	if(!Changed(m_State.shadeModel != mode)) return;
+
+	m_State.shadeModel = mode;
+	glShadeModel(mode);
+}
+
+///----------------------------------------------------------------------------
+///glCullFace
+///----------------------------------------------------------------------------
+void GLStateCache::CullFace(GLenum mode)
+{
+	if(!Changed(m_State.cullFace != mode)) return;
+
+	m_State.cullFace = mode;
+	glCullFace(mode);
+}
+
+///----------------------------------------------------------------------------
+///glAlphaFunc
+///----------------------------------------------------------------------------
+void GLStateCache::AlphaFunc(GLenum func, GLclampf ref)
+{
+	if(!Changed(m_State.alphaFunc != func || m_State.alphaRef != ref)) return;
+
+	m_State.alphaFunc = func;
+	m_State.alphaRef = ref;
+	glAlphaFunc(func, ref);
+}
+
+///----------------------------------------------------------------------------
+///glPolygonOffset
+///----------------------------------------------------------------------------
+void GLStateCache::PolygonOffset(GLfloat factor, GLfloat units)
+{
+	if(!Changed(!m_State.polygonOffsetKnown || m_State.polygonOffset[0] != factor ||
+				m_State.polygonOffset[1] != units)) return;
+
+	m_State.polygonOffset[0] = factor;
+	m_State.polygonOffset[1] = units;
+	m_State.polygonOffsetKnown = true;
+	glPolygonOffset(factor, units);
+}
+
+///----------------------------------------------------------------------------
+///@returns the calls sent to OpenGL since the last ResetCounters
+///----------------------------------------------------------------------------
+UINT GLStateCache::GetIssuedCount() const
+{
+	return m_Issued;
+}
+
+///----------------------------------------------------------------------------
+///@returns the redundant calls dropped since the last ResetCounters
+///----------------------------------------------------------------------------
+UINT GLStateCache::GetFilteredCount() const
+{
+	return m_Filtered;
+}
+
+///----------------------------------------------------------------------------
+///Clears the call counters (i.e. once per frame)
+///----------------------------------------------------------------------------
+void GLStateCache::ResetCounters()
+{
+	m_Issued = m_Filtered = 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns the index of a tracked capability or -1
+///----------------------------------------------------------------------------
+int GLStateCache::GetCapability(GLenum cap)
+{
+	for(int i=0; i<CAP_COUNT; i++)
+	{
+		if(Capabilities[i] == cap) return i;
+	}
+
+	return -1;
+}
+
+///----------------------------------------------------------------------------
+///Enables or disables a capability unless it already is
+///----------------------------------------------------------------------------
+void GLStateCache::SetCapability(GLenum cap, int flag)
+{
+	int index = GetCapability(cap);
+	if(index >= 0)
+	{
+		if(!Changed(m_State.caps[index] != flag)) return;
+		m_State.caps[index] = flag;
+	}
+	else
+	{
+		Changed(true);
+	}
+
+	if(flag == ON) glEnable(cap);
+	else glDisable(cap);
+}
+
+///----------------------------------------------------------------------------
+///Enables or disables a fixed-function vertex array unless it already is
+///----------------------------------------------------------------------------
+void GLStateCache::SetClientState(GLenum array, int flag)
+{
+	int *state = NULL;
+	if(array == GL_VERTEX_ARRAY) state = &m_State.vertexArray;
+	else if(array == GL_NORMAL_ARRAY) state = &m_State.normalArray;
+
+	if(state)
+	{
+		if(!Changed(*state != flag)) return;
+		*state = flag;
+	}
+	else
+	{
+		Changed(true);
+	}
+
+	if(flag == ON) glEnableClientState(array);
+	else glDisableClientState(array);
+}
+
+///----------------------------------------------------------------------------
+///Enables or disables a generic vertex array unless it already is
+///----------------------------------------------------------------------------
+void GLStateCache::SetAttribArray(GLuint index, int flag)
+{
+	if(index < MAX_ATTRIBS)
+	{
+		if(!Changed(m_State.attribs[index] != flag)) return;
+		m_State.attribs[index] = flag;
+	}
+	else
+	{
+		Changed(true);
+	}
+
+	if(flag == ON) glEnableVertexAttribArray(index);
+	else glDisableVertexAttribArray(index);
+}
+
+///----------------------------------------------------------------------------
+///Fills a state with the initial values of a new context
+///----------------------------------------------------------------------------
+void GLStateCache::SetDefaults(State &state) const
+{
+	//every tracked capability starts disabled
+	for(UINT i=0; i<CAP_COUNT; i++)
+		state.caps[i] = OFF;
+	for(UINT i=0; i<MAX_ATTRIBS; i++)
+		state.attribs[i] = OFF;
+	for(UINT i=0; i<4; i++)
+		state.colorMask[i] = ON;
+
+	state.vertexArray		= OFF;
+	state.normalArray		= OFF;
+	state.depthMask			= ON;
+	state.depthFunc			= GL_LESS;
+	state.blendFunc[0]		= GL_ONE;
+	state.blendFunc[1]		= GL_ZERO;
+	state.texture			= 0;
+	state.sampler			= 0;
+	state.arrayBuffer		= 0;
+	state.elementBuffer		= 0;
+	state.program			= 0;
+	state.shadeModel		= GL_SMOOTH;
+	state.cullFace			= GL_BACK;
+	state.alphaFunc			= GL_ALWAYS;
+	state.alphaRef			= 0.0f;
+	state.polygonOffset[0]	= state.polygonOffset[1] = 0.0f;
+	state.polygonOffsetKnown = true;
+}
+
+///----------------------------------------------------------------------------
+///Sets back the known values of a saved state that differ from the current
+///ones (the unchanged ones aren't counted as filtered calls)
+///----------------------------------------------------------------------------
+void GLStateCache::Restore(const State &saved)
+{
+	const State &now = m_State;
+
+	for(UINT i=0; i<CAP_COUNT; i++)
+	{
+		if(saved.caps[i] != UNKNOWN && saved.caps[i] != now.caps[i])
+			SetCapability(Capabilities[i], saved.caps[i]);
+	}
+
+	for(UINT i=0; i<MAX_ATTRIBS; i++)
+	{
+		if(saved.attribs[i] != UNKNOWN && saved.attribs[i] != now.attribs[i])
+			SetAttribArray(i, saved.attribs[i]);
+	}
+
+	if(saved.vertexArray != UNKNOWN && saved.vertexArray != now.vertexArray)
+		SetClientState(GL_VERTEX_ARRAY, saved.vertexArray);
+	if(saved.normalArray != UNKNOWN && saved.normalArray != now.normalArray)
+		SetClientState(GL_NORMAL_ARRAY, saved.normalArray);
+
+	if(saved.texture != UNKNOWN_VALUE && saved.texture != now.texture)
+		BindTexture(GL_TEXTURE_2D, saved.texture);
+	if(saved.sampler != UNKNOWN_VALUE && saved.sampler != now.sampler)
+		BindSampler(saved.sampler);
+	if(saved.arrayBuffer != UNKNOWN_VALUE && saved.arrayBuffer != now.arrayBuffer)
+		BindBuffer(GL_ARRAY_BUFFER_ARB, saved.arrayBuffer);
+	if(saved.elementBuffer != UNKNOWN_VALUE && saved.elementBuffer != now.elementBuffer)
+		BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, saved.elementBuffer);
+	if(saved.program != UNKNOWN_VALUE && saved.program != now.program)
+		UseProgram(saved.program);
+
+	if(saved.colorMask[0] != UNKNOWN && memcmp(saved.colorMask, now.colorMask, sizeof(saved.colorMask)) != 0)
+	{
+		ColorMask(saved.colorMask[0] == ON, saved.colorMask[1] == ON,
+				  saved.colorMask[2] == ON, saved.colorMask[3] == ON);
+	}
+
+	if(saved.depthMask != UNKNOWN && saved.depthMask != now.depthMask)
+		DepthMask(saved.depthMask == ON);
+	if(saved.depthFunc != UNKNOWN_VALUE && saved.depthFunc != now.depthFunc)
+		DepthFunc(saved.depthFunc);
+	if(saved.blendFunc[0] != UNKNOWN_VALUE &&
+	   (saved.blendFunc[0] != now.blendFunc[0] || saved.blendFunc[1] != now.blendFunc[1]))
+		BlendFunc(saved.blendFunc[0], saved.blendFunc[1]);
+	if(saved.shadeModel != UNKNOWN_VALUE && saved.shadeModel != now.shadeModel)
+		ShadeModel(saved.shadeModel);
+	if(saved.cullFace != UNKNOWN_VALUE && saved.cullFace != now.cullFace)
+		CullFace(saved.cullFace);
+	if(saved.alphaFunc != UNKNOWN_VALUE &&
+	   (saved.alphaFunc != now.alphaFunc || saved.alphaRef != now.alphaRef))
+		AlphaFunc(saved.alphaFunc, saved.alphaRef);
+	if(saved.polygonOffsetKnown &&
+	   (!now.polygonOffsetKnown || saved.polygonOffset[0] != now.polygonOffset[0] ||
+		saved.polygonOffset[1] != now.polygonOffset[1]))
+		PolygonOffset(saved.polygonOffset[0], saved.polygonOffset[1]);
+}
+
+///----------------------------------------------------------------------------
+///Counts a call as sent or dropped
+///@param	changed - the call changes the state
+///@returns changed
+///----------------------------------------------------------------------------
+bool GLStateCache::Changed(bool changed)
+{
+	if(changed) m_Issued++;
+	else m_Filtered++;
+
+	return changed;
+}
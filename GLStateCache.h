@@ -0,0 +1,163 @@
+///============================================================================
+///@file	GLStateCache.h
+///@brief	CPU copy of the OpenGL state the demo changes. Every state change
+///			goes through g_GLState, which only calls OpenGL when the value
+///			differs from the one last set, so the passes can set what they
+///			need without knowing what the previous pass left behind. The
+///			state is never read back with glGet*: the cache starts from the
+///			defaults of a new context and anything it doesn't know yet is
+///			always sent.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+class GLStateCache
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	GLStateCache();
+	virtual ~GLStateCache();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Reset();
+	void Invalidate();
+	void Push();
+	void Pop();
+
+	void Enable(GLenum cap);
+	void Disable(GLenum cap);
+	bool IsEnabled(GLenum cap) const;
+	void EnableClientState(GLenum array);
+	void DisableClientState(GLenum array);
+	void EnableVertexAttribArray(GLuint index);
+	void DisableVertexAttribArray(GLuint index);
+	void BindTexture(GLenum target, GLuint texture);
+	void TexParameteri(GLenum target, GLenum pname, GLint value);
+	void DeleteTexture(GLuint texture);
+	void BindSampler(GLuint sampler);
+	void DeleteSampler(GLuint sampler);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void DeleteBuffer(GLuint buffer);
+	void UseProgram(GLuint program);
+	void ColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a);
+	void DepthMask(GLboolean flag);
+	void DepthFunc(GLenum func);
+	void BlendFunc(GLenum source, GLenum destination);
+	void ShadeModel(GLenum mode);
+	void CullFace(GLenum mode);
+	void AlphaFunc(GLenum func, GLclampf ref);
+	void PolygonOffset(GLfloat factor, GLfloat units);
+
+	UINT GetIssuedCount() const;
+	UINT GetFilteredCount() const;
+	void ResetCounters();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_ATTRIBS = 8;		///> Generic vertex arrays tracked
+	static const UINT STACK_DEPTH = 4;		///> Nested Push calls
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	enum Flag
+	{
+		UNKNOWN = -1,	///> Not set through the cache yet
+		OFF = 0,
+		ON = 1
+	};
+
+	///Capabilities tracked by Enable and Disable, the rest are just passed on
+	enum Capability
+	{
+		CAP_LIGHTING = 0,
+		CAP_LIGHT0,
+		CAP_TEXTURE_2D,
+		CAP_DEPTH_TEST,
+		CAP_ALPHA_TEST,
+		CAP_CULL_FACE,
+		CAP_BLEND,
+		CAP_POLYGON_OFFSET_FILL,
+		CAP_COLOR_MATERIAL,
+		CAP_TEXTURE_GEN_S,
+		CAP_TEXTURE_GEN_T,
+		CAP_TEXTURE_GEN_R,
+		CAP_TEXTURE_GEN_Q,
+		CAP_SCISSOR_TEST,
+		CAP_COUNT
+	};
+
+	///Texture parameter last set on a texture object
+	struct TexParam
+	{
+		GLuint	texture;	///> Texture object
+		GLenum	pname;		///> Parameter
+		GLint	value;		///> Value
+	};
+
+	///Everything Push saves and Pop restores. Values not set through the
+	///cache yet are UNKNOWN (flags) or UNKNOWN_VALUE (names and enums).
+	struct State
+	{
+		int			caps[CAP_COUNT];		///> Flag of each capability
+		int			vertexArray;			///> GL_VERTEX_ARRAY flag
+		int			normalArray;			///> GL_NORMAL_ARRAY flag
+		int			attribs[MAX_ATTRIBS];	///> Generic vertex array flags
+		GLuint		texture;				///> Bound 2D texture
+		GLuint		sampler;				///> Sampler bound to unit 0
+		GLuint		arrayBuffer;			///> Bound vertex buffer
+		GLuint		elementBuffer;			///> Bound index buffer
+		GLuint		program;				///> Current program
+		int			colorMask[4];			///> Color write mask flags
+		int			depthMask;				///> Depth write mask flag
+		GLenum		depthFunc;				///> Depth test function
+		GLenum		blendFunc[2];			///> Source and destination blend factors
+		GLenum		shadeModel;				///> GL_FLAT or GL_SMOOTH
+		GLenum		cullFace;				///> Culled faces
+		GLenum		alphaFunc;				///> Alpha test function
+		GLclampf	alphaRef;				///> Alpha test reference (valid with alphaFunc)
+		GLfloat		polygonOffset[2];		///> Polygon offset factor and units
+		bool		polygonOffsetKnown;		///> polygonOffset is valid
+	};
+
+	static const GLuint UNKNOWN_VALUE = 0xFFFFFFFF;	///> Name or enum never set
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	static int GetCapability(GLenum cap);
+	void SetCapability(GLenum cap, int flag);
+	void SetClientState(GLenum array, int flag);
+	void SetAttribArray(GLuint index, int flag);
+	void SetDefaults(State &state) const;
+	void Restore(const State &saved);
+	bool Changed(bool changed);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	State				m_State;				///> Current state
+	State				m_Stack[STACK_DEPTH];	///> States saved by Push
+	UINT				m_StackSize;			///> Saved states
+	std::vector<TexParam> m_TexParams;			///> Texture parameters set so far
+	UINT				m_Issued;				///> Calls sent to OpenGL
+	UINT				m_Filtered;				///> Redundant calls dropped
+};
+
+extern GLStateCache g_GLState;
+
+#endif
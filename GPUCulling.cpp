@@ -0,0 +1,718 @@
+///============================================================================
+///@file	GPUCulling.cpp
+///@brief	Culls the scene on the GPU.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "GPUCulling.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "FramePacer.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+//Tests every object against both frustums (and the camera one against the
+//Hi-Z of the previous frame), selects its level in each pass with the same
+//hysteresis Geometry::SelectLOD uses and appends the survivors to the
+//commands and draws of the pass. The order of the draws is the order the
+//invocations reach the counters. The size of the Hi-Z level is derived from
+//level 0, textureSize with a level that differs between invocations gives
+//the wrong size on some drivers (llvmpipe).
+static const char CullShader[] =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"\n"
+	"#define CAMERA_PASS 0u\n"
+	"#define SHADOW_PASS 1u\n"
+	"#define MAX_LODS 3u\n"
+	"\n"
+	"struct Object\n"
+	"{\n"
+	"	mat4 world;\n"
+	"	vec4 normal[3];\n"
+	"	vec4 color;\n"
+	"	vec4 center;\n"
+	"	vec4 extent;\n"
+	"	uvec4 info;\n"
+	"};\n"
+	"\n"
+	"struct Level\n"
+	"{\n"
+	"	uint firstIndex;\n"
+	"	uint indexCount;\n"
+	"	int baseVertex;\n"
+	"	float minSize;\n"
+	"};\n"
+	"\n"
+	"struct Command\n"
+	"{\n"
+	"	uint count;\n"
+	"	uint instanceCount;\n"
+	"	uint firstIndex;\n"
+	"	int baseVertex;\n"
+	"	uint baseInstance;\n"
+	"};\n"
+	"\n"
+	"struct Draw\n"
+	"{\n"
+	"	mat4 world;\n"
+	"	vec4 normal[3];\n"
+	"	vec4 color;\n"
+	"};\n"
+	"\n"
+	"layout(std430, binding = 0) readonly buffer Objects { Object objects[]; };\n"
+	"layout(std430, binding = 1) readonly buffer Levels { Level levels[]; };\n"
+	"layout(std430, binding = 2) buffer LODs { uint lods[]; };\n"
+	"layout(std430, binding = 3) buffer Counts { uint drawCount[2]; uint triangles[2]; };\n"
+	"layout(std430, binding = 4) writeonly buffer CameraCommands { Command cameraCommands[]; };\n"
+	"layout(std430, binding = 5) writeonly buffer CameraDraws { Draw cameraDraws[]; };\n"
+	"layout(std430, binding = 6) writeonly buffer ShadowCommands { Command shadowCommands[]; };\n"
+	"layout(std430, binding = 7) writeonly buffer ShadowDraws { Draw shadowDraws[]; };\n"
+	"\n"
+	"uniform int objectCount;\n"
+	"uniform vec4 planes[12];\n"
+	"uniform vec4 eyes[2];\n"
+	"uniform vec4 lod;\n"
+	"uniform sampler2D hiZ;\n"
+	"uniform mat4 hiZMatrix;\n"
+	"uniform int hiZLevels;\n"
+	"\n"
+	"bool InFrustum(uint pass, vec3 center, vec3 extent)\n"
+	"{\n"
+	"	for(uint i=0u; i<6u; i++)\n"
+	"	{\n"
+	"		vec4 p = planes[pass*6u+i];\n"
+	"		if(dot(p.xyz, center) + dot(abs(p.xyz), extent) + p.w < 0.0) return false;\n"
+	"	}\n"
+	"	return true;\n"
+	"}\n"
+	"\n"
+	"bool IsOccluded(vec3 center, vec3 extent)\n"
+	"{\n"
+	"	if(hiZLevels == 0) return false;\n"
+	"\n"
+	"	vec2 minUV = vec2(1.0), maxUV = vec2(0.0);\n"
+	"	float nearest = 1.0;\n"
+	"	for(int i=0; i<8; i++)\n"
+	"	{\n"
+	"		vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0 : -1.0,\n"
+	"											 (i & 2) != 0 ? 1.0 : -1.0,\n"
+	"											 (i & 4) != 0 ? 1.0 : -1.0);\n"
+	"		vec4 clip = hiZMatrix * vec4(corner, 1.0);\n"
+	"		if(clip.w <= 1.0e-5) return false;\n"
+	"\n"
+	"		vec3 ndc = clip.xyz / clip.w;\n"
+	"		minUV = min(minUV, ndc.xy * 0.5 + 0.5);\n"
+	"		maxUV = max(maxUV, ndc.xy * 0.5 + 0.5);\n"
+	"		nearest = min(nearest, ndc.z * 0.5 + 0.5);\n"
+	"	}\n"
+	"	minUV = clamp(minUV, 0.0, 1.0);\n"
+	"	maxUV = clamp(maxUV, 0.0, 1.0);\n"
+	"\n"
+	"	vec2 rect = (maxUV - minUV) * vec2(textureSize(hiZ, 0));\n"
+	"	int level = clamp(int(ceil(log2(max(max(rect.x, rect.y), 1.0)))), 0, hiZLevels - 1);\n"
+	"	ivec2 size = max(textureSize(hiZ, 0) >> level, ivec2(1));\n"
+	"	ivec2 p0 = clamp(ivec2(minUV * vec2(size)), ivec2(0), size - 1);\n"
+	"	ivec2 p1 = clamp(ivec2(maxUV * vec2(size)), ivec2(0), size - 1);\n"
+	"\n"
+	"	float farthest = max(max(texelFetch(hiZ, p0, level).r, texelFetch(hiZ, ivec2(p1.x, p0.y), level).r),\n"
+	"						 max(texelFetch(hiZ, ivec2(p0.x, p1.y), level).r, texelFetch(hiZ, p1, level).r));\n"
+	"	return nearest > farthest;\n"
+	"}\n"
+	"\n"
+	"Level SelectLevel(uint pass, uint index, Object object)\n"
+	"{\n"
+	"	uint count = object.info.y;\n"
+	"	uint base = (object.info.x * 2u + pass) * MAX_LODS;\n"
+	"	uint current = min(lods[index * 2u + pass], count - 1u);\n"
+	"\n"
+	"	if(lod.w == 0.0)\n"
+	"	{\n"
+	"		current = 0u;\n"
+	"	}\n"
+	"	else\n"
+	"	{\n"
+	"		vec3 d = object.center.xyz - eyes[pass].xyz;\n"
+	"		float d2 = dot(d, d);\n"
+	"		float r2 = dot(object.extent.xyz, object.extent.xyz);\n"
+	"		float size = d2 > r2 ? 2.0 * sqrt(r2 / d2) * lod[pass] : 3.0e38;\n"
+	"\n"
+	"		while(current > 0u && size > levels[base + current - 1u].minSize * (1.0 + lod.z))\n"
+	"			current--;\n"
+	"		while(current + 1u < count && size < levels[base + current].minSize * (1.0 - lod.z))\n"
+	"			current++;\n"
+	"	}\n"
+	"\n"
+	"	lods[index * 2u + pass] = current;\n"
+	"	return levels[base + current];\n"
+	"}\n"
+	"\n"
+	"void Append(uint pass, Object object, Level level)\n"
+	"{\n"
+	"	uint slot = atomicAdd(drawCount[pass], 1u);\n"
+	"	atomicAdd(triangles[pass], level.indexCount / 3u);\n"
+	"\n"
+	"	Command command = Command(level.indexCount, 1u, level.firstIndex, level.baseVertex, 0u);\n"
+	"	Draw draw = Draw(object.world, object.normal, object.color);\n"
+	"	if(pass == CAMERA_PASS)\n"
+	"	{\n"
+	"		cameraCommands[slot] = command;\n"
+	"		cameraDraws[slot] = draw;\n"
+	"	}\n"
+	"	else\n"
+	"	{\n"
+	"		shadowCommands[slot] = command;\n"
+	"		shadowDraws[slot] = draw;\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	uint index = gl_GlobalInvocationID.x;\n"
+	"	if(index >= uint(objectCount)) return;\n"
+	"\n"
+	"	Object object = objects[index];\n"
+	"	vec3 center = object.center.xyz;\n"
+	"	vec3 extent = object.extent.xyz;\n"
+	"\n"
+	"	if(InFrustum(SHADOW_PASS, center, extent))\n"
+	"		Append(SHADOW_PASS, object, SelectLevel(SHADOW_PASS, index, object));\n"
+	"\n"
+	"	if(InFrustum(CAMERA_PASS, center, extent) && !IsOccluded(center, extent))\n"
+	"		Append(CAMERA_PASS, object, SelectLevel(CAMERA_PASS, index, object));\n"
+	"}\n";
+
+//Builds a level of the Hi-Z: each texel keeps the farthest depth of the
+//texels of the source level it covers (up to 3x3 when the source size is
+//odd, so no source texel is skipped)
+static const char ReduceShader[] =
+	"#version 430\n"
+	"layout(local_size_x = 8, local_size_y = 8) in;\n"
+	"\n"
+	"uniform sampler2D source;\n"
+	"uniform int sourceLevel;\n"
+	"layout(r32f, binding = 0) writeonly uniform image2D destination;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	ivec2 size = imageSize(destination);\n"
+	"	ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+	"	if(any(greaterThanEqual(p, size))) return;\n"
+	"\n"
+	"	ivec2 sourceSize = textureSize(source, sourceLevel);\n"
+	"	ivec2 first = p * sourceSize / size;\n"
+	"	ivec2 last = min(((p + 1) * sourceSize + size - 1) / size, sourceSize);\n"
+	"\n"
+	"	float depth = 0.0;\n"
+	"	for(int y=first.y; y<last.y; y++)\n"
+	"	{\n"
+	"		for(int x=first.x; x<last.x; x++)\n"
+		"			depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);\n"
+	"	}\n"
+	"	imageStore(destination, p, vec4(depth));\n"
+	"}\n";
+
+//buffer binding points of the cull shader
+static const GLuint ObjectBinding = 0;
+static const GLuint LevelBinding = 1;
+static const GLuint LODBinding = 2;
+static const GLuint CountBinding = 3;
+static const GLuint CommandBinding[PASS_COUNT] = {4, 6};
+static const GLuint DrawBinding[PASS_COUNT] = {5, 7};
+
+//size of the indirect commands and the draws (see MultiDraw)
+static const UINT CommandSize = 5 * sizeof(GLuint);
+static const UINT DrawSize = 32 * sizeof(GLfloat);
+
+//distance between the counters of two frames in flight, the largest
+//offset alignment a storage buffer may require
+static const UINT CountStride = 256;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+GPUCulling::GPUCulling() : m_Packed(NULL), m_PackOffset(0), m_Ring(NULL), m_ObjectCount(-1),
+						   m_Planes(-1), m_Eyes(-1), m_LODParameters(-1), m_HiZMatrixUniform(-1),
+						   m_HiZLevelsUniform(-1), m_SourceLevel(-1), m_DepthSampler(0), m_ObjectBuffer(0),
+						   m_LevelBuffer(0), m_LODBuffer(0), m_CountBuffer(0), m_Frame(0), m_BufferBytes(0),
+						   m_DepthTexture(0), m_HiZTexture(0), m_HiZWidth(0), m_HiZHeight(0),
+						   m_HiZLevels(0)
+{
+	for(UINT i=0; i<PASS_COUNT; i++)
+		m_CommandBuffers[i] = m_DrawBuffers[i] = 0;
+
+	memset(m_Counts, 0, sizeof(m_Counts));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+GPUCulling::~GPUCulling()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the context can run the cull shader and draw with a
+///count written by it
+///----------------------------------------------------------------------------
+bool GPUCulling::IsSupported()
+{
+	return g_GLCaps.computeShader && g_GLCaps.indirectCount && g_GLCaps.samplerObjects;
+}
+
+///----------------------------------------------------------------------------
+///Creates the shaders and the buffers for the objects of the scene (the
+///context must be current). Call again whenever objects are added.
+///@param	geometry - the scene
+///@param	multiDraw - the shared buffers the levels are drawn from (valid)
+///@param	ring - per-frame upload memory for the objects (NULL to upload
+///			to a buffer of our own)
+///@returns false if the GPU can't cull the scene
+///----------------------------------------------------------------------------
+bool GPUCulling::Create(const Geometry &geometry, const MultiDraw &multiDraw, UploadRing *ring)
+{
+	Release();
+	if(!IsSupported() || !multiDraw.IsValid() || geometry.GetObjectCount() == 0) return false;
+
+	m_Ring = ring && ring->IsValid() ? ring : NULL;
+
+	//levels of every shape, the shadow pass draws the shadow proxies
+	std::vector<LevelData> levels(geometry.GetShapeCount() * PASS_COUNT * LODChain::MAX_LODS);
+	memset(&levels[0], 0, levels.size() * sizeof(LevelData));
+
+	for(UINT s=0; s<geometry.GetShapeCount(); s++)
+	{
+		const LODChain &chain = geometry.GetShape(s);
+		for(UINT p=0; p<PASS_COUNT; p++)
+		{
+			for(UINT l=0; l<chain.count; l++)
+			{
+				LevelData &level = levels[(s * PASS_COUNT + p) * LODChain::MAX_LODS + l];
+				const Mesh *mesh = p == SHADOW_PASS ? chain.shadowMeshes[l] : chain.meshes[l];
+				if(!multiDraw.GetRange(mesh, &level.firstIndex, &level.indexCount, &level.baseVertex))
+					return false;
+
+				level.minSize = chain.minSize[l];
+			}
+		}
+	}
+
+	if(!m_CullShader.CreateCompute(CullShader) || !m_ReduceShader.CreateCompute(ReduceShader))
+	{
+		Release();
+		return false;
+	}
+
+	m_ObjectCount = m_CullShader.GetUniform("objectCount");
+	m_Planes = m_CullShader.GetUniform("planes");
+	m_Eyes = m_CullShader.GetUniform("eyes");
+	m_LODParameters = m_CullShader.GetUniform("lod");
+	m_HiZMatrixUniform = m_CullShader.GetUniform("hiZMatrix");
+	m_HiZLevelsUniform = m_CullShader.GetUniform("hiZLevels");
+	m_SourceLevel = m_ReduceShader.GetUniform("sourceLevel");
+
+	//the samplers of both shaders read texture unit 0
+	m_CullShader.Bind();
+	glUniform1i(m_CullShader.GetUniform("hiZ"), 0);
+	m_ReduceShader.Bind();
+	glUniform1i(m_ReduceShader.GetUniform("source"), 0);
+	Shader::Unbind();
+
+	//the reduce shader reads plain depth from the depth copy
+	glGenSamplers(1, &m_DepthSampler);
+	glSamplerParameteri(m_DepthSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glSamplerParameteri(m_DepthSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glSamplerParameteri(m_DepthSampler, GL_TEXTURE_COMPARE_MODE_ARB, GL_NONE);
+
+	UINT objects = geometry.GetObjectCount();
+	m_Objects.resize(objects);
+	m_BufferBytes = 0;
+
+	glGenBuffersARB(1, &m_ObjectBuffer);
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_ObjectBuffer);
+	glBufferDataARB(GL_SHADER_STORAGE_BUFFER, objects * sizeof(ObjectData), NULL, GL_STREAM_DRAW_ARB);
+	m_BufferBytes += objects * sizeof(ObjectData);
+
+	glGenBuffersARB(1, &m_LevelBuffer);
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_LevelBuffer);
+	glBufferDataARB(GL_SHADER_STORAGE_BUFFER, levels.size() * sizeof(LevelData), &levels[0],
+					GL_STATIC_DRAW_ARB);
+	m_BufferBytes += (UINT)levels.size() * sizeof(LevelData);
+
+	//every object starts at the finest level
+	std::vector<GLuint> lods(objects * PASS_COUNT, 0);
+	glGenBuffersARB(1, &m_LODBuffer);
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_LODBuffer);
+	glBufferDataARB(GL_SHADER_STORAGE_BUFFER, lods.size() * sizeof(GLuint), &lods[0], GL_DYNAMIC_COPY_ARB);
+	m_BufferBytes += (UINT)lods.size() * sizeof(GLuint);
+
+	//the counters of every frame in flight
+	std::vector<GLubyte> counts(CountStride * FramePacer::MAX_FRAMES, 0);
+	memset(m_Counts, 0, sizeof(m_Counts));
+	m_Frame = 0;
+	glGenBuffersARB(1, &m_CountBuffer);
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_CountBuffer);
+	glBufferDataARB(GL_SHADER_STORAGE_BUFFER, counts.size(), &counts[0], GL_DYNAMIC_COPY_ARB);
+	m_BufferBytes += (UINT)counts.size();
+
+	//room for every object in both passes
+	for(UINT i=0; i<PASS_COUNT; i++)
+	{
+		glGenBuffersARB(1, &m_CommandBuffers[i]);
+		g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_CommandBuffers[i]);
+		glBufferDataARB(GL_SHADER_STORAGE_BUFFER, objects * CommandSize, NULL, GL_DYNAMIC_COPY_ARB);
+
+		glGenBuffersARB(1, &m_DrawBuffers[i]);
+		g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_DrawBuffers[i]);
+		glBufferDataARB(GL_SHADER_STORAGE_BUFFER, objects * DrawSize, NULL, GL_DYNAMIC_COPY_ARB);
+
+		m_BufferBytes += objects * (CommandSize + DrawSize);
+	}
+
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the buffers, the textures and the shaders (the context must be
+///current)
+///----------------------------------------------------------------------------
+void GPUCulling::Release()
+{
+	GLuint *buffers[] = {&m_ObjectBuffer, &m_LevelBuffer, &m_LODBuffer, &m_CountBuffer,
+						 &m_CommandBuffers[0], &m_CommandBuffers[1],
+						 &m_DrawBuffers[0], &m_DrawBuffers[1]};
+
+	for(UINT i=0; i<sizeof(buffers) / sizeof(buffers[0]); i++)
+	{
+		if(*buffers[i] == 0) continue;
+
+		g_GLState.DeleteBuffer(*buffers[i]);
+		glDeleteBuffersARB(1, buffers[i]);
+		*buffers[i] = 0;
+	}
+
+	if(m_DepthSampler)
+	{
+		g_GLState.DeleteSampler(m_DepthSampler);
+		glDeleteSamplers(1, &m_DepthSampler);
+		m_DepthSampler = 0;
+	}
+
+	ReleaseHiZ();
+	m_CullShader.Release();
+	m_ReduceShader.Release();
+	m_Objects.clear();
+	m_Packed = NULL;
+	m_Ring = NULL;
+	m_BufferBytes = 0;
+	memset(m_Counts, 0, sizeof(m_Counts));
+}
+
+///----------------------------------------------------------------------------
+///@returns true if Create succeeded
+///----------------------------------------------------------------------------
+bool GPUCulling::IsValid() const
+{
+	return m_ObjectBuffer != 0;
+}
+
+///----------------------------------------------------------------------------
+///Finds room for this frame's objects in the upload ring (or uses the
+///upload array), call on the render thread before the objects are packed
+///@param	frame - the frame in flight (FramePacer::GetFrame), selects the
+///			copy of the counters the frame writes
+///----------------------------------------------------------------------------
+void GPUCulling::BeginPack(UINT frame)
+{
+	if(!IsValid()) return;
+
+	m_Frame = frame % FramePacer::MAX_FRAMES;
+
+	UINT bytes = (UINT)m_Objects.size() * sizeof(ObjectData);
+	m_Packed = m_Ring ? (ObjectData *)m_Ring->Allocate(GL_SHADER_STORAGE_BUFFER, bytes, &m_PackOffset) : NULL;
+	if(!m_Packed) m_Packed = &m_Objects[0];
+}
+
+///----------------------------------------------------------------------------
+///Copies the current transform, color and bounds of some objects to the
+///memory BeginPack found (doesn't touch OpenGL, ranges can be packed on
+///different threads once the objects are animated)
+///@param	geometry - the scene
+///@param	first - first object
+///@param	count - number of objects
+///----------------------------------------------------------------------------
+void GPUCulling::Pack(const Geometry &geometry, UINT first, UINT count)
+{
+	if(!m_Packed) return;
+
+	for(UINT i=first; i<first+count && i<(UINT)m_Objects.size(); i++)
+	{
+		const SceneObject &obj = geometry.GetSceneObject(i);
+		const AABB &box = geometry.GetBounds(i);
+		ObjectData &data = m_Packed[i];
+
+		memcpy(data.world, obj.world.m, sizeof(data.world));
+		Matrix4::GetNormalMatrix(obj.world.m, data.normal);
+
+		for(UINT k=0; k<4; k++)
+			data.color[k] = obj.color[k] / 255.0f;
+
+		box.GetCenter(data.center);
+		data.center[3] = 1.0f;
+		for(UINT k=0; k<3; k++)
+			data.extent[k] = 0.5f * (box.max[k] - box.min[k]);
+		data.extent[3] = 0.0f;
+
+		data.info[0] = obj.shape;
+		data.info[1] = geometry.GetShape(obj.shape).count;
+		data.info[2] = data.info[3] = 0;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Uploads the packed objects (unless they are in the ring already) and
+///runs the cull shader, which writes the
+///commands and the draw count of both passes. The counters this copy got
+///the last time its frame in flight ran are read back first for the
+///statistics (FramePacer waited for that frame, the read doesn't stall).
+///@param	camera - camera frustum
+///@param	light - light frustum
+///@param	cameraEye - camera position
+///@param	lightEye - light position
+///@param	cameraPixelsPerUnit - projected size of one unit for the camera
+///			(see Geometry::SelectLOD)
+///@param	shadowPixelsPerUnit - same for the shadow map
+///@param	lodEnabled - select the level of detail (or always the finest)
+///----------------------------------------------------------------------------
+void GPUCulling::Cull(const Frustum &camera, const Frustum &light, const GLfloat cameraEye[3],
+					  const GLfloat lightEye[3], GLfloat cameraPixelsPerUnit,
+					  GLfloat shadowPixelsPerUnit, bool lodEnabled)
+{
+	if(!IsValid() || !m_Packed) return;
+
+	UINT objects = (UINT)m_Objects.size();
+	GLuint zero[COUNT_TOTAL];
+	memset(zero, 0, sizeof(zero));
+
+	GLintptr countOffset = m_Frame * CountStride;
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_CountBuffer);
+	glGetBufferSubDataARB(GL_SHADER_STORAGE_BUFFER, countOffset, sizeof(m_Counts), m_Counts);
+	glBufferSubDataARB(GL_SHADER_STORAGE_BUFFER, countOffset, sizeof(zero), zero);
+
+	bool ringed = m_Packed != &m_Objects[0];
+	if(!ringed)
+	{
+		g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_ObjectBuffer);
+		glBufferDataARB(GL_SHADER_STORAGE_BUFFER, objects * sizeof(ObjectData), &m_Objects[0],
+						GL_STREAM_DRAW_ARB);
+	}
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLfloat planes[PASS_COUNT * 6][4], eyes[PASS_COUNT][4];
+	memcpy(planes[CAMERA_PASS * 6], camera.m_Planes, sizeof(camera.m_Planes));
+	memcpy(planes[SHADOW_PASS * 6], light.m_Planes, sizeof(light.m_Planes));
+	for(UINT k=0; k<3; k++)
+	{
+		eyes[CAMERA_PASS][k] = cameraEye[k];
+		eyes[SHADOW_PASS][k] = lightEye[k];
+	}
+	eyes[CAMERA_PASS][3] = eyes[SHADOW_PASS][3] = 1.0f;
+
+	GLfloat lod[4];
+	lod[CAMERA_PASS] = cameraPixelsPerUnit;
+	lod[SHADOW_PASS] = shadowPixelsPerUnit;
+	lod[2] = Geometry::LOD_HYSTERESIS;
+	lod[3] = lodEnabled ? 1.0f : 0.0f;
+
+	m_CullShader.Bind();
+	glUniform1i(m_ObjectCount, (GLint)objects);
+	glUniform4fv(m_Planes, PASS_COUNT * 6, &planes[0][0]);
+	glUniform4fv(m_Eyes, PASS_COUNT, &eyes[0][0]);
+	glUniform4fv(m_LODParameters, 1, lod);
+	glUniformMatrix4fv(m_HiZMatrixUniform, 1, GL_FALSE, m_HiZMatrix.m);
+	glUniform1i(m_HiZLevelsUniform, (GLint)m_HiZLevels);
+
+	//the pyramid of the previous frame (level 0 is always complete)
+	if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_HiZTexture);
+
+	if(ringed)
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, ObjectBinding, m_Ring->GetBuffer(),
+						  m_PackOffset, objects * sizeof(ObjectData));
+	}
+	else
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ObjectBinding, m_ObjectBuffer);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LevelBinding, m_LevelBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LODBinding, m_LODBuffer);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CountBinding, m_CountBuffer, countOffset,
+					  sizeof(m_Counts));
+	for(UINT i=0; i<PASS_COUNT; i++)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CommandBinding[i], m_CommandBuffers[i]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawBinding[i], m_DrawBuffers[i]);
+	}
+
+	glDispatchCompute((objects + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	//the draws read the commands, the count and the draw data
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+					GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	Shader::Unbind();
+	m_Packed = NULL;
+}
+
+///----------------------------------------------------------------------------
+///Draws what the cull shader left in a pass
+///@param	pass - the pass to draw
+///@param	multiDraw - holds the shared buffers and the pass shaders
+///----------------------------------------------------------------------------
+void GPUCulling::Draw(RenderPass pass, MultiDraw &multiDraw)
+{
+	if(!IsValid()) return;
+
+	UINT countIndex = m_Frame * CountStride / sizeof(GLuint) + COUNT_DRAWS + pass;
+	multiDraw.DrawCount(pass, m_CommandBuffers[pass], m_DrawBuffers[pass], m_CountBuffer,
+						countIndex, (UINT)m_Objects.size());
+}
+
+///----------------------------------------------------------------------------
+///Builds the Hi-Z the next frame tests against from the camera depth
+///buffer, call once the camera passes are drawn
+///@param	width - width of the depth buffer
+///@param	height - height of the depth buffer
+///@param	projection - camera projection matrix the depth was drawn with
+///@param	modelview - camera view matrix the depth was drawn with
+///----------------------------------------------------------------------------
+void GPUCulling::BuildHiZ(UINT width, UINT height, const GLdouble projection[16],
+						  const GLdouble modelview[16])
+{
+	if(!IsValid() || width == 0 || height == 0) return;
+
+	if(width != m_HiZWidth || height != m_HiZHeight)
+		CreateHiZ(width, height);
+
+	//the depth copy is only read here, in red (GL_LUMINANCE, or (D,0,0,1)
+	//where the mode is ignored by GLSL 1.30 and up), through a sampler
+	//without comparison
+	g_GLState.BindSampler(m_DepthSampler);
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_DepthTexture);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+	//level 0 is a copy of the depth, every other level halves the one above
+	//(texelFetch ignores the sampler's filters)
+	m_ReduceShader.Bind();
+	for(UINT level=0; level<m_HiZLevels; level++)
+	{
+		UINT w = (std::max)(width >> level, 1U);
+		UINT h = (std::max)(height >> level, 1U);
+
+		g_GLState.BindTexture(GL_TEXTURE_2D, level == 0 ? m_DepthTexture : m_HiZTexture);
+		glUniform1i(m_SourceLevel, level == 0 ? 0 : (GLint)level - 1);
+		glBindImageTexture(0, m_HiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY_ARB, GL_R32F);
+
+		glDispatchCompute((w + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+						  (h + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	Shader::Unbind();
+	g_GLState.BindSampler(0);
+
+	Matrix4 P, V;
+	P.Set(projection);
+	V.Set(modelview);
+	Matrix4::Multiply(P, V, m_HiZMatrix);
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of draws the cull shader wrote for a pass in the
+///last frame known to be finished
+///----------------------------------------------------------------------------
+UINT GPUCulling::GetDrawCount(RenderPass pass) const
+{
+	return m_Counts[COUNT_DRAWS + pass];
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of triangles of the draws of a pass in the last
+///frame known to be finished
+///----------------------------------------------------------------------------
+UINT GPUCulling::GetTriangleCount(RenderPass pass) const
+{
+	return m_Counts[COUNT_TRIANGLES + pass];
+}
+
+///----------------------------------------------------------------------------
+///@returns the size of the buffers (textures not included)
+///----------------------------------------------------------------------------
+UINT GPUCulling::GetBufferBytes() const
+{
+	return m_BufferBytes;
+}
+
+///----------------------------------------------------------------------------
+///Creates the Hi-Z texture for a depth buffer size
+///@param	width - width of the depth buffer
+///@param	height - height of the depth buffer
+///----------------------------------------------------------------------------
+void GPUCulling::CreateHiZ(UINT width, UINT height)
+{
+	ReleaseHiZ();
+
+	if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+
+	UINT levels = 1;
+	while((width >> levels) || (height >> levels)) levels++;
+
+	glGenTextures(1, &m_HiZTexture);
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_HiZTexture);
+	for(UINT level=0; level<levels; level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, (std::max)(width >> level, 1U),
+					 (std::max)(height >> level, 1U), 0, GL_RED, GL_FLOAT, NULL);
+	}
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	//the camera depth is copied to its own texture, the shadow map's
+	//comparison state doesn't apply to it
+	glGenTextures(1, &m_DepthTexture);
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_DepthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT,
+				 GL_UNSIGNED_INT, NULL);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	m_HiZWidth = width;
+	m_HiZHeight = height;
+	m_HiZLevels = levels;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the Hi-Z texture, the next cull doesn't test occlusion until the
+///pyramid is built again
+///----------------------------------------------------------------------------
+void GPUCulling::ReleaseHiZ()
+{
+	if(m_HiZTexture)
+	{
+		g_GLState.DeleteTexture(m_HiZTexture);
+		glDeleteTextures(1, &m_HiZTexture);
+	}
+
+	if(m_DepthTexture)
+	{
+		g_GLState.DeleteTexture(m_DepthTexture);
+		glDeleteTextures(1, &m_DepthTexture);
+	}
+
+	m_HiZTexture = m_DepthTexture = 0;
+	m_HiZWidth = m_HiZHeight = m_HiZLevels = 0;
+}
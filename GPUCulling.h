@@ -0,0 +1,137 @@
+///============================================================================
+///@file	GPUCulling.h
+///@brief	Culls the scene on the GPU. Every frame the objects (transform,
+///			color and world bounds) are copied to a buffer and a compute
+///			shader tests each of them against the light frustum and the
+///			camera frustum, selects its level of detail for both passes
+///			and, for the camera, tests it against a depth pyramid (Hi-Z)
+///			of the previous frame. The survivors are compacted into the
+///			indirect commands and the per-draw data of each pass, which
+///			MultiDraw draws with the count the shader wrote, so the CPU
+///			never sees the culling result. The objects are packed straight
+///			into the upload ring when there is one. The counters have one
+///			copy per frame in flight, each read back once FramePacer
+///			knows its frame is done, so the statistics never stall.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef GPUCULLING_H
+#define GPUCULLING_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+#include "Geometry.h"
+#include "MultiDraw.h"
+#include "Culling.h"
+#include "Shader.h"
+#include "UploadRing.h"
+
+class GPUCulling
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	GPUCulling();
+	virtual ~GPUCulling();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(const Geometry &geometry, const MultiDraw &multiDraw, UploadRing *ring = NULL);
+	void Release();
+	bool IsValid() const;
+	void BeginPack(UINT frame);
+	void Pack(const Geometry &geometry, UINT first, UINT count);
+	void Cull(const Frustum &camera, const Frustum &light, const GLfloat cameraEye[3],
+			  const GLfloat lightEye[3], GLfloat cameraPixelsPerUnit,
+			  GLfloat shadowPixelsPerUnit, bool lodEnabled);
+	void Draw(RenderPass pass, MultiDraw &multiDraw);
+	void BuildHiZ(UINT width, UINT height, const GLdouble projection[16], const GLdouble modelview[16]);
+	UINT GetDrawCount(RenderPass pass) const;
+	UINT GetTriangleCount(RenderPass pass) const;
+	UINT GetBufferBytes() const;
+
+	static bool IsSupported();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT CULL_GROUP_SIZE = 64;	///> Objects per cull work group
+	static const UINT HIZ_GROUP_SIZE = 8;	///> Texels per side of a Hi-Z work group
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///Per-object input, std430 layout of the Object struct in the shader
+	struct ObjectData
+	{
+		GLfloat	world[16];		///> Object to world transform
+		GLfloat	normal[12];		///> Normal matrix (3 columns padded to vec4)
+		GLfloat	color[4];		///> Object color
+		GLfloat	center[4];		///> Center of the world bounds
+		GLfloat	extent[4];		///> Half size of the world bounds
+		GLuint	info[4];		///> Shape and number of levels
+	};
+
+	///Mesh of a level of detail of a shape in one pass
+	struct LevelData
+	{
+		GLuint	firstIndex;		///> First index in the shared index buffer
+		GLuint	indexCount;		///> Number of indices
+		GLint	baseVertex;		///> First vertex in the shared vertex buffer
+		GLfloat	minSize;		///> Smallest projected size of the level
+	};
+
+	///Values the cull shader writes besides the commands
+	enum Counter
+	{
+		COUNT_DRAWS = 0,						///> Draws of each pass
+		COUNT_TRIANGLES = COUNT_DRAWS + PASS_COUNT,	///> Triangles of each pass
+		COUNT_TOTAL = COUNT_TRIANGLES + PASS_COUNT
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void CreateHiZ(UINT width, UINT height);
+	void ReleaseHiZ();
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<ObjectData> m_Objects;	///> Objects packed when the ring is full or missing
+	ObjectData*	m_Packed;				///> Where this frame's objects are packed
+	GLintptr	m_PackOffset;			///> Offset of m_Packed in the ring
+	UploadRing*	m_Ring;					///> Per-frame upload memory (may be NULL)
+	Shader		m_CullShader;			///> Culls and compacts the objects
+	Shader		m_ReduceShader;			///> Builds a Hi-Z level from the one above
+	GLint		m_ObjectCount;			///> objectCount uniform of the cull shader
+	GLint		m_Planes;				///> planes uniform (frustum of each pass)
+	GLint		m_Eyes;					///> eyes uniform (camera and light position)
+	GLint		m_LODParameters;		///> lod uniform (sizes, hysteresis, enabled)
+	GLint		m_HiZMatrixUniform;		///> hiZMatrix uniform
+	GLint		m_HiZLevelsUniform;		///> hiZLevels uniform
+	GLint		m_SourceLevel;			///> sourceLevel uniform of the reduce shader
+	GLuint		m_DepthSampler;			///> Reads the depth copy without comparison
+	GLuint		m_ObjectBuffer;			///> Packed objects
+	GLuint		m_LevelBuffer;			///> Levels of every shape and pass
+	GLuint		m_LODBuffer;			///> Current level of every object and pass
+	GLuint		m_CountBuffer;			///> Counter values (also the draw counts)
+	GLuint		m_CommandBuffers[PASS_COUNT];	///> Compacted indirect commands
+	GLuint		m_DrawBuffers[PASS_COUNT];		///> Compacted per-draw data
+	GLuint		m_Counts[COUNT_TOTAL];	///> Counter values of the last finished frame
+	UINT		m_Frame;				///> Copy of the counters this frame writes
+	UINT		m_BufferBytes;			///> Size of the buffers above
+	GLuint		m_DepthTexture;			///> Copy of the camera depth the Hi-Z is built from
+	GLuint		m_HiZTexture;			///> Farthest depth pyramid (R32F mipmaps)
+	UINT		m_HiZWidth;				///> Size of the Hi-Z base level
+	UINT		m_HiZHeight;
+	UINT		m_HiZLevels;			///> Levels of the pyramid (0 if not built yet)
+	Matrix4		m_HiZMatrix;			///> View-projection the pyramid was drawn with
+};
+
+#endif
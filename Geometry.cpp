@@ -7,123 +7,1035 @@
 ///============================================================================
 
 #include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+const GLfloat Geometry::LOD_HYSTERESIS = 0.15f;
+
+//projected sizes (in pixels or shadow map texels) where the levels change
+static const GLfloat FineLODSize	= 64.0f;
+static const GLfloat MediumLODSize	= 20.0f;
+
+//Decodes the quantized vertices and does what the fixed-function pipeline
+//does for the camera passes: light0 with color material and a specular
+//highlight (and its cone when it's a spot light), plus the eye-linear
+//texgen of the shadow map coordinates
+static const char QuantizedVertexShader[] =
+	"uniform vec3 positionScale;\n"
+	"uniform vec3 positionOffset;\n"
+	"uniform float normalScale;\n"
+	"uniform bool lightEnabled;\n"
+	"attribute vec2 octNormal;\n"
+	"\n"
+	"vec3 DecodeNormal(vec2 e)\n"
+	"{\n"
+	"	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+	"	if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);\n"
+	"	return normalize(n);\n"
+	"}\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 position = vec4(gl_Vertex.xyz * positionScale + positionOffset, 1.0);\n"
+	"	vec4 eye = gl_ModelViewMatrix * position;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * position;\n"
+	"\n"
+	"	vec4 color = gl_Color * gl_LightModel.ambient;\n"
+	"	if(lightEnabled)\n"
+	"	{\n"
+	"		vec3 N = normalize(gl_NormalMatrix * DecodeNormal(octNormal * normalScale));\n"
+	"		vec3 L = normalize(gl_LightSource[0].position.xyz - eye.xyz * gl_LightSource[0].position.w);\n"
+	"		vec3 H = normalize(L + vec3(0.0, 0.0, 1.0));\n"
+	"		float NdotL = max(dot(N, L), 0.0);\n"
+	"\n"
+	"		float spot = 1.0;\n"
+	"		if(gl_LightSource[0].spotCutoff <= 90.0)\n"
+	"		{\n"
+	"			float cosAngle = dot(-L, normalize(gl_LightSource[0].spotDirection));\n"
+	"			spot = cosAngle < gl_LightSource[0].spotCosCutoff ? 0.0 :\n"
+	"				   pow(max(cosAngle, 0.0), gl_LightSource[0].spotExponent);\n"
+	"		}\n"
+	"\n"
+	"		color += gl_Color * (gl_LightSource[0].ambient + gl_LightSource[0].diffuse * NdotL) * spot;\n"
+	"		if(NdotL > 0.0)\n"
+	"			color += gl_FrontMaterial.specular * gl_LightSource[0].specular *\n"
+	"					 pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess) * spot;\n"
+	"	}\n"
+	"	gl_FrontColor = vec4(clamp(color.rgb, 0.0, 1.0), gl_Color.a);\n"
+	"\n"
+	"	vec4 shadow = vec4(dot(eye, gl_EyePlaneS[0]), dot(eye, gl_EyePlaneT[0]),\n"
+	"					   dot(eye, gl_EyePlaneR[0]), dot(eye, gl_EyePlaneQ[0]));\n"
+	"	gl_TexCoord[0] = gl_TextureMatrix[0] * shadow;\n"
+	"}\n";
+
+//Replaces the shadow map comparison of the camera passes when the light
+//casts its shadows from a depth cube map. The texture coordinates hold the
+//world position (identity eye planes), the face the direction to the light
+//falls on stores the depth of that face's projection, whose view depth is
+//the largest component of the direction. The comparison result goes to the
+//alpha like GL_DEPTH_TEXTURE_MODE GL_ALPHA does for the 2D shadow map.
+static const char PointShadowFragmentShader[] =
+	"#version 130\n"
+	"uniform samplerCubeShadow shadowMap;\n"
+	"uniform vec3 lightPosition;\n"
+	"uniform vec2 depthRange;\n"
+	"uniform bool shadowed;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	vec3 L = gl_TexCoord[0].xyz / gl_TexCoord[0].w - lightPosition;\n"
+	"	vec3 a = abs(L);\n"
+	"	float z = max(a.x, max(a.y, a.z));\n"
+	"	float n = depthRange.x;\n"
+	"	float f = depthRange.y;\n"
+	"	float depth = 0.5 * ((f + n) / (f - n) - 2.0 * f * n / ((f - n) * z)) + 0.5;\n"
+	"\n"
+	"	float lit = texture(shadowMap, vec4(L, depth));\n"
+	"	gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * (shadowed ? 1.0 - lit : lit));\n"
+	"}\n";
 
 ///----------------------------------------------------------------------------
 ///Default constructor
 ///----------------------------------------------------------------------------
-Geometry::Geometry() : m_DepthMap(0)
+Geometry::Geometry() : m_ShadowSamplersEnabled(true), m_LODEnabled(true),
+						   m_QuantizeShadow(false), m_OptimizeMeshes(true),
+						   m_VertexFormat(Mesh::FLOAT_VERTEX), m_PointShadowMap(0),
+						   m_PointShadowTest(SHADOW_TEST_LIT), m_SceneLoaded(false)
 {
+	memset(m_ShadowSamplers, 0, sizeof(m_ShadowSamplers));
+	memset(&m_ShaderParams, 0, sizeof(m_ShaderParams));
+	memset(&m_PointShaderParams, 0, sizeof(m_PointShaderParams));
+	memset(m_PointLight, 0, sizeof(m_PointLight));
+	memset(m_PointDepthRange, 0, sizeof(m_PointDepthRange));
 }
 
 ///----------------------------------------------------------------------------
-///Draw the objects in the scene
-///@param	angle - used to animate part of the geometry
+///Default destructor
 ///----------------------------------------------------------------------------
-void Geometry::Draw(GLfloat angle)
+Geometry::~Geometry()
 {
-	//Display lists for the objects
-	static GLuint BaseList=0, SphereList=0, ConeList=0, TorusList=0;
+	Release();
+}
 
-	//create Base display list if needed
-	if(!BaseList)
+///----------------------------------------------------------------------------
+///Deletes the meshes (call while the rendering context is still current)
+///----------------------------------------------------------------------------
+void Geometry::Release()
+{
+	for(UINT i=0; i<m_Meshes.size(); i++)
 	{
-		BaseList = glGenLists(1);
-		glNewList(BaseList, GL_COMPILE);
-		{
-			glColor3f(0.0, 0.0, 1.0);
-			glPushMatrix();
+		m_Meshes[i]->Release();
+		delete m_Meshes[i];
+	}
+	m_Meshes.clear();
+	m_Shapes.clear();
+	m_SceneFile.Close();
+	m_SceneLoaded = false;
+
+	m_QuantizedShader.Release();
+	m_PointShadowShader.Release();
+	m_QuantizedPointShader.Release();
+	m_PointShadowMap = 0;
+}
+
+///----------------------------------------------------------------------------
+///Creates the meshes (one per level of detail, plus the shadow proxies)
+///and the object instances in the scene
+///@param	extraObjects - number of additional objects scattered around the
+///			base plate (used to stress culling in big scenes)
+///----------------------------------------------------------------------------
+void Geometry::CreateScene(UINT extraObjects)
+{
+	//Meshes for the shapes, all objects share them
+	static const GLint SphereLOD[LODChain::MAX_LODS] = {24, 12, 6};
+	static const GLint TorusLOD[LODChain::MAX_LODS][2] = {{24, 48}, {12, 24}, {6, 12}};
+	static const GLint ConeLOD[LODChain::MAX_LODS][2] = {{25, 25}, {12, 4}, {6, 1}};
+	static const GLfloat MinSize[LODChain::MAX_LODS] = {FineLODSize, MediumLODSize, 0.0f};
+	AABB CubeBounds, SphereBounds, ConeBounds, TorusBounds;
+	Mesh *mesh, *proxy;
+
+	Release();
+
+	//quantized vertices can only be drawn with the decoding shader
+	if(!CreateShader()) m_VertexFormat = Mesh::FLOAT_VERTEX;
+
+	//the cube is too simple to need other levels
+	mesh = NewMesh();
+	mesh->CreateCube(1.0f);
+	AddLOD(CUBE, mesh, 0.0f);
+	GLfloat cubeMin[3] = {-0.5f, -0.5f, -0.5f}, cubeMax[3] = {0.5f, 0.5f, 0.5f};
+	CubeBounds.Clear(); CubeBounds.Grow(cubeMin); CubeBounds.Grow(cubeMax);
 
-			glScalef(7.0, 0.3, 7.0);
-			glutSolidCube(1.0);
+	//the torus lies on the XY plane, the shape of the tube's section
+	//hardly changes its shadow so the proxies have half the sides
+	for(UINT i=0; i<LODChain::MAX_LODS; i++)
+	{
+		mesh = NewMesh();
+		mesh->CreateTorus(0.3f, 1.0f, TorusLOD[i][0], TorusLOD[i][1]);
+
+		proxy = NewMesh();
+		proxy->CreateTorus(0.3f, 1.0f, TorusLOD[i][0] / 2 < 4 ? 4 : TorusLOD[i][0] / 2, TorusLOD[i][1]);
+
+		AddLOD(TORUS, mesh, MinSize[i], proxy);
+	}
+	GLfloat torusMin[3] = {-1.3f, -1.3f, -0.3f}, torusMax[3] = {1.3f, 1.3f, 0.3f};
+	TorusBounds.Clear(); TorusBounds.Grow(torusMin); TorusBounds.Grow(torusMax);
 
-			glPopMatrix();
+	for(UINT i=0; i<LODChain::MAX_LODS; i++)
+	{
+		mesh = NewMesh();
+		mesh->CreateSphere(0.2f, SphereLOD[i], SphereLOD[i]);
+		AddLOD(SPHERE, mesh, MinSize[i]);
+	}
+	GLfloat sphereMin[3] = {-0.2f, -0.2f, -0.2f}, sphereMax[3] = {0.2f, 0.2f, 0.2f};
+	SphereBounds.Clear(); SphereBounds.Grow(sphereMin); SphereBounds.Grow(sphereMax);
+
+	//cube inscribed in the sphere, used when it acts as an occluder
+	AABB SphereCore;
+	GLfloat coreMin[3] = {-0.115f, -0.115f, -0.115f}, coreMax[3] = {0.115f, 0.115f, 0.115f};
+	SphereCore.Clear(); SphereCore.Grow(coreMin); SphereCore.Grow(coreMax);
+
+	//the cone base is on the XY plane and points along +Z. The stacks only
+	//help the lighting, a single one gives the same depth
+	for(UINT i=0; i<LODChain::MAX_LODS; i++)
+	{
+		mesh = NewMesh();
+		mesh->CreateCone(0.3f, 2.0f, ConeLOD[i][0], ConeLOD[i][1]);
+
+		proxy = NULL;
+		if(ConeLOD[i][1] > 1)
+		{
+			proxy = NewMesh();
+			proxy->CreateCone(0.3f, 2.0f, ConeLOD[i][0], 1);
 		}
-		glEndList();
+
+		AddLOD(CONE, mesh, MinSize[i], proxy);
+	}
+	GLfloat coneMin[3] = {-0.3f, -0.3f, 0.0f}, coneMax[3] = {0.3f, 0.3f, 2.0f};
+	ConeBounds.Clear(); ConeBounds.Grow(coneMin); ConeBounds.Grow(coneMax);
+
+	for(UINT i=0; i<m_Meshes.size(); i++)
+	{
+		if(m_OptimizeMeshes)
+			m_Meshes[i]->Optimize();
+		else
+			m_Meshes[i]->Analyze();
 	}
+	UploadMeshes(m_VertexFormat);
+
+	m_Objects.clear();
+	m_Bounds.clear();
+	m_Animated.clear();
+
+	//Base
+	Matrix4 M;
+	M.Scale(7.0, 0.3, 7.0);
+	AddObject(CUBE, CubeBounds, M, 0.0f, 0.0f, 1.0f, false, &CubeBounds);
+
+	//Torus
+	M.Identity();
+	M.Translate(0.0f, 1.0f, 0.0f);
+	M.Rotate(90.0f, 1.0f, 0.0f, 0.0f);
+	AddObject(TORUS, TorusBounds, M, 1.0f, 0.0f, 0.0f, false);
+
+	//Spheres, animated around the Y axis
+	M.Identity();
+	M.Translate(0.5f, 2.0f, 0.5f);
+	AddObject(SPHERE, SphereBounds, M, 0.0f, 1.0f, 0.0f, true, &SphereCore);
+
+	M.Translate(-1.0f, 0.0f, 0.0f);
+	AddObject(SPHERE, SphereBounds, M, 0.0f, 1.0f, 0.0f, true, &SphereCore);
+
+	M.Translate(0.0f, 0.0f,-1.0f);
+	AddObject(SPHERE, SphereBounds, M, 0.0f, 1.0f, 0.0f, true, &SphereCore);
+
+	M.Translate(1.0f, 0.0f, 0.0f);
+	AddObject(SPHERE, SphereBounds, M, 0.0f, 1.0f, 0.0f, true, &SphereCore);
+
+	//Cones
+	M.Identity();
+	M.Translate(2.0, 0.0, 2.0);
+	M.Rotate(-90, 1.0, 0.0, 0.0);
+	AddObject(CONE, ConeBounds, M, 1.0f, 1.0f, 0.0f, false);
+
+	M.Translate(-4.0, 0.0, 0.0);
+	AddObject(CONE, ConeBounds, M, 1.0f, 1.0f, 0.0f, false);
+
+	M.Translate(0.0, 4.0, 0.0);
+	AddObject(CONE, ConeBounds, M, 1.0f, 1.0f, 0.0f, false);
+
+	M.Translate(4.0, 0.0, 0.0);
+	M.Scale(1.0, 1.0, 1.5);
+	AddObject(CONE, ConeBounds, M, 1.0f, 1.0f, 0.0f, false);
 
-	//Create torus display list if needed
-	if(!TorusList)
+	//Extra objects, scattered around the base with a fixed seed so every
+	//run (and every benchmark) sees the same scene
+	Shape shapes[4] = {CUBE, SPHERE, CONE, TORUS};
+	const AABB *bounds[4] = {&CubeBounds, &SphereBounds, &ConeBounds, &TorusBounds};
+	const AABB *occluders[4] = {&CubeBounds, &SphereCore, NULL, NULL};
+	UINT seed = 12345;
+
+	for(UINT i=0; i<extraObjects; i++)
 	{
-		TorusList=glGenLists(1);
-		glNewList(TorusList, GL_COMPILE);
+		GLfloat r[5];
+		for(int j=0; j<5; j++)
 		{
-			glColor3f(1.0f, 0.0f, 0.0f);
-			glPushMatrix();
+			seed = seed * 1664525 + 1013904223;
+			r[j] = (seed >> 8) / 16777216.0f;
+		}
+
+		GLfloat x = -50.0f + 100.0f * r[0];
+		GLfloat z = -50.0f + 100.0f * r[1];
+
+		//keep the original scene clear
+		if(fabs(x) < 4.5f && fabs(z) < 4.5f) x += x < 0.0f ? -9.0f : 9.0f;
+
+		int shape = (int)(r[2] * 4.0f) & 3;
+		GLfloat scale = 0.5f + r[3];
+
+		M.Identity();
+		M.Translate(x, 0.5f, z);
+		if(shapes[shape] == CONE) M.Rotate(-90, 1.0, 0.0, 0.0);
+		M.Scale(scale, scale, scale);
+
+		//one out of eight objects orbits with the spheres
+		AddObject(shapes[shape], *bounds[shape], M, r[4], 1.0f - r[4], r[3], (i & 7) == 0,
+				  occluders[shape]);
+	}
+
+	Animate(0.0f);
+}
+
+///----------------------------------------------------------------------------
+///Replaces the scene with the one in a scene file. The file is mapped and
+///its streams are given to the GL as they are, nothing is generated or
+///converted. The mapping is kept only when the meshes are drawn from
+///client memory.
+///@param	path - file written by SaveScene
+///@returns false if the file is missing, invalid or needs the quantized
+///			vertex shader and it isn't available (the scene is then empty)
+///----------------------------------------------------------------------------
+bool Geometry::LoadScene(LPCSTR path)
+{
+	Release();
+
+	if(!m_SceneFile.Open(path)) return false;
 
-			glTranslatef(0.0f, 1.0f, 0.0f);
-			glRotatef(90.0f, 1.0f, 0.0f, 0.0f);
-			glutSolidTorus(0.3, 1.0, 24, 48);
+	bool shader = CreateShader();
+	Mesh::VertexFormat requested = m_VertexFormat;
 
-			glPopMatrix();
+	for(UINT i=0; i<m_SceneFile.GetMeshCount(); i++)
+	{
+		Mesh::Streams streams;
+		m_SceneFile.GetMesh(i, streams);
+
+		//the passes draw every mesh the same way, so all of them must share
+		//the format of the first one
+		if(i == 0) m_VertexFormat = streams.format;
+
+		if(streams.format != m_VertexFormat || (m_VertexFormat != Mesh::FLOAT_VERTEX && !shader))
+		{
+			Release();
+			m_VertexFormat = requested;
+			return false;
 		}
-		glEndList();
+
+		NewMesh()->Attach(streams);
 	}
 
-	//create Spheres display list if needed
-	if(!SphereList)
+	for(UINT i=0; i<m_SceneFile.GetShapeCount(); i++)
 	{
-		SphereList = glGenLists(1);
-		glNewList(SphereList, GL_COMPILE);
+		const SceneShapeRecord &shape = m_SceneFile.GetShape(i);
+
+		for(UINT j=0; j<shape.lodCount && j<LODChain::MAX_LODS; j++)
 		{
-			glColor3f(0.0, 1.0, 0.0);
-			glPushMatrix();
+			Mesh *proxy = m_Meshes[shape.shadowMeshes[j]];
+			AddLOD(i, m_Meshes[shape.meshes[j]], shape.minSize[j],
+				   proxy == m_Meshes[shape.meshes[j]] ? NULL : proxy);
+		}
+	}
+
+	m_Objects.clear();
+	m_Bounds.clear();
+	m_Animated.clear();
+
+	for(UINT i=0; i<m_SceneFile.GetInstanceCount(); i++)
+	{
+		const SceneInstanceRecord &instance = m_SceneFile.GetInstance(i);
+		AABB bounds, occluder;
+		Matrix4 M;
+
+		M.Set(instance.transform);
+		bounds.Clear();
+		bounds.Grow(instance.boundsMin);
+		bounds.Grow(instance.boundsMax);
+		occluder.Clear();
+		occluder.Grow(instance.occluderMin);
+		occluder.Grow(instance.occluderMax);
+
+		AddObject(instance.shape, bounds, M, 0.0f, 0.0f, 0.0f,
+				  (instance.flags & SceneInstanceRecord::ANIMATED) != 0,
+				  (instance.flags & SceneInstanceRecord::OCCLUDER) ? &occluder : NULL);
+		memcpy(m_Objects.back().color, instance.color, sizeof(instance.color));
+	}
+
+	//the buffer objects have their own copy of the streams
+	if(g_GLCaps.vertexBufferObject) m_SceneFile.Close();
+	m_SceneLoaded = true;
 
-			glTranslatef(0.5f, 2.0f, 0.5f);
-			glutSolidSphere(0.2, 24, 24);
+	Animate(0.0f);
+	return true;
+}
 
-			glTranslatef(-1.0f, 0.0f, 0.0f);
-			glutSolidSphere(0.2, 24, 24);
+///----------------------------------------------------------------------------
+///Writes the meshes, shapes and objects of the scene to a scene file, with
+///the streams in the current vertex format
+///@param	path - file name
+///@returns false if the file couldn't be written
+///----------------------------------------------------------------------------
+bool Geometry::SaveScene(LPCSTR path) const
+{
+	std::vector<Mesh::Streams> meshes(m_Meshes.size());
+	std::vector<SceneShapeRecord> shapes(m_Shapes.size());
+	std::vector<SceneInstanceRecord> instances(m_Objects.size());
 
-			glTranslatef(0.0f, 0.0f,-1.0f);
-			glutSolidSphere(0.2, 24, 24);
+	for(UINT i=0; i<m_Meshes.size(); i++)
+		m_Meshes[i]->GetStreams(meshes[i]);
 
-			glTranslatef(1.0f, 0.0f, 0.0f);
-			glutSolidSphere(0.2, 24, 24);
+	for(UINT i=0; i<m_Shapes.size(); i++)
+	{
+		const LODChain &chain = m_Shapes[i];
+		SceneShapeRecord &shape = shapes[i];
+		memset(&shape, 0, sizeof(shape));
+		shape.lodCount = chain.count;
 
-			glPopMatrix();
+		for(UINT j=0; j<chain.count; j++)
+		{
+			//meshes are referenced by their position in m_Meshes
+			for(UINT k=0; k<m_Meshes.size(); k++)
+			{
+				if(m_Meshes[k] == chain.meshes[j]) shape.meshes[j] = k;
+				if(m_Meshes[k] == chain.shadowMeshes[j]) shape.shadowMeshes[j] = k;
+			}
+			shape.minSize[j] = chain.minSize[j];
 		}
-		glEndList();
 	}
 
-	//create Cone display list if needed
-	if(!ConeList)
+	for(UINT i=0; i<m_Objects.size(); i++)
 	{
-		ConeList = glGenLists(1);
-		glNewList(ConeList, GL_COMPILE);
+		const SceneObject &obj = m_Objects[i];
+		SceneInstanceRecord &instance = instances[i];
+		memset(&instance, 0, sizeof(instance));
+
+		instance.shape = obj.shape;
+		instance.flags = (obj.animated ? SceneInstanceRecord::ANIMATED : 0) |
+						 (obj.occluder ? SceneInstanceRecord::OCCLUDER : 0);
+		memcpy(instance.color, obj.color, sizeof(instance.color));
+		memcpy(instance.transform, obj.local.m, sizeof(instance.transform));
+
+		for(int k=0; k<3; k++)
 		{
-			glColor3f(1.0, 1.0, 0.0);
-			glPushMatrix();
+			instance.boundsMin[k] = obj.localBounds.min[k];
+			instance.boundsMax[k] = obj.localBounds.max[k];
+			if(obj.occluder)
+			{
+				instance.occluderMin[k] = obj.occluderBounds.min[k];
+				instance.occluderMax[k] = obj.occluderBounds.max[k];
+			}
+		}
+	}
+
+	return SceneFile::Write(path, meshes, shapes, instances);
+}
+
+///----------------------------------------------------------------------------
+///Optimizes a new mesh and builds its streams in the format of the scene
+///meshes. Makes no GL calls, so it can run on a loading thread.
+///@param	mesh - the mesh, not uploaded yet
+///----------------------------------------------------------------------------
+void Geometry::PrepareMesh(Mesh &mesh) const
+{
+	if(m_OptimizeMeshes)
+		mesh.Optimize();
+	else
+		mesh.Analyze();
+	mesh.Prepare(m_VertexFormat, m_QuantizeShadow);
+}
+
+///----------------------------------------------------------------------------
+///Adds an object with a mesh of its own (i.e. an imported model) standing
+///on a point. The BVH must be built again afterwards.
+///@param	mesh - a mesh prepared by PrepareMesh and uploaded, owned by the
+///				geometry from now on
+///@param	position - where the bottom center of the mesh is placed
+///@param	size - the longest side of the mesh bounds is scaled to it
+///@param	r,g,b - object color
+///----------------------------------------------------------------------------
+void Geometry::AddMesh(Mesh *mesh, const GLfloat position[3], GLfloat size,
+					   GLfloat r, GLfloat g, GLfloat b)
+{
+	m_Meshes.push_back(mesh);
+
+	UINT shape = (UINT)m_Shapes.size();
+	AddLOD(shape, mesh, 0.0f);
+
+	const AABB &bounds = mesh->GetBounds();
+	GLfloat extent = 0.0f, center[3];
+	bounds.GetCenter(center);
+	for(int k=0; k<3; k++)
+		extent = (std::max)(extent, bounds.max[k] - bounds.min[k]);
+	GLfloat scale = extent > 0.0f ? size / extent : 1.0f;
+
+	Matrix4 M;
+	M.Translate(position[0], position[1], position[2]);
+	M.Scale(scale, scale, scale);
+	M.Translate(-center[0], -bounds.min[1], -center[2]);
+
+	AddObject(shape, bounds, M, r, g, b, false);
+}
+
+///----------------------------------------------------------------------------
+///Creates the shader that decodes the quantized vertices (once)
+///@returns false if it can't be used (no GLSL support or a compile error)
+///----------------------------------------------------------------------------
+bool Geometry::CreateShader()
+{
+	if(m_QuantizedShader.IsValid()) return true;
+	if(!g_GLCaps.glsl || !m_QuantizedShader.Create(QuantizedVertexShader, NULL)) return false;
 
-			glTranslatef(2.0, 0.0, 2.0);
-			glRotatef(-90, 1.0, 0.0, 0.0);
-			glutSolidCone(0.3, 2.0, 25, 25);
+	m_ShaderParams.normal			= m_QuantizedShader.GetAttribute("octNormal");
+	m_ShaderParams.positionScale	= m_QuantizedShader.GetUniform("positionScale");
+	m_ShaderParams.positionOffset	= m_QuantizedShader.GetUniform("positionOffset");
+	m_ShaderParams.normalScale		= m_QuantizedShader.GetUniform("normalScale");
 
-			glTranslatef(-4.0, 0.0, 0.0);
-			glutSolidCone(0.3, 2.0, 25, 25);
+	if(m_ShaderParams.normal < 0)
+	{
+		m_QuantizedShader.Release();
+		return false;
+	}
 
-			glTranslatef(0.0, 4.0, 0.0);
-			glutSolidCone(0.3, 2.0, 25, 25);
+	return true;
+}
 
-			glTranslatef(4.0, 0.0, 0.0);
-			glScalef(1.0, 1.0, 1.5);
-			glutSolidCone(0.3, 2.0, 25, 25);
+///----------------------------------------------------------------------------
+///@returns a new empty mesh owned by the geometry
+///----------------------------------------------------------------------------
+Mesh* Geometry::NewMesh()
+{
+	m_Meshes.push_back(new Mesh());
+	return m_Meshes.back();
+}
 
-			glPopMatrix();
+///----------------------------------------------------------------------------
+///Builds the vertex streams of every mesh and moves them to the GPU
+///@param	format - format of the camera pass vertices
+///----------------------------------------------------------------------------
+void Geometry::UploadMeshes(Mesh::VertexFormat format)
+{
+	for(UINT i=0; i<m_Meshes.size(); i++)
+		m_Meshes[i]->Upload(format, m_QuantizeShadow);
+}
+
+///----------------------------------------------------------------------------
+///Adds a level of detail to a shape, levels are added from the finest
+///@param	shape - the shape
+///@param	mesh - mesh with the level's tessellation
+///@param	minSize - smallest projected size the level is used at
+///@param	shadowProxy - simpler mesh drawn in the shadow pass instead (NULL
+///			to draw the mesh itself)
+///----------------------------------------------------------------------------
+void Geometry::AddLOD(UINT shape, Mesh *mesh, GLfloat minSize, Mesh *shadowProxy)
+{
+	if(shape >= m_Shapes.size())
+	{
+		LODChain empty;
+		empty.count = 0;
+		m_Shapes.resize(shape + 1, empty);
+	}
+
+	LODChain &chain = m_Shapes[shape];
+	if(chain.count == LODChain::MAX_LODS) return;
+
+	chain.meshes[chain.count]		= mesh;
+	chain.shadowMeshes[chain.count]	= shadowProxy ? shadowProxy : mesh;
+	chain.minSize[chain.count]		= minSize;
+	chain.count++;
+}
+
+///----------------------------------------------------------------------------
+///Adds an object instance to the scene
+///@param	shape - the object's shape
+///@param	bounds - bounds of the shape in object space
+///@param	M - object transform
+///@param	r,g,b - object color
+///@param	animated - true if the object rotates with the spheres
+///@param	occluder - box fully inside the shape (NULL if it has none, the
+///			torus and the cone are too thin to hide anything)
+///----------------------------------------------------------------------------
+void Geometry::AddObject(UINT shape, const AABB &bounds, const Matrix4 &M,
+						 GLfloat r, GLfloat g, GLfloat b, bool animated,
+						 const AABB *occluder)
+{
+	SceneObject obj;
+	obj.shape		= shape;
+	obj.lod[CAMERA_PASS] = 0;
+	obj.lod[SHADOW_PASS] = 0;
+	obj.color[0]	= (GLubyte)(r * 255.0f + 0.5f);
+	obj.color[1]	= (GLubyte)(g * 255.0f + 0.5f);
+	obj.color[2]	= (GLubyte)(b * 255.0f + 0.5f);
+	obj.color[3]	= 255;
+	obj.local		= M;
+	obj.world		= M;
+	obj.localBounds	= bounds;
+	obj.animated	= animated;
+	obj.occluder	= occluder != NULL;
+	if(occluder) obj.occluderBounds = *occluder;
+
+	AABB world;
+	bounds.Transform(M, world);
+
+	if(animated) m_Animated.push_back((UINT)m_Objects.size());
+	m_Objects.push_back(obj);
+	m_Bounds.push_back(world);
+}
+
+///----------------------------------------------------------------------------
+///Builds the bounding volume hierarchy over the current object bounds
+///----------------------------------------------------------------------------
+void Geometry::BuildBVH()
+{
+	m_BVH.Build(m_Bounds.empty() ? NULL : &m_Bounds[0], (UINT)m_Bounds.size());
+}
+
+///----------------------------------------------------------------------------
+///Updates the transforms and bounds of the animated objects
+///@param	angle - rotation around the Y axis in degrees
+///----------------------------------------------------------------------------
+void Geometry::Animate(GLfloat angle)
+{
+	Animate(angle, 0, (UINT)m_Animated.size());
+}
+
+///----------------------------------------------------------------------------
+///Updates a range of the animated objects, ranges don't share any data so
+///they can be updated on different threads
+///@param	angle - rotation around the Y axis in degrees
+///@param	first - first animated object (not the object index)
+///@param	count - number of animated objects
+///----------------------------------------------------------------------------
+void Geometry::Animate(GLfloat angle, UINT first, UINT count)
+{
+	Matrix4 R;
+	R.Rotate(angle, 0.0, 1.0, 0.0);
+
+	for(UINT i=first; i<first+count; i++)
+	{
+		SceneObject &obj = m_Objects[m_Animated[i]];
+		Matrix4::Multiply(R, obj.local, obj.world);
+		obj.localBounds.Transform(obj.world, m_Bounds[m_Animated[i]]);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Refits the hierarchy after the animated objects moved
+///----------------------------------------------------------------------------
+void Geometry::RefitBVH()
+{
+	if(m_Animated.empty()) return;
+	m_BVH.Refit(&m_Bounds[0], &m_Animated[0], (UINT)m_Animated.size());
+}
+
+///----------------------------------------------------------------------------
+///Finds the objects inside a frustum
+///@param	frustum - camera or light frustum
+///@param	visible - returned object indices
+///----------------------------------------------------------------------------
+void Geometry::Cull(const Frustum &frustum, std::vector<UINT> &visible) const
+{
+	visible.clear();
+	if(m_Bounds.empty()) return;
+
+	m_BVH.CullFrustum(frustum, &m_Bounds[0], visible);
+}
+
+///----------------------------------------------------------------------------
+///Selects the level of detail of some objects for a pass from their
+///projected size. A level only changes once the size is LOD_HYSTERESIS
+///past the threshold, so objects near it don't flicker between levels.
+///@param	pass - pass the objects will be drawn in
+///@param	objects - indices of the objects (i.e. the culling result)
+///@param	eye - camera or light position
+///@param	pixelsPerUnit - projected size of one unit at distance 1 (for a
+///			perspective projection P this is P[5] * viewport height / 2)
+///@param	vertexBytes - returned size of the vertex streams the pass will
+///			fetch (may be NULL)
+///@returns the number of triangles of the selected levels
+///----------------------------------------------------------------------------
+UINT Geometry::SelectLOD(RenderPass pass, const std::vector<UINT> &objects,
+						 const GLfloat eye[3], GLfloat pixelsPerUnit, UINT *vertexBytes)
+{
+	if(objects.empty())
+	{
+		if(vertexBytes) *vertexBytes = 0;
+		return 0;
+	}
+
+	return SelectLOD(pass, &objects[0], (UINT)objects.size(), eye, pixelsPerUnit, vertexBytes);
+}
+
+///----------------------------------------------------------------------------
+///Same as above for a range of the culling result. Only the level of the
+///given pass is written, so ranges and passes can be selected on different
+///threads.
+///----------------------------------------------------------------------------
+UINT Geometry::SelectLOD(RenderPass pass, const UINT *objects, UINT count,
+						 const GLfloat eye[3], GLfloat pixelsPerUnit, UINT *vertexBytes)
+{
+	UINT triangles = 0, bytes = 0;
+
+	for(UINT i=0; i<count; i++)
+	{
+		SceneObject &obj = m_Objects[objects[i]];
+		const LODChain &chain = m_Shapes[obj.shape];
+		const AABB &box = m_Bounds[objects[i]];
+		UINT lod = obj.lod[pass];
+
+		if(m_LODEnabled)
+		{
+			//projected diameter of the bounding sphere
+			GLfloat c[3], d2 = 0.0f, r2 = 0.0f;
+			box.GetCenter(c);
+			for(int k=0; k<3; k++)
+			{
+				d2 += (c[k] - eye[k]) * (c[k] - eye[k]);
+				r2 += 0.25f * (box.max[k] - box.min[k]) * (box.max[k] - box.min[k]);
+			}
+
+			GLfloat size = d2 > r2 ? 2.0f * sqrtf(r2 / d2) * pixelsPerUnit : FLT_MAX;
+
+			while(lod > 0 && size > chain.minSize[lod-1] * (1.0f + LOD_HYSTERESIS))
+				lod--;
+			while(lod+1 < chain.count && size < chain.minSize[lod] * (1.0f - LOD_HYSTERESIS))
+				lod++;
 		}
-		glEndList();
+		else
+		{
+			lod = 0;
+		}
+
+		obj.lod[pass] = (BYTE)lod;
+
+		if(pass == SHADOW_PASS)
+		{
+			triangles += chain.shadowMeshes[lod]->GetTriangleCount();
+			bytes += chain.shadowMeshes[lod]->GetPositionBytes();
+		}
+		else
+		{
+			triangles += chain.meshes[lod]->GetTriangleCount();
+			bytes += chain.meshes[lod]->GetVertexBytes();
+		}
+	}
+
+	if(vertexBytes) *vertexBytes = bytes;
+	return triangles;
+}
+
+///----------------------------------------------------------------------------
+///Exchanges the level of a pass of the given objects with levels kept
+///elsewhere. A view with its own level state (a spot light's tile) swaps
+///its levels in, selects and draws, and swaps them out again, leaving the
+///levels the pass keeps for its own view untouched.
+///@param	pass - pass whose levels are exchanged
+///@param	objects - indices of the objects
+///@param	levels - level of every object in the scene (resized if needed)
+///----------------------------------------------------------------------------
+void Geometry::SwapLOD(RenderPass pass, const std::vector<UINT> &objects, std::vector<BYTE> &levels)
+{
+	if(levels.size() != m_Objects.size()) levels.resize(m_Objects.size(), 0);
+
+	for(UINT i=0; i<objects.size(); i++)
+		std::swap(m_Objects[objects[i]].lod[pass], levels[objects[i]]);
+}
+
+///----------------------------------------------------------------------------
+///Draw the given objects
+///@param	objects - indices of the objects to draw (i.e. the culling result)
+///@param	pass - selects the level of detail to draw
+///----------------------------------------------------------------------------
+void Geometry::Draw(const std::vector<UINT> &objects, RenderPass pass) const
+{
+	CommandBuffer buffer;
+	if(!objects.empty()) Record(&objects[0], (UINT)objects.size(), pass, buffer);
+	Execute(&buffer, 1, pass);
+}
+
+///----------------------------------------------------------------------------
+///Draw a single object
+///@param	object - index of the object
+///@param	pass - selects the level of detail to draw
+///----------------------------------------------------------------------------
+void Geometry::DrawObject(UINT object, RenderPass pass) const
+{
+	CommandBuffer buffer;
+	RecordObject(object, pass, buffer);
+	Execute(&buffer, 1, pass);
+}
+
+///----------------------------------------------------------------------------
+///Records the draws of a range of objects at their current level of detail.
+///Nothing is sent to OpenGL, so different ranges and passes can be recorded
+///on different threads (the levels must have been selected already).
+///@param	objects - indices of the objects (i.e. a chunk of the culling result)
+///@param	count - number of objects
+///@param	pass - selects the level of detail and the vertex stream
+///@param	buffer - receives the commands
+///----------------------------------------------------------------------------
+void Geometry::Record(const UINT *objects, UINT count, RenderPass pass,
+					  CommandBuffer &buffer) const
+{
+	for(UINT i=0; i<count; i++)
+		RecordObject(objects[i], pass, buffer);
+}
+
+///----------------------------------------------------------------------------
+///Records the draw of a single object. The sort key groups the draws by
+///shader and mesh (shape and level) and orders each group by the distance
+///from the eye of the pass.
+///@param	object - index of the object
+///@param	pass - selects the level of detail and the vertex stream
+///@param	buffer - receives the command
+///----------------------------------------------------------------------------
+void Geometry::RecordObject(UINT object, RenderPass pass, CommandBuffer &buffer) const
+{
+	const SceneObject &obj = m_Objects[object];
+	const LODChain &chain = m_Shapes[obj.shape];
+	UINT lod = obj.lod[pass];
+
+	const GLfloat *eye = pass == SHADOW_PASS ? m_Light : m_Camera;
+	GLfloat c[3], depth = 0.0f;
+	m_Bounds[object].GetCenter(c);
+	for(int k=0; k<3; k++)
+		depth += (c[k] - eye[k]) * (c[k] - eye[k]);
+
+	UINT shader = pass == CAMERA_PASS && m_VertexFormat != Mesh::FLOAT_VERTEX ? 1 : 0;
+	UINT64 key = DrawQueue::MakeKey(pass, shader, obj.shape * LODChain::MAX_LODS + lod,
+									depth, obj.color);
+
+	if(pass == SHADOW_PASS)
+		buffer.DrawPositions(key, chain.shadowMeshes[lod], obj.world.m);
+	else
+		buffer.DrawMesh(key, chain.meshes[lod], obj.world.m, obj.color);
+}
+
+///----------------------------------------------------------------------------
+///Replays recorded buffers in order, from the thread owning the context
+///@param	buffers - the buffers of the pass
+///@param	count - number of buffers
+///@param	pass - the pass the buffers were recorded for
+///@param	stats - counters added to (may be NULL)
+///----------------------------------------------------------------------------
+void Geometry::Execute(const CommandBuffer *buffers, UINT count, RenderPass pass,
+					   DrawStats *stats) const
+{
+	ExecuteState state;
+	memset(&state, 0, sizeof(state));
+
+	BeginPass(pass);
+
+	for(UINT i=0; i<count; i++)
+	{
+		for(UINT j=0; j<buffers[i].GetCount(); j++)
+			ExecuteCommand(buffers[i].GetCommand(j), state);
+	}
+
+	EndPass(pass);
+
+	if(stats)
+	{
+		stats->draws += state.stats.draws;
+		stats->meshChanges += state.stats.meshChanges;
+		stats->colorChanges += state.stats.colorChanges;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Replays the sorted draws of a pass, consecutive draws of the same mesh
+///bind its streams once
+///@param	queue - the sorted draws of the pass
+///@param	pass - the pass the draws were recorded for
+///@param	stats - counters added to (may be NULL)
+///----------------------------------------------------------------------------
+void Geometry::Execute(const DrawQueue &queue, RenderPass pass, DrawStats *stats) const
+{
+	ExecuteState state;
+	memset(&state, 0, sizeof(state));
+
+	BeginPass(pass);
+
+	for(UINT i=0; i<queue.GetCount(); i++)
+		ExecuteCommand(queue.GetCommand(i), state);
+
+	EndPass(pass);
+
+	if(stats)
+	{
+		stats->draws += state.stats.draws;
+		stats->meshChanges += state.stats.meshChanges;
+		stats->colorChanges += state.stats.colorChanges;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Enables the vertex arrays of a pass and binds the decoding shader when
+///the camera pass vertices are quantized
+///@param	pass - the pass about to be drawn
+///----------------------------------------------------------------------------
+void Geometry::BeginPass(RenderPass pass) const
+{
+	//the camera passes of a cube shadow map compare in a fragment shader
+	bool point = pass == CAMERA_PASS && m_PointShadowMap;
+
+	//the shadow pass only writes depth, it reads the position-only streams
+	if(pass == SHADOW_PASS || m_VertexFormat == Mesh::FLOAT_VERTEX)
+	{
+		if(point) BindPointShader(m_PointShadowShader);
+		Mesh::BeginDraw(pass == SHADOW_PASS, NULL);
+		return;
+	}
+
+	const Shader &shader = point ? m_QuantizedPointShader : m_QuantizedShader;
+	if(point)
+		BindPointShader(shader);
+	else
+		shader.Bind();
+
+	glUniform1i(shader.GetUniform("lightEnabled"), g_GLState.IsEnabled(GL_LIGHT0));
+	Mesh::BeginDraw(false, GetShaderParams());
+}
+
+///----------------------------------------------------------------------------
+///Disables what BeginPass enabled
+///@param	pass - the pass just drawn
+///----------------------------------------------------------------------------
+void Geometry::EndPass(RenderPass pass) const
+{
+	if(pass == SHADOW_PASS || m_VertexFormat == Mesh::FLOAT_VERTEX)
+	{
+		Mesh::EndDraw(pass == SHADOW_PASS, NULL);
+		if(pass == CAMERA_PASS && m_PointShadowMap) Shader::Unbind();
+		return;
 	}
 
-	//draw objects
-	glCallList(BaseList);
-	glCallList(TorusList);
-	glCallList(ConeList);
+	Mesh::EndDraw(false, GetShaderParams());
+	Shader::Unbind();
+}
+
+///----------------------------------------------------------------------------
+///Binds one of the cube shadow map programs and sets what the comparison
+///needs
+///@param	shader - m_PointShadowShader or m_QuantizedPointShader
+///----------------------------------------------------------------------------
+void Geometry::BindPointShader(const Shader &shader) const
+{
+	shader.Bind();
+	glUniform1i(shader.GetUniform("shadowMap"), 0);
+	glUniform3fv(shader.GetUniform("lightPosition"), 1, m_PointLight);
+	glUniform2fv(shader.GetUniform("depthRange"), 1, m_PointDepthRange);
+	glUniform1i(shader.GetUniform("shadowed"), m_PointShadowTest == SHADOW_TEST_SHADOWED);
+}
+
+///----------------------------------------------------------------------------
+///@returns the attribute and uniform locations of the program decoding the
+///			camera pass vertices (NULL for float vertices)
+///----------------------------------------------------------------------------
+const Mesh::ShaderParams* Geometry::GetShaderParams() const
+{
+	if(m_VertexFormat == Mesh::FLOAT_VERTEX) return NULL;
+	return m_PointShadowMap ? &m_PointShaderParams : &m_ShaderParams;
+}
+
+///----------------------------------------------------------------------------
+///Sends a recorded command to OpenGL, the vertex arrays must have been
+///enabled already. The mesh and the color are only set when they differ
+///from the previous command's.
+///@param	command - the command
+///@param	state - state left by the previous command
+///----------------------------------------------------------------------------
+void Geometry::ExecuteCommand(const CommandBuffer::Command &command, ExecuteState &state) const
+{
+	switch(command.type)
+	{
+	case CommandBuffer::DRAW_POSITIONS:
+		if(command.mesh != state.mesh)
+		{
+			state.mesh = command.mesh;
+			state.bound = command.mesh->BindPositions();
+			state.stats.meshChanges++;
+		}
+		if(!state.bound) break;
+
+		glPushMatrix();
+		glMultMatrixf(command.world);
+		command.mesh->DrawPositionElements();
+		glPopMatrix();
+		state.stats.draws++;
+		break;
+
+	case CommandBuffer::DRAW_MESH:
+		if(command.mesh != state.mesh)
+		{
+			state.mesh = command.mesh;
+			state.bound = command.mesh->Bind(GetShaderParams());
+			state.stats.meshChanges++;
+		}
+		if(!state.bound) break;
+
+		if(!state.colorSet || memcmp(state.color, command.color, sizeof(state.color)) != 0)
+		{
+			memcpy(state.color, command.color, sizeof(state.color));
+			state.colorSet = true;
+			glColor4ubv(command.color);
+			state.stats.colorChanges++;
+		}
+
+		glPushMatrix();
+		glMultMatrixf(command.world);
+		command.mesh->DrawElements();
+		glPopMatrix();
+		state.stats.draws++;
+		break;
 
-	//animate and draw spheres
-	glPushMatrix();
-	glRotatef(angle, 0.0, 1.0, 0.0);
-	glCallList(SphereList);
-	glPopMatrix();
+	case CommandBuffer::BEGIN_CONDITIONAL:
+		glBeginConditionalRenderNV(command.query, GL_QUERY_NO_WAIT_NV);
+		break;
 
+	case CommandBuffer::END_CONDITIONAL:
+		glEndConditionalRenderNV();
+		break;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Casts a ray against the object bounds in the scene
+///@param	origin - ray origin
+///@param	dir - ray direction
+///@param	maxT - maximum distance along dir
+///@param	object - returned index of the closest object hit
+///@param	t - returned hit distance
+///@returns true if an object was hit
+///----------------------------------------------------------------------------
+bool Geometry::Raycast(const GLfloat origin[3], const GLfloat dir[3], GLfloat maxT,
+					   UINT *object, GLfloat *t) const
+{
+	if(m_Bounds.empty()) return false;
+
+	return m_BVH.Raycast(origin, dir, maxT, &m_Bounds[0], object, t);
 }
 
 ///----------------------------------------------------------------------------
@@ -134,9 +1046,13 @@ void Geometry::SetLights(GLfloat pos[])
 	//define the light position
 	glLightfv(GL_LIGHT0, GL_POSITION, pos);
 
+	m_Light[0] = pos[0];
+	m_Light[1] = pos[1];
+	m_Light[2] = pos[2];
+
 	//enable lighting and light0
-	glEnable(GL_LIGHTING);
-	glEnable(GL_LIGHT0);
+	g_GLState.Enable(GL_LIGHTING);
+	g_GLState.Enable(GL_LIGHT0);
 }
 
 ///----------------------------------------------------------------------------
@@ -150,7 +1066,7 @@ void Geometry::SetMaterials()
 	glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
 
 	//enable color material state
-	glEnable(GL_COLOR_MATERIAL);
+	g_GLState.Enable(GL_COLOR_MATERIAL);
 
 	//enable specular lighting
 	glMaterialfv(GL_FRONT, GL_SPECULAR, white);
@@ -191,39 +1107,39 @@ void Geometry::GetLightPosition(GLfloat *pos) const
 }
 
 ///----------------------------------------------------------------------------
-///Set textures for shadow maps
+///Set the sampling state of the shadow maps. The shadow map textures belong
+///to the render graph (they are transient), BindShadowMap sets the state
+///that belongs to the texture object.
 ///----------------------------------------------------------------------------
 void Geometry::SetShadowTexture()
 {
-	//generate the texture name
-	glGenTextures(1, &m_DepthMap);
-
-	//the first time we call this function initializes the 2D texture 
-	//object with NULL texture image
-	glBindTexture(GL_TEXTURE_2D, m_DepthMap);
-
-	//specify the 2D texture image
-	glTexImage2D(GL_TEXTURE_2D,			//target must be GL_TEXTURE_2D
-				 0,						//LOD number
-				 GL_DEPTH_COMPONENT,	//number of color components
-				 DEPTH_MAP_WIDTH,		//width
-				 DEPTH_MAP_HEIGHT,		//height
-				 0,						//border
-				 GL_DEPTH_COMPONENT,	//format of pixel data
-				 GL_UNSIGNED_BYTE,		//type of pixel data
-				 NULL);					//pointer to image data in memory
-
-	//set texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	//the comparison state of both camera passes never changes, keep each
+	//one in its own sampler so switching tests is a bind and the texture
+	//object isn't modified (and validated again) twice a frame
+	if(m_ShadowSamplersEnabled && g_GLCaps.samplerObjects)
+	{
+		//depth comparison should be true (i.e. lit) if r<texture, the
+		//other test is the contrary (i.e. shadow if r>=texture)
+		const GLint compareFunc[SHADOW_TEST_COUNT] = {GL_LESS, GL_GEQUAL};
+
+		glGenSamplers(SHADOW_TEST_COUNT, m_ShadowSamplers);
+		for(UINT i=0; i<SHADOW_TEST_COUNT; i++)
+		{
+			GLuint sampler = m_ShadowSamplers[i];
+			glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP);
+			glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP);
+			glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE_ARB, GL_COMPARE_R_TO_TEXTURE);
+			glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC_ARB, compareFunc[i]);
+		}
+	}
 
 	//enable needed states
-	glEnable(GL_TEXTURE_GEN_S);
-    glEnable(GL_TEXTURE_GEN_T);
-    glEnable(GL_TEXTURE_GEN_R);
-    glEnable(GL_TEXTURE_GEN_Q);
+	g_GLState.Enable(GL_TEXTURE_GEN_S);
+    g_GLState.Enable(GL_TEXTURE_GEN_T);
+    g_GLState.Enable(GL_TEXTURE_GEN_R);
+    g_GLState.Enable(GL_TEXTURE_GEN_Q);
 
 	glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
     glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
@@ -232,12 +1148,119 @@ void Geometry::SetShadowTexture()
 }
 
 ///----------------------------------------------------------------------------
-///GetShadowTextObj()
-///@returns the current shadow texture objectID
+///Deletes the samplers of the shadow maps (call while the rendering
+///context is still current)
+///----------------------------------------------------------------------------
+void Geometry::ReleaseShadowTexture()
+{
+	if(m_ShadowSamplers[0])
+	{
+		for(UINT i=0; i<SHADOW_TEST_COUNT; i++)
+			g_GLState.DeleteSampler(m_ShadowSamplers[i]);
+
+		glDeleteSamplers(SHADOW_TEST_COUNT, m_ShadowSamplers);
+		memset(m_ShadowSamplers, 0, sizeof(m_ShadowSamplers));
+	}
+}
+
+///----------------------------------------------------------------------------
+///Binds the shadow map for one of the camera passes
+///@param	texture - the shadow map (other passes may share the texture,
+///			so the state of the texture object is set every time; the state
+///			cache filters it when nothing else changed it)
+///@param	test - which depth comparison the pass needs
+///----------------------------------------------------------------------------
+void Geometry::BindShadowMap(GLuint texture, ShadowTest test)
+{
+	m_PointShadowMap = 0;
+
+	g_GLState.BindTexture(GL_TEXTURE_2D, texture);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+	//Tell OpenGL what to do with the boolean result. This one belongs to
+	//the texture object, not to the sampler
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE_ARB, GL_ALPHA);
+
+	if(m_ShadowSamplers[test])
+	{
+		g_GLState.BindSampler(m_ShadowSamplers[test]);
+		return;
+	}
+
+	//no sampler objects, set the comparison on the texture itself
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE_ARB, GL_COMPARE_R_TO_TEXTURE);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC_ARB,
+							test == SHADOW_TEST_LIT ? GL_LESS : GL_GEQUAL);
+}
+
+///----------------------------------------------------------------------------
+///Creates the programs the camera passes use with a cube shadow map (once):
+///the comparison alone, and after the decoding of the quantized vertices
+///when these can be drawn
+///@returns false if they can't be used (no GLSL 1.30 or a compile error)
+///----------------------------------------------------------------------------
+bool Geometry::CreatePointShadowShader()
+{
+	if(m_PointShadowShader.IsValid()) return true;
+	if(!g_GLCaps.glsl || !m_PointShadowShader.Create(NULL, PointShadowFragmentShader)) return false;
+
+	if(!m_QuantizedShader.IsValid()) return true;
+
+	if(!m_QuantizedPointShader.Create(QuantizedVertexShader, PointShadowFragmentShader))
+	{
+		m_PointShadowShader.Release();
+		return false;
+	}
+
+	m_PointShaderParams.normal			= m_QuantizedPointShader.GetAttribute("octNormal");
+	m_PointShaderParams.positionScale	= m_QuantizedPointShader.GetUniform("positionScale");
+	m_PointShaderParams.positionOffset	= m_QuantizedPointShader.GetUniform("positionOffset");
+	m_PointShaderParams.normalScale		= m_QuantizedPointShader.GetUniform("normalScale");
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Binds a depth cube map for one of the camera passes instead of the 2D
+///shadow map (until the next BindShadowMap). The comparison state belongs
+///to the cube map, so no sampler object may override it.
+///@param	texture - depth cube map drawn from the light
+///@param	test - which fragments the pass draws
+///@param	light - position the cube map was drawn from
+///@param	zNear, zFar - depth range of the cube faces
+///----------------------------------------------------------------------------
+void Geometry::BindPointShadowMap(GLuint texture, ShadowTest test, const GLfloat light[3],
+								  GLfloat zNear, GLfloat zFar)
+{
+	if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+	g_GLState.BindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+	m_PointShadowMap = texture;
+	m_PointShadowTest = test;
+	memcpy(m_PointLight, light, sizeof(m_PointLight));
+	m_PointDepthRange[0] = zNear;
+	m_PointDepthRange[1] = zFar;
+}
+
+///----------------------------------------------------------------------------
+///Chooses whether the comparison state is kept in sampler objects (takes
+///effect on the next SetShadowTexture)
+///@param	enabled - true to use them when the context supports them
 ///----------------------------------------------------------------------------
-GLuint Geometry::GetShadowTexObj() const
+void Geometry::SetShadowSamplersEnabled(bool enabled)
 {
-	return m_DepthMap;
+	m_ShadowSamplersEnabled = enabled;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the shadow map is sampled through sampler objects
+///----------------------------------------------------------------------------
+bool Geometry::AreShadowSamplersUsed() const
+{
+	return m_ShadowSamplers[0] != 0;
 }
 
 ///----------------------------------------------------------------------------
@@ -256,3 +1279,318 @@ void Geometry::Transpose4x4Matrix(GLdouble M[16])
 		Swap(M[11], M[14]);
 	#undef Swap
 }
+
+///----------------------------------------------------------------------------
+///@returns the number of objects in the scene
+///----------------------------------------------------------------------------
+UINT Geometry::GetObjectCount() const
+{
+	return (UINT)m_Objects.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of animated objects in the scene
+///----------------------------------------------------------------------------
+UINT Geometry::GetAnimatedCount() const
+{
+	return (UINT)m_Animated.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the current world space bounds of an object
+///----------------------------------------------------------------------------
+const AABB& Geometry::GetBounds(UINT object) const
+{
+	return m_Bounds[object];
+}
+
+///----------------------------------------------------------------------------
+///Gets the box used to rasterize an object as an occluder
+///@param	object - object index
+///@param	world - returned object transform
+///@param	box - returned object space box, inside the shape
+///@returns false if the object can't be used as an occluder
+///----------------------------------------------------------------------------
+bool Geometry::GetOccluder(UINT object, Matrix4 &world, AABB &box) const
+{
+	const SceneObject &obj = m_Objects[object];
+	if(!obj.occluder) return false;
+
+	world = obj.world;
+	box = obj.occluderBounds;
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns the scene bounding volume hierarchy
+///----------------------------------------------------------------------------
+const BVH& Geometry::GetBVH() const
+{
+	return m_BVH;
+}
+
+///----------------------------------------------------------------------------
+///Enables or disables the level of detail selection
+///@param	enabled - false to always draw the finest level
+///----------------------------------------------------------------------------
+void Geometry::SetLODEnabled(bool enabled)
+{
+	m_LODEnabled = enabled;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the level of detail is selected by projected size
+///----------------------------------------------------------------------------
+bool Geometry::IsLODEnabled() const
+{
+	return m_LODEnabled;
+}
+
+///----------------------------------------------------------------------------
+///Selects the format of the position-only streams, call before CreateScene
+///@param	quantized - true for 16 bit positions instead of floats
+///----------------------------------------------------------------------------
+void Geometry::SetShadowPositionsQuantized(bool quantized)
+{
+	m_QuantizeShadow = quantized;
+}
+
+///----------------------------------------------------------------------------
+///Enables the vertex cache, overdraw and vertex fetch optimization of the
+///meshes, call before CreateScene
+///@param	enabled - false to draw the meshes in the generated order
+///----------------------------------------------------------------------------
+void Geometry::SetMeshOptimization(bool enabled)
+{
+	m_OptimizeMeshes = enabled;
+}
+
+///----------------------------------------------------------------------------
+///Selects the format of the camera pass vertices, call before CreateScene.
+///Quantized formats fall back to floats without GLSL support.
+///@param	format - the vertex format
+///----------------------------------------------------------------------------
+void Geometry::SetVertexFormat(Mesh::VertexFormat format)
+{
+	m_VertexFormat = format;
+}
+
+///----------------------------------------------------------------------------
+///@returns the format of the camera pass vertices
+///----------------------------------------------------------------------------
+Mesh::VertexFormat Geometry::GetVertexFormat() const
+{
+	return m_VertexFormat;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the vertex and index streams of every mesh
+///----------------------------------------------------------------------------
+UINT Geometry::GetMeshBytes() const
+{
+	UINT bytes = 0;
+	for(UINT i=0; i<m_Meshes.size(); i++)
+	{
+		bytes += m_Meshes[i]->GetVertexBytes() + m_Meshes[i]->GetPositionBytes() +
+				 m_Meshes[i]->GetIndexBytes();
+	}
+
+	return bytes;
+}
+
+///----------------------------------------------------------------------------
+///@returns an object instance
+///----------------------------------------------------------------------------
+const SceneObject& Geometry::GetSceneObject(UINT object) const
+{
+	return m_Objects[object];
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of shapes
+///----------------------------------------------------------------------------
+UINT Geometry::GetShapeCount() const
+{
+	return (UINT)m_Shapes.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the levels of detail of a shape
+///----------------------------------------------------------------------------
+const LODChain& Geometry::GetShape(UINT shape) const
+{
+	return m_Shapes[shape];
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of meshes (every level of detail and shadow proxy)
+///----------------------------------------------------------------------------
+UINT Geometry::GetMeshCount() const
+{
+	return (UINT)m_Meshes.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns one of the meshes
+///----------------------------------------------------------------------------
+const Mesh* Geometry::GetMesh(UINT index) const
+{
+	return m_Meshes[index];
+}
+
+///----------------------------------------------------------------------------
+///Writes the size and the vertex cache/overdraw metrics of every mesh,
+///before and after the optimization
+///@param	file - output file
+///----------------------------------------------------------------------------
+void Geometry::WriteMeshReport(FILE *file) const
+{
+	fprintf(file, "%-20s %7s %7s %15s %15s %15s\n", "Mesh", "Tris", "Verts",
+			"ACMR", "ATVR", "Overdraw");
+	fprintf(file, "------------------------------------------------------------------------------\n");
+
+	for(UINT s=0; s<m_Shapes.size(); s++)
+	{
+		const LODChain &chain = m_Shapes[s];
+
+		for(UINT i=0; i<chain.count; i++)
+		{
+			for(int proxy=0; proxy<2; proxy++)
+			{
+				const Mesh *mesh = proxy ? chain.shadowMeshes[i] : chain.meshes[i];
+				if(proxy && mesh == chain.meshes[i]) continue;
+
+				const Mesh::Stats &a = mesh->GetOriginalStats();
+				const Mesh::Stats &b = mesh->GetStats();
+				char name[32];
+				GetMeshName(s, i, proxy != 0, name);
+
+				fprintf(file, "%-20s %7u %7u %6.3f->%6.3f %6.3f->%6.3f %6.3f->%6.3f\n",
+						name, mesh->GetTriangleCount(), mesh->GetVertexCount(),
+						a.acmr, b.acmr, a.atvr, b.atvr, a.overdraw, b.overdraw);
+			}
+		}
+	}
+
+	fprintf(file, "\nACMR/ATVR on a %u entry FIFO cache, overdraw from the six axis views\n",
+			MeshOptimizer::CACHE_SIZE);
+
+	//memory of the streams in the current format against full floats
+	static LPCSTR FormatNames[Mesh::FORMAT_COUNT] = {"float", "quantized 8", "quantized 16"};
+	UINT total = 0, floatTotal = 0;
+
+	fprintf(file, "\nMesh memory (%s vertices)\n", FormatNames[m_VertexFormat]);
+	fprintf(file, "%-20s %10s %10s %10s %10s %10s\n", "Mesh", "Vertices", "Positions",
+			"Indices", "Total", "Float");
+	fprintf(file, "------------------------------------------------------------------------------\n");
+
+	for(UINT s=0; s<m_Shapes.size(); s++)
+	{
+		const LODChain &chain = m_Shapes[s];
+
+		for(UINT i=0; i<chain.count; i++)
+		{
+			for(int proxy=0; proxy<2; proxy++)
+			{
+				const Mesh *mesh = proxy ? chain.shadowMeshes[i] : chain.meshes[i];
+				if(proxy && mesh == chain.meshes[i]) continue;
+
+				char name[32];
+				GetMeshName(s, i, proxy != 0, name);
+
+				UINT bytes = mesh->GetVertexBytes() + mesh->GetPositionBytes() + mesh->GetIndexBytes();
+				UINT floatBytes = mesh->GetVertexCount() * 9 * sizeof(GLfloat) +
+								  mesh->GetTriangleCount() * 3 * sizeof(GLuint);
+				total += bytes;
+				floatTotal += floatBytes;
+
+				fprintf(file, "%-20s %10u %10u %10u %10u %10u\n", name, mesh->GetVertexBytes(),
+						mesh->GetPositionBytes(), mesh->GetIndexBytes(), bytes, floatBytes);
+			}
+		}
+	}
+
+	fprintf(file, "%-20s %10s %10s %10s %10u %10u\n", "Total", "", "", "", total, floatTotal);
+}
+
+///----------------------------------------------------------------------------
+///Measures the camera pass vertex throughput of every vertex format by
+///drawing the finest level of each shape many times with the current
+///matrices and states. The meshes are uploaded again in each format and
+///restored to the selected one afterwards.
+///@param	file - output file
+///----------------------------------------------------------------------------
+void Geometry::BenchmarkFormats(FILE *file)
+{
+	static LPCSTR FormatNames[Mesh::FORMAT_COUNT] = {"float", "quantized 8", "quantized 16"};
+	static const UINT Repeats = 200;
+	Mesh::VertexFormat selected = m_VertexFormat;
+
+	fprintf(file, "\n%-20s %10s %12s %12s\n", "Vertex format", "KB", "ms", "Mtris/s");
+	fprintf(file, "------------------------------------------------------------------------------\n");
+
+	for(int f=0; f<Mesh::FORMAT_COUNT; f++)
+	{
+		m_VertexFormat = (Mesh::VertexFormat)f;
+		if(m_SceneLoaded || (m_VertexFormat != Mesh::FLOAT_VERTEX && !m_QuantizedShader.IsValid()))
+		{
+			fprintf(file, "%-20s %10s\n", FormatNames[f], "n/a");
+			continue;
+		}
+
+		UploadMeshes(m_VertexFormat);
+
+		//one untimed pass so the driver has the buffers in video memory
+		UINT triangles = 0, bytes = 0;
+		glFinish();
+		double start = 0.0;
+		for(UINT r=0; r<=Repeats; r++)
+		{
+			if(r == 1)
+			{
+				glFinish();
+				start = Profiler::GetTime();
+			}
+
+			BeginPass(CAMERA_PASS);
+			for(UINT s=0; s<m_Shapes.size(); s++)
+			{
+				const Mesh *mesh = m_Shapes[s].meshes[0];
+				glColor4ub(255, 255, 255, 255);
+				mesh->Draw(GetShaderParams());
+
+				if(r == 0)
+				{
+					triangles += mesh->GetTriangleCount();
+					bytes += mesh->GetVertexBytes() + mesh->GetIndexBytes();
+				}
+			}
+			EndPass(CAMERA_PASS);
+		}
+		glFinish();
+		double elapsed = Profiler::GetTime() - start;
+
+		fprintf(file, "%-20s %10.1f %12.3f %12.2f\n", FormatNames[f], bytes / 1024.0, elapsed,
+				elapsed > 0.0 ? (double)triangles * Repeats / (elapsed * 1000.0) : 0.0);
+	}
+
+	m_VertexFormat = selected;
+	if(!m_SceneLoaded) UploadMeshes(m_VertexFormat);
+}
+
+///----------------------------------------------------------------------------
+///Builds the name of a mesh for the reports
+///@param	shape - shape index
+///@param	lod - level of detail
+///@param	proxy - true for the shadow proxy of the level
+///@param	name - returned name
+///----------------------------------------------------------------------------
+void Geometry::GetMeshName(UINT shape, UINT lod, bool proxy, char name[32]) const
+{
+	static LPCSTR Names[SHAPE_COUNT] = {"Cube", "Torus", "Sphere", "Cone"};
+
+	if(shape < SHAPE_COUNT)
+		sprintf(name, "%s LOD%u%s", Names[shape], lod, proxy ? " shadow" : "");
+	else
+		sprintf(name, "Shape%u LOD%u%s", shape, lod, proxy ? " shadow" : "");
+}
@@ -11,45 +11,226 @@
 
 #include <windows.h>
 #include <math.h>
+#include <vector>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <GL/glut.h>
 #include <GL/glext.h>
+#include <stdio.h>
+#include "Matrix4.h"
+#include "Culling.h"
+#include "BVH.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "SceneFile.h"
+#include "CommandBuffer.h"
+#include "DrawQueue.h"
+
+///----------------------------------------------------------------------------
+///Passes which select their own level of detail
+///----------------------------------------------------------------------------
+enum RenderPass
+{
+	CAMERA_PASS = 0,	///> Lit and shadowed camera passes
+	SHADOW_PASS,		///> Depth only pass from the light
+	PASS_COUNT
+};
+
+///----------------------------------------------------------------------------
+///Meshes of a shape from the finest to the coarsest tessellation
+///----------------------------------------------------------------------------
+struct LODChain
+{
+	static const UINT MAX_LODS = 3;	///> Max levels per shape
+
+	Mesh*	meshes[MAX_LODS];		///> Mesh of each level
+	Mesh*	shadowMeshes[MAX_LODS];	///> Shadow proxy of each level (or the mesh)
+	GLfloat	minSize[MAX_LODS];		///> Smallest projected size (pixels) of each level
+	UINT	count;					///> Number of levels
+};
+
+///----------------------------------------------------------------------------
+///Counters of a replayed pass
+///----------------------------------------------------------------------------
+struct DrawStats
+{
+	UINT	draws;			///> Meshes drawn
+	UINT	meshChanges;	///> Vertex streams bound
+	UINT	colorChanges;	///> Colors set
+};
+
+///----------------------------------------------------------------------------
+///An object instance in the scene
+///----------------------------------------------------------------------------
+struct SceneObject
+{
+	UINT	shape;			///> Index of the object's shape
+	BYTE	lod[PASS_COUNT];///> Current level of detail in each pass
+	GLubyte	color[4];		///> Object color (RGBA8)
+	Matrix4	local;			///> Transform before animation
+	Matrix4	world;			///> Current world transform
+	AABB	localBounds;	///> Bounds of the shape in object space
+	AABB	occluderBounds;	///> Box inside the shape (valid if occluder)
+	bool	occluder;		///> Can be used as a software occluder
+	bool	animated;		///> Rotates around the Y axis every frame
+};
 
 class Geometry
 {
 public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum ShadowTest
+	{
+		SHADOW_TEST_LIT = 0,	///> Comparison passes where r < depth (lit)
+		SHADOW_TEST_SHADOWED,	///> Comparison passes where r >= depth (shadow)
+		SHADOW_TEST_COUNT
+	};
+
 	//-------------------------------------------------------------------------
 	//Constructors and destructors
 	//-------------------------------------------------------------------------
 	Geometry();
+	virtual ~Geometry();
 
 	//-------------------------------------------------------------------------
 	//Public methods
 	//-------------------------------------------------------------------------
-	void Draw(GLfloat angle);
+	void CreateScene(UINT extraObjects);
+	bool LoadScene(LPCSTR path);
+	bool SaveScene(LPCSTR path) const;
+	void PrepareMesh(Mesh &mesh) const;
+	void AddMesh(Mesh *mesh, const GLfloat position[3], GLfloat size,
+				 GLfloat r, GLfloat g, GLfloat b);
+	void Release();
+	void BuildBVH();
+	void Animate(GLfloat angle);
+	void Animate(GLfloat angle, UINT first, UINT count);
+	void RefitBVH();
+	void Cull(const Frustum &frustum, std::vector<UINT> &visible) const;
+	UINT SelectLOD(RenderPass pass, const std::vector<UINT> &objects,
+				   const GLfloat eye[3], GLfloat pixelsPerUnit, UINT *vertexBytes = NULL);
+	UINT SelectLOD(RenderPass pass, const UINT *objects, UINT count,
+				   const GLfloat eye[3], GLfloat pixelsPerUnit, UINT *vertexBytes = NULL);
+	void SwapLOD(RenderPass pass, const std::vector<UINT> &objects, std::vector<BYTE> &levels);
+	void Draw(const std::vector<UINT> &objects, RenderPass pass) const;
+	void DrawObject(UINT object, RenderPass pass) const;
+	void Record(const UINT *objects, UINT count, RenderPass pass, CommandBuffer &buffer) const;
+	void RecordObject(UINT object, RenderPass pass, CommandBuffer &buffer) const;
+	void Execute(const CommandBuffer *buffers, UINT count, RenderPass pass,
+				 DrawStats *stats = NULL) const;
+	void Execute(const DrawQueue &queue, RenderPass pass, DrawStats *stats = NULL) const;
+	bool Raycast(const GLfloat origin[3], const GLfloat dir[3], GLfloat maxT,
+				 UINT *object, GLfloat *t) const;
 	void SetLights(GLfloat pos[]);
 	void SetCameraPosition(GLfloat pos[]);
 	void SetMaterials();
 	void SetShadowTexture();
+	void ReleaseShadowTexture();
+	void BindShadowMap(GLuint texture, ShadowTest test);
+	bool CreatePointShadowShader();
+	void BindPointShadowMap(GLuint texture, ShadowTest test, const GLfloat light[3],
+							GLfloat zNear, GLfloat zFar);
 	void GetCameraPosition(GLfloat *pos) const;
 	void GetLightPosition(GLfloat *pos) const;
 	void Transpose4x4Matrix(GLdouble M[]);
-	GLuint GetShadowTexObj() const;
+	UINT GetObjectCount() const;
+	const SceneObject& GetSceneObject(UINT object) const;
+	UINT GetShapeCount() const;
+	const LODChain& GetShape(UINT shape) const;
+	UINT GetAnimatedCount() const;
+	const AABB& GetBounds(UINT object) const;
+	bool GetOccluder(UINT object, Matrix4 &world, AABB &box) const;
+	const BVH& GetBVH() const;
+	void SetLODEnabled(bool enabled);
+	bool IsLODEnabled() const;
+	void SetShadowPositionsQuantized(bool quantized);
+	void SetShadowSamplersEnabled(bool enabled);
+	bool AreShadowSamplersUsed() const;
+	void SetMeshOptimization(bool enabled);
+	void SetVertexFormat(Mesh::VertexFormat format);
+	Mesh::VertexFormat GetVertexFormat() const;
+	UINT GetMeshBytes() const;
+	UINT GetMeshCount() const;
+	const Mesh* GetMesh(UINT index) const;
+	void WriteMeshReport(FILE *file) const;
+	void BenchmarkFormats(FILE *file);
 
 	//-------------------------------------------------------------------------
 	//Public members
 	//-------------------------------------------------------------------------
-	static const GLuint DEPTH_MAP_WIDTH  = 512;	///> Depth map width
-	static const GLuint DEPTH_MAP_HEIGHT = 512;	///> Depth map height
+	static const GLfloat LOD_HYSTERESIS;	///> Size margin before switching levels
 
 private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	enum Shape
+	{
+		CUBE = 0,
+		TORUS,
+		SPHERE,
+		CONE,
+		SHAPE_COUNT
+	};
+
+	///State left by the previous command of a replay
+	struct ExecuteState
+	{
+		const Mesh*	mesh;		///> Mesh whose streams are bound
+		bool		bound;		///> The mesh has something to draw
+		GLubyte		color[4];	///> Current color
+		bool		colorSet;	///> color is valid
+		DrawStats	stats;		///> Counters of the replay
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	Mesh* NewMesh();
+	void AddLOD(UINT shape, Mesh *mesh, GLfloat minSize, Mesh *shadowProxy = NULL);
+	bool CreateShader();
+	void GetMeshName(UINT shape, UINT lod, bool proxy, char name[32]) const;
+	void BeginPass(RenderPass pass) const;
+	void EndPass(RenderPass pass) const;
+	void BindPointShader(const Shader &shader) const;
+	const Mesh::ShaderParams* GetShaderParams() const;
+	void ExecuteCommand(const CommandBuffer::Command &command, ExecuteState &state) const;
+	void UploadMeshes(Mesh::VertexFormat format);
+	void AddObject(UINT shape, const AABB &bounds, const Matrix4 &M,
+				   GLfloat r, GLfloat g, GLfloat b, bool animated,
+				   const AABB *occluder = NULL);
+
 	//-------------------------------------------------------------------------
 	//Private members
 	//-------------------------------------------------------------------------
-	GLuint m_DepthMap;		///> A shadow texture object
+	GLuint m_ShadowSamplers[SHADOW_TEST_COUNT];	///> Comparison state of each test (0 if unused)
+	bool m_ShadowSamplersEnabled;	///> Use sampler objects when available
 	GLfloat m_Light[3];		///> Light's position
 	GLfloat m_Camera[3];	///> Camera's position
+	bool m_LODEnabled;		///> Select the level of detail (or always the finest)
+	bool m_QuantizeShadow;	///> Quantize the position-only streams
+	bool m_OptimizeMeshes;	///> Reorder the meshes before uploading them
+	Mesh::VertexFormat m_VertexFormat;	///> Format of the camera pass vertices
+	Shader m_QuantizedShader;			///> Decodes the quantized vertices
+	Mesh::ShaderParams m_ShaderParams;	///> Locations in m_QuantizedShader
+	Shader m_PointShadowShader;			///> Compares with the point light's cube map
+	Shader m_QuantizedPointShader;		///> The same after decoding the quantized vertices
+	Mesh::ShaderParams m_PointShaderParams;	///> Locations in m_QuantizedPointShader
+	GLuint m_PointShadowMap;		///> Cube map of the camera passes (0 for a 2D map)
+	ShadowTest m_PointShadowTest;	///> Which fragments the cube map passes draw
+	GLfloat m_PointLight[3];		///> Position the cube map was drawn from
+	GLfloat m_PointDepthRange[2];	///> Near and far planes of the cube faces
+	bool m_SceneLoaded;		///> The meshes come from a scene file
+	std::vector<LODChain> m_Shapes;	///> Levels of detail of every shape
+	std::vector<Mesh*> m_Meshes;	///> Every mesh (owned)
+	SceneFile m_SceneFile;			///> Mapped scene drawn from client memory
+
+	std::vector<SceneObject>	m_Objects;	///> Every object in the scene
+	std::vector<AABB>			m_Bounds;	///> World bounds of each object
+	std::vector<UINT>			m_Animated;	///> Indices of animated objects
+	BVH							m_BVH;		///> Hierarchy used for culling
 };
 
 #endif
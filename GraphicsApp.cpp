@@ -8,11 +8,29 @@
 
 #include "GraphicsApp.h"
 
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+GraphicsApp::GraphicsApp() : m_hWnd(NULL), m_WindowTitle(NULL), m_Width(0), m_Height(0),
+							 m_hDC(NULL), m_RenderThread(NULL), m_Quit(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+GraphicsApp::~GraphicsApp()
+{
+}
+
 ///----------------------------------------------------------------------------
 ///Initializes this GraphicsApp instance
 ///----------------------------------------------------------------------------
 bool GraphicsApp::InitInstance(HANDLE hInstance, LPCTSTR lpCmdLine, int iCmdShow)
 {
+	//let the application read its options before the display is created
+	if(lpCmdLine) ParseCommandLine(lpCmdLine);
+
 	if(!CreateDisplay())
 	{
 		ShutDown();
@@ -23,32 +41,78 @@ bool GraphicsApp::InitInstance(HANDLE hInstance, LPCTSTR lpCmdLine, int iCmdShow
 }
 
 ///----------------------------------------------------------------------------
-///Starts the main application loop
+///Starts the render thread and runs the message pump until the application
+///quits, so neither of them can stall the other
 ///----------------------------------------------------------------------------
 int GraphicsApp::StartApp()
 {
 	MSG msg;
 
-	while(true)
+	m_Quit = 0;
+	m_RenderThread = CreateThread(NULL, 0, RenderThreadProc, this, 0, NULL);
+	if(!m_RenderThread) return -1;
+
+	while(GetMessage(&msg, NULL, 0, 0) > 0)
 	{
-		//Did we receive a message or are we idling?
-		if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
-		{
-			if(msg.message == WM_QUIT) break;
-
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
-		else
-		{
-			//render the scene
-			Render();
-		}
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+
+	//let the render thread finish its frame and release the device
+	InterlockedExchange(&m_Quit, 1);
+	WaitForSingleObject(m_RenderThread, INFINITE);
+	CloseHandle(m_RenderThread);
+	m_RenderThread = NULL;
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Render thread main loop: initializes the graphics device, then handles
+///the queued window messages before every frame
+///@param	param - the application
+///----------------------------------------------------------------------------
+DWORD WINAPI GraphicsApp::RenderThreadProc(LPVOID param)
+{
+	GraphicsApp *app = (GraphicsApp *)param;
+	WindowEvent event;
+
+	app->InitGraphics();
+
+	while(!app->m_Quit)
+	{
+		while(app->m_Events.Pop(event))
+			app->HandleEvent(event);
+
+		//render the scene
+		app->Render();
 	}
 
+	app->ReleaseGraphics();
 	return 0;
 }
 
+///----------------------------------------------------------------------------
+///Queues a window message for the render thread (message pump thread only)
+///----------------------------------------------------------------------------
+void GraphicsApp::PostEvent(UINT message, WPARAM wParam, LPARAM lParam)
+{
+	WindowEvent event;
+	event.message	= message;
+	event.wParam	= wParam;
+	event.lParam	= lParam;
+
+	m_Events.Push(event);
+}
+
+///----------------------------------------------------------------------------
+///Asks the message pump to quit (can be called from the render thread)
+///----------------------------------------------------------------------------
+void GraphicsApp::Quit()
+{
+	PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+}
+
 ///----------------------------------------------------------------------------
 ///Creates the main rendering window and initializes graphics device
 ///----------------------------------------------------------------------------
@@ -67,7 +131,7 @@ bool GraphicsApp::CreateDisplay()
 	wc.lpfnWndProc		= StaticWndProc;
 	wc.lpszClassName	= m_WindowTitle;
 	wc.lpszMenuName		= NULL;
-	wc.style			= CS_BYTEALIGNCLIENT | CS_HREDRAW | CS_VREDRAW;
+	wc.style			= CS_BYTEALIGNCLIENT | CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
 	RegisterClass(&wc);
 
 	//create the rendering window
@@ -85,12 +149,10 @@ bool GraphicsApp::CreateDisplay()
 	
 	if(!m_hWnd) return false;
 
-	//show the window
+	//show the window, the graphics device is initialized by the render
+	//thread once the application starts
 	ShowWindow(m_hWnd, SW_SHOW);
 
-	//initilizes the graphics device
-	InitGraphics();
-
 	return true;
 }
 
@@ -119,6 +181,15 @@ LRESULT CALLBACK GraphicsApp::StaticWndProc(HWND hWnd, UINT Msg, WPARAM wParam,
 	return DefWindowProc(hWnd, Msg, wParam, lParam);
 }
 
+///----------------------------------------------------------------------------
+///Handles a window message queued by PostEvent (render thread only)
+///@param	event - the message
+///----------------------------------------------------------------------------
+void GraphicsApp::HandleEvent(const WindowEvent &event)
+{
+
+}
+
 ///----------------------------------------------------------------------------
 ///Helper function used to render some information on screen (FPS, etc)
 ///@param	text pointer to string to render
@@ -126,4 +197,13 @@ LRESULT CALLBACK GraphicsApp::StaticWndProc(HWND hWnd, UINT Msg, WPARAM wParam,
 void GraphicsApp::RenderText(LPTSTR text)
 {
 
+}
+
+///----------------------------------------------------------------------------
+///Reads the application options from the command line
+///@param	cmdLine - the command line (without the program name)
+///----------------------------------------------------------------------------
+void GraphicsApp::ParseCommandLine(LPCTSTR cmdLine)
+{
+
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 ///============================================================================
 ///@file	GraphicsApp.h
-///@brief	Defines a Windows Graphics Application Abstract Class
+///@brief	Defines a Windows Graphics Application Abstract Class. The
+///			calling thread runs the message pump and a render thread owns
+///			the graphics device: window messages reach it through a queue
+///			and are handled between frames.
 ///
 ///@author	Hctor Morales Piloni
 ///@date	November 13, 2006
@@ -10,10 +13,17 @@
 #define GRAPHICSAPP_H
 
 #include <windows.h>
+#include "EventQueue.h"
 
 class GraphicsApp
 {
 public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	GraphicsApp();
+	virtual ~GraphicsApp();
+
 	//-------------------------------------------------------------------------
 	//Public methods
 	//-------------------------------------------------------------------------
@@ -22,15 +32,21 @@ public:
 	bool	CreateDisplay();
 	virtual void	InitGraphics() = 0;
 	virtual void	Render() = 0;
+	virtual void	HandleEvent(const WindowEvent &event);
+	virtual void	ReleaseGraphics() = 0;
 	virtual void	RenderText(LPTSTR text);
 	virtual bool	ShutDown() = 0;
 	virtual LRESULT DisplayWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam) = 0;
+	virtual void	ParseCommandLine(LPCTSTR cmdLine);
 
 protected:
 	//-------------------------------------------------------------------------
 	//Protected methods
 	//-------------------------------------------------------------------------
 	static	LRESULT CALLBACK StaticWndProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
+	static	DWORD WINAPI RenderThreadProc(LPVOID param);
+	void	PostEvent(UINT message, WPARAM wParam, LPARAM lParam);
+	void	Quit();
 
 	//-------------------------------------------------------------------------
 	//Protected members
@@ -40,6 +56,9 @@ protected:
 	USHORT	m_Width;		///> Main Window Width
 	USHORT	m_Height;		///> Main Window Height
 	HDC		m_hDC;			///> Handle to Device Context
+	HANDLE	m_RenderThread;	///> Thread that owns the graphics device
+	EventQueue	m_Events;	///> Messages waiting for the render thread
+	volatile LONG m_Quit;	///> Tells the render thread to finish
 };
 
 #endif
\ No newline at end of file
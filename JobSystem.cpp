@@ -0,0 +1,358 @@
+///============================================================================
+///@file	JobSystem.cpp
+///@brief	Runs the per-frame CPU work on every core.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <limits.h>
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+JobSystem::JobSystem() : m_ThreadCount(0), m_Semaphore(NULL), m_Quit(0), m_Stolen(0),
+	m_Profiler(NULL)
+{
+	for(UINT i=0; i<=MAX_THREADS; i++)
+	{
+		m_Deques[i].top = m_Deques[i].bottom = 0;
+		InitializeCriticalSection(&m_Deques[i].lock);
+	}
+
+	InitializeCriticalSection(&m_WaitingLock);
+	m_TlsIndex = TlsAlloc();
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+JobSystem::~JobSystem()
+{
+	Stop();
+
+	for(UINT i=0; i<=MAX_THREADS; i++)
+		DeleteCriticalSection(&m_Deques[i].lock);
+
+	DeleteCriticalSection(&m_WaitingLock);
+	if(m_TlsIndex != TLS_OUT_OF_INDEXES) TlsFree(m_TlsIndex);
+}
+
+///----------------------------------------------------------------------------
+///@returns one thread per core but the one of the caller
+///----------------------------------------------------------------------------
+UINT JobSystem::GetDefaultThreadCount()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	UINT count = info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors - 1 : 0;
+	return count > MAX_THREADS ? MAX_THREADS : count;
+}
+
+///----------------------------------------------------------------------------
+///Starts the worker threads. With no workers the jobs run on the thread
+///that waits for them.
+///@param	threads - number of worker threads (the caller works too)
+///@param	profiler - receives the time spent in each job (may be NULL)
+///@returns false if the threads couldn't be created
+///----------------------------------------------------------------------------
+bool JobSystem::Start(UINT threads, Profiler *profiler)
+{
+	m_Profiler = profiler;
+	m_Quit = 0;
+
+	if(m_TlsIndex == TLS_OUT_OF_INDEXES) return false;
+	if(threads > MAX_THREADS) threads = MAX_THREADS;
+	if(!threads) return true;
+
+	m_Semaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	if(!m_Semaphore) return false;
+
+	for(UINT i=0; i<threads; i++)
+	{
+		m_Workers[i].system = this;
+		m_Workers[i].index = i + 1;
+
+		m_Threads[m_ThreadCount] = CreateThread(NULL, 0, WorkerProc, &m_Workers[i], 0, NULL);
+		if(!m_Threads[m_ThreadCount]) break;
+		m_ThreadCount++;
+	}
+
+	return m_ThreadCount == threads;
+}
+
+///----------------------------------------------------------------------------
+///Stops the worker threads. The jobs must be finished.
+///----------------------------------------------------------------------------
+void JobSystem::Stop()
+{
+	InterlockedExchange(&m_Quit, 1);
+	if(m_ThreadCount) ReleaseSemaphore(m_Semaphore, m_ThreadCount, NULL);
+
+	if(m_ThreadCount) WaitForMultipleObjects(m_ThreadCount, m_Threads, TRUE, INFINITE);
+	for(UINT i=0; i<m_ThreadCount; i++)
+		CloseHandle(m_Threads[i]);
+	m_ThreadCount = 0;
+
+	if(m_Semaphore) CloseHandle(m_Semaphore);
+	m_Semaphore = NULL;
+}
+
+///----------------------------------------------------------------------------
+///Queues a job
+///@param	name - profiler entry of the job (a string literal)
+///@param	func - entry point, called with (data, 0, 1)
+///@param	data - argument of the entry point
+///@param	counter - incremented now and decremented when the job finishes
+///@param	dependency - the job starts when this counter reaches zero (may
+///			be NULL)
+///----------------------------------------------------------------------------
+void JobSystem::Add(LPCSTR name, JobFunc func, void *data, Counter *counter,
+					Counter *dependency)
+{
+	ParallelFor(name, 1, 1, func, data, counter, dependency);
+}
+
+///----------------------------------------------------------------------------
+///Splits a loop in jobs of grain items each
+///@param	name - profiler entry of the jobs (a string literal)
+///@param	count - number of items
+///@param	grain - items per job
+///@param	func - entry point, called once per job with its range of items
+///@param	data - argument of the entry point
+///@param	counter - incremented now by the number of jobs, zero when the
+///			whole loop is done
+///@param	dependency - the loop starts when this counter reaches zero (may
+///			be NULL)
+///----------------------------------------------------------------------------
+void JobSystem::ParallelFor(LPCSTR name, UINT count, UINT grain, JobFunc func, void *data,
+							Counter *counter, Counter *dependency)
+{
+	if(!count) return;
+	if(!grain) grain = 1;
+
+	UINT jobs = (count + grain - 1) / grain;
+	InterlockedExchangeAdd(counter, (LONG)jobs);
+
+	Job job;
+	job.name		= name;
+	job.func		= func;
+	job.data		= data;
+	job.counter		= counter;
+	job.dependency	= dependency;
+
+	//checked again under the lock, Finish takes it once the dependency is done
+	bool waiting = dependency && *dependency > 0;
+	if(waiting)
+	{
+		EnterCriticalSection(&m_WaitingLock);
+		waiting = *dependency > 0;
+		for(UINT i=0; waiting && i<jobs; i++)
+		{
+			job.first = i * grain;
+			job.count = (count - job.first) < grain ? count - job.first : grain;
+			m_Waiting.push_back(job);
+		}
+		LeaveCriticalSection(&m_WaitingLock);
+	}
+
+	for(UINT i=0; !waiting && i<jobs; i++)
+	{
+		job.first = i * grain;
+		job.count = (count - job.first) < grain ? count - job.first : grain;
+		Push(job);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Runs queued jobs until the counter reaches zero
+///@param	counter - counter given to Add or ParallelFor
+///----------------------------------------------------------------------------
+void JobSystem::Wait(Counter *counter)
+{
+	UINT thread = GetThreadIndex();
+
+	while(*counter > 0)
+	{
+		//nothing to run, the last jobs are running on other threads
+		if(!RunOne(thread)) SwitchToThread();
+	}
+
+	MemoryBarrier();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of worker threads
+///----------------------------------------------------------------------------
+UINT JobSystem::GetThreadCount() const
+{
+	return m_ThreadCount;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of jobs stolen since the start
+///----------------------------------------------------------------------------
+UINT JobSystem::GetStolenCount() const
+{
+	return (UINT)m_Stolen;
+}
+
+///----------------------------------------------------------------------------
+///Worker thread: runs jobs while there are any and sleeps on the semaphore
+///----------------------------------------------------------------------------
+DWORD WINAPI JobSystem::WorkerProc(LPVOID param)
+{
+	Worker *worker = (Worker *)param;
+	JobSystem *system = worker->system;
+
+	TlsSetValue(system->m_TlsIndex, (LPVOID)(UINT_PTR)worker->index);
+
+	for(;;)
+	{
+		WaitForSingleObject(system->m_Semaphore, INFINITE);
+		if(system->m_Quit) break;
+
+		while(system->RunOne(worker->index))
+			;
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Puts a job at the bottom of the deque of the current thread and wakes a
+///worker. A full deque runs the job right away.
+///----------------------------------------------------------------------------
+void JobSystem::Push(const Job &job)
+{
+	Deque &deque = m_Deques[GetThreadIndex()];
+
+	EnterCriticalSection(&deque.lock);
+	bool full = deque.bottom - deque.top == QUEUE_SIZE;
+	if(!full) deque.jobs[deque.bottom++ % QUEUE_SIZE] = job;
+	LeaveCriticalSection(&deque.lock);
+
+	if(full)
+		Run(job);
+	else if(m_ThreadCount)
+		ReleaseSemaphore(m_Semaphore, 1, NULL);
+}
+
+///----------------------------------------------------------------------------
+///Takes the newest job of a thread's own deque
+///@returns false if the deque is empty
+///----------------------------------------------------------------------------
+bool JobSystem::Pop(UINT thread, Job &job)
+{
+	Deque &deque = m_Deques[thread];
+	bool found = false;
+
+	EnterCriticalSection(&deque.lock);
+	if(deque.bottom != deque.top)
+	{
+		job = deque.jobs[--deque.bottom % QUEUE_SIZE];
+		found = true;
+	}
+	LeaveCriticalSection(&deque.lock);
+
+	return found;
+}
+
+///----------------------------------------------------------------------------
+///Takes the oldest job of another thread, the victims are visited in turn
+///starting after the thief so they don't all hit the same deque
+///@returns false if every deque is empty
+///----------------------------------------------------------------------------
+bool JobSystem::Steal(UINT thread, Job &job)
+{
+	UINT deques = m_ThreadCount + 1;
+
+	for(UINT i=1; i<deques; i++)
+	{
+		Deque &deque = m_Deques[(thread + i) % deques];
+		if(deque.bottom == deque.top) continue;
+
+		bool found = false;
+		EnterCriticalSection(&deque.lock);
+		if(deque.bottom != deque.top)
+		{
+			job = deque.jobs[deque.top++ % QUEUE_SIZE];
+			found = true;
+		}
+		LeaveCriticalSection(&deque.lock);
+
+		if(found)
+		{
+			InterlockedIncrement(&m_Stolen);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+///----------------------------------------------------------------------------
+///Runs one job, from the thread's own deque first
+///@returns false if there was nothing to run
+///----------------------------------------------------------------------------
+bool JobSystem::RunOne(UINT thread)
+{
+	Job job;
+	if(!Pop(thread, job) && !Steal(thread, job)) return false;
+
+	Run(job);
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Runs a job and signals its counter
+///----------------------------------------------------------------------------
+void JobSystem::Run(const Job &job)
+{
+	double start = m_Profiler ? Profiler::GetTime() : 0.0;
+
+	job.func(job.data, job.first, job.count);
+
+	if(m_Profiler) m_Profiler->AddTime(job.name, Profiler::GetTime() - start);
+	Finish(job);
+}
+
+///----------------------------------------------------------------------------
+///Decrements the counter of a finished job and queues the jobs that were
+///waiting for it
+///----------------------------------------------------------------------------
+void JobSystem::Finish(const Job &job)
+{
+	if(InterlockedDecrement(job.counter) > 0) return;
+
+	std::vector<Job> ready;
+
+	EnterCriticalSection(&m_WaitingLock);
+	for(UINT i=0; i<m_Waiting.size(); )
+	{
+		if(*m_Waiting[i].dependency > 0)
+		{
+			i++;
+			continue;
+		}
+
+		ready.push_back(m_Waiting[i]);
+		m_Waiting[i] = m_Waiting.back();
+		m_Waiting.pop_back();
+	}
+	LeaveCriticalSection(&m_WaitingLock);
+
+	for(UINT i=0; i<ready.size(); i++)
+		Push(ready[i]);
+}
+
+///----------------------------------------------------------------------------
+///@returns the deque of the current thread (0 for threads other than the
+///workers, i.e. the render thread)
+///----------------------------------------------------------------------------
+UINT JobSystem::GetThreadIndex() const
+{
+	return (UINT)(UINT_PTR)TlsGetValue(m_TlsIndex);
+}
@@ -0,0 +1,118 @@
+///============================================================================
+///@file	JobSystem.h
+///@brief	Runs the per-frame CPU work on every core. Each thread owns a
+///			deque of jobs: it pushes and pops its own jobs at the bottom and
+///			idle threads steal from the top of the others. Jobs signal a
+///			counter when they finish, so a job can wait for another one
+///			before it starts and the render thread can wait for a group of
+///			jobs, running queued jobs itself in the meantime.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <windows.h>
+#include <vector>
+
+class Profiler;
+
+class JobSystem
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///Job entry point, runs the items [first, first+count) of the job
+	typedef void (*JobFunc)(void *data, UINT first, UINT count);
+
+	///Number of unfinished jobs of a group, zero when all of them are done
+	typedef volatile LONG Counter;
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	JobSystem();
+	virtual ~JobSystem();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Start(UINT threads, Profiler *profiler = NULL);
+	void Stop();
+	void Add(LPCSTR name, JobFunc func, void *data, Counter *counter,
+			 Counter *dependency = NULL);
+	void ParallelFor(LPCSTR name, UINT count, UINT grain, JobFunc func, void *data,
+					 Counter *counter, Counter *dependency = NULL);
+	void Wait(Counter *counter);
+	UINT GetThreadCount() const;
+	UINT GetStolenCount() const;
+
+	static UINT GetDefaultThreadCount();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_THREADS = 16;		///> Worker threads (plus the caller)
+	static const UINT QUEUE_SIZE = 1024;	///> Jobs each deque can hold
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Job
+	{
+		LPCSTR		name;		///> Profiler entry of the job
+		JobFunc		func;		///> Entry point
+		void*		data;		///> Argument of the entry point
+		UINT		first;		///> First item
+		UINT		count;		///> Number of items
+		Counter*	counter;	///> Decremented when the job finishes
+		Counter*	dependency;	///> Must reach zero before the job starts
+	};
+
+	///Ring of jobs, the owner works at the bottom and thieves at the top
+	struct Deque
+	{
+		Job					jobs[QUEUE_SIZE];	///> Queued jobs
+		UINT				top;		///> Oldest job (stolen first)
+		UINT				bottom;		///> One past the newest job
+		CRITICAL_SECTION	lock;		///> Serializes the owner and thieves
+	};
+
+	struct Worker
+	{
+		JobSystem*	system;		///> Owner of the thread
+		UINT		index;		///> Deque of the thread
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	static DWORD WINAPI WorkerProc(LPVOID param);
+	void Push(const Job &job);
+	bool Pop(UINT thread, Job &job);
+	bool Steal(UINT thread, Job &job);
+	bool RunOne(UINT thread);
+	void Run(const Job &job);
+	void Finish(const Job &job);
+	UINT GetThreadIndex() const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	Deque				m_Deques[MAX_THREADS + 1];	///> The caller's first, then one per worker
+	HANDLE				m_Threads[MAX_THREADS];		///> Worker threads
+	Worker				m_Workers[MAX_THREADS];		///> Thread parameters
+	UINT				m_ThreadCount;	///> Number of running workers
+	HANDLE				m_Semaphore;	///> Counts the queued jobs
+	DWORD				m_TlsIndex;		///> Deque of the current thread (0 if not a worker)
+	volatile LONG		m_Quit;			///> Tells the threads to exit
+	volatile LONG		m_Stolen;		///> Jobs run by a thread other than the owner
+	std::vector<Job>	m_Waiting;		///> Jobs whose dependency isn't done yet
+	CRITICAL_SECTION	m_WaitingLock;	///> Protects m_Waiting
+	Profiler*			m_Profiler;		///> Receives the time of each job
+};
+
+#endif
@@ -0,0 +1,95 @@
+///============================================================================
+///@file	MappedFile.cpp
+///@brief	Read-only memory mapped file.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "MappedFile.h"
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+MappedFile::MappedFile() : m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL), m_View(NULL), m_Size(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+///----------------------------------------------------------------------------
+///Maps a whole file for reading
+///@param	path - file name
+///@returns false if the file can't be opened, is empty or bigger than 4GB
+///----------------------------------------------------------------------------
+bool MappedFile::Open(LPCSTR path)
+{
+	Close();
+
+	m_File = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+						FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(m_File == INVALID_HANDLE_VALUE) return false;
+
+	DWORD high = 0;
+	m_Size = GetFileSize(m_File, &high);
+	if(high != 0 || m_Size == 0 || m_Size == INVALID_FILE_SIZE)
+	{
+		Close();
+		return false;
+	}
+
+	m_Mapping = CreateFileMapping(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(m_Mapping) m_View = (const BYTE *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if(!m_View)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Unmaps the file, pointers into it are no longer valid
+///----------------------------------------------------------------------------
+void MappedFile::Close()
+{
+	if(m_View) UnmapViewOfFile(m_View);
+	if(m_Mapping) CloseHandle(m_Mapping);
+	if(m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+
+	m_File = INVALID_HANDLE_VALUE;
+	m_Mapping = NULL;
+	m_View = NULL;
+	m_Size = 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if a file is mapped
+///----------------------------------------------------------------------------
+bool MappedFile::IsOpen() const
+{
+	return m_View != NULL;
+}
+
+///----------------------------------------------------------------------------
+///@returns the mapped contents (NULL if not open)
+///----------------------------------------------------------------------------
+const BYTE* MappedFile::GetData() const
+{
+	return m_View;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the mapped file
+///----------------------------------------------------------------------------
+UINT MappedFile::GetSize() const
+{
+	return m_Size;
+}
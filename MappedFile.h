@@ -0,0 +1,42 @@
+///============================================================================
+///@file	MappedFile.h
+///@brief	Read-only memory mapped file, used to read scene and mesh files
+///			without copying them into our own buffers.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <windows.h>
+
+class MappedFile
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	MappedFile();
+	virtual ~MappedFile();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Open(LPCSTR path);
+	void Close();
+	bool IsOpen() const;
+	const BYTE* GetData() const;
+	UINT GetSize() const;
+
+private:
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	HANDLE		m_File;		///> Opened file
+	HANDLE		m_Mapping;	///> File mapping object
+	const BYTE*	m_View;		///> Mapped view of the whole file
+	UINT		m_Size;		///> Size of the file
+};
+
+#endif
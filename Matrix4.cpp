@@ -0,0 +1,173 @@
+///============================================================================
+///@file	Matrix4.cpp
+///@brief	Small 4x4 matrix class implementation.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Matrix4.h"
+#include <math.h>
+#include <string.h>
+
+///----------------------------------------------------------------------------
+///Default constructor, initializes the matrix to identity.
+///----------------------------------------------------------------------------
+Matrix4::Matrix4()
+{
+	Identity();
+}
+
+///----------------------------------------------------------------------------
+///Loads the identity matrix.
+///----------------------------------------------------------------------------
+void Matrix4::Identity()
+{
+	memset(m, 0, sizeof(m));
+	m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+///----------------------------------------------------------------------------
+///Copies a column-major matrix.
+///@param	M - 16 float values
+///----------------------------------------------------------------------------
+void Matrix4::Set(const GLfloat M[16])
+{
+	memcpy(m, M, sizeof(m));
+}
+
+///----------------------------------------------------------------------------
+///Copies a column-major matrix (i.e. the ones returned by glGetDoublev).
+///@param	M - 16 double values
+///----------------------------------------------------------------------------
+void Matrix4::Set(const GLdouble M[16])
+{
+	for(int i=0; i<16; i++)
+		m[i] = (GLfloat)M[i];
+}
+
+///----------------------------------------------------------------------------
+///Post-multiplies by a translation matrix (same as glTranslatef).
+///----------------------------------------------------------------------------
+void Matrix4::Translate(GLfloat x, GLfloat y, GLfloat z)
+{
+	m[12] += m[0]*x + m[4]*y + m[8]*z;
+	m[13] += m[1]*x + m[5]*y + m[9]*z;
+	m[14] += m[2]*x + m[6]*y + m[10]*z;
+	m[15] += m[3]*x + m[7]*y + m[11]*z;
+}
+
+///----------------------------------------------------------------------------
+///Post-multiplies by a rotation matrix (same as glRotatef).
+///@param	angle - rotation angle in degrees
+///@param	x,y,z - rotation axis
+///----------------------------------------------------------------------------
+void Matrix4::Rotate(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat len = sqrtf(x*x + y*y + z*z);
+	if(len == 0.0f) return;
+
+	x /= len;
+	y /= len;
+	z /= len;
+
+	GLfloat rad = angle * 3.14159265f / 180.0f;
+	GLfloat c = cosf(rad);
+	GLfloat s = sinf(rad);
+	GLfloat t = 1.0f - c;
+
+	Matrix4 R;
+	R.m[0] = t*x*x + c;		R.m[4] = t*x*y - s*z;	R.m[8]  = t*x*z + s*y;
+	R.m[1] = t*x*y + s*z;	R.m[5] = t*y*y + c;		R.m[9]  = t*y*z - s*x;
+	R.m[2] = t*x*z - s*y;	R.m[6] = t*y*z + s*x;	R.m[10] = t*z*z + c;
+
+	Multiply(R);
+}
+
+///----------------------------------------------------------------------------
+///Post-multiplies by a scale matrix (same as glScalef).
+///----------------------------------------------------------------------------
+void Matrix4::Scale(GLfloat x, GLfloat y, GLfloat z)
+{
+	for(int i=0; i<4; i++)
+	{
+		m[i]   *= x;
+		m[4+i] *= y;
+		m[8+i] *= z;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Post-multiplies this matrix by B (this = this * B).
+///----------------------------------------------------------------------------
+void Matrix4::Multiply(const Matrix4 &B)
+{
+	Matrix4 result;
+	Multiply(*this, B, result);
+	*this = result;
+}
+
+///----------------------------------------------------------------------------
+///Computes result = A * B. result must not alias A or B.
+///----------------------------------------------------------------------------
+void Matrix4::Multiply(const Matrix4 &A, const Matrix4 &B, Matrix4 &result)
+{
+	for(int col=0; col<4; col++)
+	{
+		for(int row=0; row<4; row++)
+		{
+			result.m[col*4+row] = A.m[row]    * B.m[col*4]   +
+								  A.m[4+row]  * B.m[col*4+1] +
+								  A.m[8+row]  * B.m[col*4+2] +
+								  A.m[12+row] * B.m[col*4+3];
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Transforms a point (w=1), the result is not divided by w.
+///----------------------------------------------------------------------------
+void Matrix4::TransformPoint(const GLfloat in[3], GLfloat out[3]) const
+{
+	GLfloat x = in[0], y = in[1], z = in[2];
+
+	out[0] = m[0]*x + m[4]*y + m[8]*z  + m[12];
+	out[1] = m[1]*x + m[5]*y + m[9]*z  + m[13];
+	out[2] = m[2]*x + m[6]*y + m[10]*z + m[14];
+}
+
+///----------------------------------------------------------------------------
+///Transforms a direction vector (w=0).
+///----------------------------------------------------------------------------
+void Matrix4::TransformVector(const GLfloat in[3], GLfloat out[3]) const
+{
+	GLfloat x = in[0], y = in[1], z = in[2];
+
+	out[0] = m[0]*x + m[4]*y + m[8]*z;
+	out[1] = m[1]*x + m[5]*y + m[9]*z;
+	out[2] = m[2]*x + m[6]*y + m[10]*z;
+}
+
+///----------------------------------------------------------------------------
+///Computes the matrix that transforms normals: the inverse transpose of the
+///upper 3x3, up to a positive scale (the cofactor matrix with the sign of
+///the determinant). Shaders normalize the result.
+///@param	M - column-major transform
+///@param	N - returned 3x3 matrix, 3 columns padded to 4 floats (the
+///			std140/std430 layout of a mat3)
+///----------------------------------------------------------------------------
+void Matrix4::GetNormalMatrix(const GLfloat M[16], GLfloat N[12])
+{
+	const GLfloat *a0 = M, *a1 = M + 4, *a2 = M + 8;
+
+	N[0] = a1[1]*a2[2] - a1[2]*a2[1];	N[1] = a1[2]*a2[0] - a1[0]*a2[2];	N[2] = a1[0]*a2[1] - a1[1]*a2[0];
+	N[4] = a2[1]*a0[2] - a2[2]*a0[1];	N[5] = a2[2]*a0[0] - a2[0]*a0[2];	N[6] = a2[0]*a0[1] - a2[1]*a0[0];
+	N[8] = a0[1]*a1[2] - a0[2]*a1[1];	N[9] = a0[2]*a1[0] - a0[0]*a1[2];	N[10] = a0[0]*a1[1] - a0[1]*a1[0];
+	N[3] = N[7] = N[11] = 0.0f;
+
+	//the determinant is the first column dotted with its cofactors
+	if(a0[0]*N[0] + a0[1]*N[1] + a0[2]*N[2] < 0.0f)
+	{
+		for(int i=0; i<12; i++)
+			N[i] = -N[i];
+	}
+}
@@ -0,0 +1,47 @@
+///============================================================================
+///@file	Matrix4.h
+///@brief	Small 4x4 matrix class used to compute object transforms on the
+///			CPU. Matrices are stored column-major (same layout OpenGL uses)
+///			and the transform methods post-multiply just like glTranslate,
+///			glRotate and glScale do, so scene code reads the same way.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef MATRIX4_H
+#define MATRIX4_H
+
+#include <windows.h>
+#include <GL/gl.h>
+
+class Matrix4
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors
+	//-------------------------------------------------------------------------
+	Matrix4();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Identity();
+	void Set(const GLfloat M[16]);
+	void Set(const GLdouble M[16]);
+	void Translate(GLfloat x, GLfloat y, GLfloat z);
+	void Rotate(GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+	void Scale(GLfloat x, GLfloat y, GLfloat z);
+	void Multiply(const Matrix4 &B);
+	void TransformPoint(const GLfloat in[3], GLfloat out[3]) const;
+	void TransformVector(const GLfloat in[3], GLfloat out[3]) const;
+
+	static void Multiply(const Matrix4 &A, const Matrix4 &B, Matrix4 &result);
+	static void GetNormalMatrix(const GLfloat M[16], GLfloat N[12]);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	GLfloat m[16];	///> Column-major matrix elements
+};
+
+#endif
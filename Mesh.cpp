@@ -0,0 +1,964 @@
+///============================================================================
+///@file	Mesh.cpp
+///@brief	Indexed triangle mesh generated in the demo.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Mesh.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "MeshOptimizer.h"
+#include "UploadRing.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+static const GLfloat PI = 3.14159265358979f;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+Mesh::Mesh() : m_UseQuantized(false), m_Format(FLOAT_VERTEX), m_Stride(sizeof(Vertex)),
+			   m_IndexType(GL_UNSIGNED_INT), m_VertexCount(0), m_IndexCount(0), m_VertexData(NULL),
+			   m_PositionData(NULL), m_IndexData(NULL), m_VertexBuffer(0), m_PositionBuffer(0),
+			   m_IndexBuffer(0), m_StagedBytes(0)
+{
+	m_Bounds.Clear();
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	memset(&m_OriginalStats, 0, sizeof(m_OriginalStats));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+Mesh::~Mesh()
+{
+}
+
+///----------------------------------------------------------------------------
+///Removes all vertices and triangles
+///----------------------------------------------------------------------------
+void Mesh::Clear()
+{
+	m_Vertices.clear();
+	m_Positions.clear();
+	m_Quantized.clear();
+	m_Packed.clear();
+	m_Indices.clear();
+	m_Indices16.clear();
+	m_Bounds.Clear();
+	m_VertexCount = m_IndexCount = 0;
+	m_VertexData = m_PositionData = m_IndexData = NULL;
+}
+
+///----------------------------------------------------------------------------
+///Appends a vertex to the full vertex stream
+///----------------------------------------------------------------------------
+void Mesh::AddVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz)
+{
+	Vertex v;
+	v.position[0] = x;
+	v.position[1] = y;
+	v.position[2] = z;
+	v.normal[0] = nx;
+	v.normal[1] = ny;
+	v.normal[2] = nz;
+
+	m_Vertices.push_back(v);
+	m_Bounds.Grow(v.position);
+}
+
+///----------------------------------------------------------------------------
+///Appends a counter-clockwise triangle
+///----------------------------------------------------------------------------
+void Mesh::AddTriangle(GLuint a, GLuint b, GLuint c)
+{
+	m_Indices.push_back(a);
+	m_Indices.push_back(b);
+	m_Indices.push_back(c);
+}
+
+///----------------------------------------------------------------------------
+///Creates a cube centered at the origin (same as glutSolidCube)
+///@param	size - length of the edges
+///----------------------------------------------------------------------------
+void Mesh::CreateCube(GLfloat size)
+{
+	//face normal and two edge directions with u x v = normal
+	static const GLfloat Faces[6][3][3] =
+	{
+		{{ 1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+		{{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+		{{ 0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+		{{ 0,-1, 0}, {1, 0, 0}, {0, 0, 1}},
+		{{ 0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+		{{ 0, 0,-1}, {0, 1, 0}, {1, 0, 0}}
+	};
+	static const GLfloat Corners[4][2] = {{-1,-1}, {1,-1}, {1,1}, {-1,1}};
+
+	Clear();
+	GLfloat h = 0.5f * size;
+
+	for(int f=0; f<6; f++)
+	{
+		const GLfloat *n = Faces[f][0], *u = Faces[f][1], *v = Faces[f][2];
+		GLuint first = (GLuint)m_Vertices.size();
+
+		for(int c=0; c<4; c++)
+		{
+			GLfloat p[3];
+			for(int k=0; k<3; k++)
+				p[k] = h * (n[k] + Corners[c][0]*u[k] + Corners[c][1]*v[k]);
+
+			AddVertex(p[0], p[1], p[2], n[0], n[1], n[2]);
+		}
+
+		AddTriangle(first, first+1, first+2);
+		AddTriangle(first, first+2, first+3);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Creates a sphere centered at the origin with its poles on the Z axis
+///(same as glutSolidSphere)
+///@param	radius - sphere radius
+///@param	slices - subdivisions around the Z axis
+///@param	stacks - subdivisions along the Z axis
+///----------------------------------------------------------------------------
+void Mesh::CreateSphere(GLfloat radius, GLint slices, GLint stacks)
+{
+	Clear();
+
+	for(GLint i=0; i<=stacks; i++)
+	{
+		GLfloat theta = PI * i / stacks;
+
+		for(GLint j=0; j<=slices; j++)
+		{
+			GLfloat phi = 2.0f * PI * j / slices;
+			GLfloat n[3] = {cosf(phi) * sinf(theta), sinf(phi) * sinf(theta), cosf(theta)};
+			AddVertex(radius*n[0], radius*n[1], radius*n[2], n[0], n[1], n[2]);
+		}
+	}
+
+	//the first and last stacks are fans around the poles
+	for(GLint i=0; i<stacks; i++)
+	{
+		for(GLint j=0; j<slices; j++)
+		{
+			GLuint a = i*(slices+1) + j;
+			GLuint b = a + slices + 1;
+
+			if(i > 0)			AddTriangle(a, b, a+1);
+			if(i < stacks-1)	AddTriangle(a+1, b, b+1);
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Creates a torus centered at the origin lying on the XY plane (same as
+///glutSolidTorus)
+///@param	innerRadius - radius of the tube
+///@param	outerRadius - distance from the center to the tube's center
+///@param	sides - subdivisions of the tube
+///@param	rings - subdivisions around the Z axis
+///----------------------------------------------------------------------------
+void Mesh::CreateTorus(GLfloat innerRadius, GLfloat outerRadius, GLint sides, GLint rings)
+{
+	Clear();
+
+	for(GLint i=0; i<=rings; i++)
+	{
+		GLfloat u = 2.0f * PI * i / rings;
+
+		for(GLint j=0; j<=sides; j++)
+		{
+			GLfloat v = 2.0f * PI * j / sides;
+			GLfloat n[3] = {cosf(v) * cosf(u), cosf(v) * sinf(u), sinf(v)};
+			GLfloat d = outerRadius + innerRadius * cosf(v);
+
+			AddVertex(d * cosf(u), d * sinf(u), innerRadius * n[2], n[0], n[1], n[2]);
+		}
+	}
+
+	for(GLint i=0; i<rings; i++)
+	{
+		for(GLint j=0; j<sides; j++)
+		{
+			GLuint a = i*(sides+1) + j;
+			GLuint b = a + sides + 1;
+
+			AddTriangle(a, b, a+1);
+			AddTriangle(a+1, b, b+1);
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Creates a cone with its base on the XY plane pointing along +Z (same as
+///glutSolidCone)
+///@param	base - radius of the base
+///@param	height - height of the cone
+///@param	slices - subdivisions around the Z axis
+///@param	stacks - subdivisions along the Z axis
+///----------------------------------------------------------------------------
+void Mesh::CreateCone(GLfloat base, GLfloat height, GLint slices, GLint stacks)
+{
+	Clear();
+
+	GLfloat len = sqrtf(height*height + base*base);
+	GLfloat nxy = height / len, nz = base / len;
+
+	//side, the last row are copies of the apex with each slice's normal
+	for(GLint i=0; i<=stacks; i++)
+	{
+		GLfloat t = (GLfloat)i / stacks;
+
+		for(GLint j=0; j<=slices; j++)
+		{
+			GLfloat phi = 2.0f * PI * j / slices;
+			GLfloat c = cosf(phi), s = sinf(phi);
+			AddVertex(base * (1.0f - t) * c, base * (1.0f - t) * s, height * t, nxy * c, nxy * s, nz);
+		}
+	}
+
+	for(GLint i=0; i<stacks; i++)
+	{
+		for(GLint j=0; j<slices; j++)
+		{
+			GLuint a = i*(slices+1) + j;
+			GLuint b = a + slices + 1;
+
+			AddTriangle(a, a+1, b);
+			if(i < stacks-1) AddTriangle(a+1, b+1, b);
+		}
+	}
+
+	//base, facing -Z
+	GLuint center = (GLuint)m_Vertices.size();
+	AddVertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
+
+	for(GLint j=0; j<=slices; j++)
+	{
+		GLfloat phi = 2.0f * PI * j / slices;
+		AddVertex(base * cosf(phi), base * sinf(phi), 0.0f, 0.0f, 0.0f, -1.0f);
+	}
+
+	for(GLint j=0; j<slices; j++)
+		AddTriangle(center, center+j+2, center+j+1);
+}
+
+///----------------------------------------------------------------------------
+///Creates a mesh from indexed arrays (i.e. an imported model)
+///@param	positions - 3 floats per vertex
+///@param	normals - 3 floats per vertex, unit length
+///@param	indices - counter-clockwise triangle list
+///----------------------------------------------------------------------------
+void Mesh::CreateIndexed(const std::vector<GLfloat> &positions, const std::vector<GLfloat> &normals,
+						 const std::vector<GLuint> &indices)
+{
+	Clear();
+
+	UINT count = (UINT)(positions.size() / 3);
+	m_Vertices.reserve(count);
+
+	for(UINT i=0; i<count; i++)
+	{
+		const GLfloat *p = &positions[i*3];
+		const GLfloat *n = &normals[i*3];
+		AddVertex(p[0], p[1], p[2], n[0], n[1], n[2]);
+	}
+
+	m_Indices = indices;
+}
+
+///----------------------------------------------------------------------------
+///Creates a coarser version of a mesh by vertex clustering: the vertices in
+///each cell of a grid over the bounds are merged into their average and the
+///triangles that collapse are removed. Used for the levels of detail and
+///shadow proxies of imported meshes.
+///@param	source - the mesh to simplify (not this one)
+///@param	gridSize - cells along the longest side of the bounds
+///@param	keepCreases - vertices facing different directions aren't merged
+///						  (not needed for depth-only proxies)
+///----------------------------------------------------------------------------
+void Mesh::CreateSimplified(const Mesh &source, UINT gridSize, bool keepCreases)
+{
+	Clear();
+
+	UINT count = (UINT)source.m_Vertices.size();
+	if(count == 0 || gridSize == 0) return;
+
+	const AABB &bounds = source.m_Bounds;
+	GLfloat extent = 0.0f;
+	for(int k=0; k<3; k++)
+		if(bounds.max[k] - bounds.min[k] > extent) extent = bounds.max[k] - bounds.min[k];
+	GLfloat invCell = extent > 0.0f ? gridSize / extent : 0.0f;
+
+	//cell (and dominant normal direction) of every vertex, sorted by cell
+	std::vector< std::pair<UINT64, GLuint> > keys(count);
+	for(UINT i=0; i<count; i++)
+	{
+		const Vertex &v = source.m_Vertices[i];
+		UINT64 key = 0;
+
+		for(int k=0; k<3; k++)
+		{
+			UINT cell = (UINT)((v.position[k] - bounds.min[k]) * invCell);
+			if(cell >= gridSize) cell = gridSize - 1;
+			key = key * gridSize + cell;
+		}
+
+		if(keepCreases)
+		{
+			int axis = 0;
+			for(int k=1; k<3; k++)
+				if(fabs(v.normal[k]) > fabs(v.normal[axis])) axis = k;
+			key = key * 6 + axis * 2 + (v.normal[axis] < 0.0f ? 1 : 0);
+		}
+
+		keys[i] = std::make_pair(key, (GLuint)i);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	//one vertex per cluster with the average position and normal
+	std::vector<GLuint> cluster(count);
+	for(UINT i=0; i<count; )
+	{
+		UINT end = i;
+		GLfloat p[3] = {0.0f, 0.0f, 0.0f}, n[3] = {0.0f, 0.0f, 0.0f};
+
+		for(; end<count && keys[end].first == keys[i].first; end++)
+		{
+			const Vertex &v = source.m_Vertices[keys[end].second];
+			for(int k=0; k<3; k++)
+			{
+				p[k] += v.position[k];
+				n[k] += v.normal[k];
+			}
+			cluster[keys[end].second] = (GLuint)m_Vertices.size();
+		}
+
+		GLfloat invCount = 1.0f / (end - i);
+		GLfloat len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		GLfloat invLen = len > 0.0f ? 1.0f / len : 0.0f;
+		AddVertex(p[0]*invCount, p[1]*invCount, p[2]*invCount, n[0]*invLen, n[1]*invLen, n[2]*invLen);
+		i = end;
+	}
+
+	for(UINT i=0; i+2<source.m_Indices.size(); i+=3)
+	{
+		GLuint a = cluster[source.m_Indices[i]];
+		GLuint b = cluster[source.m_Indices[i+1]];
+		GLuint c = cluster[source.m_Indices[i+2]];
+
+		if(a != b && b != c && c != a) AddTriangle(a, b, c);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Measures the vertex cache efficiency and overdraw of the current order
+///(call after creating the mesh, Optimize does it by itself)
+///----------------------------------------------------------------------------
+void Mesh::Analyze()
+{
+	if(m_Vertices.empty()) return;
+
+	UINT count = (UINT)m_Vertices.size();
+	const UINT stride = sizeof(Vertex) / sizeof(GLfloat);
+
+	MeshOptimizer::AnalyzeVertexCache(m_Indices, count, &m_Stats.acmr, &m_Stats.atvr);
+	m_Stats.overdraw = MeshOptimizer::AnalyzeOverdraw(m_Indices, m_Vertices[0].position, stride, count);
+	m_OriginalStats = m_Stats;
+}
+
+///----------------------------------------------------------------------------
+///Reorders the triangles for the vertex cache and less overdraw, then the
+///vertices in the order they are used. Call before Upload.
+///----------------------------------------------------------------------------
+void Mesh::Optimize()
+{
+	if(m_Vertices.empty()) return;
+
+	Analyze();
+
+	UINT count = (UINT)m_Vertices.size();
+	const UINT stride = sizeof(Vertex) / sizeof(GLfloat);
+
+	MeshOptimizer::OptimizeVertexCache(m_Indices, count);
+	MeshOptimizer::OptimizeOverdraw(m_Indices, m_Vertices[0].position, stride, count, 1.05f);
+
+	std::vector<GLuint> remap;
+	MeshOptimizer::OptimizeVertexFetch(m_Indices, count, remap);
+
+	std::vector<Vertex> vertices(count);
+	for(UINT i=0; i<count; i++)
+		vertices[remap[i]] = m_Vertices[i];
+	m_Vertices.swap(vertices);
+
+	MeshOptimizer::AnalyzeVertexCache(m_Indices, count, &m_Stats.acmr, &m_Stats.atvr);
+	m_Stats.overdraw = MeshOptimizer::AnalyzeOverdraw(m_Indices, m_Vertices[0].position, stride, count);
+}
+
+///----------------------------------------------------------------------------
+///Encodes a unit vector with the octahedral mapping (the octahedron's
+///lower half is folded over the upper one)
+///@param	n - unit vector
+///@param	e - returned coordinates in [-1,1]
+///----------------------------------------------------------------------------
+void Mesh::EncodeOctahedral(const GLfloat n[3], GLfloat e[2])
+{
+	GLfloat l1 = fabs(n[0]) + fabs(n[1]) + fabs(n[2]);
+	GLfloat x = l1 > 0.0f ? n[0] / l1 : 0.0f;
+	GLfloat y = l1 > 0.0f ? n[1] / l1 : 0.0f;
+
+	if(n[2] < 0.0f)
+	{
+		GLfloat fx = (1.0f - fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		GLfloat fy = (1.0f - fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = fx;
+		y = fy;
+	}
+
+	e[0] = x;
+	e[1] = y;
+}
+
+///----------------------------------------------------------------------------
+///Builds the vertex streams in the requested format. Makes no GL calls
+///unless the mesh already has buffer objects, so new meshes can be
+///prepared on any thread and then uploaded with BeginStaging and Stage
+///(when supported, otherwise they are drawn from client memory).
+///@param	format - format of the full vertex stream, quantized formats
+///			must be drawn with the quantized vertex shader bound
+///@param	quantizePositions - store the position-only stream as 16 bit
+///			integers relative to the mesh bounds instead of floats (always
+///			done for quantized formats)
+///----------------------------------------------------------------------------
+void Mesh::Prepare(VertexFormat format, bool quantizePositions)
+{
+	Release();
+
+	UINT count = (UINT)m_Vertices.size();
+	m_Format = format;
+	m_UseQuantized = quantizePositions || format != FLOAT_VERTEX;
+	m_Positions.clear();
+	m_Quantized.clear();
+	m_Packed.clear();
+	m_Indices16.clear();
+
+	//map the bounds to [-32767, 32767]
+	GLfloat invScale[3];
+	for(int k=0; k<3; k++)
+	{
+		GLfloat half = 0.5f * (m_Bounds.max[k] - m_Bounds.min[k]);
+		if(half <= 0.0f) half = 1.0f;
+
+		m_DequantizeOffset[k] = 0.5f * (m_Bounds.max[k] + m_Bounds.min[k]);
+		m_DequantizeScale[k] = half / 32767.0f;
+		invScale[k] = 32767.0f / half;
+	}
+
+	std::vector<GLshort> quantized(count * 4);
+	for(UINT i=0; i<count; i++)
+	{
+		for(int k=0; k<3; k++)
+		{
+			GLfloat q = (m_Vertices[i].position[k] - m_DequantizeOffset[k]) * invScale[k];
+			quantized[i*4 + k] = (GLshort)floor(q + 0.5f);
+		}
+		quantized[i*4 + 3] = 1;
+	}
+
+	//position-only stream, the fourth short keeps every position 8 byte aligned
+	if(m_UseQuantized)
+	{
+		m_Quantized.swap(quantized);
+	}
+	else
+	{
+		m_Positions.resize(count * 3);
+		for(UINT i=0; i<count; i++)
+		{
+			for(int k=0; k<3; k++)
+				m_Positions[i*3 + k] = m_Vertices[i].position[k];
+		}
+	}
+
+	//full vertex stream
+	if(m_Format == FLOAT_VERTEX)
+	{
+		m_Stride = sizeof(Vertex);
+	}
+	else
+	{
+		//with 8 bit normals they take the place of the fourth short
+		m_Stride = m_Format == QUANTIZED_8 ? 4*sizeof(GLshort) : 6*sizeof(GLshort);
+		m_Packed.resize(count * m_Stride);
+
+		const std::vector<GLshort> &q = m_UseQuantized ? m_Quantized : quantized;
+		GLfloat normalScale = m_Format == QUANTIZED_8 ? 127.0f : 32767.0f;
+
+		for(UINT i=0; i<count; i++)
+		{
+			GLubyte *v = &m_Packed[i * m_Stride];
+			memcpy(v, &q[i*4], 3*sizeof(GLshort));
+
+			GLfloat e[2];
+			EncodeOctahedral(m_Vertices[i].normal, e);
+
+			if(m_Format == QUANTIZED_8)
+			{
+				GLbyte *n = (GLbyte *)(v + 3*sizeof(GLshort));
+				n[0] = (GLbyte)floor(e[0] * normalScale + 0.5f);
+				n[1] = (GLbyte)floor(e[1] * normalScale + 0.5f);
+			}
+			else
+			{
+				GLshort n[2];
+				n[0] = (GLshort)floor(e[0] * normalScale + 0.5f);
+				n[1] = (GLshort)floor(e[1] * normalScale + 0.5f);
+				memcpy(v + 4*sizeof(GLshort), n, sizeof(n));
+			}
+		}
+	}
+
+	//16 bit indices whenever the vertices fit
+	m_IndexType = GL_UNSIGNED_INT;
+	if(m_Format != FLOAT_VERTEX && count <= 65536)
+	{
+		m_IndexType = GL_UNSIGNED_SHORT;
+		m_Indices16.assign(m_Indices.begin(), m_Indices.end());
+	}
+
+	m_VertexCount = count;
+	m_IndexCount = (UINT)m_Indices.size();
+	if(m_IndexCount == 0) return;
+
+	m_VertexData = m_Format == FLOAT_VERTEX ? (const GLubyte *)&m_Vertices[0] : &m_Packed[0];
+	m_PositionData = m_UseQuantized ? (const GLubyte *)&m_Quantized[0] :
+									  (const GLubyte *)&m_Positions[0];
+	m_IndexData = m_IndexType == GL_UNSIGNED_SHORT ? (const GLubyte *)&m_Indices16[0] :
+													 (const GLubyte *)&m_Indices[0];
+}
+
+///----------------------------------------------------------------------------
+///Builds the streams and copies them to buffer objects
+///@param	format - format of the full vertex stream
+///@param	quantizePositions - 16 bit position-only stream
+///----------------------------------------------------------------------------
+void Mesh::Upload(VertexFormat format, bool quantizePositions)
+{
+	Prepare(format, quantizePositions);
+	if(m_IndexCount) CreateBuffers();
+}
+
+///----------------------------------------------------------------------------
+///Draws streams kept outside the mesh, which must outlive it unless they
+///are copied to buffer objects. The generated vertices are discarded.
+///@param	streams - the streams (i.e. from a mapped scene file)
+///----------------------------------------------------------------------------
+void Mesh::Attach(const Streams &streams)
+{
+	Release();
+	Clear();
+
+	m_Format		= streams.format;
+	m_Stride		= streams.stride;
+	m_IndexType		= streams.indexType;
+	m_UseQuantized	= streams.quantizedPositions;
+	m_VertexCount	= streams.vertexCount;
+	m_IndexCount	= streams.indexCount;
+	m_VertexData	= (const GLubyte *)streams.vertices;
+	m_PositionData	= (const GLubyte *)streams.positions;
+	m_IndexData		= (const GLubyte *)streams.indices;
+	m_Bounds		= streams.bounds;
+	m_OriginalStats	= streams.originalStats;
+	m_Stats			= streams.stats;
+	memcpy(m_DequantizeScale, streams.dequantizeScale, sizeof(m_DequantizeScale));
+	memcpy(m_DequantizeOffset, streams.dequantizeOffset, sizeof(m_DequantizeOffset));
+
+	if(m_IndexCount) CreateBuffers();
+}
+
+///----------------------------------------------------------------------------
+///Gets the streams built by the last Upload (or Attach)
+///@param	streams - returned streams, valid until the mesh changes
+///----------------------------------------------------------------------------
+void Mesh::GetStreams(Streams &streams) const
+{
+	streams.format				= m_Format;
+	streams.vertexCount			= m_VertexCount;
+	streams.indexCount			= m_IndexCount;
+	streams.stride				= m_Stride;
+	streams.indexType			= m_IndexType;
+	streams.quantizedPositions	= m_UseQuantized;
+	streams.vertices			= m_VertexData;
+	streams.positions			= m_PositionData;
+	streams.indices				= m_IndexData;
+	streams.bounds				= m_Bounds;
+	streams.originalStats		= m_OriginalStats;
+	streams.stats				= m_Stats;
+	memcpy(streams.dequantizeScale, m_DequantizeScale, sizeof(m_DequantizeScale));
+	memcpy(streams.dequantizeOffset, m_DequantizeOffset, sizeof(m_DequantizeOffset));
+}
+
+///----------------------------------------------------------------------------
+///Copies the drawn streams to buffer objects (when supported)
+///----------------------------------------------------------------------------
+void Mesh::CreateBuffers()
+{
+	BeginStaging();
+	Stage(GetStagingBytes());
+}
+
+///----------------------------------------------------------------------------
+///Creates empty buffer objects for the streams built by Prepare, they are
+///filled by Stage (the rendering context must be current). Without buffer
+///objects the streams are drawn from memory and there is nothing to copy.
+///----------------------------------------------------------------------------
+void Mesh::BeginStaging()
+{
+	Release();
+
+	if(!g_GLCaps.vertexBufferObject)
+	{
+		m_StagedBytes = GetStagingBytes();
+		return;
+	}
+
+	m_StagedBytes = 0;
+
+	glGenBuffersARB(1, &m_VertexBuffer);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_VertexBuffer);
+	glBufferDataARB(GL_ARRAY_BUFFER_ARB, GetVertexBytes(), NULL, GL_STATIC_DRAW_ARB);
+
+	glGenBuffersARB(1, &m_PositionBuffer);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_PositionBuffer);
+	glBufferDataARB(GL_ARRAY_BUFFER_ARB, GetPositionBytes(), NULL, GL_STATIC_DRAW_ARB);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+
+	glGenBuffersARB(1, &m_IndexBuffer);
+	g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer);
+	glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, GetIndexBytes(), NULL, GL_STATIC_DRAW_ARB);
+	g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+}
+
+///----------------------------------------------------------------------------
+///Copies the next part of the streams to the buffer objects, in order:
+///full vertices, positions and indices. The mesh can't be drawn until
+///IsStaged. With a ring the data is written to its current segment and
+///copied from there by the GPU, the driver doesn't have to keep its own
+///copy; the pieces that don't fit are copied with glBufferSubData.
+///@param	maxBytes - most bytes to copy
+///@param	ring - staging memory (NULL to copy from the streams)
+///@returns the bytes copied
+///----------------------------------------------------------------------------
+UINT Mesh::Stage(UINT maxBytes, UploadRing *ring)
+{
+	const GLubyte *data[3] = {m_VertexData, m_PositionData, m_IndexData};
+	const UINT bytes[3] = {GetVertexBytes(), GetPositionBytes(), GetIndexBytes()};
+	const GLuint buffers[3] = {m_VertexBuffer, m_PositionBuffer, m_IndexBuffer};
+	const GLenum targets[3] = {GL_ARRAY_BUFFER_ARB, GL_ARRAY_BUFFER_ARB, GL_ELEMENT_ARRAY_BUFFER_ARB};
+	UINT staged = 0, start = 0;
+
+	for(int i=0; i<3 && staged < maxBytes; i++)
+	{
+		UINT end = start + bytes[i];
+
+		if(m_StagedBytes < end)
+		{
+			UINT offset = m_StagedBytes - start;
+			UINT count = end - m_StagedBytes;
+			if(count > maxBytes - staged) count = maxBytes - staged;
+
+			GLintptr source = 0;
+			void *memory = ring ? ring->Allocate(GL_COPY_READ_BUFFER, count, &source) : NULL;
+
+			if(memory)
+			{
+				memcpy(memory, data[i] + offset, count);
+				g_GLState.BindBuffer(GL_COPY_READ_BUFFER, ring->GetBuffer());
+				g_GLState.BindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source, offset, count);
+				g_GLState.BindBuffer(GL_COPY_READ_BUFFER, 0);
+				g_GLState.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+			else
+			{
+				g_GLState.BindBuffer(targets[i], buffers[i]);
+				glBufferSubDataARB(targets[i], offset, count, data[i] + offset);
+				g_GLState.BindBuffer(targets[i], 0);
+			}
+
+			m_StagedBytes += count;
+			staged += count;
+		}
+
+		start = end;
+	}
+
+	return staged;
+}
+
+///----------------------------------------------------------------------------
+///@returns true when the streams are completely in the buffer objects
+///----------------------------------------------------------------------------
+bool Mesh::IsStaged() const
+{
+	return m_StagedBytes >= GetStagingBytes();
+}
+
+///----------------------------------------------------------------------------
+///@returns the size of all the streams copied by Stage
+///----------------------------------------------------------------------------
+UINT Mesh::GetStagingBytes() const
+{
+	return GetVertexBytes() + GetPositionBytes() + GetIndexBytes();
+}
+
+///----------------------------------------------------------------------------
+///Deletes the buffer objects (the rendering context must be current)
+///----------------------------------------------------------------------------
+void Mesh::Release()
+{
+	if(!m_VertexBuffer) return;
+
+	g_GLState.DeleteBuffer(m_VertexBuffer);
+	g_GLState.DeleteBuffer(m_PositionBuffer);
+	g_GLState.DeleteBuffer(m_IndexBuffer);
+
+	glDeleteBuffersARB(1, &m_VertexBuffer);
+	glDeleteBuffersARB(1, &m_PositionBuffer);
+	glDeleteBuffersARB(1, &m_IndexBuffer);
+	m_VertexBuffer = m_PositionBuffer = m_IndexBuffer = 0;
+}
+
+///----------------------------------------------------------------------------
+///Enables the arrays used by Draw (positions and normals) or DrawPositions
+///(positions only). Call once before drawing many meshes.
+///@param	positionsOnly - true for DrawPositions
+///@param	shader - quantized vertex shader (NULL for float vertices)
+///----------------------------------------------------------------------------
+void Mesh::BeginDraw(bool positionsOnly, const ShaderParams *shader)
+{
+	g_GLState.EnableClientState(GL_VERTEX_ARRAY);
+	if(positionsOnly) return;
+
+	if(shader)
+		g_GLState.EnableVertexAttribArray(shader->normal);
+	else
+		g_GLState.EnableClientState(GL_NORMAL_ARRAY);
+}
+
+///----------------------------------------------------------------------------
+///Disables the arrays enabled by BeginDraw
+///----------------------------------------------------------------------------
+void Mesh::EndDraw(bool positionsOnly, const ShaderParams *shader)
+{
+	if(!positionsOnly)
+	{
+		if(shader)
+			g_GLState.DisableVertexAttribArray(shader->normal);
+		else
+			g_GLState.DisableClientState(GL_NORMAL_ARRAY);
+	}
+	g_GLState.DisableClientState(GL_VERTEX_ARRAY);
+
+	//the buffers stay bound, every Bind sets both targets (to 0 for
+	//meshes drawn from client memory)
+}
+
+///----------------------------------------------------------------------------
+///Draws the mesh with positions and normals (between BeginDraw(false) and
+///EndDraw(false))
+///@param	shader - bound quantized vertex shader (NULL for float vertices)
+///----------------------------------------------------------------------------
+void Mesh::Draw(const ShaderParams *shader) const
+{
+	if(Bind(shader)) DrawElements();
+}
+
+///----------------------------------------------------------------------------
+///Draws the mesh from the position-only stream (between BeginDraw(true)
+///and EndDraw(true)). Quantized positions are scaled back to object space
+///with the modelview matrix.
+///----------------------------------------------------------------------------
+void Mesh::DrawPositions() const
+{
+	if(BindPositions()) DrawPositionElements();
+}
+
+///----------------------------------------------------------------------------
+///Points the vertex arrays to the full vertex stream. Draws of the same mesh
+///that follow each other only need to bind it once.
+///@param	shader - bound quantized vertex shader (NULL for float vertices)
+///@returns false if there is nothing to draw
+///----------------------------------------------------------------------------
+bool Mesh::Bind(const ShaderParams *shader) const
+{
+	if(m_IndexCount == 0) return false;
+
+	//offsets into the buffer objects or pointers to client memory
+	const GLubyte *vertices = m_VertexBuffer ? NULL : m_VertexData;
+
+	if(g_GLCaps.vertexBufferObject)
+	{
+		g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_VertexBuffer);
+		g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer);
+	}
+
+	if(m_Format == FLOAT_VERTEX)
+	{
+		glVertexPointer(3, GL_FLOAT, m_Stride, vertices);
+		glNormalPointer(GL_FLOAT, m_Stride, vertices + 3*sizeof(GLfloat));
+	}
+	else if(shader)
+	{
+		glUniform3fv(shader->positionScale, 1, m_DequantizeScale);
+		glUniform3fv(shader->positionOffset, 1, m_DequantizeOffset);
+
+		glVertexPointer(3, GL_SHORT, m_Stride, vertices);
+		if(m_Format == QUANTIZED_8)
+		{
+			glUniform1f(shader->normalScale, 1.0f / 127.0f);
+			glVertexAttribPointer(shader->normal, 2, GL_BYTE, GL_FALSE, m_Stride, vertices + 3*sizeof(GLshort));
+		}
+		else
+		{
+			glUniform1f(shader->normalScale, 1.0f / 32767.0f);
+			glVertexAttribPointer(shader->normal, 2, GL_SHORT, GL_FALSE, m_Stride, vertices + 4*sizeof(GLshort));
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Points the vertex array to the position-only stream
+///@returns false if there is nothing to draw
+///----------------------------------------------------------------------------
+bool Mesh::BindPositions() const
+{
+	if(m_IndexCount == 0) return false;
+
+	const GLubyte *positions = m_PositionBuffer ? NULL : m_PositionData;
+
+	if(g_GLCaps.vertexBufferObject)
+	{
+		g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_PositionBuffer);
+		g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer);
+	}
+
+	if(m_UseQuantized)
+		glVertexPointer(3, GL_SHORT, 4*sizeof(GLshort), positions);
+	else
+		glVertexPointer(3, GL_FLOAT, 3*sizeof(GLfloat), positions);
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Draws the triangles of the mesh bound with Bind
+///----------------------------------------------------------------------------
+void Mesh::DrawElements() const
+{
+	const GLubyte *indices = m_VertexBuffer ? NULL : m_IndexData;
+	glDrawElements(GL_TRIANGLES, (GLsizei)m_IndexCount, m_IndexType, indices);
+}
+
+///----------------------------------------------------------------------------
+///Draws the triangles of the mesh bound with BindPositions
+///----------------------------------------------------------------------------
+void Mesh::DrawPositionElements() const
+{
+	const GLubyte *indices = m_PositionBuffer ? NULL : m_IndexData;
+
+	if(m_UseQuantized)
+	{
+		glPushMatrix();
+		glTranslatef(m_DequantizeOffset[0], m_DequantizeOffset[1], m_DequantizeOffset[2]);
+		glScalef(m_DequantizeScale[0], m_DequantizeScale[1], m_DequantizeScale[2]);
+	}
+
+	glDrawElements(GL_TRIANGLES, (GLsizei)m_IndexCount, m_IndexType, indices);
+
+	if(m_UseQuantized) glPopMatrix();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of vertices
+///----------------------------------------------------------------------------
+UINT Mesh::GetVertexCount() const
+{
+	return m_VertexCount ? m_VertexCount : (UINT)m_Vertices.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of triangles
+///----------------------------------------------------------------------------
+UINT Mesh::GetTriangleCount() const
+{
+	return (m_IndexCount ? m_IndexCount : (UINT)m_Indices.size()) / 3;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the full vertex stream
+///----------------------------------------------------------------------------
+UINT Mesh::GetVertexBytes() const
+{
+	return m_VertexCount * m_Stride;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the position-only stream
+///----------------------------------------------------------------------------
+UINT Mesh::GetPositionBytes() const
+{
+	return m_VertexCount * (m_UseQuantized ? 4*sizeof(GLshort) : 3*sizeof(GLfloat));
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the index buffer
+///----------------------------------------------------------------------------
+UINT Mesh::GetIndexBytes() const
+{
+	return m_IndexCount * (m_IndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+///----------------------------------------------------------------------------
+///@returns the format of the full vertex stream
+///----------------------------------------------------------------------------
+Mesh::VertexFormat Mesh::GetFormat() const
+{
+	return m_Format;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bounds of the vertices in object space
+///----------------------------------------------------------------------------
+const AABB& Mesh::GetBounds() const
+{
+	return m_Bounds;
+}
+
+///----------------------------------------------------------------------------
+///@returns the metrics of the mesh as it was generated
+///----------------------------------------------------------------------------
+const Mesh::Stats& Mesh::GetOriginalStats() const
+{
+	return m_OriginalStats;
+}
+
+///----------------------------------------------------------------------------
+///@returns the metrics of the mesh as it's drawn
+///----------------------------------------------------------------------------
+const Mesh::Stats& Mesh::GetStats() const
+{
+	return m_Stats;
+}
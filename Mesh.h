@@ -0,0 +1,171 @@
+///============================================================================
+///@file	Mesh.h
+///@brief	Indexed triangle mesh generated in the demo (replaces the GLUT
+///			solids so we control the vertex layout). Every mesh keeps two
+///			vertex streams: the full vertex (position and normal) used by
+///			the lit passes and a tightly packed position-only stream for
+///			depth-only rendering, optionally quantized to 16 bits. The full
+///			vertex may be quantized too (16 bit positions and octahedral
+///			normals), it's then decoded by a vertex shader. A mesh can
+///			also draw streams it doesn't own, loaded from a scene file.
+///			The streams can be built on any thread (Prepare) and copied to
+///			the buffer objects a few bytes at a time (Stage), through a
+///			persistently mapped staging ring when there is one.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+#include "Culling.h"
+
+class UploadRing;
+
+class Mesh
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum VertexFormat
+	{
+		FLOAT_VERTEX = 0,	///> Float position and normal (24 bytes)
+		QUANTIZED_8,		///> 16 bit position, 2x8 bit octahedral normal (8 bytes)
+		QUANTIZED_16,		///> 16 bit position, 2x16 bit octahedral normal (12 bytes)
+		FORMAT_COUNT
+	};
+
+	struct ShaderParams
+	{
+		GLint normal;			///> Octahedral normal attribute
+		GLint positionScale;	///> Dequantization scale uniform
+		GLint positionOffset;	///> Dequantization offset uniform
+		GLint normalScale;		///> Octahedral normal scale uniform
+	};
+
+	struct Stats
+	{
+		GLfloat acmr;		///> Cache misses per triangle
+		GLfloat atvr;		///> Cache misses per vertex
+		GLfloat overdraw;	///> Fragments drawn per covered pixel
+	};
+
+	///Uploaded streams of a mesh, used to save them and to attach a mesh to
+	///streams kept elsewhere (i.e. a mapped scene file)
+	struct Streams
+	{
+		VertexFormat	format;				///> Format of the full vertices
+		UINT			vertexCount;		///> Number of vertices
+		UINT			indexCount;			///> Number of indices
+		UINT			stride;				///> Size of a full vertex
+		GLenum			indexType;			///> GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		bool			quantizedPositions;	///> Position stream uses 4 shorts
+		const GLvoid*	vertices;			///> Full vertex stream
+		const GLvoid*	positions;			///> Position-only stream
+		const GLvoid*	indices;			///> Triangle list
+		AABB			bounds;				///> Bounds of the vertices
+		GLfloat			dequantizeScale[3];	///> Quantized to object space scale
+		GLfloat			dequantizeOffset[3];///> Quantized to object space offset
+		Stats			originalStats;		///> Metrics of the generated order
+		Stats			stats;				///> Metrics of the current order
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	Mesh();
+	virtual ~Mesh();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void CreateCube(GLfloat size);
+	void CreateSphere(GLfloat radius, GLint slices, GLint stacks);
+	void CreateTorus(GLfloat innerRadius, GLfloat outerRadius, GLint sides, GLint rings);
+	void CreateCone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+	void CreateIndexed(const std::vector<GLfloat> &positions, const std::vector<GLfloat> &normals,
+					   const std::vector<GLuint> &indices);
+	void CreateSimplified(const Mesh &source, UINT gridSize, bool keepCreases);
+	void Analyze();
+	void Optimize();
+	void Prepare(VertexFormat format, bool quantizePositions);
+	void Upload(VertexFormat format, bool quantizePositions);
+	void BeginStaging();
+	UINT Stage(UINT maxBytes, UploadRing *ring = NULL);
+	bool IsStaged() const;
+	UINT GetStagingBytes() const;
+	void Attach(const Streams &streams);
+	void GetStreams(Streams &streams) const;
+	void Release();
+	void Draw(const ShaderParams *shader) const;
+	void DrawPositions() const;
+	bool Bind(const ShaderParams *shader) const;
+	bool BindPositions() const;
+	void DrawElements() const;
+	void DrawPositionElements() const;
+	UINT GetVertexCount() const;
+	UINT GetTriangleCount() const;
+	UINT GetVertexBytes() const;
+	UINT GetPositionBytes() const;
+	UINT GetIndexBytes() const;
+	VertexFormat GetFormat() const;
+	const AABB& GetBounds() const;
+	const Stats& GetOriginalStats() const;
+	const Stats& GetStats() const;
+
+	static void BeginDraw(bool positionsOnly, const ShaderParams *shader);
+	static void EndDraw(bool positionsOnly, const ShaderParams *shader);
+	static void EncodeOctahedral(const GLfloat n[3], GLfloat e[2]);
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Vertex
+	{
+		GLfloat position[3];	///> Object space position
+		GLfloat normal[3];		///> Unit normal
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void Clear();
+	void AddVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz);
+	void AddTriangle(GLuint a, GLuint b, GLuint c);
+	void CreateBuffers();
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<Vertex>		m_Vertices;		///> Full vertex stream
+	std::vector<GLfloat>	m_Positions;	///> Position-only stream (3 floats)
+	std::vector<GLshort>	m_Quantized;	///> Position-only stream (4 shorts)
+	std::vector<GLubyte>	m_Packed;		///> Quantized full vertex stream
+	std::vector<GLuint>		m_Indices;		///> Triangle list
+	std::vector<GLushort>	m_Indices16;	///> Triangle list with 16 bit indices
+	AABB	m_Bounds;				///> Bounds of the vertices
+	Stats	m_OriginalStats;		///> Metrics of the generated order
+	Stats	m_Stats;				///> Metrics of the current order
+	GLfloat	m_DequantizeScale[3];	///> Quantized to object space scale
+	GLfloat	m_DequantizeOffset[3];	///> Quantized to object space offset
+	bool	m_UseQuantized;			///> Position stream is quantized
+	VertexFormat m_Format;			///> Format of the full vertex stream
+	UINT	m_Stride;				///> Size of a full vertex
+	GLenum	m_IndexType;			///> GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	UINT	m_VertexCount;			///> Vertices in the drawn streams
+	UINT	m_IndexCount;			///> Indices in the drawn streams
+	const GLubyte* m_VertexData;	///> Drawn full vertex stream
+	const GLubyte* m_PositionData;	///> Drawn position-only stream
+	const GLubyte* m_IndexData;		///> Drawn triangle list
+	GLuint	m_VertexBuffer;			///> Buffer object of the full vertices
+	GLuint	m_PositionBuffer;		///> Buffer object of the positions
+	GLuint	m_IndexBuffer;			///> Buffer object of the indices
+	UINT	m_StagedBytes;			///> Bytes of the streams copied to the buffers
+};
+
+#endif
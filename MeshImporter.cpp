@@ -0,0 +1,944 @@
+///============================================================================
+///@file	MeshImporter.cpp
+///@brief	Imports Wavefront OBJ and Stanford PLY models into a Mesh.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+//corner index flags of an OBJ chunk (negative indices count back from
+//the last vertex read, which depends on the chunks before)
+static const BYTE RelativePosition	= 1;
+static const BYTE RelativeNormal	= 2;
+
+//exact powers of ten for the float parser
+static const double PowersOf10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//sizes of the PLY types
+static const UINT PlyTypeSize[MeshImporter::PLY_INVALID] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+///----------------------------------------------------------------------------
+///Skips blanks (not line ends)
+///----------------------------------------------------------------------------
+static inline const char* SkipBlanks(const char *p, const char *end)
+{
+	while(p < end && (*p == ' ' || *p == '\t')) p++;
+	return p;
+}
+
+///----------------------------------------------------------------------------
+///@returns the start of the next line
+///----------------------------------------------------------------------------
+static inline const char* NextLine(const char *p, const char *end)
+{
+	const char *eol = (const char *)memchr(p, '\n', end - p);
+	return eol ? eol + 1 : end;
+}
+
+///----------------------------------------------------------------------------
+///Parses a decimal number without going through the C runtime (strtod is
+///locale aware and several times slower)
+///@param	p - first character, leading blanks are skipped
+///@param	end - end of the buffer
+///@param	value - returned value
+///@returns the character after the number (p if there is no number)
+///----------------------------------------------------------------------------
+static const char* ParseFloat(const char *p, const char *end, GLfloat &value)
+{
+	p = SkipBlanks(p, end);
+	const char *start = p;
+
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+	double mantissa = 0.0;
+	int exponent = 0, digits = 0;
+
+	while(p < end && *p >= '0' && *p <= '9')
+	{
+		mantissa = mantissa * 10.0 + (*p++ - '0');
+		digits++;
+	}
+
+	if(p < end && *p == '.')
+	{
+		p++;
+		while(p < end && *p >= '0' && *p <= '9')
+		{
+			mantissa = mantissa * 10.0 + (*p++ - '0');
+			exponent--;
+			digits++;
+		}
+	}
+
+	if(digits == 0) return start;
+
+	if(p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char *e = p + 1;
+		bool negativeExp = false;
+		if(e < end && (*e == '-' || *e == '+')) negativeExp = *e++ == '-';
+
+		if(e < end && *e >= '0' && *e <= '9')
+		{
+			int n = 0;
+			while(e < end && *e >= '0' && *e <= '9') n = n * 10 + (*e++ - '0');
+			exponent += negativeExp ? -n : n;
+			p = e;
+		}
+	}
+
+	if(exponent < 0)
+		mantissa = exponent >= -22 ? mantissa / PowersOf10[-exponent] : mantissa * pow(10.0, exponent);
+	else if(exponent > 0)
+		mantissa = exponent <= 22 ? mantissa * PowersOf10[exponent] : mantissa * pow(10.0, exponent);
+
+	value = (GLfloat)(negative ? -mantissa : mantissa);
+	return p;
+}
+
+///----------------------------------------------------------------------------
+///Parses a decimal integer
+///@param	p - first character, leading blanks are skipped
+///@param	end - end of the buffer
+///@param	value - returned value
+///@returns the character after the number (p if there is no number)
+///----------------------------------------------------------------------------
+static const char* ParseInt(const char *p, const char *end, GLint &value)
+{
+	p = SkipBlanks(p, end);
+	const char *start = p;
+
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	if(p == end || *p < '0' || *p > '9') return start;
+
+	GLint n = 0;
+	while(p < end && *p >= '0' && *p <= '9') n = n * 10 + (*p++ - '0');
+
+	value = negative ? -n : n;
+	return p;
+}
+
+///----------------------------------------------------------------------------
+///Reads a binary PLY value
+///@param	p - the value
+///@param	type - its type
+///@param	swap - true if it's big endian
+///@returns the value
+///----------------------------------------------------------------------------
+static double ReadBinary(const char *p, MeshImporter::PlyType type, bool swap)
+{
+	BYTE bytes[8];
+	UINT size = PlyTypeSize[type];
+
+	for(UINT i=0; i<size; i++)
+		bytes[i] = (BYTE)p[swap ? size - 1 - i : i];
+
+	switch(type)
+	{
+	case MeshImporter::PLY_INT8:	return *(const signed char *)bytes;
+	case MeshImporter::PLY_UINT8:	return *(const unsigned char *)bytes;
+	case MeshImporter::PLY_INT16:	return *(const short *)bytes;
+	case MeshImporter::PLY_UINT16:	return *(const unsigned short *)bytes;
+	case MeshImporter::PLY_INT32:	return *(const int *)bytes;
+	case MeshImporter::PLY_UINT32:	return *(const unsigned int *)bytes;
+	case MeshImporter::PLY_FLOAT32:	return *(const float *)bytes;
+	case MeshImporter::PLY_FLOAT64:	return *(const double *)bytes;
+	default:						return 0.0;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Triangulates a convex polygon as a fan and appends its corners
+///@param	polygon - corners of the polygon
+///@param	flags - relative index flags of each corner
+///@param	chunk - chunk receiving the triangles
+///----------------------------------------------------------------------------
+static void AddPolygon(const std::vector<MeshImporter::Corner> &polygon, const std::vector<BYTE> &flags,
+					   MeshImporter::Chunk &chunk)
+{
+	for(UINT i=2; i<polygon.size(); i++)
+	{
+		chunk.corners.push_back(polygon[0]);
+		chunk.corners.push_back(polygon[i-1]);
+		chunk.corners.push_back(polygon[i]);
+		chunk.relative.push_back(flags[0]);
+		chunk.relative.push_back(flags[i-1]);
+		chunk.relative.push_back(flags[i]);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Parses the lines of an OBJ chunk. Only v, vn and f lines are used.
+///@param	param - the MeshImporter::Chunk
+///@returns 0
+///----------------------------------------------------------------------------
+static DWORD WINAPI ParseObjChunk(LPVOID param)
+{
+	MeshImporter::Chunk &chunk = *(MeshImporter::Chunk *)param;
+	const char *p = chunk.begin, *end = chunk.end;
+	std::vector<MeshImporter::Corner> polygon;
+	std::vector<BYTE> flags;
+
+	chunk.ok = true;
+
+	while(p < end)
+	{
+		p = SkipBlanks(p, end);
+		if(p + 1 >= end) break;
+
+		if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			GLfloat v[3] = {0.0f, 0.0f, 0.0f};
+			p += 1;
+			for(int k=0; k<3; k++) p = ParseFloat(p, end, v[k]);
+			chunk.positions.insert(chunk.positions.end(), v, v + 3);
+		}
+		else if(p[0] == 'v' && p[1] == 'n')
+		{
+			GLfloat n[3] = {0.0f, 0.0f, 0.0f};
+			p += 2;
+			for(int k=0; k<3; k++) p = ParseFloat(p, end, n[k]);
+			chunk.normalData.insert(chunk.normalData.end(), n, n + 3);
+		}
+		else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			GLint positions = (GLint)chunk.positions.size() / 3;
+			GLint normals = (GLint)chunk.normalData.size() / 3;
+
+			polygon.clear();
+			flags.clear();
+			p += 1;
+
+			//v, v/vt, v//vn or v/vt/vn
+			for(;;)
+			{
+				GLint v, vt, vn = 0;
+				const char *next = ParseInt(p, end, v);
+				if(next == p || v == 0) break;
+				p = next;
+
+				if(p < end && *p == '/')
+				{
+					p = ParseInt(p + 1, end, vt);
+					if(p < end && *p == '/') p = ParseInt(p + 1, end, vn);
+				}
+
+				MeshImporter::Corner c;
+				BYTE f = 0;
+				c.position = v > 0 ? v - 1 : positions + v;
+				if(v < 0) f |= RelativePosition;
+				c.normal = vn > 0 ? vn - 1 : (vn < 0 ? normals + vn : -1);
+				if(vn < 0) f |= RelativeNormal;
+
+				polygon.push_back(c);
+				flags.push_back(f);
+			}
+
+			if(polygon.size() >= 3)
+				AddPolygon(polygon, flags, chunk);
+			else
+				chunk.ok = false;
+		}
+
+		p = NextLine(p, end);
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Parses the records of a PLY vertex or face element chunk
+///@param	param - the MeshImporter::Chunk
+///@returns 0
+///----------------------------------------------------------------------------
+static DWORD WINAPI ParsePlyChunk(LPVOID param)
+{
+	MeshImporter::Chunk &chunk = *(MeshImporter::Chunk *)param;
+	const MeshImporter::PlyElement &element = *chunk.element;
+	const char *p = chunk.begin, *end = chunk.end;
+	std::vector<MeshImporter::Corner> polygon;
+	std::vector<BYTE> flags;
+
+	chunk.ok = true;
+
+	for(UINT r=0; chunk.binary ? r < chunk.records : p < end; r++)
+	{
+		GLfloat v[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+		const char *line = p;
+		polygon.clear();
+		flags.clear();
+
+		if(!chunk.binary)
+		{
+			p = SkipBlanks(p, end);
+			if(p == end || *p == '\n' || *p == '\r')
+			{
+				p = NextLine(p, end);
+				r--;
+				continue;
+			}
+		}
+
+		for(UINT i=0; i<element.properties.size() && chunk.ok; i++)
+		{
+			const MeshImporter::PlyProperty &prop = element.properties[i];
+
+			if(prop.countType == MeshImporter::PLY_INVALID)
+			{
+				GLfloat value = 0.0f;
+				if(chunk.binary)
+				{
+					if(p + PlyTypeSize[prop.type] > end) { chunk.ok = false; break; }
+					value = (GLfloat)ReadBinary(p, prop.type, chunk.swap);
+					p += PlyTypeSize[prop.type];
+				}
+				else
+				{
+					const char *next = ParseFloat(p, end, value);
+					if(next == p) { chunk.ok = false; break; }
+					p = next;
+				}
+
+				if(prop.role <= MeshImporter::ROLE_NZ) v[prop.role] = value;
+				continue;
+			}
+
+			//list: only the face indices are kept
+			GLint count = 0;
+			if(chunk.binary)
+			{
+				if(p + PlyTypeSize[prop.countType] > end) { chunk.ok = false; break; }
+				count = (GLint)ReadBinary(p, prop.countType, chunk.swap);
+				p += PlyTypeSize[prop.countType];
+			}
+			else
+			{
+				const char *next = ParseInt(p, end, count);
+				if(next == p) { chunk.ok = false; break; }
+				p = next;
+			}
+
+			for(GLint j=0; j<count; j++)
+			{
+				GLint index = 0;
+				if(chunk.binary)
+				{
+					if(p + PlyTypeSize[prop.type] > end) { chunk.ok = false; break; }
+					index = (GLint)ReadBinary(p, prop.type, chunk.swap);
+					p += PlyTypeSize[prop.type];
+				}
+				else
+				{
+					const char *next = ParseInt(p, end, index);
+					if(next == p) { chunk.ok = false; break; }
+					p = next;
+				}
+
+				if(prop.role == MeshImporter::ROLE_INDICES)
+				{
+					MeshImporter::Corner c;
+					c.position = index;
+					c.normal = chunk.normals ? index : -1;
+					polygon.push_back(c);
+					flags.push_back(0);
+				}
+			}
+		}
+
+		if(!chunk.ok) break;
+
+		if(element.vertex)
+		{
+			chunk.positions.insert(chunk.positions.end(), v, v + 3);
+			chunk.normalData.insert(chunk.normalData.end(), v + 3, v + 6);
+		}
+		else if(polygon.size() >= 3)
+		{
+			AddPolygon(polygon, flags, chunk);
+		}
+
+		if(!chunk.binary)
+		{
+			p = NextLine(p, end);
+			if(p == line) break;
+		}
+	}
+
+	chunk.relative.clear();
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Runs a parsing function over every chunk, one thread per chunk (the
+///first one runs on the calling thread)
+///@param	chunks - the chunks
+///@param	proc - ParseObjChunk or ParsePlyChunk
+///----------------------------------------------------------------------------
+static void RunParallel(std::vector<MeshImporter::Chunk> &chunks, LPTHREAD_START_ROUTINE proc)
+{
+	HANDLE threads[MeshImporter::MAX_THREADS];
+	UINT count = 0;
+
+	for(UINT i=1; i<chunks.size(); i++)
+	{
+		threads[count] = CreateThread(NULL, 0, proc, &chunks[i], 0, NULL);
+
+		//run it here if there are no threads left
+		if(threads[count])
+			count++;
+		else
+			proc(&chunks[i]);
+	}
+
+	if(!chunks.empty()) proc(&chunks[0]);
+
+	if(count) WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+	for(UINT i=0; i<count; i++)
+		CloseHandle(threads[i]);
+}
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+MeshImporter::MeshImporter() : m_Threads(1), m_Indexed(false)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+MeshImporter::~MeshImporter()
+{
+}
+
+///----------------------------------------------------------------------------
+///Imports an OBJ or PLY file (chosen by the extension)
+///@param	path - file name
+///@param	mesh - returned mesh (not uploaded)
+///@param	threads - parsing threads (0 for one per core)
+///@returns false if the file can't be read or has errors
+///----------------------------------------------------------------------------
+bool MeshImporter::Import(LPCSTR path, Mesh &mesh, UINT threads)
+{
+	double start = Profiler::GetTime();
+	memset(&m_Stats, 0, sizeof(m_Stats));
+
+	if(threads == 0)
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		threads = info.dwNumberOfProcessors;
+	}
+	m_Threads = (std::min)((std::max)(threads, 1U), MAX_THREADS);
+
+	MappedFile file;
+	if(!file.Open(path)) return false;
+
+	const char *data = (const char *)file.GetData();
+	UINT size = file.GetSize();
+	const char *extension = strrchr(path, '.');
+
+	m_Positions.clear();
+	m_Normals.clear();
+	m_Corners.clear();
+	m_Indexed = false;
+
+	bool ok = false;
+	if(extension && _stricmp(extension, ".obj") == 0)
+		ok = ImportOBJ(data, size);
+	else if(extension && _stricmp(extension, ".ply") == 0)
+		ok = ImportPLY(data, size);
+
+	ok = ok && BuildMesh(mesh);
+
+	//the parsed arrays aren't needed anymore
+	std::vector<GLfloat>().swap(m_Positions);
+	std::vector<GLfloat>().swap(m_Normals);
+	std::vector<Corner>().swap(m_Corners);
+
+	m_Stats.bytes = size;
+	m_Stats.ms = Profiler::GetTime() - start;
+	return ok;
+}
+
+///----------------------------------------------------------------------------
+///@returns the results of the last import
+///----------------------------------------------------------------------------
+const MeshImporter::Stats& MeshImporter::GetStats() const
+{
+	return m_Stats;
+}
+
+///----------------------------------------------------------------------------
+///@returns the import speed of the last import in MB/s
+///----------------------------------------------------------------------------
+double MeshImporter::GetThroughput() const
+{
+	return m_Stats.ms > 0.0 ? m_Stats.bytes / (1024.0 * 1024.0) / (m_Stats.ms / 1000.0) : 0.0;
+}
+
+///----------------------------------------------------------------------------
+///Splits a buffer into one chunk per thread, every chunk starts at a line
+///@param	begin - start of the buffer
+///@param	end - end of the buffer
+///@param	chunks - returned chunks
+///----------------------------------------------------------------------------
+void MeshImporter::SplitChunks(const char *begin, const char *end, std::vector<Chunk> &chunks)
+{
+	UINT size = (UINT)(end - begin);
+	UINT count = (std::min)(m_Threads, size / MIN_CHUNK + 1);
+
+	chunks.clear();
+	chunks.resize(count);
+
+	const char *p = begin;
+	for(UINT i=0; i<count; i++)
+	{
+		Chunk &chunk = chunks[i];
+		chunk.begin		= p;
+		chunk.end		= i+1 == count ? end : (std::max)(p, NextLine(begin + (UINT64)size * (i+1) / count, end));
+		chunk.records	= 0;
+		chunk.element	= NULL;
+		chunk.binary	= false;
+		chunk.swap		= false;
+		chunk.normals	= false;
+		chunk.ok		= true;
+		p = chunk.end;
+	}
+
+	m_Stats.threads = (std::max)(m_Stats.threads, count);
+}
+
+///----------------------------------------------------------------------------
+///Parses an OBJ file. Every chunk keeps its own vertices, relative (negative)
+///indices are resolved once the vertices before each chunk are known.
+///@returns false on syntax errors
+///----------------------------------------------------------------------------
+bool MeshImporter::ImportOBJ(const char *data, UINT size)
+{
+	std::vector<Chunk> chunks;
+	SplitChunks(data, data + size, chunks);
+	RunParallel(chunks, ParseObjChunk);
+
+	UINT positions = 0, normals = 0, corners = 0;
+	for(UINT i=0; i<chunks.size(); i++)
+	{
+		if(!chunks[i].ok) return false;
+		positions += (UINT)chunks[i].positions.size();
+		normals += (UINT)chunks[i].normalData.size();
+		corners += (UINT)chunks[i].corners.size();
+	}
+
+	m_Positions.reserve(positions);
+	m_Normals.reserve(normals);
+	m_Corners.reserve(corners);
+
+	for(UINT i=0; i<chunks.size(); i++)
+	{
+		Chunk &chunk = chunks[i];
+		GLint positionBase = (GLint)m_Positions.size() / 3;
+		GLint normalBase = (GLint)m_Normals.size() / 3;
+
+		for(UINT j=0; j<chunk.corners.size(); j++)
+		{
+			Corner c = chunk.corners[j];
+			if(chunk.relative[j] & RelativePosition) c.position += positionBase;
+			if(chunk.relative[j] & RelativeNormal) c.normal += normalBase;
+			m_Corners.push_back(c);
+		}
+
+		m_Positions.insert(m_Positions.end(), chunk.positions.begin(), chunk.positions.end());
+		m_Normals.insert(m_Normals.end(), chunk.normalData.begin(), chunk.normalData.end());
+
+		//free as we go, big files have big chunks
+		std::vector<GLfloat>().swap(chunk.positions);
+		std::vector<GLfloat>().swap(chunk.normalData);
+		std::vector<Corner>().swap(chunk.corners);
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Parses the header of a PLY file
+///@param	data - file contents
+///@param	size - file size
+///@param	elements - returned elements, with their records located
+///@param	binary - returned true for binary files
+///@param	swap - returned true for big endian files
+///@returns false if the header is invalid or an element can't be located
+///----------------------------------------------------------------------------
+bool MeshImporter::ParsePlyHeader(const char *data, UINT size, std::vector<PlyElement> &elements,
+								  bool &binary, bool &swap)
+{
+	static LPCSTR TypeNames[][2] =
+	{
+		{"char", "int8"}, {"uchar", "uint8"}, {"short", "int16"}, {"ushort", "uint16"},
+		{"int", "int32"}, {"uint", "uint32"}, {"float", "float32"}, {"double", "float64"}
+	};
+	static LPCSTR RoleNames[ROLE_INDICES] = {"x", "y", "z", "nx", "ny", "nz"};
+
+	const char *end = data + size;
+	if(size < 4 || strncmp(data, "ply", 3) != 0) return false;
+
+	const char *p = NextLine(data, end);
+	bool format = false;
+	binary = swap = false;
+	elements.clear();
+
+	for(;;)
+	{
+		if(p == end) return false;
+
+		//copy the line so sscanf/strcmp stop at its end
+		const char *next = NextLine(p, end);
+		char line[256], word[64], a[64], b[64], c[64];
+		UINT length = (std::min)((UINT)(next - p), (UINT)sizeof(line) - 1);
+		memcpy(line, p, length);
+		line[length] = '\0';
+		p = next;
+
+		if(sscanf(line, "%63s", word) != 1) continue;
+
+		if(strcmp(word, "end_header") == 0)
+			break;
+
+		if(strcmp(word, "format") == 0 && sscanf(line, "%*s %63s", a) == 1)
+		{
+			format = true;
+			binary = strcmp(a, "ascii") != 0;
+			swap = strcmp(a, "binary_big_endian") == 0;
+			if(binary && !swap && strcmp(a, "binary_little_endian") != 0) return false;
+		}
+		else if(strcmp(word, "element") == 0)
+		{
+			PlyElement element;
+			if(sscanf(line, "%*s %63s %u", a, &element.count) != 2) return false;
+
+			element.vertex = strcmp(a, "vertex") == 0;
+			element.face = strcmp(a, "face") == 0;
+			element.begin = element.end = NULL;
+			elements.push_back(element);
+		}
+		else if(strcmp(word, "property") == 0)
+		{
+			if(elements.empty()) return false;
+
+			PlyProperty prop;
+			prop.countType = PLY_INVALID;
+			prop.type = PLY_INVALID;
+			prop.role = ROLE_OTHER;
+
+			LPCSTR type, name;
+			if(sscanf(line, "%*s %63s", a) != 1) return false;
+
+			if(strcmp(a, "list") == 0)
+			{
+				if(sscanf(line, "%*s %*s %63s %63s %63s", a, b, c) != 3) return false;
+
+				for(int t=0; t<PLY_INVALID; t++)
+					if(strcmp(a, TypeNames[t][0]) == 0 || strcmp(a, TypeNames[t][1]) == 0)
+						prop.countType = (PlyType)t;
+
+				if(prop.countType == PLY_INVALID) return false;
+				type = b;
+				name = c;
+			}
+			else
+			{
+				if(sscanf(line, "%*s %*s %63s", b) != 1) return false;
+				type = a;
+				name = b;
+			}
+
+			for(int t=0; t<PLY_INVALID; t++)
+				if(strcmp(type, TypeNames[t][0]) == 0 || strcmp(type, TypeNames[t][1]) == 0)
+					prop.type = (PlyType)t;
+
+			if(prop.type == PLY_INVALID) return false;
+
+			if(prop.countType != PLY_INVALID)
+			{
+				if(strcmp(name, "vertex_indices") == 0 || strcmp(name, "vertex_index") == 0)
+					prop.role = ROLE_INDICES;
+			}
+			else
+			{
+				for(int r=0; r<ROLE_INDICES; r++)
+					if(strcmp(name, RoleNames[r]) == 0) prop.role = (PlyRole)r;
+			}
+
+			elements.back().properties.push_back(prop);
+		}
+	}
+
+	if(!format) return false;
+
+	//locate the records of every element, in order
+	for(UINT i=0; i<elements.size(); i++)
+	{
+		PlyElement &element = elements[i];
+		element.begin = p;
+
+		UINT stride = 0;
+		bool fixed = binary;
+		for(UINT j=0; j<element.properties.size(); j++)
+		{
+			if(element.properties[j].countType != PLY_INVALID) fixed = false;
+			stride += PlyTypeSize[element.properties[j].type];
+		}
+
+		if(fixed)
+		{
+			if((UINT64)stride * element.count > (UINT64)(end - p)) return false;
+			p += stride * element.count;
+		}
+		else if(!binary)
+		{
+			for(UINT r=0; r<element.count; r++)
+			{
+				if(p == end) return false;
+				p = NextLine(p, end);
+			}
+		}
+		else
+		{
+			//records with lists have to be walked
+			for(UINT r=0; r<element.count; r++)
+			{
+				for(UINT j=0; j<element.properties.size(); j++)
+				{
+					const PlyProperty &prop = element.properties[j];
+					UINT items = 1;
+
+					if(prop.countType != PLY_INVALID)
+					{
+						if(p + PlyTypeSize[prop.countType] > end) return false;
+						items = (UINT)ReadBinary(p, prop.countType, swap);
+						p += PlyTypeSize[prop.countType];
+					}
+
+					if((UINT64)items * PlyTypeSize[prop.type] > (UINT64)(end - p)) return false;
+					p += items * PlyTypeSize[prop.type];
+				}
+			}
+		}
+
+		element.end = p;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Parses a PLY file. ASCII elements are split by lines, binary vertices
+///(fixed size records) by record ranges; binary faces are walked by one
+///thread as each record has its own size.
+///@returns false on syntax errors
+///----------------------------------------------------------------------------
+bool MeshImporter::ImportPLY(const char *data, UINT size)
+{
+	std::vector<PlyElement> elements;
+	bool binary, swap;
+
+	if(!ParsePlyHeader(data, size, elements, binary, swap)) return false;
+
+	const PlyElement *vertex = NULL, *face = NULL;
+	for(UINT i=0; i<elements.size(); i++)
+	{
+		if(elements[i].vertex) vertex = &elements[i];
+		if(elements[i].face) face = &elements[i];
+	}
+	if(!vertex || !face) return false;
+	m_Indexed = true;
+
+	bool normals = false;
+	for(UINT j=0; j<vertex->properties.size(); j++)
+		if(vertex->properties[j].role == ROLE_NX) normals = true;
+
+	for(int pass=0; pass<2; pass++)
+	{
+		const PlyElement &element = pass == 0 ? *vertex : *face;
+		std::vector<Chunk> chunks;
+		SplitChunks(element.begin, element.end, chunks);
+
+		if(binary)
+		{
+			UINT stride = 0;
+			bool fixed = true;
+			for(UINT j=0; j<element.properties.size(); j++)
+			{
+				if(element.properties[j].countType != PLY_INVALID) fixed = false;
+				stride += PlyTypeSize[element.properties[j].type];
+			}
+
+			if(!fixed) chunks.resize(1);
+
+			UINT first = 0;
+			for(UINT i=0; i<chunks.size(); i++)
+			{
+				UINT records = fixed ? element.count * (i+1) / (UINT)chunks.size() - first : element.count;
+				chunks[i].begin = fixed ? element.begin + first * stride : element.begin;
+				chunks[i].end = element.end;
+				chunks[i].records = records;
+				first += records;
+			}
+		}
+
+		for(UINT i=0; i<chunks.size(); i++)
+		{
+			chunks[i].element = &element;
+			chunks[i].binary = binary;
+			chunks[i].swap = swap;
+			chunks[i].normals = normals;
+		}
+
+		RunParallel(chunks, ParsePlyChunk);
+
+		for(UINT i=0; i<chunks.size(); i++)
+		{
+			if(!chunks[i].ok) return false;
+
+			if(pass == 0)
+			{
+				m_Positions.insert(m_Positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+				if(normals)
+					m_Normals.insert(m_Normals.end(), chunks[i].normalData.begin(), chunks[i].normalData.end());
+			}
+			else
+			{
+				m_Corners.insert(m_Corners.end(), chunks[i].corners.begin(), chunks[i].corners.end());
+			}
+		}
+	}
+
+	return m_Positions.size() / 3 == vertex->count;
+}
+
+///----------------------------------------------------------------------------
+///Merges the corners into unique vertices (a corner is a position and a
+///normal index) and computes the normals the file doesn't have by
+///averaging the normals of the faces around each position
+///@param	mesh - returned mesh
+///@returns false if a corner references a missing position
+///----------------------------------------------------------------------------
+bool MeshImporter::BuildMesh(Mesh &mesh)
+{
+	GLint positionCount = (GLint)m_Positions.size() / 3;
+	GLint normalCount = (GLint)m_Normals.size() / 3;
+	if(m_Corners.empty()) return false;
+
+	std::vector<Corner> vertices;
+	std::vector<GLuint> indices(m_Corners.size());
+	bool missingNormals = false;
+
+	//PLY vertices are already unique, there's nothing to merge
+	if(m_Indexed)
+	{
+		vertices.resize(positionCount);
+		for(GLint i=0; i<positionCount; i++)
+		{
+			vertices[i].position = i;
+			vertices[i].normal = normalCount ? i : -1;
+		}
+
+		for(UINT i=0; i<m_Corners.size(); i++)
+		{
+			if(m_Corners[i].position < 0 || m_Corners[i].position >= positionCount) return false;
+			indices[i] = m_Corners[i].position;
+		}
+
+		missingNormals = normalCount == 0;
+	}
+
+	//open addressing table of corner -> vertex+1 (0 is empty)
+	UINT tableSize = 1024;
+	while(!m_Indexed && tableSize < m_Corners.size() * 2) tableSize *= 2;
+	std::vector<UINT> table(m_Indexed ? 0 : tableSize, 0);
+
+	for(UINT i=0; i<m_Corners.size() && !m_Indexed; i++)
+	{
+		Corner c = m_Corners[i];
+		if(c.position < 0 || c.position >= positionCount) return false;
+		if(c.normal >= normalCount) c.normal = -1;
+		if(c.normal < 0) missingNormals = true;
+
+		UINT h = ((UINT)c.position * 73856093u ^ (UINT)c.normal * 19349663u) & (tableSize - 1);
+		for(;;)
+		{
+			if(table[h] == 0)
+			{
+				vertices.push_back(c);
+				table[h] = (UINT)vertices.size();
+				break;
+			}
+
+			const Corner &v = vertices[table[h] - 1];
+			if(v.position == c.position && v.normal == c.normal) break;
+
+			h = (h + 1) & (tableSize - 1);
+		}
+
+		indices[i] = table[h] - 1;
+	}
+
+	//area weighted face normals around every position
+	std::vector<GLfloat> faceNormals;
+	if(missingNormals)
+	{
+		faceNormals.assign(m_Positions.size(), 0.0f);
+
+		for(UINT i=0; i+2<m_Corners.size(); i+=3)
+		{
+			const GLfloat *a = &m_Positions[m_Corners[i].position * 3];
+			const GLfloat *b = &m_Positions[m_Corners[i+1].position * 3];
+			const GLfloat *c = &m_Positions[m_Corners[i+2].position * 3];
+			GLfloat u[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+			GLfloat v[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+			GLfloat n[3] = {u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0]};
+
+			for(int k=0; k<3; k++)
+			{
+				GLfloat *f = &faceNormals[m_Corners[i+k].position * 3];
+				f[0] += n[0];
+				f[1] += n[1];
+				f[2] += n[2];
+			}
+		}
+	}
+
+	std::vector<GLfloat> positions(vertices.size() * 3), normals(vertices.size() * 3);
+	for(UINT i=0; i<vertices.size(); i++)
+	{
+		const Corner &c = vertices[i];
+		const GLfloat *n = c.normal >= 0 ? &m_Normals[c.normal * 3] : &faceNormals[c.position * 3];
+		GLfloat length = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+		for(int k=0; k<3; k++)
+		{
+			positions[i*3 + k] = m_Positions[c.position * 3 + k];
+			normals[i*3 + k] = length > 0.0f ? n[k] / length : (k == 1 ? 1.0f : 0.0f);
+		}
+	}
+
+	mesh.CreateIndexed(positions, normals, indices);
+
+	m_Stats.vertices = (UINT)vertices.size();
+	m_Stats.triangles = (UINT)indices.size() / 3;
+	m_Stats.generatedNormals = missingNormals;
+	return true;
+}
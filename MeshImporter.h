@@ -0,0 +1,130 @@
+///============================================================================
+///@file	MeshImporter.h
+///@brief	Imports Wavefront OBJ and Stanford PLY (ASCII or binary) models
+///			into a Mesh. The file is memory mapped and split into chunks
+///			parsed by several threads, corners are merged into unique
+///			vertices with a hash table and missing normals are computed
+///			from the faces.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef MESHIMPORTER_H
+#define MESHIMPORTER_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+#include "Mesh.h"
+
+class MeshImporter
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	struct Stats
+	{
+		UINT	bytes;				///> Size of the imported file
+		UINT	threads;			///> Threads used to parse it
+		UINT	vertices;			///> Unique vertices of the mesh
+		UINT	triangles;			///> Triangles of the mesh
+		bool	generatedNormals;	///> Some normals were computed
+		double	ms;					///> Time spent importing
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	MeshImporter();
+	virtual ~MeshImporter();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Import(LPCSTR path, Mesh &mesh, UINT threads = 0);
+	const Stats& GetStats() const;
+	double GetThroughput() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_THREADS = 8;			///> Max parsing threads
+	static const UINT MIN_CHUNK = 64 * 1024;	///> Smallest chunk worth a thread
+
+	//-------------------------------------------------------------------------
+	//Public types (parsing, used by the worker threads)
+	//-------------------------------------------------------------------------
+	struct Corner
+	{
+		GLint position;	///> Index of the position
+		GLint normal;	///> Index of the normal (-1 if none)
+	};
+
+	enum PlyType
+	{
+		PLY_INT8 = 0, PLY_UINT8, PLY_INT16, PLY_UINT16,
+		PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID
+	};
+
+	enum PlyRole
+	{
+		ROLE_X = 0, ROLE_Y, ROLE_Z, ROLE_NX, ROLE_NY, ROLE_NZ, ROLE_INDICES, ROLE_OTHER
+	};
+
+	struct PlyProperty
+	{
+		PlyType	type;		///> Value type (item type of lists)
+		PlyType	countType;	///> Type of the list count (PLY_INVALID if not a list)
+		PlyRole	role;		///> What we use the value for
+	};
+
+	struct PlyElement
+	{
+		UINT	count;						///> Number of records
+		bool	vertex;						///> "vertex" element
+		bool	face;						///> "face" element
+		std::vector<PlyProperty> properties;///> Properties of each record
+		const char*	begin;					///> First record in the file
+		const char*	end;					///> Past the last record
+	};
+
+	struct Chunk
+	{
+		const char*	begin;		///> First byte (or record) to parse
+		const char*	end;		///> Past the last byte
+		UINT		records;	///> Records to parse (binary PLY)
+		const PlyElement* element;	///> Element being parsed (PLY)
+		bool		binary;		///> Binary PLY
+		bool		swap;		///> Big endian PLY
+		bool		normals;	///> The PLY vertices have normals
+		bool		ok;			///> Parsed without errors
+		std::vector<GLfloat>	positions;	///> Parsed positions
+		std::vector<GLfloat>	normalData;	///> Parsed normals
+		std::vector<Corner>		corners;	///> Triangle corners
+		std::vector<BYTE>		relative;	///> OBJ: corner indices relative to the chunk
+	};
+
+private:
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	bool ImportOBJ(const char *data, UINT size);
+	bool ImportPLY(const char *data, UINT size);
+	bool ParsePlyHeader(const char *data, UINT size, std::vector<PlyElement> &elements,
+						bool &binary, bool &swap);
+	void SplitChunks(const char *begin, const char *end, std::vector<Chunk> &chunks);
+	bool BuildMesh(Mesh &mesh);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<GLfloat>	m_Positions;	///> Positions of the file
+	std::vector<GLfloat>	m_Normals;		///> Normals of the file
+	std::vector<Corner>		m_Corners;		///> 3 corners per triangle
+	UINT					m_Threads;		///> Threads used for this import
+	bool					m_Indexed;		///> Corners are vertex indices (PLY)
+	Stats					m_Stats;		///> Results of the last import
+};
+
+#endif
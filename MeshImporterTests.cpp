@@ -0,0 +1,302 @@
+///============================================================================
+///@file	MeshImporterTests.cpp
+///@brief	Imports the small OBJ/PLY fixtures of TestData and files written
+///			here (binary PLY of both byte orders, an OBJ big enough to be
+///			split between threads) and checks the meshes they give.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Tests.h"
+#include "MeshImporter.h"
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+static const UINT GridSize = 160;	//vertices per side of the generated OBJ
+
+///----------------------------------------------------------------------------
+///Gets the float vertices (position and normal) and the triangle list of
+///an imported mesh
+///----------------------------------------------------------------------------
+static void GetVertices(Mesh &mesh, std::vector<GLfloat> &vertices, std::vector<GLuint> &indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	mesh.Prepare(Mesh::FLOAT_VERTEX, false);
+	Mesh::Streams streams;
+	mesh.GetStreams(streams);
+	if(!streams.indexCount) return;
+
+	const GLfloat *v = (const GLfloat *)streams.vertices;
+	vertices.assign(v, v + streams.vertexCount * 6);
+
+	indices.resize(streams.indexCount);
+	for(UINT i=0; i<streams.indexCount; i++)
+	{
+		indices[i] = streams.indexType == GL_UNSIGNED_SHORT ? ((const GLushort *)streams.indices)[i] :
+															  ((const GLuint *)streams.indices)[i];
+	}
+}
+
+///----------------------------------------------------------------------------
+///@returns true if every normal has unit length
+///----------------------------------------------------------------------------
+static bool NormalsAreUnit(const std::vector<GLfloat> &vertices)
+{
+	for(UINT i=0; i+5<vertices.size(); i+=6)
+	{
+		const GLfloat *n = &vertices[i + 3];
+		if(fabsf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2] - 1.0f) > 1e-4f) return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if a vertex has the given position and normal
+///----------------------------------------------------------------------------
+static bool IsVertex(const std::vector<GLfloat> &vertices, UINT vertex, GLfloat x, GLfloat y, GLfloat z,
+					 GLfloat nx, GLfloat ny, GLfloat nz)
+{
+	const GLfloat expected[6] = {x, y, z, nx, ny, nz};
+	if(vertices.size() < (vertex + 1) * 6) return false;
+
+	for(int k=0; k<6; k++)
+		if(fabsf(vertices[vertex * 6 + k] - expected[k]) > 1e-4f) return false;
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Appends a binary PLY value in the file byte order
+///----------------------------------------------------------------------------
+static void AppendValue(std::vector<BYTE> &bytes, const void *value, UINT size, bool bigEndian)
+{
+	const BYTE *b = (const BYTE *)value;
+	for(UINT i=0; i<size; i++)
+		bytes.push_back(b[bigEndian ? size - 1 - i : i]);
+}
+
+///----------------------------------------------------------------------------
+///Writes a binary PLY holding a quad and a triangle
+///@param	path - file name
+///@param	bigEndian - byte order of the file
+///@param	cut - bytes left out at the end of the file
+///----------------------------------------------------------------------------
+static void WriteBinaryPly(LPCSTR path, bool bigEndian, UINT cut)
+{
+	static const GLfloat Positions[4][3] = {{0, 0, 0}, {2, 0, 0}, {2, 3, 0}, {0, 3, 1}};
+	static const int Faces[] = {4, 0, 1, 2, 3, 3, 1, 3, 0};
+
+	std::vector<BYTE> bytes;
+	char header[512];
+	_snprintf(header, sizeof(header),
+			  "ply\nformat %s 1.0\nelement vertex 4\nproperty float x\nproperty float y\n"
+			  "property double z\nproperty short flags\nelement face 2\n"
+			  "property list uchar int vertex_indices\nend_header\n",
+			  bigEndian ? "binary_big_endian" : "binary_little_endian");
+	header[sizeof(header) - 1] = '\0';
+	bytes.insert(bytes.end(), header, header + strlen(header));
+
+	for(UINT i=0; i<4; i++)
+	{
+		double z = Positions[i][2];
+		short flags = (short)i;
+		AppendValue(bytes, &Positions[i][0], sizeof(float), bigEndian);
+		AppendValue(bytes, &Positions[i][1], sizeof(float), bigEndian);
+		AppendValue(bytes, &z, sizeof(double), bigEndian);
+		AppendValue(bytes, &flags, sizeof(short), bigEndian);
+	}
+
+	for(UINT i=0; i<sizeof(Faces) / sizeof(Faces[0]);)
+	{
+		BYTE count = (BYTE)Faces[i++];
+		bytes.push_back(count);
+		for(BYTE j=0; j<count; j++)
+			AppendValue(bytes, &Faces[i++], sizeof(int), bigEndian);
+	}
+
+	FILE *file = fopen(path, "wb");
+	if(!file) return;
+	fwrite(&bytes[0], 1, bytes.size() - cut, file);
+	fclose(file);
+}
+
+///----------------------------------------------------------------------------
+///Writes a grid of GridSize x GridSize vertices whose faces follow every
+///row of vertices and reference them with relative indices
+///@param	path - file name
+///----------------------------------------------------------------------------
+static void WriteGridObj(LPCSTR path)
+{
+	FILE *file = fopen(path, "wb");
+	if(!file) return;
+
+	fprintf(file, "vn 0 0 1\n");
+	for(UINT r=0; r<GridSize; r++)
+	{
+		for(UINT c=0; c<GridSize; c++)
+			fprintf(file, "v %.6f %.6f %.6f\n", c * 0.25f, r * 0.25f, (GLfloat)((r * 7 + c * 3) % 11) * 0.01f);
+
+		for(UINT c=0; r>0 && c+1<GridSize; c++)
+		{
+			int below = -(int)(2 * GridSize - c), above = -(int)(GridSize - c);
+			fprintf(file, "f %d//1 %d//1 %d//1 %d//1\n", below, below + 1, above + 1, above);
+		}
+	}
+
+	fclose(file);
+}
+
+///----------------------------------------------------------------------------
+///Checks the OBJ fixtures
+///----------------------------------------------------------------------------
+static void CheckObj()
+{
+	MeshImporter importer;
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	char path[MAX_PATH];
+
+	//quads without normals: one vertex per position, normals computed
+	Mesh cube;
+	GetTestFile("cube.obj", path);
+	CHECK(importer.Import(path, cube, 1));
+	CHECK(importer.GetStats().vertices == 8);
+	CHECK(importer.GetStats().triangles == 12);
+	CHECK(importer.GetStats().generatedNormals);
+
+	GetVertices(cube, vertices, indices);
+	CHECK(vertices.size() == 8 * 6 && indices.size() == 36);
+	CHECK(NormalsAreUnit(vertices));
+	CHECK(cube.GetBounds().min[0] == -1.0f && cube.GetBounds().max[2] == 1.0f);
+
+	bool outwards = true;
+	for(UINT i=0; i+5<vertices.size(); i+=6)
+	{
+		const GLfloat *v = &vertices[i];
+		if(v[0]*v[3] + v[1]*v[4] + v[2]*v[5] <= 0.0f) outwards = false;
+	}
+	CHECK(outwards);
+
+	//relative indices, a position used with two normals is two vertices
+	Mesh quad;
+	GetTestFile("quad.obj", path);
+	CHECK(importer.Import(path, quad, 1));
+	CHECK(importer.GetStats().vertices == 7);
+	CHECK(importer.GetStats().triangles == 3);
+	CHECK(!importer.GetStats().generatedNormals);
+
+	GetVertices(quad, vertices, indices);
+	static const GLuint QuadIndices[] = {0, 1, 2, 0, 2, 3, 4, 5, 6};
+	CHECK(indices.size() == 9 && memcmp(&indices[0], QuadIndices, sizeof(QuadIndices)) == 0);
+	CHECK(IsVertex(vertices, 2, 1.5f, 2.5f, 0.0f, 0.0f, 0.0f, 1.0f));
+	CHECK(IsVertex(vertices, 5, 1.5f, 2.5f, 0.0f, 0.0f, 0.0f, -1.0f));
+
+	//errors
+	Mesh mesh;
+	GetTestFile("broken.obj", path);
+	CHECK(!importer.Import(path, mesh, 1));
+	GetTestFile("line.obj", path);
+	CHECK(!importer.Import(path, mesh, 1));
+	GetTestFile("missing.obj", path);
+	CHECK(!importer.Import(path, mesh, 1));
+}
+
+///----------------------------------------------------------------------------
+///Checks the PLY fixtures and binary files of both byte orders
+///----------------------------------------------------------------------------
+static void CheckPly()
+{
+	MeshImporter importer;
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	char path[MAX_PATH];
+
+	//the vertices are kept as they are, with their normals
+	Mesh tetrahedron;
+	GetTestFile("tetrahedron.ply", path);
+	CHECK(importer.Import(path, tetrahedron, 1));
+	CHECK(importer.GetStats().vertices == 4);
+	CHECK(importer.GetStats().triangles == 4);
+	CHECK(!importer.GetStats().generatedNormals);
+
+	GetVertices(tetrahedron, vertices, indices);
+	static const GLuint TetrahedronIndices[] = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+	CHECK(indices.size() == 12 && memcmp(&indices[0], TetrahedronIndices, sizeof(TetrahedronIndices)) == 0);
+	CHECK(IsVertex(vertices, 0, 0.0f, 0.0f, 0.0f, -0.57735f, -0.57735f, -0.57735f));
+	CHECK(IsVertex(vertices, 3, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f));
+
+	GetTestFile("noheader.ply", path);
+	CHECK(!importer.Import(path, tetrahedron, 1));
+
+	//binary, the quad is split in two triangles
+	for(int order=0; order<2; order++)
+	{
+		Mesh mesh;
+		GetTestFile("binary.ply", path);
+		WriteBinaryPly(path, order == 1, 0);
+		CHECK(importer.Import(path, mesh, 1));
+		CHECK(importer.GetStats().vertices == 4);
+		CHECK(importer.GetStats().triangles == 3);
+		CHECK(importer.GetStats().generatedNormals);
+
+		GetVertices(mesh, vertices, indices);
+		static const GLuint BinaryIndices[] = {0, 1, 2, 0, 2, 3, 1, 3, 0};
+		CHECK(indices.size() == 9 && memcmp(&indices[0], BinaryIndices, sizeof(BinaryIndices)) == 0);
+		CHECK(vertices.size() == 24 && vertices[12] == 2.0f && vertices[13] == 3.0f && vertices[20] == 1.0f);
+		CHECK(NormalsAreUnit(vertices));
+
+		//the last face is cut short
+		WriteBinaryPly(path, order == 1, 2);
+		CHECK(!importer.Import(path, mesh, 1));
+		remove(path);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Imports a file split between threads and compares it with the same file
+///imported by one thread
+///----------------------------------------------------------------------------
+static void CheckThreads()
+{
+	char path[MAX_PATH];
+	GetTestFile("grid.obj", path);
+	WriteGridObj(path);
+
+	MeshImporter importer;
+	Mesh single, parallel;
+	CHECK(importer.Import(path, single, 1));
+	CHECK(importer.GetStats().threads == 1);
+
+	CHECK(importer.Import(path, parallel, 4));
+	CHECK(importer.GetStats().threads == 4);
+	CHECK(importer.GetStats().vertices == GridSize * GridSize);
+	CHECK(importer.GetStats().triangles == 2 * (GridSize - 1) * (GridSize - 1));
+	remove(path);
+
+	std::vector<GLfloat> singleVertices, parallelVertices;
+	std::vector<GLuint> singleIndices, parallelIndices;
+	GetVertices(single, singleVertices, singleIndices);
+	GetVertices(parallel, parallelVertices, parallelIndices);
+	CHECK(parallelVertices == singleVertices);
+	CHECK(parallelIndices == singleIndices);
+
+	//the first face starts at the first vertex, the last one reaches the
+	//far corner of the grid
+	const AABB &bounds = parallel.GetBounds();
+	CHECK(IsVertex(parallelVertices, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+	CHECK(bounds.max[0] == (GridSize - 1) * 0.25f && bounds.max[1] == (GridSize - 1) * 0.25f);
+}
+
+///----------------------------------------------------------------------------
+///Checks the MeshImporter
+///----------------------------------------------------------------------------
+void TestMeshImporter()
+{
+	CheckObj();
+	CheckPly();
+	CheckThreads();
+}
@@ -0,0 +1,460 @@
+///============================================================================
+///@file	MeshOptimizer.cpp
+///@brief	Vertex cache, overdraw and vertex fetch optimization of meshes.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "MeshOptimizer.h"
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+///----------------------------------------------------------------------------
+///A group of consecutive triangles which is moved as a whole by the
+///overdraw optimization
+///----------------------------------------------------------------------------
+struct Cluster
+{
+	UINT	first;	///> First triangle
+	UINT	count;	///> Number of triangles
+	GLfloat	sort;	///> How much the cluster faces away from the mesh center
+
+	bool operator<(const Cluster &c) const
+	{
+		return sort > c.sort;
+	}
+};
+
+///----------------------------------------------------------------------------
+///Forsyth's vertex score: vertices in the cache are preferred (the last
+///triangle's ones a bit less, they'd be reused by strips anyway) and so
+///are vertices with few triangles left, so no lonely triangles are left
+///behind.
+///@param	cachePosition - position in the simulated LRU cache (-1 if out)
+///@param	remaining - triangles not yet emitted which use the vertex
+///@returns the vertex score
+///----------------------------------------------------------------------------
+GLfloat MeshOptimizer::VertexScore(int cachePosition, UINT remaining)
+{
+	if(remaining == 0) return -1.0f;
+
+	GLfloat score = 0.0f;
+	if(cachePosition >= 0)
+	{
+		if(cachePosition < 3)
+			score = 0.75f;
+		else
+			score = powf(1.0f - (cachePosition - 3) / (GLfloat)(FORSYTH_CACHE - 3), 1.5f);
+	}
+
+	return score + 2.0f / sqrtf((GLfloat)remaining);
+}
+
+///----------------------------------------------------------------------------
+///Reorders the triangles for the post-transform vertex cache (Tom Forsyth,
+///"Linear-Speed Vertex Cache Optimisation")
+///@param	indices - triangle list, reordered in place
+///@param	vertexCount - number of vertices referenced
+///----------------------------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint> &indices, UINT vertexCount)
+{
+	UINT triangleCount = (UINT)indices.size() / 3;
+	if(triangleCount == 0) return;
+
+	//triangles using each vertex
+	std::vector<UINT> remaining(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(indices.size());
+	for(UINT i=0; i<indices.size(); i++)
+		remaining[indices[i]]++;
+
+	for(UINT v=0; v<vertexCount; v++)
+		offsets[v+1] = offsets[v] + remaining[v];
+
+	std::vector<UINT> fill(offsets.begin(), offsets.end() - 1);
+	for(UINT i=0; i<indices.size(); i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<GLfloat> vertexScore(vertexCount), triangleScore(triangleCount, 0.0f);
+	std::vector<bool> emitted(triangleCount, false);
+
+	for(UINT v=0; v<vertexCount; v++)
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+
+	for(UINT t=0; t<triangleCount; t++)
+	{
+		for(int k=0; k<3; k++)
+			triangleScore[t] += vertexScore[indices[t*3 + k]];
+	}
+
+	std::vector<GLuint> result;
+	result.reserve(indices.size());
+
+	std::vector<UINT> cache, newCache;
+	UINT cursor = 0;
+
+	while(result.size() < indices.size())
+	{
+		//best triangle around the cached vertices
+		UINT best = triangleCount;
+		GLfloat bestScore = -FLT_MAX;
+
+		for(UINT c=0; c<cache.size(); c++)
+		{
+			UINT v = cache[c];
+			for(UINT a=offsets[v]; a<offsets[v+1]; a++)
+			{
+				UINT t = adjacency[a];
+				if(!emitted[t] && triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					best = t;
+				}
+			}
+		}
+
+		//nothing connected to the cache, take the next triangle left
+		if(best == triangleCount)
+		{
+			while(emitted[cursor]) cursor++;
+			best = cursor;
+		}
+
+		emitted[best] = true;
+
+		//emit it and move its vertices to the front of the cache
+		newCache.clear();
+		for(int k=0; k<3; k++)
+		{
+			UINT v = indices[best*3 + k];
+			result.push_back(v);
+			newCache.push_back(v);
+			remaining[v]--;
+		}
+
+		for(UINT c=0; c<cache.size(); c++)
+		{
+			UINT v = cache[c];
+			if(v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache.push_back(v);
+		}
+
+		//vertices pushed out of the cache lose their cache score
+		for(UINT c=FORSYTH_CACHE; c<newCache.size(); c++)
+			cachePosition[newCache[c]] = -1;
+		if(newCache.size() > FORSYTH_CACHE) newCache.resize(FORSYTH_CACHE);
+		cache.swap(newCache);
+
+		//update the scores of the cached vertices and their triangles
+		for(UINT c=0; c<cache.size(); c++)
+			cachePosition[cache[c]] = (int)c;
+
+		for(UINT c=0; c<cache.size(); c++)
+		{
+			UINT v = cache[c];
+			GLfloat score = VertexScore(cachePosition[v], remaining[v]);
+			GLfloat delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			for(UINT a=offsets[v]; a<offsets[v+1]; a++)
+				triangleScore[adjacency[a]] += delta;
+		}
+
+		//and the ones which just left the cache
+		for(UINT c=0; c<newCache.size(); c++)
+		{
+			UINT v = newCache[c];
+			if(cachePosition[v] >= 0) continue;
+
+			GLfloat score = VertexScore(-1, remaining[v]);
+			GLfloat delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			for(UINT a=offsets[v]; a<offsets[v+1]; a++)
+				triangleScore[adjacency[a]] += delta;
+		}
+	}
+
+	indices.swap(result);
+}
+
+///----------------------------------------------------------------------------
+///Reorders clusters of triangles so the ones facing away from the mesh
+///center (which usually hide the rest) are drawn first. Clusters start
+///where the cache optimized order misses all three vertices, so cache
+///efficiency is mostly kept (Sander et al. "Fast Triangle Reordering for
+///Vertex Locality and Reduced Overdraw"). Run it after OptimizeVertexCache.
+///@param	indices - triangle list, reordered in place
+///@param	positions - first vertex position
+///@param	stride - distance between positions (in floats)
+///@param	vertexCount - number of vertices
+///@param	threshold - max ACMR increase allowed (i.e. 1.05 = 5%)
+///----------------------------------------------------------------------------
+void MeshOptimizer::OptimizeOverdraw(std::vector<GLuint> &indices, const GLfloat *positions,
+									 UINT stride, UINT vertexCount, GLfloat threshold)
+{
+	UINT triangleCount = (UINT)indices.size() / 3;
+	if(triangleCount < 2) return;
+
+	//split where the FIFO cache is restarted
+	std::vector<Cluster> clusters;
+	std::vector<UINT> stamp(vertexCount, 0);
+	UINT time = CACHE_SIZE + 1;
+
+	for(UINT t=0; t<triangleCount; t++)
+	{
+		int misses = 0;
+		for(int k=0; k<3; k++)
+		{
+			UINT v = indices[t*3 + k];
+			if(time - stamp[v] > CACHE_SIZE)
+			{
+				stamp[v] = time++;
+				misses++;
+			}
+		}
+
+		if(misses == 3 || clusters.empty())
+		{
+			Cluster c = {t, 0, 0.0f};
+			clusters.push_back(c);
+		}
+		clusters.back().count++;
+	}
+
+	if(clusters.size() < 2) return;
+
+	//mesh centroid
+	GLfloat center[3] = {0.0f, 0.0f, 0.0f};
+	for(UINT v=0; v<vertexCount; v++)
+	{
+		for(int k=0; k<3; k++)
+			center[k] += positions[v*stride + k] / vertexCount;
+	}
+
+	//sort clusters by how much their average normal points away from it
+	for(UINT i=0; i<clusters.size(); i++)
+	{
+		Cluster &c = clusters[i];
+		GLfloat centroid[3] = {0.0f, 0.0f, 0.0f}, normal[3] = {0.0f, 0.0f, 0.0f}, area = 0.0f;
+
+		for(UINT t=c.first; t<c.first + c.count; t++)
+		{
+			const GLfloat *p0 = &positions[indices[t*3 + 0] * stride];
+			const GLfloat *p1 = &positions[indices[t*3 + 1] * stride];
+			const GLfloat *p2 = &positions[indices[t*3 + 2] * stride];
+
+			GLfloat e1[3] = {p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]};
+			GLfloat e2[3] = {p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2]};
+			GLfloat n[3] = {e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0]};
+			GLfloat a = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+			for(int k=0; k<3; k++)
+			{
+				centroid[k] += a * (p0[k] + p1[k] + p2[k]) / 3.0f;
+				normal[k] += n[k];
+			}
+			area += a;
+		}
+
+		GLfloat len = sqrtf(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+		c.sort = 0.0f;
+		if(area > 0.0f && len > 0.0f)
+		{
+			for(int k=0; k<3; k++)
+				c.sort += (centroid[k] / area - center[k]) * normal[k] / len;
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end());
+
+	std::vector<GLuint> result;
+	result.reserve(indices.size());
+	for(UINT i=0; i<clusters.size(); i++)
+	{
+		result.insert(result.end(), indices.begin() + clusters[i].first * 3,
+					  indices.begin() + (clusters[i].first + clusters[i].count) * 3);
+	}
+
+	//keep the new order only if the cache doesn't suffer too much
+	GLfloat before, after;
+	AnalyzeVertexCache(indices, vertexCount, &before, NULL);
+	AnalyzeVertexCache(result, vertexCount, &after, NULL);
+
+	if(after <= before * threshold)
+		indices.swap(result);
+}
+
+///----------------------------------------------------------------------------
+///Renumbers the vertices in the order they are first used so the vertex
+///fetch reads memory sequentially. Unused vertices are moved to the end.
+///@param	indices - triangle list, renumbered in place
+///@param	vertexCount - number of vertices
+///@param	remap - returned new index of every old vertex
+///----------------------------------------------------------------------------
+void MeshOptimizer::OptimizeVertexFetch(std::vector<GLuint> &indices, UINT vertexCount,
+										std::vector<GLuint> &remap)
+{
+	const GLuint Unused = 0xFFFFFFFF;
+	remap.assign(vertexCount, Unused);
+
+	GLuint next = 0;
+	for(UINT i=0; i<indices.size(); i++)
+	{
+		GLuint &v = remap[indices[i]];
+		if(v == Unused) v = next++;
+		indices[i] = v;
+	}
+
+	for(UINT v=0; v<vertexCount; v++)
+	{
+		if(remap[v] == Unused) remap[v] = next++;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Simulates a FIFO post-transform cache of CACHE_SIZE entries
+///@param	indices - triangle list
+///@param	vertexCount - number of vertices
+///@param	acmr - returned average cache misses per triangle (0.5 is ideal)
+///@param	atvr - returned average transformed vertices per vertex (1.0 is
+///			ideal), may be NULL
+///----------------------------------------------------------------------------
+void MeshOptimizer::AnalyzeVertexCache(const std::vector<GLuint> &indices, UINT vertexCount,
+									   GLfloat *acmr, GLfloat *atvr)
+{
+	std::vector<UINT> stamp(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	UINT time = CACHE_SIZE + 1, misses = 0, unique = 0;
+
+	for(UINT i=0; i<indices.size(); i++)
+	{
+		UINT v = indices[i];
+		if(time - stamp[v] > CACHE_SIZE)
+		{
+			stamp[v] = time++;
+			misses++;
+		}
+
+		if(!used[v])
+		{
+			used[v] = true;
+			unique++;
+		}
+	}
+
+	UINT triangles = (UINT)indices.size() / 3;
+	if(acmr) *acmr = triangles ? (GLfloat)misses / triangles : 0.0f;
+	if(atvr) *atvr = unique ? (GLfloat)misses / unique : 0.0f;
+}
+
+///----------------------------------------------------------------------------
+///Measures overdraw by rasterizing the mesh (back faces culled) from the
+///six axis directions with a depth test, like the GPU would.
+///@param	indices - triangle list
+///@param	positions - first vertex position
+///@param	stride - distance between positions (in floats)
+///@param	vertexCount - number of vertices
+///@returns fragments which passed the depth test per covered pixel (1.0
+///			means no overdraw at all)
+///----------------------------------------------------------------------------
+GLfloat MeshOptimizer::AnalyzeOverdraw(const std::vector<GLuint> &indices, const GLfloat *positions,
+									   UINT stride, UINT vertexCount)
+{
+	if(indices.empty() || vertexCount == 0) return 0.0f;
+
+	//fit the mesh in the views
+	GLfloat lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(UINT v=0; v<vertexCount; v++)
+	{
+		for(int k=0; k<3; k++)
+		{
+			lo[k] = (std::min)(lo[k], positions[v*stride + k]);
+			hi[k] = (std::max)(hi[k], positions[v*stride + k]);
+		}
+	}
+
+	GLfloat extent = (std::max)(hi[0] - lo[0], (std::max)(hi[1] - lo[1], hi[2] - lo[2]));
+	if(extent <= 0.0f) return 0.0f;
+
+	GLfloat scale = (OVERDRAW_SIZE - 1) / extent;
+	std::vector<GLfloat> depth(OVERDRAW_SIZE * OVERDRAW_SIZE);
+	UINT covered = 0, drawn = 0;
+
+	for(int axis=0; axis<3; axis++)
+	{
+		for(int side=0; side<2; side++)
+		{
+			std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+			//look down the axis, mirror x when looking from the other
+			//side so front faces stay counter-clockwise
+			int ax = (axis + 1) % 3, ay = (axis + 2) % 3;
+			GLfloat flip = side ? -1.0f : 1.0f;
+
+			for(UINT t=0; t<indices.size() / 3; t++)
+			{
+				GLfloat v[3][3];
+				for(int k=0; k<3; k++)
+				{
+					const GLfloat *p = &positions[indices[t*3 + k] * stride];
+					v[k][0] = side ? (hi[ax] - p[ax]) * scale : (p[ax] - lo[ax]) * scale;
+					v[k][1] = (p[ay] - lo[ay]) * scale;
+					v[k][2] = flip * (lo[axis] - p[axis]);
+				}
+
+				RasterizeOverdraw(v, depth, &covered, &drawn);
+			}
+		}
+	}
+
+	return covered ? (GLfloat)drawn / covered : 0.0f;
+}
+
+///----------------------------------------------------------------------------
+///Rasterizes a front facing triangle for AnalyzeOverdraw
+///@param	v - vertices (x, y in pixels, z is the view distance)
+///@param	depth - depth buffer
+///@param	covered - incremented for every pixel covered the first time
+///@param	drawn - incremented for every fragment passing the depth test
+///----------------------------------------------------------------------------
+void MeshOptimizer::RasterizeOverdraw(const GLfloat v[3][3], std::vector<GLfloat> &depth,
+									  UINT *covered, UINT *drawn)
+{
+	GLfloat area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) -
+				   (v[2][0] - v[0][0]) * (v[1][1] - v[0][1]);
+	if(area <= 0.0f) return;
+
+	int x0 = (std::max)(0, (int)floor((std::min)(v[0][0], (std::min)(v[1][0], v[2][0]))));
+	int x1 = (std::min)(OVERDRAW_SIZE - 1, (int)ceil((std::max)(v[0][0], (std::max)(v[1][0], v[2][0]))));
+	int y0 = (std::max)(0, (int)floor((std::min)(v[0][1], (std::min)(v[1][1], v[2][1]))));
+	int y1 = (std::min)(OVERDRAW_SIZE - 1, (int)ceil((std::max)(v[0][1], (std::max)(v[1][1], v[2][1]))));
+
+	for(int y=y0; y<=y1; y++)
+	{
+		GLfloat py = y + 0.5f;
+
+		for(int x=x0; x<=x1; x++)
+		{
+			GLfloat px = x + 0.5f;
+			GLfloat w[3];
+			for(int k=0; k<3; k++)
+			{
+				const GLfloat *a = v[(k+1) % 3], *b = v[(k+2) % 3];
+				w[k] = (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+			}
+
+			if(w[0] < 0.0f || w[1] < 0.0f || w[2] < 0.0f) continue;
+
+			GLfloat z = (w[0]*v[0][2] + w[1]*v[1][2] + w[2]*v[2][2]) / area;
+			GLfloat &d = depth[y * OVERDRAW_SIZE + x];
+
+			if(z < d)
+			{
+				if(d == FLT_MAX) (*covered)++;
+				(*drawn)++;
+				d = z;
+			}
+		}
+	}
+}
@@ -0,0 +1,518 @@
+///============================================================================
+///@file	MultiDraw.cpp
+///@brief	GPU-driven submission of the recorded passes.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "MultiDraw.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include <string.h>
+
+//size of a float full vertex (position and normal)
+static const UINT VertexStride = 6 * sizeof(GLfloat);
+
+//Camera passes: what the quantized vertex shader does (light0 with color
+//material, a specular highlight and the eye-linear texgen of the shadow
+//map), with the transform and the color of the draw read from the draw
+//buffer instead of the modelview matrix and glColor, and the camera and
+//shadow matrices from the frame block
+static const char CameraVertexShader[] =
+	"#version 430 compatibility\n"
+	"#extension GL_ARB_shader_draw_parameters : require\n"
+	"\n"
+	"struct Draw\n"
+	"{\n"
+	"	mat4 world;\n"
+	"	vec4 normal[3];\n"
+	"	vec4 color;\n"
+	"};\n"
+	"\n"
+	"layout(std430, binding = 0) readonly buffer Draws\n"
+	"{\n"
+	"	Draw draws[];\n"
+	"};\n"
+	"\n"
+	"layout(std140, binding = 0) uniform Frame\n"
+	"{\n"
+	"	mat4 cameraView;\n"
+	"	mat4 cameraViewProjection;\n"
+	"	mat4 lightViewProjection;\n"
+	"	mat4 shadowMatrix;\n"
+	"};\n"
+	"\n"
+	"uniform bool lightEnabled;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	Draw draw = draws[gl_DrawIDARB];\n"
+	"	vec4 position = draw.world * gl_Vertex;\n"
+	"	vec4 eye = cameraView * position;\n"
+	"	gl_Position = cameraViewProjection * position;\n"
+	"\n"
+	"	vec4 color = draw.color * gl_LightModel.ambient;\n"
+	"	if(lightEnabled)\n"
+	"	{\n"
+	"		mat3 normalMatrix = mat3(draw.normal[0].xyz, draw.normal[1].xyz, draw.normal[2].xyz);\n"
+	"		vec3 N = normalize(mat3(cameraView) * (normalMatrix * gl_Normal));\n"
+	"		vec3 L = normalize(gl_LightSource[0].position.xyz - eye.xyz * gl_LightSource[0].position.w);\n"
+	"		vec3 H = normalize(L + vec3(0.0, 0.0, 1.0));\n"
+	"		float NdotL = max(dot(N, L), 0.0);\n"
+	"\n"
+	"		color += draw.color * (gl_LightSource[0].ambient + gl_LightSource[0].diffuse * NdotL);\n"
+	"		if(NdotL > 0.0)\n"
+	"			color += gl_FrontMaterial.specular * gl_LightSource[0].specular *\n"
+	"					 pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);\n"
+	"	}\n"
+	"	gl_FrontColor = vec4(clamp(color.rgb, 0.0, 1.0), draw.color.a);\n"
+	"\n"
+	"	gl_TexCoord[0] = shadowMatrix * position;\n"
+	"}\n";
+
+//Shadow pass: only the position is needed
+static const char ShadowVertexShader[] =
+	"#version 430 compatibility\n"
+	"#extension GL_ARB_shader_draw_parameters : require\n"
+	"\n"
+	"struct Draw\n"
+	"{\n"
+	"	mat4 world;\n"
+	"	vec4 normal[3];\n"
+	"	vec4 color;\n"
+	"};\n"
+	"\n"
+	"layout(std430, binding = 0) readonly buffer Draws\n"
+	"{\n"
+	"	Draw draws[];\n"
+	"};\n"
+	"\n"
+	"layout(std140, binding = 0) uniform Frame\n"
+	"{\n"
+	"	mat4 cameraView;\n"
+	"	mat4 cameraViewProjection;\n"
+	"	mat4 lightViewProjection;\n"
+	"	mat4 shadowMatrix;\n"
+	"};\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = lightViewProjection * (draws[gl_DrawIDARB].world * gl_Vertex);\n"
+	"}\n";
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+MultiDraw::MultiDraw() : m_VertexBuffer(0), m_IndexBuffer(0), m_VertexBytes(0),
+						 m_IndexBytes(0), m_LightEnabled(-1), m_Ring(NULL), m_FrameBuffer(0)
+{
+	for(UINT i=0; i<PASS_COUNT; i++)
+	{
+		m_Passes[i].commandBuffer = m_Passes[i].commandSource = 0;
+		m_Passes[i].drawBuffer = m_Passes[i].drawSource = 0;
+		m_Passes[i].commandOffset = m_Passes[i].drawOffset = 0;
+		m_Passes[i].uploaded = false;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+MultiDraw::~MultiDraw()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the context can draw a pass with one indirect call and
+///read the draw index in the vertex shader
+///----------------------------------------------------------------------------
+bool MultiDraw::IsSupported()
+{
+	return g_GLCaps.multiDrawIndirect;
+}
+
+///----------------------------------------------------------------------------
+///Copies the meshes of the scene to the shared buffers and creates the
+///shaders and the per-pass buffers (the context must be current). Call
+///again whenever meshes are added.
+///@param	geometry - the scene
+///@param	ring - per-frame upload memory for the arrays and the frame
+///			block (NULL to upload to buffers of our own)
+///@returns false if multi-draw can't be used: no support, or meshes which
+///			are not float vertices with 32 bit indices (quantized formats)
+///----------------------------------------------------------------------------
+bool MultiDraw::Create(const Geometry &geometry, UploadRing *ring)
+{
+	Release();
+	if(!IsSupported()) return false;
+
+	m_Ring = ring && ring->IsValid() ? ring : NULL;
+
+	//every mesh has to share the vertex layout and the index type
+	UINT vertexCount = 0, indexCount = 0;
+	for(UINT i=0; i<geometry.GetMeshCount(); i++)
+	{
+		Mesh::Streams streams;
+		geometry.GetMesh(i)->GetStreams(streams);
+		if(streams.indexCount == 0) continue;
+
+		if(streams.format != Mesh::FLOAT_VERTEX || streams.stride != VertexStride ||
+		   streams.indexType != GL_UNSIGNED_INT || !streams.vertices || !streams.indices)
+			return false;
+
+		vertexCount += streams.vertexCount;
+		indexCount += streams.indexCount;
+	}
+
+	if(indexCount == 0) return false;
+
+	if(!m_Shaders[CAMERA_PASS].Create(CameraVertexShader, NULL) ||
+	   !m_Shaders[SHADOW_PASS].Create(ShadowVertexShader, NULL))
+	{
+		Release();
+		return false;
+	}
+	m_LightEnabled = m_Shaders[CAMERA_PASS].GetUniform("lightEnabled");
+
+	m_VertexBytes = vertexCount * VertexStride;
+	m_IndexBytes = indexCount * sizeof(GLuint);
+
+	glGenBuffersARB(1, &m_VertexBuffer);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_VertexBuffer);
+	glBufferDataARB(GL_ARRAY_BUFFER_ARB, m_VertexBytes, NULL, GL_STATIC_DRAW_ARB);
+
+	glGenBuffersARB(1, &m_IndexBuffer);
+	g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer);
+	glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBytes, NULL, GL_STATIC_DRAW_ARB);
+
+	//the meshes follow each other, the indices stay relative to the mesh
+	//and the base vertex of its draws moves them to its vertices
+	MeshRange range = {0, 0, 0};
+	for(UINT i=0; i<geometry.GetMeshCount(); i++)
+	{
+		const Mesh *mesh = geometry.GetMesh(i);
+		Mesh::Streams streams;
+		mesh->GetStreams(streams);
+		if(streams.indexCount == 0) continue;
+
+		range.indexCount = streams.indexCount;
+		m_Ranges[mesh] = range;
+
+		glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, range.baseVertex * VertexStride,
+						   streams.vertexCount * VertexStride, streams.vertices);
+		glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, range.firstIndex * sizeof(GLuint),
+						   streams.indexCount * sizeof(GLuint), streams.indices);
+
+		range.baseVertex += streams.vertexCount;
+		range.firstIndex += streams.indexCount;
+	}
+
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+	g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+
+	for(UINT i=0; i<PASS_COUNT; i++)
+	{
+		glGenBuffersARB(1, &m_Passes[i].commandBuffer);
+		glGenBuffersARB(1, &m_Passes[i].drawBuffer);
+		m_Passes[i].uploaded = false;
+	}
+	glGenBuffersARB(1, &m_FrameBuffer);
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the buffers and the shaders (the context must be current)
+///----------------------------------------------------------------------------
+void MultiDraw::Release()
+{
+	m_Ranges.clear();
+
+	for(UINT i=0; i<PASS_COUNT; i++)
+	{
+		PassData &data = m_Passes[i];
+		if(data.commandBuffer)
+		{
+			g_GLState.DeleteBuffer(data.commandBuffer);
+			g_GLState.DeleteBuffer(data.drawBuffer);
+			glDeleteBuffersARB(1, &data.commandBuffer);
+			glDeleteBuffersARB(1, &data.drawBuffer);
+		}
+
+		data.commandBuffer = data.drawBuffer = 0;
+		data.commands.clear();
+		data.draws.clear();
+		data.uploaded = false;
+
+		m_Shaders[i].Release();
+	}
+
+	if(m_VertexBuffer)
+	{
+		g_GLState.DeleteBuffer(m_VertexBuffer);
+		g_GLState.DeleteBuffer(m_IndexBuffer);
+		glDeleteBuffersARB(1, &m_VertexBuffer);
+		glDeleteBuffersARB(1, &m_IndexBuffer);
+	}
+
+	if(m_FrameBuffer)
+	{
+		g_GLState.DeleteBuffer(m_FrameBuffer);
+		glDeleteBuffersARB(1, &m_FrameBuffer);
+	}
+
+	m_VertexBuffer = m_IndexBuffer = m_FrameBuffer = 0;
+	m_VertexBytes = m_IndexBytes = 0;
+	m_LightEnabled = -1;
+	m_Ring = NULL;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if Create succeeded
+///----------------------------------------------------------------------------
+bool MultiDraw::IsValid() const
+{
+	return m_VertexBuffer != 0;
+}
+
+///----------------------------------------------------------------------------
+///Fills the arrays of a pass from its sorted draws (doesn't touch OpenGL,
+///the conditional draws are left to Geometry::Execute)
+///@param	pass - the pass the draws were recorded for
+///@param	queue - the sorted draws
+///----------------------------------------------------------------------------
+void MultiDraw::Build(RenderPass pass, const DrawQueue &queue)
+{
+	PassData &data = m_Passes[pass];
+	data.commands.clear();
+	data.draws.clear();
+	data.uploaded = false;
+
+	for(UINT i=0; i<queue.GetCount(); i++)
+		Add(queue.GetCommand(i), data);
+}
+
+///----------------------------------------------------------------------------
+///Fills the arrays of a pass from its command buffers, in recorded order
+///@param	pass - the pass the draws were recorded for
+///@param	buffers - the recorded buffers
+///@param	count - number of buffers
+///----------------------------------------------------------------------------
+void MultiDraw::Build(RenderPass pass, const CommandBuffer *buffers, UINT count)
+{
+	PassData &data = m_Passes[pass];
+	data.commands.clear();
+	data.draws.clear();
+	data.uploaded = false;
+
+	for(UINT b=0; b<count; b++)
+	{
+		for(UINT i=0; i<buffers[b].GetCount(); i++)
+			Add(buffers[b].GetCommand(i), data);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Uploads the matrices of the frame and binds them to the Frame block of
+///the shaders, call once per frame before the first pass is drawn
+///@param	frame - the matrices
+///----------------------------------------------------------------------------
+void MultiDraw::SetFrame(const FrameData &frame)
+{
+	if(!IsValid()) return;
+
+	GLintptr offset;
+	void *memory = m_Ring ? m_Ring->Allocate(GL_UNIFORM_BUFFER, sizeof(FrameData), &offset) : NULL;
+	if(memory)
+	{
+		memcpy(memory, &frame, sizeof(FrameData));
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_Ring->GetBuffer(), offset, sizeof(FrameData));
+		return;
+	}
+
+	g_GLState.BindBuffer(GL_UNIFORM_BUFFER, m_FrameBuffer);
+	glBufferDataARB(GL_UNIFORM_BUFFER, sizeof(FrameData), &frame, GL_STREAM_DRAW_ARB);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_FrameBuffer);
+}
+
+///----------------------------------------------------------------------------
+///Appends a recorded draw to the arrays of a pass
+///@param	command - the recorded command (other kinds are skipped)
+///@param	data - the pass
+///----------------------------------------------------------------------------
+void MultiDraw::Add(const CommandBuffer::Command &command, PassData &data) const
+{
+	if(command.type != CommandBuffer::DRAW_MESH && command.type != CommandBuffer::DRAW_POSITIONS)
+		return;
+
+	RangeMap::const_iterator it = m_Ranges.find(command.mesh);
+	if(it == m_Ranges.end()) return;
+
+	const MeshRange &range = it->second;
+	IndirectCommand indirect = {range.indexCount, 1, range.firstIndex, range.baseVertex, 0};
+	data.commands.push_back(indirect);
+
+	data.draws.resize(data.draws.size() + 1);
+	DrawData &draw = data.draws.back();
+	memcpy(draw.world, command.world, sizeof(draw.world));
+
+	//the base is scaled unevenly, the normals can't use the world matrix
+	Matrix4::GetNormalMatrix(command.world, draw.normal);
+
+	for(UINT i=0; i<4; i++)
+		draw.color[i] = command.color[i] / 255.0f;
+}
+
+///----------------------------------------------------------------------------
+///Copies the arrays of a pass to this frame's part of the upload ring. If
+///there is no ring or it's full they go to the pass' buffers instead, the
+///previous contents are orphaned so the driver doesn't wait for the last
+///frame's draws.
+///@param	data - the pass
+///----------------------------------------------------------------------------
+void MultiDraw::Upload(PassData &data)
+{
+	UINT commandBytes = (UINT)data.commands.size() * sizeof(IndirectCommand);
+	UINT drawBytes = (UINT)data.draws.size() * sizeof(DrawData);
+	data.uploaded = true;
+
+	void *commands = NULL, *draws = NULL;
+	if(m_Ring)
+	{
+		commands = m_Ring->Allocate(GL_DRAW_INDIRECT_BUFFER, commandBytes, &data.commandOffset);
+		if(commands) draws = m_Ring->Allocate(GL_SHADER_STORAGE_BUFFER, drawBytes, &data.drawOffset);
+	}
+
+	if(commands && draws)
+	{
+		memcpy(commands, &data.commands[0], commandBytes);
+		memcpy(draws, &data.draws[0], drawBytes);
+		data.commandSource = data.drawSource = m_Ring->GetBuffer();
+		return;
+	}
+
+	data.commandSource = data.commandBuffer;
+	data.drawSource = data.drawBuffer;
+	data.commandOffset = data.drawOffset = 0;
+
+	g_GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, data.commandBuffer);
+	glBufferDataARB(GL_DRAW_INDIRECT_BUFFER, data.commands.size() * sizeof(IndirectCommand),
+					&data.commands[0], GL_STREAM_DRAW_ARB);
+
+	g_GLState.BindBuffer(GL_SHADER_STORAGE_BUFFER, data.drawBuffer);
+	glBufferDataARB(GL_SHADER_STORAGE_BUFFER, data.draws.size() * sizeof(DrawData),
+					&data.draws[0], GL_STREAM_DRAW_ARB);
+}
+
+///----------------------------------------------------------------------------
+///Draws the arrays built for a pass with a single indirect call. The first
+///call of the frame uploads them, the camera pass is drawn twice.
+///@param	pass - the pass to draw
+///@param	stats - counters added to (may be NULL)
+///----------------------------------------------------------------------------
+void MultiDraw::Draw(RenderPass pass, DrawStats *stats)
+{
+	PassData &data = m_Passes[pass];
+	if(data.commands.empty()) return;
+
+	if(!data.uploaded) Upload(data);
+
+	BeginPass(pass, data.drawSource, data.drawOffset, data.draws.size() * sizeof(DrawData));
+	g_GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, data.commandSource);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const GLvoid *)data.commandOffset,
+								(GLsizei)data.commands.size(), 0);
+	EndPass(pass);
+
+	if(stats)
+	{
+		stats->draws += (UINT)data.commands.size();
+		stats->meshChanges++;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Draws indirect commands written by the GPU, the number of draws is read
+///from a buffer as well (GL_ARB_indirect_parameters)
+///@param	pass - the pass to draw
+///@param	commands - buffer of indirect commands
+///@param	draws - buffer of per-draw data (same layout as the Build arrays)
+///@param	parameters - buffer holding the draw counts
+///@param	countIndex - index of the pass' count in parameters (GLuint)
+///@param	maxDraws - size of the command buffer in commands
+///----------------------------------------------------------------------------
+void MultiDraw::DrawCount(RenderPass pass, GLuint commands, GLuint draws, GLuint parameters,
+						  UINT countIndex, UINT maxDraws)
+{
+	if(maxDraws == 0) return;
+
+	BeginPass(pass, draws, 0, 0);
+	g_GLState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commands);
+	g_GLState.BindBuffer(GL_PARAMETER_BUFFER_ARB, parameters);
+	glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, NULL,
+										countIndex * sizeof(GLuint), (GLsizei)maxDraws, 0);
+	EndPass(pass);
+}
+
+///----------------------------------------------------------------------------
+///Binds the shader and the shared buffers of a pass
+///@param	pass - the pass about to be drawn
+///@param	draws - buffer of per-draw data read by the shader
+///@param	offset - where the per-draw data starts in the buffer
+///@param	size - size of the per-draw data (0 for the whole buffer)
+///----------------------------------------------------------------------------
+void MultiDraw::BeginPass(RenderPass pass, GLuint draws, GLintptr offset, GLsizeiptr size)
+{
+	bool positionsOnly = pass == SHADOW_PASS;
+	m_Shaders[pass].Bind();
+	if(!positionsOnly) glUniform1i(m_LightEnabled, g_GLState.IsEnabled(GL_LIGHT0));
+
+	Mesh::BeginDraw(positionsOnly, NULL);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_VertexBuffer);
+	g_GLState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB, m_IndexBuffer);
+	glVertexPointer(3, GL_FLOAT, VertexStride, NULL);
+	if(!positionsOnly) glNormalPointer(GL_FLOAT, VertexStride, (const GLvoid *)(3*sizeof(GLfloat)));
+
+	if(size)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, draws, offset, size);
+	else
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, draws);
+}
+
+///----------------------------------------------------------------------------
+///Disables what BeginPass enabled
+///@param	pass - the pass just drawn
+///----------------------------------------------------------------------------
+void MultiDraw::EndPass(RenderPass pass)
+{
+	Mesh::EndDraw(pass == SHADOW_PASS, NULL);
+	Shader::Unbind();
+}
+
+///----------------------------------------------------------------------------
+///Finds where a mesh is in the shared buffers
+///@param	mesh - the mesh
+///@param	firstIndex - returned first index
+///@param	indexCount - returned number of indices
+///@param	baseVertex - returned first vertex
+///@returns false if the mesh is not in the shared buffers
+///----------------------------------------------------------------------------
+bool MultiDraw::GetRange(const Mesh *mesh, GLuint *firstIndex, GLuint *indexCount,
+						 GLint *baseVertex) const
+{
+	RangeMap::const_iterator it = m_Ranges.find(mesh);
+	if(it == m_Ranges.end()) return false;
+
+	*firstIndex = it->second.firstIndex;
+	*indexCount = it->second.indexCount;
+	*baseVertex = it->second.baseVertex;
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size of the shared vertex and index buffers
+///----------------------------------------------------------------------------
+UINT MultiDraw::GetBufferBytes() const
+{
+	return m_VertexBytes + m_IndexBytes;
+}
@@ -0,0 +1,138 @@
+///============================================================================
+///@file	MultiDraw.h
+///@brief	GPU-driven submission of the recorded passes. Every mesh is
+///			copied into one shared vertex buffer and one shared index
+///			buffer, the draws of a pass become an array of indirect
+///			commands plus an array of per-draw data (world transform,
+///			normal matrix and color) and the whole pass is sent with a
+///			single glMultiDrawElementsIndirect. The vertex shader finds its
+///			draw's data with gl_DrawIDARB, so the GL calls of a pass don't
+///			depend on the number of objects. The arrays are filled without
+///			touching OpenGL (any thread) and uploaded by the first Draw of
+///			the frame, into the upload ring when there is one. The arrays
+///			can also be written by the GPU (see GPUCulling) and drawn with
+///			the count it wrote. The camera and light matrices come from a
+///			per-frame uniform block instead of the matrix stacks.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef MULTIDRAW_H
+#define MULTIDRAW_H
+
+#include <windows.h>
+#include <vector>
+#include <map>
+#include <GL/gl.h>
+#include "Geometry.h"
+#include "Shader.h"
+#include "UploadRing.h"
+
+class MultiDraw
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///Per-frame matrices, std140 layout of the Frame block in the shaders
+	struct FrameData
+	{
+		GLfloat	cameraView[16];				///> Camera view matrix
+		GLfloat	cameraViewProjection[16];	///> Camera projection * view
+		GLfloat	lightViewProjection[16];	///> Light projection * view
+		GLfloat	shadowMatrix[16];			///> World to shadow map coordinates
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	MultiDraw();
+	virtual ~MultiDraw();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(const Geometry &geometry, UploadRing *ring = NULL);
+	void Release();
+	bool IsValid() const;
+	void Build(RenderPass pass, const DrawQueue &queue);
+	void Build(RenderPass pass, const CommandBuffer *buffers, UINT count);
+	void SetFrame(const FrameData &frame);
+	void Draw(RenderPass pass, DrawStats *stats = NULL);
+	void DrawCount(RenderPass pass, GLuint commands, GLuint draws, GLuint parameters,
+				   UINT countIndex, UINT maxDraws);
+	bool GetRange(const Mesh *mesh, GLuint *firstIndex, GLuint *indexCount, GLint *baseVertex) const;
+	UINT GetBufferBytes() const;
+
+	static bool IsSupported();
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///Layout read by glMultiDrawElementsIndirect
+	struct IndirectCommand
+	{
+		GLuint	count;			///> Indices of the draw
+		GLuint	instanceCount;	///> Always 1
+		GLuint	firstIndex;		///> First index in the shared index buffer
+		GLint	baseVertex;		///> Added to every index
+		GLuint	baseInstance;	///> Unused
+	};
+
+	///Per-draw data, std430 layout of the Draw struct in the shaders
+	struct DrawData
+	{
+		GLfloat	world[16];		///> Object to world transform
+		GLfloat	normal[12];		///> Normal matrix (3 columns padded to vec4)
+		GLfloat	color[4];		///> Object color
+	};
+
+	///Place of a mesh in the shared buffers
+	struct MeshRange
+	{
+		GLuint	firstIndex;		///> First index
+		GLuint	indexCount;		///> Number of indices
+		GLint	baseVertex;		///> First vertex
+	};
+
+	///Arrays and buffers of one pass
+	struct PassData
+	{
+		std::vector<IndirectCommand> commands;	///> Indirect commands of the frame
+		std::vector<DrawData> draws;			///> Per-draw data of the frame
+		GLuint	commandBuffer;					///> GL_DRAW_INDIRECT_BUFFER
+		GLuint	drawBuffer;						///> GL_SHADER_STORAGE_BUFFER
+		GLuint	commandSource;					///> Buffer holding the frame's commands
+		GLintptr commandOffset;					///> Where they start in it
+		GLuint	drawSource;						///> Buffer holding the frame's draws
+		GLintptr drawOffset;					///> Where they start in it
+		bool	uploaded;						///> Buffers hold the arrays
+	};
+
+	typedef std::map<const Mesh*, MeshRange> RangeMap;
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void Add(const CommandBuffer::Command &command, PassData &data) const;
+	void Upload(PassData &data);
+	void BeginPass(RenderPass pass, GLuint draws, GLintptr offset, GLsizeiptr size);
+	void EndPass(RenderPass pass);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	RangeMap	m_Ranges;				///> Place of every mesh in the shared buffers
+	GLuint		m_VertexBuffer;			///> Shared full vertices (float position and normal)
+	GLuint		m_IndexBuffer;			///> Shared 32 bit indices
+	UINT		m_VertexBytes;			///> Size of the shared vertices
+	UINT		m_IndexBytes;			///> Size of the shared indices
+	Shader		m_Shaders[PASS_COUNT];	///> Vertex shader of each pass
+	GLint		m_LightEnabled;			///> lightEnabled uniform of the camera shader
+	PassData	m_Passes[PASS_COUNT];	///> Per-frame arrays of each pass
+	UploadRing*	m_Ring;					///> Per-frame upload memory (may be NULL)
+	GLuint		m_FrameBuffer;			///> Frame block when the ring is full or missing
+};
+
+#endif
@@ -0,0 +1,279 @@
+///============================================================================
+///@file	OcclusionCulling.cpp
+///@brief	Camera pass occlusion culling with hardware occlusion queries.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "OcclusionCulling.h"
+#include "GLStateCache.h"
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+OcclusionCuller::OcclusionCuller() : m_Frame(0), m_Occluded(0), m_Queries(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+///----------------------------------------------------------------------------
+///Allocates the per-object visibility state.
+///@param	objectCount - number of objects in the scene
+///@returns false if occlusion queries are not supported
+///----------------------------------------------------------------------------
+bool OcclusionCuller::Init(UINT objectCount)
+{
+	if(!g_GLCaps.occlusionQuery) return false;
+
+	ObjectState state;
+	state.query		= 0;
+	state.lastFrame	= 0;
+	state.visible	= true;
+	state.pending	= false;
+
+	m_States.assign(objectCount, state);
+	m_Pending.clear();
+	m_Frame = 0;
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Releases the query objects, the GL context must still be current.
+///----------------------------------------------------------------------------
+void OcclusionCuller::Shutdown()
+{
+	for(UINT i=0; i<m_States.size(); i++)
+	{
+		if(m_States[i].query) glDeleteQueriesARB(1, &m_States[i].query);
+	}
+
+	m_States.clear();
+	m_Pending.clear();
+}
+
+///----------------------------------------------------------------------------
+///Reads back the query results that are ready. Queries complete in the
+///order they were issued, so we stop at the first one that is not.
+///----------------------------------------------------------------------------
+void OcclusionCuller::ReadResults()
+{
+	UINT done = 0;
+
+	for(; done<m_Pending.size(); done++)
+	{
+		ObjectState &state = m_States[m_Pending[done]];
+
+		GLuint available = 0;
+		glGetQueryObjectuivARB(state.query, GL_QUERY_RESULT_AVAILABLE_ARB, &available);
+		if(!available) break;
+
+		GLuint samples = 0;
+		glGetQueryObjectuivARB(state.query, GL_QUERY_RESULT_ARB, &samples);
+
+		state.visible = samples > VISIBLE_PIXEL_THRESHOLD;
+		state.pending = false;
+	}
+
+	m_Pending.erase(m_Pending.begin(), m_Pending.begin() + done);
+}
+
+///----------------------------------------------------------------------------
+///Decides which of the frustum visible objects are drawn this frame.
+///@param	geometry - the scene
+///@param	candidates - objects inside the camera frustum
+///@param	cameraPos - camera position in world space
+///----------------------------------------------------------------------------
+void OcclusionCuller::Select(const Geometry &geometry, const std::vector<UINT> &candidates,
+							 const GLfloat cameraPos[3])
+{
+	m_Frame++;
+	m_Drawn.clear();
+	m_Conditional.clear();
+	m_Occluded = 0;
+
+	ReadResults();
+
+	for(UINT i=0; i<candidates.size(); i++)
+	{
+		UINT obj = candidates[i];
+		ObjectState &state = m_States[obj];
+
+		//objects coming back into the frustum have stale visibility,
+		//assume they are visible until a new query says otherwise
+		if(state.lastFrame + 1 != m_Frame && !state.pending)
+			state.visible = true;
+		state.lastFrame = m_Frame;
+
+		if(state.visible || IsInside(geometry.GetBounds(obj), cameraPos))
+		{
+			m_Drawn.push_back(obj);
+		}
+		else if(state.pending && g_GLCaps.conditionalRender)
+		{
+			//the answer is not back yet, let the GPU decide with the
+			//query already in flight instead of trusting an old result
+			m_Conditional.push_back(obj);
+		}
+		else
+		{
+			m_Occluded++;
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Records the objects whose query is still in flight, each one drawn only
+///if its query finds samples. The rest of the selected objects are recorded
+///by the caller (see GetDrawn).
+///@param	geometry - the scene
+///@param	buffer - receives the commands
+///----------------------------------------------------------------------------
+void OcclusionCuller::RecordConditional(const Geometry &geometry, CommandBuffer &buffer) const
+{
+	for(UINT i=0; i<m_Conditional.size(); i++)
+	{
+		UINT obj = m_Conditional[i];
+
+		buffer.BeginConditional(m_States[obj].query);
+		geometry.RecordObject(obj, CAMERA_PASS, buffer);
+		buffer.EndConditional();
+	}
+}
+
+///----------------------------------------------------------------------------
+///Issues bounding box queries once the camera passes have filled the depth
+///buffer. Occluded objects are checked every frame, visible ones only every
+///VISIBLE_QUERY_INTERVAL frames (staggered so the work is spread evenly).
+///The results are read in the next frame.
+///@param	geometry - the scene
+///@param	candidates - objects inside the camera frustum
+///@param	cameraPos - camera position in world space
+///----------------------------------------------------------------------------
+void OcclusionCuller::IssueQueries(const Geometry &geometry, const std::vector<UINT> &candidates,
+								   const GLfloat cameraPos[3])
+{
+	m_Queries = 0;
+
+	//boxes only touch the depth test, nothing is written
+	g_GLState.Push();
+	g_GLState.Disable(GL_LIGHTING);
+	g_GLState.Disable(GL_TEXTURE_2D);
+	g_GLState.Disable(GL_ALPHA_TEST);
+	g_GLState.Disable(GL_CULL_FACE);
+	g_GLState.ColorMask(0, 0, 0, 0);
+	g_GLState.DepthMask(GL_FALSE);
+
+	//the object is in the depth buffer already and tight bounds lie on its
+	//own faces (the base plate, unrotated cubes), pull the boxes toward the
+	//camera so an object never hides its own box
+	g_GLState.DepthFunc(GL_LEQUAL);
+	g_GLState.Enable(GL_POLYGON_OFFSET_FILL);
+	g_GLState.PolygonOffset(-1.0, -4.0);
+
+	for(UINT i=0; i<candidates.size(); i++)
+	{
+		UINT obj = candidates[i];
+		ObjectState &state = m_States[obj];
+
+		if(state.pending) continue;
+		if(state.visible && (m_Frame + obj) % VISIBLE_QUERY_INTERVAL != 0) continue;
+
+		//the box would be clipped by the near plane, it is visible anyway
+		const AABB &box = geometry.GetBounds(obj);
+		if(IsInside(box, cameraPos)) continue;
+
+		if(!state.query) glGenQueriesARB(1, &state.query);
+
+		glBeginQueryARB(GL_SAMPLES_PASSED_ARB, state.query);
+		DrawBox(box);
+		glEndQueryARB(GL_SAMPLES_PASSED_ARB);
+
+		state.pending = true;
+		m_Pending.push_back(obj);
+		m_Queries++;
+	}
+
+	g_GLState.Pop();
+}
+
+///----------------------------------------------------------------------------
+///Draws a world space box with immediate mode
+///@param	box - the box
+///----------------------------------------------------------------------------
+void OcclusionCuller::DrawBox(const AABB &box) const
+{
+	const GLfloat *a = box.min;
+	const GLfloat *b = box.max;
+
+	glBegin(GL_QUADS);
+		glVertex3f(a[0], a[1], a[2]); glVertex3f(a[0], b[1], a[2]); glVertex3f(b[0], b[1], a[2]); glVertex3f(b[0], a[1], a[2]);
+		glVertex3f(a[0], a[1], b[2]); glVertex3f(b[0], a[1], b[2]); glVertex3f(b[0], b[1], b[2]); glVertex3f(a[0], b[1], b[2]);
+		glVertex3f(a[0], a[1], a[2]); glVertex3f(a[0], a[1], b[2]); glVertex3f(a[0], b[1], b[2]); glVertex3f(a[0], b[1], a[2]);
+		glVertex3f(b[0], a[1], a[2]); glVertex3f(b[0], b[1], a[2]); glVertex3f(b[0], b[1], b[2]); glVertex3f(b[0], a[1], b[2]);
+		glVertex3f(a[0], a[1], a[2]); glVertex3f(b[0], a[1], a[2]); glVertex3f(b[0], a[1], b[2]); glVertex3f(a[0], a[1], b[2]);
+		glVertex3f(a[0], b[1], a[2]); glVertex3f(a[0], b[1], b[2]); glVertex3f(b[0], b[1], b[2]); glVertex3f(b[0], b[1], a[2]);
+	glEnd();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if p is inside the box enlarged by the camera near distance
+///----------------------------------------------------------------------------
+bool OcclusionCuller::IsInside(const AABB &box, const GLfloat p[3]) const
+{
+	const GLfloat nearDist = 1.0f;
+
+	for(int i=0; i<3; i++)
+	{
+		if(p[i] < box.min[i] - nearDist || p[i] > box.max[i] + nearDist)
+			return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns the objects drawn this frame (without conditional ones)
+///----------------------------------------------------------------------------
+const std::vector<UINT>& OcclusionCuller::GetDrawn() const
+{
+	return m_Drawn;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of objects drawn this frame (without conditional ones)
+///----------------------------------------------------------------------------
+UINT OcclusionCuller::GetDrawnCount() const
+{
+	return (UINT)m_Drawn.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of objects skipped this frame
+///----------------------------------------------------------------------------
+UINT OcclusionCuller::GetOccludedCount() const
+{
+	return m_Occluded;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of queries issued this frame
+///----------------------------------------------------------------------------
+UINT OcclusionCuller::GetQueryCount() const
+{
+	return m_Queries;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of queries whose results are still in flight
+///----------------------------------------------------------------------------
+UINT OcclusionCuller::GetPendingCount() const
+{
+	return (UINT)m_Pending.size();
+}
@@ -0,0 +1,82 @@
+///============================================================================
+///@file	OcclusionCulling.h
+///@brief	Camera pass occlusion culling with hardware occlusion queries.
+///			Visibility is coherent from frame to frame (the CHC++ idea):
+///			objects are drawn or skipped based on the result of the last
+///			query issued for them, results are only read once the GPU has
+///			them ready so the CPU never stalls, and visible objects are only
+///			re-checked every few frames.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef OCCLUSIONCULLING_H
+#define OCCLUSIONCULLING_H
+
+#include <vector>
+#include "GLExtensions.h"
+#include "Geometry.h"
+
+class OcclusionCuller
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	OcclusionCuller();
+	virtual ~OcclusionCuller();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Init(UINT objectCount);
+	void Shutdown();
+	void Select(const Geometry &geometry, const std::vector<UINT> &candidates,
+				const GLfloat cameraPos[3]);
+	void RecordConditional(const Geometry &geometry, CommandBuffer &buffer) const;
+	const std::vector<UINT>& GetDrawn() const;
+	void IssueQueries(const Geometry &geometry, const std::vector<UINT> &candidates,
+					  const GLfloat cameraPos[3]);
+	UINT GetDrawnCount() const;
+	UINT GetOccludedCount() const;
+	UINT GetQueryCount() const;
+	UINT GetPendingCount() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT VISIBLE_QUERY_INTERVAL = 8;	///> Frames between checks of visible objects
+	static const UINT VISIBLE_PIXEL_THRESHOLD = 0;	///> Samples needed to be visible
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct ObjectState
+	{
+		GLuint	query;		///> Query object (0 until first needed)
+		UINT	lastFrame;	///> Last frame the object was inside the frustum
+		bool	visible;	///> Visibility according to the last result
+		bool	pending;	///> A query was issued and its result not read yet
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void ReadResults();
+	void DrawBox(const AABB &box) const;
+	bool IsInside(const AABB &box, const GLfloat p[3]) const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<ObjectState>	m_States;		///> One per scene object
+	std::vector<UINT>			m_Pending;		///> Objects with queries in flight (issue order)
+	std::vector<UINT>			m_Drawn;		///> Objects drawn this frame
+	std::vector<UINT>			m_Conditional;	///> Objects drawn with conditional rendering
+	UINT						m_Frame;		///> Frame counter
+	UINT						m_Occluded;		///> Objects skipped this frame
+	UINT						m_Queries;		///> Queries issued this frame
+};
+
+#endif
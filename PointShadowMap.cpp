@@ -0,0 +1,407 @@
+///============================================================================
+///@file	PointShadowMap.cpp
+///@brief	Depth cube map that shadows a point light in every direction.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "PointShadowMap.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "Geometry.h"
+#include <algorithm>
+
+//The faces' matrices are applied in the geometry shader, the vertex shader
+//only takes the vertices to world space
+static const char LayeredVertexShader[] =
+	"#version 150 compatibility\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = gl_ModelViewMatrix * gl_Vertex;\n"
+	"}\n";
+
+//Sends every triangle to the faces of faceMask whose frustum it may cross
+//(a triangle outside one of the side planes of a face is dropped there)
+static const char LayeredGeometryShader[] =
+	"#version 150 compatibility\n"
+	"layout(triangles) in;\n"
+	"layout(triangle_strip, max_vertices = 18) out;\n"
+	"uniform mat4 faceMatrix[6];\n"
+	"uniform int faceMask;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	for(int face = 0; face < 6; face++)\n"
+	"	{\n"
+	"		if((faceMask & (1 << face)) == 0) continue;\n"
+	"\n"
+	"		vec4 p[3];\n"
+	"		for(int i = 0; i < 3; i++)\n"
+	"			p[i] = faceMatrix[face] * gl_in[i].gl_Position;\n"
+	"\n"
+	"		vec3 x = vec3(p[0].x, p[1].x, p[2].x);\n"
+	"		vec3 y = vec3(p[0].y, p[1].y, p[2].y);\n"
+	"		vec3 w = vec3(p[0].w, p[1].w, p[2].w);\n"
+	"		if(all(lessThan(x, -w)) || all(greaterThan(x, w)) ||\n"
+	"		   all(lessThan(y, -w)) || all(greaterThan(y, w)))\n"
+	"			continue;\n"
+	"\n"
+	"		for(int i = 0; i < 3; i++)\n"
+	"		{\n"
+	"			gl_Layer = face;\n"
+	"			gl_Position = p[i];\n"
+	"			EmitVertex();\n"
+	"		}\n"
+	"		EndPrimitive();\n"
+	"	}\n"
+	"}\n";
+
+//depth only
+static const char LayeredFragmentShader[] =
+	"#version 150 compatibility\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"}\n";
+
+//direction and up vector of each face, the usual cube map orientation
+static const GLdouble FaceDirections[PointShadowMap::FACE_COUNT][3] =
+{
+	{ 1.0, 0.0, 0.0}, {-1.0, 0.0, 0.0},
+	{ 0.0, 1.0, 0.0}, { 0.0,-1.0, 0.0},
+	{ 0.0, 0.0, 1.0}, { 0.0, 0.0,-1.0}
+};
+
+static const GLdouble FaceUps[PointShadowMap::FACE_COUNT][3] =
+{
+	{ 0.0,-1.0, 0.0}, { 0.0,-1.0, 0.0},
+	{ 0.0, 0.0, 1.0}, { 0.0, 0.0,-1.0},
+	{ 0.0,-1.0, 0.0}, { 0.0,-1.0, 0.0}
+};
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+PointShadowMap::PointShadowMap() : m_Texture(0), m_Framebuffer(0), m_Size(0),
+								   m_Near(1.0f), m_Far(100.0f), m_FaceCasters(0)
+{
+	memset(m_Light, 0, sizeof(m_Light));
+	memset(m_FaceMatrices, 0, sizeof(m_FaceMatrices));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+PointShadowMap::~PointShadowMap()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the context can draw the six faces in one pass
+///----------------------------------------------------------------------------
+bool PointShadowMap::IsSupported()
+{
+	return g_GLCaps.layeredRendering;
+}
+
+///----------------------------------------------------------------------------
+///Creates the depth cube map, the layered framebuffer object that renders
+///into its six faces and the program that picks the faces (the context must
+///be current)
+///@param	size - face size in texels (clamped to what the context allows)
+///@returns false if layered rendering is not supported or the framebuffer
+///			is not complete
+///----------------------------------------------------------------------------
+bool PointShadowMap::Create(UINT size)
+{
+	Release();
+	if(!IsSupported()) return false;
+
+	if(!m_Shader.CreateLayered(LayeredVertexShader, LayeredGeometryShader, LayeredFragmentShader))
+		return false;
+
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxSize);
+	m_Size = (std::max)((std::min)(size, (UINT)maxSize), 16U);
+
+	if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+
+	//the comparison state never changes, it is kept in the texture (lit
+	//where r < depth, the camera passes derive the shadowed test from it)
+	glGenTextures(1, &m_Texture);
+	g_GLState.BindTexture(GL_TEXTURE_CUBE_MAP, m_Texture);
+	for(UINT i=0; i<FACE_COUNT; i++)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT24_ARB, m_Size, m_Size,
+					 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	}
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE_ARB, GL_COMPARE_R_TO_TEXTURE);
+	g_GLState.TexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC_ARB, GL_LESS);
+	g_GLState.BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	//all the faces are attached at once, gl_Layer selects the face
+	glGenFramebuffers(1, &m_Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_Texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if(!complete)
+	{
+		Release();
+		return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the cube map, the framebuffer object and the program (the context
+///must be current)
+///----------------------------------------------------------------------------
+void PointShadowMap::Release()
+{
+	if(m_Framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_Framebuffer);
+		m_Framebuffer = 0;
+	}
+
+	if(m_Texture)
+	{
+		g_GLState.DeleteTexture(m_Texture);
+		glDeleteTextures(1, &m_Texture);
+		m_Texture = 0;
+	}
+
+	m_Shader.Release();
+	m_Groups.clear();
+	m_Commands.clear();
+	m_Size = m_FaceCasters = 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the cube map was created
+///----------------------------------------------------------------------------
+bool PointShadowMap::IsValid() const
+{
+	return m_Texture != 0;
+}
+
+///----------------------------------------------------------------------------
+///Places the light and computes the matrices and frustums of the faces, a
+///90 degrees square frustum looking down each axis (uses the model-view
+///stack, the context must be current)
+///@param	position - light position
+///@param	zNear, zFar - depth range of the faces
+///----------------------------------------------------------------------------
+void PointShadowMap::SetLight(const GLfloat position[3], GLfloat zNear, GLfloat zFar)
+{
+	GLdouble projection[16], view[16];
+
+	memcpy(m_Light, position, sizeof(m_Light));
+	m_Near = zNear;
+	m_Far = zFar;
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+
+	glLoadIdentity();
+	gluPerspective(90.0, 1.0, zNear, zFar);
+	glGetDoublev(GL_MODELVIEW_MATRIX, projection);
+
+	for(UINT i=0; i<FACE_COUNT; i++)
+	{
+		glLoadIdentity();
+		gluLookAt(position[0], position[1], position[2],
+				  position[0] + FaceDirections[i][0],
+				  position[1] + FaceDirections[i][1],
+				  position[2] + FaceDirections[i][2],
+				  FaceUps[i][0], FaceUps[i][1], FaceUps[i][2]);
+		glGetDoublev(GL_MODELVIEW_MATRIX, view);
+		m_Frustums[i].Extract(projection, view);
+
+		glLoadMatrixd(projection);
+		glMultMatrixd(view);
+		glGetFloatv(GL_MODELVIEW_MATRIX, m_FaceMatrices[i]);
+	}
+
+	glPopMatrix();
+}
+
+///----------------------------------------------------------------------------
+///Finds the casters of every face and groups them by the faces that see
+///them. An object seen by several faces is listed once and drawn once, the
+///geometry shader copies its triangles to those faces only. Doesn't use
+///OpenGL, it can run on any thread.
+///@param	geometry - the scene (the hierarchy must be refitted)
+///@param	casters - returned casters, sorted by group
+///----------------------------------------------------------------------------
+void PointShadowMap::Cull(const Geometry &geometry, std::vector<UINT> &casters)
+{
+	UINT objects = geometry.GetObjectCount();
+	m_Masks.assign(objects, 0);
+	m_FaceCasters = 0;
+
+	for(UINT i=0; i<FACE_COUNT; i++)
+	{
+		geometry.Cull(m_Frustums[i], m_Visible);
+		m_FaceCasters += (UINT)m_Visible.size();
+
+		for(UINT j=0; j<m_Visible.size(); j++)
+			m_Masks[m_Visible[j]] |= (BYTE)(1 << i);
+	}
+
+	//counting sort by mask, objects no face sees have mask 0
+	UINT offsets[FACE_MASKS];
+	memset(offsets, 0, sizeof(offsets));
+	for(UINT i=0; i<objects; i++)
+		offsets[m_Masks[i]]++;
+
+	m_Groups.clear();
+	UINT first = 0;
+	for(UINT mask=1; mask<FACE_MASKS; mask++)
+	{
+		UINT count = offsets[mask];
+		offsets[mask] = first;
+		if(!count) continue;
+
+		Group group = {mask, first, count};
+		m_Groups.push_back(group);
+		first += count;
+	}
+
+	casters.resize(first);
+	for(UINT i=0; i<objects; i++)
+	{
+		if(m_Masks[i]) casters[offsets[m_Masks[i]]++] = i;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Records the draws of each group once the casters' levels of detail are
+///selected. Doesn't use OpenGL, it can run on any thread.
+///@param	geometry - the scene
+///@param	casters - the casters returned by Cull
+///----------------------------------------------------------------------------
+void PointShadowMap::Record(const Geometry &geometry, const std::vector<UINT> &casters)
+{
+	m_Commands.resize(m_Groups.size());
+	for(UINT i=0; i<m_Groups.size(); i++)
+	{
+		const Group &group = m_Groups[i];
+		m_Commands[i].Reset();
+		geometry.Record(&casters[group.first], group.count, SHADOW_PASS, m_Commands[i]);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Draws the six faces in one pass, a group of casters at a time with its
+///face mask. The depth state (color mask, polygon offset) is the caller's.
+///@param	geometry - the scene
+///@param	stats - counters added to (may be NULL)
+///----------------------------------------------------------------------------
+void PointShadowMap::Render(const Geometry &geometry, DrawStats *stats)
+{
+	//never leave the cube map bound while drawing into it
+	g_GLState.BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	g_GLState.DepthMask(GL_TRUE);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glViewport(0, 0, m_Size, m_Size);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	m_Shader.Bind();
+	glUniformMatrix4fv(m_Shader.GetUniform("faceMatrix"), FACE_COUNT, GL_FALSE, &m_FaceMatrices[0][0]);
+	GLint faceMask = m_Shader.GetUniform("faceMask");
+
+	//the objects' transforms go alone in the model-view
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	for(UINT i=0; i<m_Groups.size() && i<m_Commands.size(); i++)
+	{
+		glUniform1i(faceMask, m_Groups[i].mask);
+		geometry.Execute(&m_Commands[i], 1, SHADOW_PASS, stats);
+	}
+
+	glPopMatrix();
+
+	Shader::Unbind();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+///----------------------------------------------------------------------------
+///@returns the depth cube map
+///----------------------------------------------------------------------------
+GLuint PointShadowMap::GetTexture() const
+{
+	return m_Texture;
+}
+
+///----------------------------------------------------------------------------
+///@returns the face size in texels
+///----------------------------------------------------------------------------
+UINT PointShadowMap::GetSize() const
+{
+	return m_Size;
+}
+
+///----------------------------------------------------------------------------
+///@returns the light position
+///----------------------------------------------------------------------------
+const GLfloat* PointShadowMap::GetLightPosition() const
+{
+	return m_Light;
+}
+
+///----------------------------------------------------------------------------
+///@returns the near plane of the faces
+///----------------------------------------------------------------------------
+GLfloat PointShadowMap::GetNear() const
+{
+	return m_Near;
+}
+
+///----------------------------------------------------------------------------
+///@returns the far plane of the faces
+///----------------------------------------------------------------------------
+GLfloat PointShadowMap::GetFar() const
+{
+	return m_Far;
+}
+
+///----------------------------------------------------------------------------
+///@returns the casters of the last Cull summed over the faces, what six
+///			separate passes would have submitted
+///----------------------------------------------------------------------------
+UINT PointShadowMap::GetFaceCasterCount() const
+{
+	return m_FaceCasters;
+}
+
+///----------------------------------------------------------------------------
+///@returns the groups of casters of the last Cull (one face mask each)
+///----------------------------------------------------------------------------
+UINT PointShadowMap::GetGroupCount() const
+{
+	return (UINT)m_Groups.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the cube map
+///----------------------------------------------------------------------------
+UINT PointShadowMap::GetTextureBytes() const
+{
+	return m_Size * m_Size * 4 * FACE_COUNT;
+}
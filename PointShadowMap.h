@@ -0,0 +1,108 @@
+///============================================================================
+///@file	PointShadowMap.h
+///@brief	Depth cube map that shadows a point light in every direction.
+///			The six faces are drawn in a single pass: the cube map is a
+///			layered attachment of a framebuffer object and a geometry
+///			shader sends every triangle to the faces (layers) it falls on.
+///			The casters are culled against each face's frustum on the CPU
+///			and grouped by the faces they touch, so a caster is submitted
+///			once and only reaches the faces that can see it.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef POINTSHADOWMAP_H
+#define POINTSHADOWMAP_H
+
+#include <windows.h>
+#include <vector>
+#include <GL/gl.h>
+#include "Culling.h"
+#include "Shader.h"
+#include "CommandBuffer.h"
+
+class Geometry;
+struct DrawStats;
+
+class PointShadowMap
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum Face
+	{
+		POSITIVE_X = 0,	///> Faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X order
+		NEGATIVE_X,
+		POSITIVE_Y,
+		NEGATIVE_Y,
+		POSITIVE_Z,
+		NEGATIVE_Z,
+		FACE_COUNT
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	PointShadowMap();
+	virtual ~PointShadowMap();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(UINT size);
+	void Release();
+	bool IsValid() const;
+	void SetLight(const GLfloat position[3], GLfloat zNear, GLfloat zFar);
+	void Cull(const Geometry &geometry, std::vector<UINT> &casters);
+	void Record(const Geometry &geometry, const std::vector<UINT> &casters);
+	void Render(const Geometry &geometry, DrawStats *stats = NULL);
+	GLuint GetTexture() const;
+	UINT GetSize() const;
+	const GLfloat* GetLightPosition() const;
+	GLfloat GetNear() const;
+	GLfloat GetFar() const;
+	UINT GetFaceCasterCount() const;
+	UINT GetGroupCount() const;
+	UINT GetTextureBytes() const;
+
+	static bool IsSupported();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT DEFAULT_SIZE = 512;	///> Face size in texels
+	static const UINT FACE_MASKS = 1 << FACE_COUNT;	///> Combinations of faces
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///Casters that reach the same faces, submitted together
+	struct Group
+	{
+		UINT	mask;			///> Bit i set if face i sees the casters
+		UINT	first;			///> First caster in the culled list
+		UINT	count;			///> Number of casters
+	};
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	GLuint				m_Texture;		///> Depth cube map
+	GLuint				m_Framebuffer;	///> Layered framebuffer of the six faces
+	Shader				m_Shader;		///> Sends the triangles to their faces
+	UINT				m_Size;			///> Face size in texels
+	GLfloat				m_Light[3];		///> Light position
+	GLfloat				m_Near;			///> Depth range of the faces
+	GLfloat				m_Far;
+	GLfloat				m_FaceMatrices[FACE_COUNT][16];	///> Projection * view of each face
+	Frustum				m_Frustums[FACE_COUNT];			///> Frustum of each face
+	std::vector<UINT>	m_Visible;		///> Casters seen by one face (scratch)
+	std::vector<BYTE>	m_Masks;		///> Faces that see each object (scratch)
+	std::vector<Group>	m_Groups;		///> Casters grouped by face mask
+	std::vector<CommandBuffer> m_Commands;	///> Draws of each group
+	UINT				m_FaceCasters;	///> Casters summed over the faces
+};
+
+#endif
@@ -0,0 +1,242 @@
+///============================================================================
+///@file	Profiler.cpp
+///@brief	Collects named timings and counters every frame.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Profiler.h"
+#include <string.h>
+#include <float.h>
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+Profiler::Profiler() : m_EntryCount(0), m_Frames(0), m_FrameStart(0.0)
+{
+	InitializeCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+Profiler::~Profiler()
+{
+	DeleteCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///@returns the current time in milliseconds (high resolution counter)
+///----------------------------------------------------------------------------
+double Profiler::GetTime()
+{
+	static double scale = 0.0;
+	LARGE_INTEGER counter;
+
+	if(scale == 0.0)
+	{
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		scale = 1000.0 / (double)freq.QuadPart;
+	}
+
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart * scale;
+}
+
+///----------------------------------------------------------------------------
+///Marks the beginning of a new frame
+///----------------------------------------------------------------------------
+void Profiler::BeginFrame()
+{
+	m_FrameStart = GetTime();
+}
+
+///----------------------------------------------------------------------------
+///Folds the values accumulated during the frame into the statistics
+///----------------------------------------------------------------------------
+void Profiler::EndFrame()
+{
+	AddTime("Frame", GetTime() - m_FrameStart);
+
+	EnterCriticalSection(&m_Lock);
+	for(UINT i=0; i<m_EntryCount; i++)
+	{
+		Entry &e = m_Entries[i];
+		if(e.type == VALUE) continue;
+
+		e.last = e.current;
+		e.total += e.current;
+		if(e.current < e.min) e.min = e.current;
+		if(e.current > e.max) e.max = e.current;
+		e.current = 0.0;
+	}
+	m_Frames++;
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Clears the per-frame statistics (one-off values are kept)
+///----------------------------------------------------------------------------
+void Profiler::Reset()
+{
+	EnterCriticalSection(&m_Lock);
+	for(UINT i=0; i<m_EntryCount; i++)
+	{
+		Entry &e = m_Entries[i];
+		if(e.type == VALUE) continue;
+
+		e.current = e.last = e.total = 0.0;
+		e.min = DBL_MAX;
+		e.max = 0.0;
+	}
+	m_Frames = 0;
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Adds a time sample to the current frame
+///@param	name - entry name
+///@param	ms - elapsed milliseconds
+///----------------------------------------------------------------------------
+void Profiler::AddTime(LPCSTR name, double ms)
+{
+	EnterCriticalSection(&m_Lock);
+	Entry *e = Find(name, TIME);
+	if(e) e->current += ms;
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Adds to a counter of the current frame
+///@param	name - entry name
+///@param	count - amount to add
+///----------------------------------------------------------------------------
+void Profiler::AddCount(LPCSTR name, double count)
+{
+	EnterCriticalSection(&m_Lock);
+	Entry *e = Find(name, COUNT);
+	if(e) e->current += count;
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Sets a one-off value which is not averaged over frames
+///@param	name - entry name
+///@param	value - the value
+///----------------------------------------------------------------------------
+void Profiler::SetValue(LPCSTR name, double value)
+{
+	EnterCriticalSection(&m_Lock);
+	Entry *e = Find(name, VALUE);
+	if(e) e->last = e->total = e->min = e->max = value;
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///@returns the value of the entry in the previous frame (0 if unknown)
+///----------------------------------------------------------------------------
+double Profiler::GetLastFrame(LPCSTR name) const
+{
+	EnterCriticalSection(&m_Lock);
+	const Entry *e = Find(name);
+	double value = e ? e->last : 0.0;
+	LeaveCriticalSection(&m_Lock);
+
+	return value;
+}
+
+///----------------------------------------------------------------------------
+///@returns the average per-frame value of the entry (0 if unknown)
+///----------------------------------------------------------------------------
+double Profiler::GetAverage(LPCSTR name) const
+{
+	EnterCriticalSection(&m_Lock);
+	const Entry *e = Find(name);
+	double value = 0.0;
+	if(e) value = e->type == VALUE ? e->total : (m_Frames ? e->total / m_Frames : 0.0);
+	LeaveCriticalSection(&m_Lock);
+
+	return value;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of frames collected since the last reset
+///----------------------------------------------------------------------------
+UINT Profiler::GetFrameCount() const
+{
+	return m_Frames;
+}
+
+///----------------------------------------------------------------------------
+///Writes all the entries to a text file
+///@param	file - output file (i.e. stdout or an opened report file)
+///----------------------------------------------------------------------------
+void Profiler::Report(FILE *file) const
+{
+	EnterCriticalSection(&m_Lock);
+
+	fprintf(file, "%-40s %12s %12s %12s\n", "Entry", "Average", "Min", "Max");
+	fprintf(file, "------------------------------------------------------------------------------\n");
+
+	for(UINT i=0; i<m_EntryCount; i++)
+	{
+		const Entry &e = m_Entries[i];
+		LPCSTR unit = e.type == TIME ? "ms" : "";
+
+		if(e.type == VALUE)
+		{
+			fprintf(file, "%-40s %12.3f\n", e.name, e.total);
+		}
+		else if(m_Frames > 0)
+		{
+			fprintf(file, "%-40s %10.3f%2s %10.3f%2s %10.3f%2s\n", e.name,
+					e.total / m_Frames, unit, e.min, unit, e.max, unit);
+		}
+	}
+
+	fprintf(file, "\n%u frames\n", m_Frames);
+
+	LeaveCriticalSection(&m_Lock);
+}
+
+///----------------------------------------------------------------------------
+///Finds an entry, creating it if it doesn't exist. Caller holds the lock.
+///@returns the entry or NULL if there is no room for a new one
+///----------------------------------------------------------------------------
+Profiler::Entry* Profiler::Find(LPCSTR name, EntryType type)
+{
+	for(UINT i=0; i<m_EntryCount; i++)
+	{
+		if(strcmp(m_Entries[i].name, name) == 0)
+			return &m_Entries[i];
+	}
+
+	if(m_EntryCount == MAX_ENTRIES) return NULL;
+
+	Entry &e = m_Entries[m_EntryCount++];
+	e.name		= name;
+	e.type		= type;
+	e.current	= 0.0;
+	e.last		= 0.0;
+	e.total		= 0.0;
+	e.min		= DBL_MAX;
+	e.max		= 0.0;
+
+	return &e;
+}
+
+///----------------------------------------------------------------------------
+///Finds an existing entry. Caller holds the lock.
+///@returns the entry or NULL if not found
+///----------------------------------------------------------------------------
+const Profiler::Entry* Profiler::Find(LPCSTR name) const
+{
+	for(UINT i=0; i<m_EntryCount; i++)
+	{
+		if(strcmp(m_Entries[i].name, name) == 0)
+			return &m_Entries[i];
+	}
+
+	return NULL;
+}
@@ -0,0 +1,109 @@
+///============================================================================
+///@file	Profiler.h
+///@brief	Collects named timings and counters every frame and reports their
+///			average, minimum and maximum (used by the benchmark mode and the
+///			on-screen statistics).
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <windows.h>
+#include <stdio.h>
+
+class Profiler
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	enum EntryType
+	{
+		TIME = 0,	///> Milliseconds accumulated during a frame
+		COUNT,		///> Counter accumulated during a frame
+		VALUE		///> One-off value (i.e. a build time at start-up)
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	Profiler();
+	virtual ~Profiler();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void	BeginFrame();
+	void	EndFrame();
+	void	Reset();
+	void	AddTime(LPCSTR name, double ms);
+	void	AddCount(LPCSTR name, double count);
+	void	SetValue(LPCSTR name, double value);
+	double	GetLastFrame(LPCSTR name) const;
+	double	GetAverage(LPCSTR name) const;
+	UINT	GetFrameCount() const;
+	void	Report(FILE *file) const;
+
+	static double GetTime();
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_ENTRIES = 128;	///> Max number of named entries
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Entry
+	{
+		LPCSTR		name;		///> Entry name (must be a string literal)
+		EntryType	type;		///> What kind of value this is
+		double		current;	///> Value accumulated in the current frame
+		double		last;		///> Value of the previous frame
+		double		total;		///> Sum of all finished frames
+		double		min;		///> Minimum per-frame value
+		double		max;		///> Maximum per-frame value
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	Entry*			Find(LPCSTR name, EntryType type);
+	const Entry*	Find(LPCSTR name) const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	Entry				m_Entries[MAX_ENTRIES];	///> Named entries
+	UINT				m_EntryCount;			///> Used entries
+	UINT				m_Frames;				///> Finished frames
+	double				m_FrameStart;			///> Start time of this frame
+	mutable CRITICAL_SECTION m_Lock;			///> Entries can be added from any thread
+};
+
+///----------------------------------------------------------------------------
+///Helper that adds the time spent in a scope to a profiler entry
+///----------------------------------------------------------------------------
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler &profiler, LPCSTR name) :
+		m_Profiler(profiler), m_Name(name), m_Start(Profiler::GetTime())
+	{
+	}
+
+	~ProfileScope()
+	{
+		m_Profiler.AddTime(m_Name, Profiler::GetTime() - m_Start);
+	}
+
+private:
+	Profiler&	m_Profiler;	///> Profiler receiving the sample
+	LPCSTR		m_Name;		///> Entry name
+	double		m_Start;	///> Time the scope was entered
+};
+
+#endif
@@ -0,0 +1,586 @@
+///============================================================================
+///@file	RenderGraph.cpp
+///@brief	Declarative frame with pass culling, ordering and transient
+///			texture aliasing.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "RenderGraph.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+#include <string.h>
+
+///----------------------------------------------------------------------------
+///@returns true if a format is a depth format
+///----------------------------------------------------------------------------
+static bool IsDepthFormat(GLenum format)
+{
+	return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_COMPONENT16_ARB ||
+		   format == GL_DEPTH_COMPONENT24_ARB || format == GL_DEPTH_COMPONENT32_ARB;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if two transient textures can share a pool texture
+///----------------------------------------------------------------------------
+static bool IsSameDesc(const RenderGraph::TextureDesc &a, const RenderGraph::TextureDesc &b)
+{
+	return a.width == b.width && a.height == b.height && a.format == b.format;
+}
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+RenderGraph::RenderGraph() : m_Compiled(false), m_Cycle(false)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+RenderGraph::~RenderGraph()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///Forgets the passes and resources of the previous frame (the pool textures
+///are kept), call before declaring a frame
+///----------------------------------------------------------------------------
+void RenderGraph::Reset()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+	m_Accesses.clear();
+	m_Dependencies.clear();
+	m_Order.clear();
+	m_Physical.clear();
+	m_Compiled = false;
+	m_Cycle = false;
+}
+
+///----------------------------------------------------------------------------
+///Declares a transient texture, only alive during the frame
+///@param	name - resource name (must be a string literal)
+///@param	width - width in texels
+///@param	height - height in texels
+///@param	format - internal format
+///@returns the resource
+///----------------------------------------------------------------------------
+RenderGraph::Handle RenderGraph::CreateTexture(LPCSTR name, UINT width, UINT height, GLenum format)
+{
+	Resource r;
+	r.name = name;
+	r.desc.width = width;
+	r.desc.height = height;
+	r.desc.format = format;
+	r.transient = true;
+	r.output = false;
+	r.texture = 0;
+	r.first = r.last = r.physical = NONE;
+
+	m_Resources.push_back(r);
+	return (Handle)m_Resources.size() - 1;
+}
+
+///----------------------------------------------------------------------------
+///Declares a resource the graph doesn't own
+///@param	name - resource name (must be a string literal)
+///@param	texture - its texture (0 for the back buffer or plain GL state)
+///@param	output - it is used after the frame (i.e. the back buffer or a
+///			texture read by the next frame), which keeps its writers alive
+///@returns the resource
+///----------------------------------------------------------------------------
+RenderGraph::Handle RenderGraph::Import(LPCSTR name, GLuint texture, bool output)
+{
+	Resource r;
+	memset(&r.desc, 0, sizeof(r.desc));
+	r.name = name;
+	r.transient = false;
+	r.output = output;
+	r.texture = texture;
+	r.first = r.last = r.physical = NONE;
+
+	m_Resources.push_back(r);
+	return (Handle)m_Resources.size() - 1;
+}
+
+///----------------------------------------------------------------------------
+///Declares a pass
+///@param	name - pass name (must be a string literal)
+///@param	func - entry point, runs on the render thread
+///@param	data - argument of the entry point
+///@param	sideEffect - never cull the pass
+///@returns the pass
+///----------------------------------------------------------------------------
+UINT RenderGraph::AddPass(LPCSTR name, PassFunc func, void *data, bool sideEffect)
+{
+	Pass p;
+	p.name = name;
+	p.func = func;
+	p.data = data;
+	p.sideEffect = sideEffect;
+	p.culled = false;
+	p.ms = 0.0;
+
+	m_Passes.push_back(p);
+	return (UINT)m_Passes.size() - 1;
+}
+
+///----------------------------------------------------------------------------
+///Declares that a pass reads a resource
+///----------------------------------------------------------------------------
+void RenderGraph::Read(UINT pass, Handle resource)
+{
+	Access a = {pass, resource, false};
+	m_Accesses.push_back(a);
+}
+
+///----------------------------------------------------------------------------
+///Declares that a pass writes a resource
+///----------------------------------------------------------------------------
+void RenderGraph::Write(UINT pass, Handle resource)
+{
+	Access a = {pass, resource, true};
+	m_Accesses.push_back(a);
+}
+
+///----------------------------------------------------------------------------
+///Culls, orders and allocates the declared frame. The accesses of each
+///resource go in declaration order: a write waits for every earlier access
+///and a read for the earlier writes. A transient texture read before any
+///declared write waits for all its writers, so its producer may be declared
+///after its consumers.
+///@returns false if the passes depend on each other in a cycle (they run in
+///			declaration order then)
+///----------------------------------------------------------------------------
+bool RenderGraph::Compile()
+{
+	UINT passes = (UINT)m_Passes.size();
+	m_Dependencies.assign(passes, std::vector<Dependency>());
+
+	for(UINT i=0; i<m_Accesses.size(); i++)
+	{
+		const Access &a = m_Accesses[i];
+		bool earlierWrite = false;
+
+		for(UINT j=0; j<i; j++)
+		{
+			const Access &b = m_Accesses[j];
+			if(b.resource != a.resource) continue;
+
+			if(a.write || b.write)
+				AddDependency(a.pass, b.pass, !a.write && b.write);
+			if(b.write && b.pass != a.pass) earlierWrite = true;
+		}
+
+		if(a.write || earlierWrite || !m_Resources[a.resource].transient) continue;
+
+		for(UINT j=i+1; j<m_Accesses.size(); j++)
+		{
+			const Access &b = m_Accesses[j];
+			if(b.resource == a.resource && b.write)
+				AddDependency(a.pass, b.pass, true);
+		}
+	}
+
+	CullPasses();
+	m_Cycle = !SortPasses();
+	AllocateTransients();
+
+	m_Compiled = true;
+	return !m_Cycle;
+}
+
+///----------------------------------------------------------------------------
+///Runs the passes of the compiled frame, with the transient textures of a
+///frame in flight (the GPU must be done with the frame that used them last)
+///@param	frame - the frame in flight (FramePacer::GetFrame)
+///----------------------------------------------------------------------------
+void RenderGraph::Execute(UINT frame)
+{
+	if(!m_Compiled) return;
+
+	std::vector<GLuint> &pool = m_Pool[frame % FramePacer::MAX_FRAMES];
+	std::vector<TextureDesc> &descs = m_PoolDescs[frame % FramePacer::MAX_FRAMES];
+
+	//create the pool textures the frame needs (they stay for next frames)
+	for(UINT i=0; i<m_Physical.size(); i++)
+	{
+		const TextureDesc &desc = m_Physical[i].desc;
+		if(i < pool.size() && IsSameDesc(descs[i], desc)) continue;
+
+		if(i == pool.size())
+		{
+			pool.push_back(0);
+			descs.push_back(desc);
+			glGenTextures(1, &pool[i]);
+		}
+		descs[i] = desc;
+
+		bool depth = IsDepthFormat(desc.format);
+		if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+		g_GLState.BindTexture(GL_TEXTURE_2D, pool[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0,
+					 depth ? GL_DEPTH_COMPONENT : GL_RGBA,
+					 depth ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE, NULL);
+
+		//one level only, the passes set the sampling they need
+		g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	for(UINT i=0; i<m_Resources.size(); i++)
+	{
+		Resource &r = m_Resources[i];
+		if(r.transient) r.texture = r.physical == NONE ? 0 : pool[r.physical];
+	}
+
+	for(UINT i=0; i<m_Order.size(); i++)
+	{
+		Pass &pass = m_Passes[m_Order[i]];
+		double start = Profiler::GetTime();
+		pass.func(pass.data, *this);
+		pass.ms = Profiler::GetTime() - start;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Deletes the pool textures (the context must be current)
+///----------------------------------------------------------------------------
+void RenderGraph::Release()
+{
+	for(UINT f=0; f<FramePacer::MAX_FRAMES; f++)
+	{
+		for(UINT i=0; i<m_Pool[f].size(); i++)
+		{
+			g_GLState.DeleteTexture(m_Pool[f][i]);
+			glDeleteTextures(1, &m_Pool[f][i]);
+		}
+
+		m_Pool[f].clear();
+		m_PoolDescs[f].clear();
+	}
+
+	Reset();
+}
+
+///----------------------------------------------------------------------------
+///@returns the texture of a resource in the executing frame (0 for plain
+///			state or a culled transient)
+///----------------------------------------------------------------------------
+GLuint RenderGraph::GetTexture(Handle resource) const
+{
+	return resource < m_Resources.size() ? m_Resources[resource].texture : 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of declared passes
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetPassCount() const
+{
+	return (UINT)m_Passes.size();
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of passes culled by the last Compile
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetCulledCount() const
+{
+	UINT culled = 0;
+	for(UINT i=0; i<m_Passes.size(); i++)
+	{
+		if(m_Passes[i].culled) culled++;
+	}
+
+	return culled;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes the used transient textures would take without aliasing
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetTransientBytes() const
+{
+	UINT bytes = 0;
+	for(UINT i=0; i<m_Resources.size(); i++)
+	{
+		const Resource &r = m_Resources[i];
+		if(r.transient && r.physical != NONE)
+			bytes += r.desc.width * r.desc.height * GetTexelBytes(r.desc.format);
+	}
+
+	return bytes;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes of the pool textures a frame uses
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetAllocatedBytes() const
+{
+	UINT bytes = 0;
+	for(UINT i=0; i<m_Physical.size(); i++)
+	{
+		const TextureDesc &desc = m_Physical[i].desc;
+		bytes += desc.width * desc.height * GetTexelBytes(desc.format);
+	}
+
+	return bytes;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes of every pool texture of every frame in flight
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetPoolBytes() const
+{
+	UINT bytes = 0;
+	for(UINT f=0; f<FramePacer::MAX_FRAMES; f++)
+	{
+		for(UINT i=0; i<m_PoolDescs[f].size(); i++)
+		{
+			const TextureDesc &desc = m_PoolDescs[f][i];
+			bytes += desc.width * desc.height * GetTexelBytes(desc.format);
+		}
+	}
+
+	return bytes;
+}
+
+///----------------------------------------------------------------------------
+///Writes the passes in execution order, the transient textures with their
+///lifetimes and the memory aliasing saves
+///@param	file - output file (i.e. the benchmark report)
+///----------------------------------------------------------------------------
+void RenderGraph::WriteReport(FILE *file) const
+{
+	fprintf(file, "Render graph: %u passes, %u culled%s\n", GetPassCount(), GetCulledCount(),
+			m_Cycle ? " (cycle, declaration order)" : "");
+
+	fprintf(file, "%-6s %-24s %10s\n", "Order", "Pass", "CPU");
+	for(UINT i=0; i<m_Order.size(); i++)
+	{
+		const Pass &pass = m_Passes[m_Order[i]];
+		fprintf(file, "%-6u %-24s %8.3fms\n", i, pass.name, pass.ms);
+	}
+
+	for(UINT i=0; i<m_Passes.size(); i++)
+	{
+		if(m_Passes[i].culled) fprintf(file, "%-6s %-24s\n", "culled", m_Passes[i].name);
+	}
+
+	fprintf(file, "\n%-24s %12s %10s %10s %8s\n", "Transient texture", "Size", "KB", "Passes", "Texture");
+	for(UINT i=0; i<m_Resources.size(); i++)
+	{
+		const Resource &r = m_Resources[i];
+		if(!r.transient) continue;
+
+		if(r.physical == NONE)
+		{
+			fprintf(file, "%-24s %5ux%-6u %10s\n", r.name, r.desc.width, r.desc.height, "unused");
+			continue;
+		}
+
+		fprintf(file, "%-24s %5ux%-6u %10.1f %4u - %-3u %8u\n", r.name, r.desc.width, r.desc.height,
+				r.desc.width * r.desc.height * GetTexelBytes(r.desc.format) / 1024.0,
+				r.first, r.last, r.physical);
+	}
+
+	UINT transient = GetTransientBytes();
+	UINT allocated = GetAllocatedBytes();
+	fprintf(file, "\nTransient memory per frame: %.1f KB without aliasing, %.1f KB with aliasing "
+			"(%.1f KB saved)\n", transient / 1024.0, allocated / 1024.0,
+			(transient - allocated) / 1024.0);
+	fprintf(file, "Pool of every frame in flight: %.1f KB\n", GetPoolBytes() / 1024.0);
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes of a texel of an internal format
+///----------------------------------------------------------------------------
+UINT RenderGraph::GetTexelBytes(GLenum format)
+{
+	switch(format)
+	{
+		case GL_DEPTH_COMPONENT16_ARB:	return 2;
+		case GL_RGBA16F_ARB:			return 8;
+		case GL_RGBA32F_ARB:			return 16;
+		default:						return 4;
+	}
+}
+
+///----------------------------------------------------------------------------
+///Makes a pass wait for another one (nothing if it's the same pass)
+///@param	pass - the later pass
+///@param	before - the pass that goes first
+///@param	data - the later pass reads what the first one wrote
+///----------------------------------------------------------------------------
+void RenderGraph::AddDependency(UINT pass, UINT before, bool data)
+{
+	if(pass == before) return;
+
+	std::vector<Dependency> &dependencies = m_Dependencies[pass];
+	for(UINT i=0; i<dependencies.size(); i++)
+	{
+		if(dependencies[i].pass == before)
+		{
+			dependencies[i].data = dependencies[i].data || data;
+			return;
+		}
+	}
+
+	Dependency d = {before, data};
+	dependencies.push_back(d);
+}
+
+///----------------------------------------------------------------------------
+///Culls every pass that has no side effect, writes no output and whose
+///writes no live pass reads
+///----------------------------------------------------------------------------
+void RenderGraph::CullPasses()
+{
+	UINT passes = (UINT)m_Passes.size();
+	std::vector<UINT> stack;
+
+	for(UINT i=0; i<passes; i++)
+		m_Passes[i].culled = !m_Passes[i].sideEffect;
+
+	for(UINT i=0; i<m_Accesses.size(); i++)
+	{
+		const Access &a = m_Accesses[i];
+		if(a.write && m_Resources[a.resource].output)
+			m_Passes[a.pass].culled = false;
+	}
+
+	for(UINT i=0; i<passes; i++)
+	{
+		if(!m_Passes[i].culled) stack.push_back(i);
+	}
+
+	//the producers of whatever a live pass reads are alive too
+	while(!stack.empty())
+	{
+		UINT pass = stack.back();
+		stack.pop_back();
+
+		const std::vector<Dependency> &dependencies = m_Dependencies[pass];
+		for(UINT i=0; i<dependencies.size(); i++)
+		{
+			Pass &before = m_Passes[dependencies[i].pass];
+			if(!dependencies[i].data || !before.culled) continue;
+
+			before.culled = false;
+			stack.push_back(dependencies[i].pass);
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Orders the live passes so each one runs after the passes it waits for,
+///the earliest declared ready pass goes first
+///@returns false if there is a cycle (declaration order is used)
+///----------------------------------------------------------------------------
+bool RenderGraph::SortPasses()
+{
+	UINT passes = (UINT)m_Passes.size();
+	std::vector<UINT> waiting(passes, 0);
+	std::vector<bool> done(passes, false);
+
+	for(UINT i=0; i<passes; i++)
+	{
+		const std::vector<Dependency> &dependencies = m_Dependencies[i];
+		for(UINT j=0; j<dependencies.size(); j++)
+		{
+			if(!m_Passes[dependencies[j].pass].culled) waiting[i]++;
+		}
+	}
+
+	UINT alive = 0;
+	for(UINT i=0; i<passes; i++)
+	{
+		if(!m_Passes[i].culled) alive++;
+	}
+
+	m_Order.clear();
+	while(m_Order.size() < alive)
+	{
+		UINT next = NONE;
+		for(UINT i=0; i<passes && next == NONE; i++)
+		{
+			if(!m_Passes[i].culled && !done[i] && waiting[i] == 0) next = i;
+		}
+
+		if(next == NONE)
+		{
+			m_Order.clear();
+			for(UINT i=0; i<passes; i++)
+			{
+				if(!m_Passes[i].culled) m_Order.push_back(i);
+			}
+			return false;
+		}
+
+		done[next] = true;
+		m_Order.push_back(next);
+
+		for(UINT i=0; i<passes; i++)
+		{
+			const std::vector<Dependency> &dependencies = m_Dependencies[i];
+			for(UINT j=0; j<dependencies.size(); j++)
+			{
+				if(dependencies[j].pass == next) waiting[i]--;
+			}
+		}
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Gives every transient texture used by a live pass a pool texture. A pool
+///texture is reused once the last pass of its current resource has run, if
+///the size and format match.
+///----------------------------------------------------------------------------
+void RenderGraph::AllocateTransients()
+{
+	std::vector<UINT> position(m_Passes.size(), (UINT)NONE);
+	for(UINT i=0; i<m_Order.size(); i++)
+		position[m_Order[i]] = i;
+
+	//lifetime of each resource, in execution order
+	for(UINT i=0; i<m_Accesses.size(); i++)
+	{
+		const Access &a = m_Accesses[i];
+		UINT p = position[a.pass];
+		if(p == NONE) continue;
+
+		Resource &r = m_Resources[a.resource];
+		if(r.first == NONE || p < r.first) r.first = p;
+		if(r.last == NONE || p > r.last) r.last = p;
+	}
+
+	m_Physical.clear();
+	for(UINT p=0; p<m_Order.size(); p++)
+	{
+		for(UINT i=0; i<m_Resources.size(); i++)
+		{
+			Resource &r = m_Resources[i];
+			if(!r.transient || r.first != p) continue;
+
+			for(UINT k=0; k<m_Physical.size() && r.physical == NONE; k++)
+			{
+				Physical &physical = m_Physical[k];
+				if(physical.busyUntil < p && IsSameDesc(physical.desc, r.desc))
+				{
+					physical.busyUntil = r.last;
+					r.physical = k;
+				}
+			}
+
+			if(r.physical == NONE)
+			{
+				Physical physical = {r.desc, r.last};
+				m_Physical.push_back(physical);
+				r.physical = (UINT)m_Physical.size() - 1;
+			}
+		}
+	}
+}
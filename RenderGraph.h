@@ -0,0 +1,151 @@
+///============================================================================
+///@file	RenderGraph.h
+///@brief	Declarative frame: every pass says which resources it reads and
+///			writes, and the graph works out the rest. Passes whose results
+///			nobody uses are culled, the others are ordered so every read
+///			sees the writes it depends on (declaration order breaks ties),
+///			and the transient textures (only alive during the frame) are
+///			taken from a pool where textures of the same size and format
+///			whose lifetimes don't overlap share one texture. The pool has
+///			one set of textures per frame in flight. Imported resources
+///			(the back buffer, textures kept between frames, plain GL state)
+///			only order the passes; the ones marked as outputs keep their
+///			writers alive.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include <GL/gl.h>
+#include "FramePacer.h"
+
+class RenderGraph
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///Resource declared in the graph
+	typedef UINT Handle;
+
+	///Pass entry point, the graph gives the textures of its resources
+	typedef void (*PassFunc)(void *data, const RenderGraph &graph);
+
+	///Size and format of a transient texture
+	struct TextureDesc
+	{
+		UINT	width;			///> Width in texels
+		UINT	height;			///> Height in texels
+		GLenum	format;			///> Internal format (i.e. GL_DEPTH_COMPONENT)
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	RenderGraph();
+	virtual ~RenderGraph();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Reset();
+	Handle CreateTexture(LPCSTR name, UINT width, UINT height, GLenum format);
+	Handle Import(LPCSTR name, GLuint texture = 0, bool output = false);
+	UINT AddPass(LPCSTR name, PassFunc func, void *data, bool sideEffect = false);
+	void Read(UINT pass, Handle resource);
+	void Write(UINT pass, Handle resource);
+	bool Compile();
+	void Execute(UINT frame);
+	void Release();
+	GLuint GetTexture(Handle resource) const;
+	UINT GetPassCount() const;
+	UINT GetCulledCount() const;
+	UINT GetTransientBytes() const;
+	UINT GetAllocatedBytes() const;
+	UINT GetPoolBytes() const;
+	void WriteReport(FILE *file) const;
+
+	static UINT GetTexelBytes(GLenum format);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT NONE = 0xFFFFFFFF;	///> No pass, resource or texture
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Resource
+	{
+		LPCSTR		name;		///> Name (must be a string literal)
+		TextureDesc	desc;		///> Size and format of a transient texture
+		bool		transient;	///> Taken from the pool (or imported)
+		bool		output;		///> Used after the frame, its writers stay alive
+		GLuint		texture;	///> Texture of this frame (0 for plain state)
+		UINT		first;		///> First pass using it (position in the order)
+		UINT		last;		///> Last pass using it
+		UINT		physical;	///> Pool texture it was given
+	};
+
+	struct Pass
+	{
+		LPCSTR		name;		///> Name (must be a string literal)
+		PassFunc	func;		///> Entry point
+		void*		data;		///> Argument of the entry point
+		bool		sideEffect;	///> Never culled
+		bool		culled;		///> Nothing alive uses its results
+		double		ms;			///> CPU time of its last execution
+	};
+
+	///Read or write of a resource by a pass, in declaration order
+	struct Access
+	{
+		UINT		pass;		///> Accessing pass
+		Handle		resource;	///> Accessed resource
+		bool		write;		///> Write (or read)
+	};
+
+	///Pass another pass has to wait for
+	struct Dependency
+	{
+		UINT		pass;		///> Pass that goes first
+		bool		data;		///> The later pass reads what it wrote
+	};
+
+	///Texture of the pool shared by transient resources
+	struct Physical
+	{
+		TextureDesc	desc;		///> Size and format
+		UINT		busyUntil;	///> Last pass using its current resource
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void AddDependency(UINT pass, UINT before, bool data);
+	void CullPasses();
+	bool SortPasses();
+	void AllocateTransients();
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<Resource>	m_Resources;	///> Declared resources
+	std::vector<Pass>		m_Passes;		///> Declared passes
+	std::vector<Access>		m_Accesses;		///> Reads and writes of the passes
+	std::vector< std::vector<Dependency> > m_Dependencies;	///> Of each pass
+	std::vector<UINT>		m_Order;		///> Alive passes in execution order
+	std::vector<Physical>	m_Physical;		///> Pool textures the frame needs
+	std::vector<GLuint>		m_Pool[FramePacer::MAX_FRAMES];		///> Textures of each frame
+	std::vector<TextureDesc> m_PoolDescs[FramePacer::MAX_FRAMES];	///> Their size and format
+	bool					m_Compiled;		///> Compile succeeded
+	bool					m_Cycle;		///> The passes depend on each other
+};
+
+#endif
@@ -0,0 +1,398 @@
+///============================================================================
+///@file	SceneFile.cpp
+///@brief	Binary scene container, mapped and handed to the GL as is.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "SceneFile.h"
+#include <string.h>
+#include <limits.h>
+
+//size of a full vertex in each Mesh::VertexFormat
+static const UINT FormatStride[Mesh::FORMAT_COUNT] = {6*sizeof(GLfloat), 4*sizeof(GLshort), 6*sizeof(GLshort)};
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+SceneFile::SceneFile() : m_View(NULL), m_Size(0), m_Header(NULL), m_Meshes(NULL),
+						 m_Shapes(NULL), m_Instances(NULL)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+///----------------------------------------------------------------------------
+///Maps a scene file and checks its structure (the streams aren't read
+///except for the index range check)
+///@param	path - file name
+///@returns false if the file can't be mapped or isn't a valid scene
+///----------------------------------------------------------------------------
+bool SceneFile::Open(LPCSTR path)
+{
+	Close();
+
+	if(!m_File.Open(path)) return false;
+
+	m_View = m_File.GetData();
+	m_Size = m_File.GetSize();
+	if(m_Size < sizeof(SceneFileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	m_Header	= (const SceneFileHeader *)m_View;
+	m_Meshes	= (const SceneMeshRecord *)(m_View + m_Header->meshOffset);
+	m_Shapes	= (const SceneShapeRecord *)(m_View + m_Header->shapeOffset);
+	m_Instances	= (const SceneInstanceRecord *)(m_View + m_Header->instanceOffset);
+
+	if(!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Unmaps the file. Meshes attached to it must have been released (unless
+///their streams were copied to buffer objects).
+///----------------------------------------------------------------------------
+void SceneFile::Close()
+{
+	m_File.Close();
+
+	m_View = NULL;
+	m_Size = 0;
+	m_Header = NULL;
+	m_Meshes = NULL;
+	m_Shapes = NULL;
+	m_Instances = NULL;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if a valid file is mapped
+///----------------------------------------------------------------------------
+bool SceneFile::IsOpen() const
+{
+	return m_View != NULL;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the mapped file
+///----------------------------------------------------------------------------
+UINT SceneFile::GetSize() const
+{
+	return m_Size;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of meshes in the file
+///----------------------------------------------------------------------------
+UINT SceneFile::GetMeshCount() const
+{
+	return m_Header ? m_Header->meshCount : 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of shapes in the file
+///----------------------------------------------------------------------------
+UINT SceneFile::GetShapeCount() const
+{
+	return m_Header ? m_Header->shapeCount : 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of object instances in the file
+///----------------------------------------------------------------------------
+UINT SceneFile::GetInstanceCount() const
+{
+	return m_Header ? m_Header->instanceCount : 0;
+}
+
+///----------------------------------------------------------------------------
+///Gets the streams of a mesh, pointing into the mapped file
+///@param	mesh - mesh index
+///@param	streams - returned streams, valid until the file is closed
+///----------------------------------------------------------------------------
+void SceneFile::GetMesh(UINT mesh, Mesh::Streams &streams) const
+{
+	const SceneMeshRecord &m = m_Meshes[mesh];
+
+	streams.format				= (Mesh::VertexFormat)m.format;
+	streams.vertexCount			= m.vertexCount;
+	streams.indexCount			= m.indexCount;
+	streams.stride				= m.stride;
+	streams.indexType			= m.indexType;
+	streams.quantizedPositions	= m.quantizedPositions != 0;
+	streams.vertices			= m_View + m.vertexOffset;
+	streams.positions			= m_View + m.positionOffset;
+	streams.indices				= m_View + m.indexOffset;
+
+	for(int k=0; k<3; k++)
+	{
+		streams.bounds.min[k]		= m.boundsMin[k];
+		streams.bounds.max[k]		= m.boundsMax[k];
+		streams.dequantizeScale[k]	= m.dequantizeScale[k];
+		streams.dequantizeOffset[k]	= m.dequantizeOffset[k];
+	}
+
+	streams.originalStats.acmr		= m.originalStats[0];
+	streams.originalStats.atvr		= m.originalStats[1];
+	streams.originalStats.overdraw	= m.originalStats[2];
+	streams.stats.acmr				= m.stats[0];
+	streams.stats.atvr				= m.stats[1];
+	streams.stats.overdraw			= m.stats[2];
+}
+
+///----------------------------------------------------------------------------
+///@returns a shape of the file
+///----------------------------------------------------------------------------
+const SceneShapeRecord& SceneFile::GetShape(UINT shape) const
+{
+	return m_Shapes[shape];
+}
+
+///----------------------------------------------------------------------------
+///@returns an object instance of the file
+///----------------------------------------------------------------------------
+const SceneInstanceRecord& SceneFile::GetInstance(UINT instance) const
+{
+	return m_Instances[instance];
+}
+
+///----------------------------------------------------------------------------
+///Writes a scene file. The tables come first, then the streams of every
+///mesh, each one starting at a multiple of ALIGNMENT.
+///@param	path - file name
+///@param	meshes - streams of the meshes (i.e. from Mesh::GetStreams)
+///@param	shapes - levels of detail, referencing the meshes by index
+///@param	instances - object instances, referencing the shapes by index
+///@returns false if the file couldn't be written or is too big for the
+///			32 bit offsets of the format
+///----------------------------------------------------------------------------
+bool SceneFile::Write(LPCSTR path, const std::vector<Mesh::Streams> &meshes,
+					  const std::vector<SceneShapeRecord> &shapes,
+					  const std::vector<SceneInstanceRecord> &instances)
+{
+	SceneFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SMGS", 4);
+	header.version			= VERSION;
+	header.headerSize		= sizeof(SceneFileHeader);
+	header.meshCount		= (UINT)meshes.size();
+	header.shapeCount		= (UINT)shapes.size();
+	header.instanceCount	= (UINT)instances.size();
+
+	//the layout is computed in 64 bits, every offset must fit in 32 (they
+	//only grow, so checking the end of each block is enough)
+	UINT64 meshOffset = Align(sizeof(SceneFileHeader));
+	UINT64 shapeOffset = Align(meshOffset + (UINT64)meshes.size() * sizeof(SceneMeshRecord));
+	UINT64 instanceOffset = Align(shapeOffset + (UINT64)shapes.size() * sizeof(SceneShapeRecord));
+	UINT64 offset = instanceOffset + (UINT64)instances.size() * sizeof(SceneInstanceRecord);
+	if(offset > UINT_MAX) return false;
+
+	header.meshOffset		= (UINT)meshOffset;
+	header.shapeOffset		= (UINT)shapeOffset;
+	header.instanceOffset	= (UINT)instanceOffset;
+
+	//lay out the streams after the tables
+	std::vector<SceneMeshRecord> records(meshes.size());
+
+	for(UINT i=0; i<meshes.size(); i++)
+	{
+		const Mesh::Streams &s = meshes[i];
+		SceneMeshRecord &m = records[i];
+		memset(&m, 0, sizeof(m));
+
+		m.format				= s.format;
+		m.vertexCount			= s.vertexCount;
+		m.indexCount			= s.indexCount;
+		m.stride				= s.stride;
+		m.indexType				= s.indexType;
+		m.quantizedPositions	= s.quantizedPositions ? 1 : 0;
+
+		for(int k=0; k<3; k++)
+		{
+			m.boundsMin[k]			= s.bounds.min[k];
+			m.boundsMax[k]			= s.bounds.max[k];
+			m.dequantizeScale[k]	= s.dequantizeScale[k];
+			m.dequantizeOffset[k]	= s.dequantizeOffset[k];
+		}
+
+		m.originalStats[0]	= s.originalStats.acmr;
+		m.originalStats[1]	= s.originalStats.atvr;
+		m.originalStats[2]	= s.originalStats.overdraw;
+		m.stats[0]			= s.stats.acmr;
+		m.stats[1]			= s.stats.atvr;
+		m.stats[2]			= s.stats.overdraw;
+
+		UINT64 vertexOffset		= Align(offset);
+		UINT64 positionOffset	= Align(vertexOffset + (UINT64)m.vertexCount * m.stride);
+		UINT64 indexOffset		= Align(positionOffset + GetPositionBytes(m));
+		offset					= indexOffset + GetIndexBytes(m);
+		if(offset > UINT_MAX) return false;
+
+		m.vertexOffset		= (UINT)vertexOffset;
+		m.positionOffset	= (UINT)positionOffset;
+		m.indexOffset		= (UINT)indexOffset;
+	}
+	header.fileSize = (UINT)offset;
+
+	FILE *file = fopen(path, "wb");
+	if(!file) return false;
+
+	UINT position = 0;
+	bool ok = WriteBlock(file, position, 0, &header, sizeof(header));
+
+	if(!records.empty())
+		ok = ok && WriteBlock(file, position, header.meshOffset, &records[0],
+							  header.meshCount * sizeof(SceneMeshRecord));
+	if(!shapes.empty())
+		ok = ok && WriteBlock(file, position, header.shapeOffset, &shapes[0],
+							  header.shapeCount * sizeof(SceneShapeRecord));
+	if(!instances.empty())
+		ok = ok && WriteBlock(file, position, header.instanceOffset, &instances[0],
+							  header.instanceCount * sizeof(SceneInstanceRecord));
+
+	for(UINT i=0; i<meshes.size() && ok; i++)
+	{
+		const SceneMeshRecord &m = records[i];
+		ok = WriteBlock(file, position, m.vertexOffset, meshes[i].vertices, m.vertexCount * m.stride) &&
+			 WriteBlock(file, position, m.positionOffset, meshes[i].positions, (UINT)GetPositionBytes(m)) &&
+			 WriteBlock(file, position, m.indexOffset, meshes[i].indices, (UINT)GetIndexBytes(m));
+	}
+
+	return fclose(file) == 0 && ok;
+}
+
+///----------------------------------------------------------------------------
+///Writes a block at its offset in the file, the gap since the previous
+///block is zero padding
+///@param	file - output file
+///@param	position - current file position, returned past the block
+///@param	offset - offset of the block (not before position)
+///@param	data - block contents
+///@param	bytes - block size
+///@returns false on a write error
+///----------------------------------------------------------------------------
+bool SceneFile::WriteBlock(FILE *file, UINT &position, UINT offset, const void *data, UINT bytes)
+{
+	static const GLubyte Zeros[ALIGNMENT] = {0};
+
+	UINT padding = offset - position;
+	position = offset + bytes;
+
+	if(padding && fwrite(Zeros, 1, padding, file) != padding) return false;
+	return bytes == 0 || fwrite(data, 1, bytes, file) == bytes;
+}
+
+///----------------------------------------------------------------------------
+///Checks that the header matches this version and that every table and
+///stream lies inside the file
+///@returns true if the file can be used
+///----------------------------------------------------------------------------
+bool SceneFile::Validate() const
+{
+	const SceneFileHeader &h = *m_Header;
+
+	if(memcmp(h.magic, "SMGS", 4) != 0 || h.version != VERSION ||
+	   h.headerSize != sizeof(SceneFileHeader) || h.fileSize != m_Size)
+		return false;
+
+	if(h.meshOffset % ALIGNMENT || h.shapeOffset % ALIGNMENT || h.instanceOffset % ALIGNMENT)
+		return false;
+
+	//the counts come from the file, the sizes are computed in 64 bits so
+	//a huge count can't wrap around to a size that fits
+	if(!IsInside(h.meshOffset, (UINT64)h.meshCount * sizeof(SceneMeshRecord)) ||
+	   !IsInside(h.shapeOffset, (UINT64)h.shapeCount * sizeof(SceneShapeRecord)) ||
+	   !IsInside(h.instanceOffset, (UINT64)h.instanceCount * sizeof(SceneInstanceRecord)))
+		return false;
+
+	for(UINT i=0; i<h.meshCount; i++)
+	{
+		const SceneMeshRecord &m = m_Meshes[i];
+
+		if(m.format >= Mesh::FORMAT_COUNT || m.stride != FormatStride[m.format] ||
+		   m.indexCount % 3 || (m.indexType != GL_UNSIGNED_SHORT && m.indexType != GL_UNSIGNED_INT))
+			return false;
+
+		if(m.vertexOffset % ALIGNMENT || m.positionOffset % ALIGNMENT || m.indexOffset % ALIGNMENT ||
+		   !IsInside(m.vertexOffset, (UINT64)m.vertexCount * m.stride) ||
+		   !IsInside(m.positionOffset, GetPositionBytes(m)) ||
+		   !IsInside(m.indexOffset, GetIndexBytes(m)))
+			return false;
+
+		//an index past the vertices would read outside the streams
+		GLuint maxIndex = 0;
+		if(m.indexType == GL_UNSIGNED_SHORT)
+		{
+			const GLushort *indices = (const GLushort *)(m_View + m.indexOffset);
+			for(UINT j=0; j<m.indexCount; j++)
+				if(indices[j] > maxIndex) maxIndex = indices[j];
+		}
+		else
+		{
+			const GLuint *indices = (const GLuint *)(m_View + m.indexOffset);
+			for(UINT j=0; j<m.indexCount; j++)
+				if(indices[j] > maxIndex) maxIndex = indices[j];
+		}
+
+		if(m.indexCount && maxIndex >= m.vertexCount) return false;
+	}
+
+	for(UINT i=0; i<h.shapeCount; i++)
+	{
+		const SceneShapeRecord &s = m_Shapes[i];
+		if(s.lodCount == 0 || s.lodCount > SceneShapeRecord::MAX_LODS) return false;
+
+		for(UINT j=0; j<s.lodCount; j++)
+			if(s.meshes[j] >= h.meshCount || s.shadowMeshes[j] >= h.meshCount) return false;
+	}
+
+	for(UINT i=0; i<h.instanceCount; i++)
+		if(m_Instances[i].shape >= h.shapeCount) return false;
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the byte range lies inside the file
+///----------------------------------------------------------------------------
+bool SceneFile::IsInside(UINT offset, UINT64 bytes) const
+{
+	return offset <= m_Size && bytes <= m_Size - offset;
+}
+
+///----------------------------------------------------------------------------
+///@returns the offset rounded up to the next multiple of ALIGNMENT
+///----------------------------------------------------------------------------
+UINT64 SceneFile::Align(UINT64 offset)
+{
+	return (offset + ALIGNMENT - 1) & ~(UINT64)(ALIGNMENT - 1);
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the position-only stream of a mesh
+///----------------------------------------------------------------------------
+UINT64 SceneFile::GetPositionBytes(const SceneMeshRecord &mesh)
+{
+	return (UINT64)mesh.vertexCount * (mesh.quantizedPositions ? 4*sizeof(GLshort) : 3*sizeof(GLfloat));
+}
+
+///----------------------------------------------------------------------------
+///@returns the size in bytes of the triangle list of a mesh
+///----------------------------------------------------------------------------
+UINT64 SceneFile::GetIndexBytes(const SceneMeshRecord &mesh)
+{
+	return (UINT64)mesh.indexCount * (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
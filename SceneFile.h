@@ -0,0 +1,153 @@
+///============================================================================
+///@file	SceneFile.h
+///@brief	Binary scene container. The file holds a header, a table of
+///			meshes, a table of shapes (levels of detail of the meshes) and a
+///			table of object instances, followed by the vertex and index
+///			streams of every mesh exactly as they are uploaded. Streams are
+///			aligned so the mapped file is handed to the GL without parsing
+///			or copying anything.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include <GL/gl.h>
+#include "Mesh.h"
+#include "MappedFile.h"
+
+///----------------------------------------------------------------------------
+///File header, always at offset 0
+///----------------------------------------------------------------------------
+struct SceneFileHeader
+{
+	char	magic[4];		///> "SMGS"
+	UINT	version;		///> SceneFile::VERSION of the writer
+	UINT	headerSize;		///> sizeof(SceneFileHeader)
+	UINT	fileSize;		///> Total size of the file
+	UINT	meshCount;		///> Entries in the mesh table
+	UINT	meshOffset;		///> Offset of the mesh table
+	UINT	shapeCount;		///> Entries in the shape table
+	UINT	shapeOffset;	///> Offset of the shape table
+	UINT	instanceCount;	///> Entries in the instance table
+	UINT	instanceOffset;	///> Offset of the instance table
+};
+
+///----------------------------------------------------------------------------
+///A mesh and the location of its streams
+///----------------------------------------------------------------------------
+struct SceneMeshRecord
+{
+	UINT	format;					///> Mesh::VertexFormat of the full vertices
+	UINT	vertexCount;			///> Number of vertices
+	UINT	indexCount;				///> Number of indices
+	UINT	stride;					///> Size of a full vertex
+	UINT	indexType;				///> GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	UINT	quantizedPositions;		///> Position stream uses 4 shorts
+	UINT	vertexOffset;			///> Offset of the full vertex stream
+	UINT	positionOffset;			///> Offset of the position-only stream
+	UINT	indexOffset;			///> Offset of the triangle list
+	GLfloat	boundsMin[3];			///> Bounds of the vertices
+	GLfloat	boundsMax[3];
+	GLfloat	dequantizeScale[3];		///> Quantized to object space scale
+	GLfloat	dequantizeOffset[3];	///> Quantized to object space offset
+	GLfloat	originalStats[3];		///> ACMR, ATVR and overdraw as generated
+	GLfloat	stats[3];				///> ACMR, ATVR and overdraw as stored
+};
+
+///----------------------------------------------------------------------------
+///Levels of detail of a shape (indices into the mesh table)
+///----------------------------------------------------------------------------
+struct SceneShapeRecord
+{
+	static const UINT MAX_LODS = 3;	///> Max levels per shape
+
+	UINT	lodCount;				///> Number of levels
+	UINT	meshes[MAX_LODS];		///> Mesh of each level
+	UINT	shadowMeshes[MAX_LODS];	///> Shadow proxy of each level
+	GLfloat	minSize[MAX_LODS];		///> Smallest projected size of each level
+};
+
+///----------------------------------------------------------------------------
+///An object instance
+///----------------------------------------------------------------------------
+struct SceneInstanceRecord
+{
+	enum Flags
+	{
+		ANIMATED = 1,	///> Rotates with the spheres
+		OCCLUDER = 2	///> occluderMin/Max is valid
+	};
+
+	UINT	shape;			///> Index into the shape table
+	UINT	flags;			///> Combination of Flags
+	GLubyte	color[4];		///> RGBA8 color
+	GLfloat	transform[16];	///> Column-major object transform
+	GLfloat	boundsMin[3];	///> Bounds of the shape in object space
+	GLfloat	boundsMax[3];
+	GLfloat	occluderMin[3];	///> Box inside the shape in object space
+	GLfloat	occluderMax[3];
+};
+
+class SceneFile
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	SceneFile();
+	virtual ~SceneFile();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Open(LPCSTR path);
+	void Close();
+	bool IsOpen() const;
+	UINT GetSize() const;
+	UINT GetMeshCount() const;
+	UINT GetShapeCount() const;
+	UINT GetInstanceCount() const;
+	void GetMesh(UINT mesh, Mesh::Streams &streams) const;
+	const SceneShapeRecord& GetShape(UINT shape) const;
+	const SceneInstanceRecord& GetInstance(UINT instance) const;
+
+	static bool Write(LPCSTR path, const std::vector<Mesh::Streams> &meshes,
+					  const std::vector<SceneShapeRecord> &shapes,
+					  const std::vector<SceneInstanceRecord> &instances);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT VERSION = 1;		///> Bumped whenever a record changes
+	static const UINT ALIGNMENT = 64;	///> Alignment of tables and streams
+
+private:
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	bool Validate() const;
+	bool IsInside(UINT offset, UINT64 bytes) const;
+
+	static UINT64 Align(UINT64 offset);
+	static bool WriteBlock(FILE *file, UINT &position, UINT offset, const void *data, UINT bytes);
+	static UINT64 GetPositionBytes(const SceneMeshRecord &mesh);
+	static UINT64 GetIndexBytes(const SceneMeshRecord &mesh);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	MappedFile		m_File;		///> Mapped file
+	const GLubyte*	m_View;		///> Contents of the file
+	UINT			m_Size;		///> Size of the file
+	const SceneFileHeader*		m_Header;		///> Header in the view
+	const SceneMeshRecord*		m_Meshes;		///> Mesh table in the view
+	const SceneShapeRecord*		m_Shapes;		///> Shape table in the view
+	const SceneInstanceRecord*	m_Instances;	///> Instance table in the view
+};
+
+#endif
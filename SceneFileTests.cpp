@@ -0,0 +1,300 @@
+///============================================================================
+///@file	SceneFileTests.cpp
+///@brief	Writes a scene, reads it back and checks that truncated or
+///			corrupt copies of it are refused before anything is read out
+///			of bounds.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Tests.h"
+#include "SceneFile.h"
+#include <stdio.h>
+#include <string.h>
+
+///----------------------------------------------------------------------------
+///Reads a whole file
+///@returns false if it can't be read
+///----------------------------------------------------------------------------
+static bool LoadBytes(LPCSTR path, std::vector<BYTE> &bytes)
+{
+	FILE *file = fopen(path, "rb");
+	if(!file) return false;
+
+	fseek(file, 0, SEEK_END);
+	bytes.resize(ftell(file));
+	fseek(file, 0, SEEK_SET);
+
+	bool ok = bytes.empty() || fread(&bytes[0], 1, bytes.size(), file) == bytes.size();
+	fclose(file);
+	return ok;
+}
+
+///----------------------------------------------------------------------------
+///Writes the bytes to a scratch file and opens it as a scene
+///@param	bytes - file contents
+///@returns true if the scene was accepted
+///----------------------------------------------------------------------------
+static bool Opens(const std::vector<BYTE> &bytes)
+{
+	char path[MAX_PATH];
+	GetTestFile("corrupt.smgs", path);
+
+	FILE *file = fopen(path, "wb");
+	if(!file) return false;
+	if(!bytes.empty()) fwrite(&bytes[0], 1, bytes.size(), file);
+	fclose(file);
+
+	SceneFile scene;
+	bool ok = scene.Open(path);
+	scene.Close();
+	remove(path);
+
+	return ok;
+}
+
+///----------------------------------------------------------------------------
+///Records of a scene held in memory
+///----------------------------------------------------------------------------
+static SceneFileHeader& Header(std::vector<BYTE> &bytes)
+{
+	return *(SceneFileHeader *)&bytes[0];
+}
+
+static SceneMeshRecord& MeshRecord(std::vector<BYTE> &bytes, UINT mesh)
+{
+	return ((SceneMeshRecord *)&bytes[Header(bytes).meshOffset])[mesh];
+}
+
+static SceneShapeRecord& ShapeRecord(std::vector<BYTE> &bytes, UINT shape)
+{
+	return ((SceneShapeRecord *)&bytes[Header(bytes).shapeOffset])[shape];
+}
+
+static SceneInstanceRecord& InstanceRecord(std::vector<BYTE> &bytes, UINT instance)
+{
+	return ((SceneInstanceRecord *)&bytes[Header(bytes).instanceOffset])[instance];
+}
+
+///----------------------------------------------------------------------------
+///Compares the streams read back with the written ones
+///----------------------------------------------------------------------------
+static bool SameStreams(const Mesh::Streams &a, const Mesh::Streams &b)
+{
+	UINT positionSize = a.quantizedPositions ? 4 * sizeof(GLshort) : 3 * sizeof(GLfloat);
+	UINT indexSize = a.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+	return a.format == b.format && a.vertexCount == b.vertexCount && a.indexCount == b.indexCount &&
+		   a.stride == b.stride && a.indexType == b.indexType && a.quantizedPositions == b.quantizedPositions &&
+		   memcmp(a.vertices, b.vertices, a.vertexCount * a.stride) == 0 &&
+		   memcmp(a.positions, b.positions, a.vertexCount * positionSize) == 0 &&
+		   memcmp(a.indices, b.indices, a.indexCount * indexSize) == 0 &&
+		   memcmp(&a.bounds, &b.bounds, sizeof(AABB)) == 0 &&
+		   memcmp(a.dequantizeScale, b.dequantizeScale, sizeof(a.dequantizeScale)) == 0;
+}
+
+///----------------------------------------------------------------------------
+///Changes one field of the scene at a time, every copy must be refused
+///@param	bytes - valid scene
+///----------------------------------------------------------------------------
+static void CheckCorrupt(const std::vector<BYTE> &bytes)
+{
+	std::vector<BYTE> copy;
+
+	//the copies are written the same way as the corrupt ones
+	copy = bytes;
+	CHECK(Opens(copy));
+
+	//header
+	copy = bytes;
+	Header(copy).magic[0] = 'X';
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	Header(copy).version++;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	Header(copy).headerSize--;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	Header(copy).meshOffset += 4;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	Header(copy).shapeOffset = Header(copy).fileSize + SceneFile::ALIGNMENT;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	Header(copy).instanceCount = 0x10000000;
+	CHECK(!Opens(copy));
+
+	//tables
+	copy = bytes;
+	MeshRecord(copy, 0).format = Mesh::FORMAT_COUNT;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	MeshRecord(copy, 0).stride += 4;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	MeshRecord(copy, 1).indexCount--;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	MeshRecord(copy, 1).indexType = GL_FLOAT;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	MeshRecord(copy, 0).indexOffset += sizeof(GLushort);
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	MeshRecord(copy, 1).vertexOffset = Header(copy).fileSize & ~(SceneFile::ALIGNMENT - 1);
+	CHECK(!Opens(copy));
+
+	//the sizes of both vertex streams wrap around to their real size in
+	//32 bits
+	copy = bytes;
+	MeshRecord(copy, 1).vertexCount += 0x20000000;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	ShapeRecord(copy, 0).lodCount = 0;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	ShapeRecord(copy, 0).lodCount = SceneShapeRecord::MAX_LODS + 1;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	ShapeRecord(copy, 1).shadowMeshes[0] = Header(copy).meshCount;
+	CHECK(!Opens(copy));
+
+	copy = bytes;
+	InstanceRecord(copy, 2).shape = Header(copy).shapeCount;
+	CHECK(!Opens(copy));
+
+	//an index past the vertices of its mesh, in both index types
+	for(UINT mesh=0; mesh<2; mesh++)
+	{
+		copy = bytes;
+		const SceneMeshRecord &m = MeshRecord(copy, mesh);
+		if(m.indexType == GL_UNSIGNED_SHORT)
+			((GLushort *)&copy[m.indexOffset])[m.indexCount - 1] = (GLushort)m.vertexCount;
+		else
+			((GLuint *)&copy[m.indexOffset])[m.indexCount - 1] = m.vertexCount;
+		CHECK(!Opens(copy));
+	}
+}
+
+///----------------------------------------------------------------------------
+///Cuts the scene short, with and without fixing the size in the header
+///@param	bytes - valid scene
+///----------------------------------------------------------------------------
+static void CheckTruncated(const std::vector<BYTE> &bytes)
+{
+	const SceneFileHeader &header = *(const SceneFileHeader *)&bytes[0];
+	UINT size = (UINT)bytes.size();
+	UINT lengths[] =
+	{
+		0, 4, sizeof(SceneFileHeader) - 1, sizeof(SceneFileHeader),
+		header.shapeOffset + 8, header.instanceOffset + 8, size / 2, size - 1
+	};
+
+	for(UINT i=0; i<sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		std::vector<BYTE> copy(bytes.begin(), bytes.begin() + lengths[i]);
+		CHECK(!Opens(copy));
+
+		if(copy.size() < sizeof(SceneFileHeader)) continue;
+
+		Header(copy).fileSize = lengths[i];
+		CHECK(!Opens(copy));
+	}
+}
+
+///----------------------------------------------------------------------------
+///Checks the SceneFile
+///----------------------------------------------------------------------------
+void TestSceneFile()
+{
+	//quantized vertices with 16 bit indices, float vertices with 32 bit
+	//indices and quantized positions
+	Mesh cube, sphere;
+	cube.CreateCube(1.0f);
+	cube.Prepare(Mesh::QUANTIZED_8, false);
+	sphere.CreateSphere(1.0f, 16, 16);
+	sphere.Prepare(Mesh::FLOAT_VERTEX, true);
+
+	std::vector<Mesh::Streams> meshes(2);
+	cube.GetStreams(meshes[0]);
+	sphere.GetStreams(meshes[1]);
+	CHECK(meshes[0].indexType == GL_UNSIGNED_SHORT);
+	CHECK(meshes[1].indexType == GL_UNSIGNED_INT);
+
+	std::vector<SceneShapeRecord> shapes(2);
+	memset(&shapes[0], 0, shapes.size() * sizeof(SceneShapeRecord));
+	for(UINT i=0; i<2; i++)
+	{
+		shapes[i].lodCount = 1;
+		shapes[i].meshes[0] = shapes[i].shadowMeshes[0] = i;
+	}
+
+	std::vector<SceneInstanceRecord> instances(3);
+	memset(&instances[0], 0, instances.size() * sizeof(SceneInstanceRecord));
+	for(UINT i=0; i<3; i++)
+	{
+		instances[i].shape = i % 2;
+		instances[i].transform[0] = instances[i].transform[5] = 1.0f;
+		instances[i].transform[10] = instances[i].transform[15] = 1.0f;
+		instances[i].transform[12] = (GLfloat)i;
+	}
+
+	char path[MAX_PATH];
+	GetTestFile("scene.smgs", path);
+	CHECK(SceneFile::Write(path, meshes, shapes, instances));
+
+	//read back as written
+	SceneFile scene;
+	CHECK(scene.Open(path));
+	if(scene.IsOpen())
+	{
+		CHECK(scene.GetMeshCount() == 2 && scene.GetShapeCount() == 2 && scene.GetInstanceCount() == 3);
+
+		for(UINT i=0; i<scene.GetMeshCount(); i++)
+		{
+			Mesh::Streams streams;
+			scene.GetMesh(i, streams);
+			CHECK(SameStreams(streams, meshes[i]));
+		}
+
+		CHECK(scene.GetInstance(2).shape == 0 && scene.GetInstance(2).transform[12] == 2.0f);
+		scene.Close();
+	}
+
+	std::vector<BYTE> bytes;
+	CHECK(LoadBytes(path, bytes));
+	remove(path);
+
+	if(bytes.size() >= sizeof(SceneFileHeader))
+	{
+		CHECK(Header(bytes).fileSize == bytes.size());
+		for(UINT i=0; i<2; i++)
+		{
+			const SceneMeshRecord &m = MeshRecord(bytes, i);
+			CHECK(m.vertexOffset % SceneFile::ALIGNMENT == 0 && m.positionOffset % SceneFile::ALIGNMENT == 0 &&
+				  m.indexOffset % SceneFile::ALIGNMENT == 0);
+		}
+
+		CheckCorrupt(bytes);
+		CheckTruncated(bytes);
+	}
+
+	//a layout past 32 bit offsets isn't written
+	std::vector<Mesh::Streams> huge(1, meshes[0]);
+	huge[0].vertexCount = 0x10000000;
+	CHECK(!SceneFile::Write(path, huge, shapes, instances));
+}
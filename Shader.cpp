@@ -0,0 +1,215 @@
+///============================================================================
+///@file	Shader.cpp
+///@brief	GLSL program built from sources embedded in the demo.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+Shader::Shader() : m_Program(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+Shader::~Shader()
+{
+}
+
+///----------------------------------------------------------------------------
+///Compiles a shader stage, errors go to the debugger output
+///@param	type - GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER,
+///			GL_COMPUTE_SHADER
+///@param	source - GLSL source
+///@returns the shader object or 0 if it didn't compile
+///----------------------------------------------------------------------------
+GLuint Shader::Compile(GLenum type, LPCSTR source)
+{
+	GLuint shader = glCreateShader(type);
+	if(!shader) return 0;
+
+	const GLchar *sources[1] = {source};
+	glShaderSource(shader, 1, sources, NULL);
+	glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if(status != GL_TRUE)
+	{
+		GLchar log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		OutputDebugStringA(log);
+
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+///----------------------------------------------------------------------------
+///Compiles and links the program (the context must be current)
+///@param	vertexSource - vertex shader source (NULL for fixed-function)
+///@param	fragmentSource - fragment shader source (NULL for fixed-function)
+///@returns false if shaders are not supported or the sources don't build
+///----------------------------------------------------------------------------
+bool Shader::Create(LPCSTR vertexSource, LPCSTR fragmentSource)
+{
+	Release();
+	if(!g_GLCaps.glsl) return false;
+
+	GLuint vertex = vertexSource ? Compile(GL_VERTEX_SHADER, vertexSource) : 0;
+	GLuint fragment = fragmentSource ? Compile(GL_FRAGMENT_SHADER, fragmentSource) : 0;
+
+	if((vertexSource && !vertex) || (fragmentSource && !fragment))
+	{
+		if(vertex) glDeleteShader(vertex);
+		if(fragment) glDeleteShader(fragment);
+		return false;
+	}
+
+	return Link(vertex, fragment);
+}
+
+///----------------------------------------------------------------------------
+///Compiles and links a compute program (the context must be current)
+///@param	computeSource - compute shader source
+///@returns false if compute shaders are not supported or the source
+///			doesn't build
+///----------------------------------------------------------------------------
+bool Shader::CreateCompute(LPCSTR computeSource)
+{
+	Release();
+	if(!g_GLCaps.computeShader) return false;
+
+	GLuint compute = Compile(GL_COMPUTE_SHADER, computeSource);
+	if(!compute) return false;
+
+	return Link(compute, 0);
+}
+
+///----------------------------------------------------------------------------
+///Compiles and links a program whose geometry shader routes the primitives
+///to the layers of a layered framebuffer (the context must be current)
+///@param	vertexSource - vertex shader source
+///@param	geometrySource - geometry shader source
+///@param	fragmentSource - fragment shader source
+///@returns false if layered rendering is not supported or the sources
+///			don't build
+///----------------------------------------------------------------------------
+bool Shader::CreateLayered(LPCSTR vertexSource, LPCSTR geometrySource, LPCSTR fragmentSource)
+{
+	Release();
+	if(!g_GLCaps.layeredRendering) return false;
+
+	GLuint vertex = Compile(GL_VERTEX_SHADER, vertexSource);
+	GLuint geometry = Compile(GL_GEOMETRY_SHADER, geometrySource);
+	GLuint fragment = Compile(GL_FRAGMENT_SHADER, fragmentSource);
+
+	if(!vertex || !geometry || !fragment)
+	{
+		if(vertex) glDeleteShader(vertex);
+		if(geometry) glDeleteShader(geometry);
+		if(fragment) glDeleteShader(fragment);
+		return false;
+	}
+
+	return Link(vertex, geometry, fragment);
+}
+
+///----------------------------------------------------------------------------
+///Links the compiled stages into the program and deletes them
+///@param	first, second, third - shader objects (0 if unused)
+///@returns false if the program doesn't link
+///----------------------------------------------------------------------------
+bool Shader::Link(GLuint first, GLuint second, GLuint third)
+{
+	m_Program = glCreateProgram();
+	if(first) glAttachShader(m_Program, first);
+	if(second) glAttachShader(m_Program, second);
+	if(third) glAttachShader(m_Program, third);
+	glLinkProgram(m_Program);
+
+	//the program keeps the stages alive
+	if(first) glDeleteShader(first);
+	if(second) glDeleteShader(second);
+	if(third) glDeleteShader(third);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(m_Program, GL_LINK_STATUS, &status);
+	if(status != GL_TRUE)
+	{
+		GLchar log[1024];
+		glGetProgramInfoLog(m_Program, sizeof(log), NULL, log);
+		OutputDebugStringA(log);
+
+		Release();
+		return false;
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the program (the context must be current)
+///----------------------------------------------------------------------------
+void Shader::Release()
+{
+	if(m_Program) glDeleteProgram(m_Program);
+	m_Program = 0;
+}
+
+///----------------------------------------------------------------------------
+///Makes the program current
+///----------------------------------------------------------------------------
+void Shader::Bind() const
+{
+	g_GLState.UseProgram(m_Program);
+}
+
+///----------------------------------------------------------------------------
+///Goes back to the fixed-function pipeline
+///----------------------------------------------------------------------------
+void Shader::Unbind()
+{
+	if(g_GLCaps.glsl) g_GLState.UseProgram(0);
+}
+
+///----------------------------------------------------------------------------
+///@returns the location of a uniform (-1 if not used by the program)
+///----------------------------------------------------------------------------
+GLint Shader::GetUniform(LPCSTR name) const
+{
+	return m_Program ? glGetUniformLocation(m_Program, name) : -1;
+}
+
+///----------------------------------------------------------------------------
+///@returns the location of a vertex attribute (-1 if not used)
+///----------------------------------------------------------------------------
+GLint Shader::GetAttribute(LPCSTR name) const
+{
+	return m_Program ? glGetAttribLocation(m_Program, name) : -1;
+}
+
+///----------------------------------------------------------------------------
+///@returns the program object
+///----------------------------------------------------------------------------
+GLuint Shader::GetProgram() const
+{
+	return m_Program;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the program was built
+///----------------------------------------------------------------------------
+bool Shader::IsValid() const
+{
+	return m_Program != 0;
+}
@@ -0,0 +1,54 @@
+///============================================================================
+///@file	Shader.h
+///@brief	GLSL program built from sources embedded in the demo. Only the
+///			stages we need are given, the rest of the pipeline stays
+///			fixed-function.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+class Shader
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	Shader();
+	virtual ~Shader();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(LPCSTR vertexSource, LPCSTR fragmentSource);
+	bool CreateCompute(LPCSTR computeSource);
+	bool CreateLayered(LPCSTR vertexSource, LPCSTR geometrySource, LPCSTR fragmentSource);
+	void Release();
+	void Bind() const;
+	GLint GetUniform(LPCSTR name) const;
+	GLint GetAttribute(LPCSTR name) const;
+	GLuint GetProgram() const;
+	bool IsValid() const;
+
+	static void Unbind();
+
+private:
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	static GLuint Compile(GLenum type, LPCSTR source);
+	bool Link(GLuint first, GLuint second, GLuint third = 0);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	GLuint m_Program;	///> Linked program object (0 if not created)
+};
+
+#endif
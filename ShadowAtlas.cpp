@@ -0,0 +1,609 @@
+///============================================================================
+///@file	ShadowAtlas.cpp
+///@brief	One large depth texture shared by the shadow maps of many lights.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "ShadowAtlas.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+const GLfloat ShadowAtlas::TILE_HYSTERESIS = 0.15f;
+
+//largest atlas, the quadtree levels from it down to MIN_TILE
+static const UINT MaxAtlasSize = 8192;
+
+///----------------------------------------------------------------------------
+///Functor that orders the lights to pack, largest tile first and the most
+///important first among equal tiles
+///----------------------------------------------------------------------------
+struct PackOrder
+{
+	const UINT *sizes;
+	const ShadowAtlas::Request *requests;
+
+	bool operator()(UINT a, UINT b) const
+	{
+		if(sizes[a] != sizes[b]) return sizes[a] > sizes[b];
+		return requests[a].importance > requests[b].importance;
+	}
+};
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+ShadowAtlas::ShadowAtlas() : m_Texture(0), m_Framebuffer(0), m_Size(0), m_Levels(0),
+							 m_Repacks(0), m_Fresh(0), m_Shrunk(0)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+ShadowAtlas::~ShadowAtlas()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///Creates the atlas texture and, if available, the framebuffer object that
+///renders into it (the context must be current)
+///@param	size - atlas size in texels, rounded down to a power of two
+///@returns true if the atlas was created
+///----------------------------------------------------------------------------
+bool ShadowAtlas::Create(UINT size)
+{
+	Release();
+
+	m_Size = MIN_TILE * 2;
+	while(m_Size * 2 <= size && m_Size * 2 <= MaxAtlasSize) m_Size *= 2;
+
+	m_Levels = 1;
+	while((m_Size >> m_Levels) >= MIN_TILE) m_Levels++;
+
+	if(g_GLCaps.samplerObjects) g_GLState.BindSampler(0);
+
+	glGenTextures(1, &m_Texture);
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_Texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24_ARB, m_Size, m_Size, 0,
+				 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	g_GLState.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	//depth only, nothing is drawn or read from a color buffer
+	if(g_GLCaps.framebufferObject)
+	{
+		glGenFramebuffers(1, &m_Framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_Texture, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		//the tiles are drawn in the back buffer and copied then
+		if(!complete)
+		{
+			glDeleteFramebuffers(1, &m_Framebuffer);
+			m_Framebuffer = 0;
+		}
+	}
+
+	m_Tiles.clear();
+	m_Repacks = m_Fresh = m_Shrunk = 0;
+	ClearBlocks();
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the texture and the framebuffer object (the context must be
+///current)
+///----------------------------------------------------------------------------
+void ShadowAtlas::Release()
+{
+	if(m_Framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_Framebuffer);
+		m_Framebuffer = 0;
+	}
+
+	if(m_Texture)
+	{
+		g_GLState.DeleteTexture(m_Texture);
+		glDeleteTextures(1, &m_Texture);
+		m_Texture = 0;
+	}
+
+	for(UINT i=0; i<MAX_LEVELS; i++)
+		m_Free[i].clear();
+
+	m_Tiles.clear();
+	m_Size = m_Levels = 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the atlas was created
+///----------------------------------------------------------------------------
+bool ShadowAtlas::IsValid() const
+{
+	return m_Texture != 0;
+}
+
+///----------------------------------------------------------------------------
+///Gives every light a tile of the size it asks for. A light keeps its tile
+///while the size doesn't change, the others are allocated largest first.
+///If the requested area is larger than the atlas the tiles whose texels
+///are worth the least (importance per texel) are halved first, and the
+///least important lights lose their shadow once every tile is MIN_TILE.
+///If the free blocks are too fragmented for the new tiles, the whole
+///atlas is packed again.
+///@param	requests - tile of each light, indexed by light
+///----------------------------------------------------------------------------
+void ShadowAtlas::Allocate(const std::vector<Request> &requests)
+{
+	if(!IsValid()) return;
+
+	UINT count = (UINT)requests.size();
+
+	//the lights that are gone give their tiles back
+	for(UINT i=count; i<m_Tiles.size(); i++)
+	{
+		if(!m_Tiles[i].size) continue;
+
+		Block block = {m_Tiles[i].x, m_Tiles[i].y};
+		FreeBlock(block, m_Tiles[i].size);
+	}
+
+	Tile none = {0, 0, 0, false};
+	m_Tiles.resize(count, none);
+	m_Fresh = m_Shrunk = 0;
+
+	//round the requests to the tiles the quadtree has
+	std::vector<UINT> sizes(count, 0);
+	double area = 0.0;
+	for(UINT i=0; i<count; i++)
+	{
+		m_Tiles[i].fresh = false;
+		if(requests[i].size == 0) continue;
+
+		UINT size = MIN_TILE;
+		while(size * 2 <= requests[i].size && size * 2 <= m_Size) size *= 2;
+
+		sizes[i] = size;
+		area += (double)size * size;
+	}
+
+	//shrink until the tiles fit in the atlas
+	std::vector<bool> shrunk(count, false);
+	while(area > (double)m_Size * m_Size)
+	{
+		UINT cheapest = count, weakest = count;
+		for(UINT i=0; i<count; i++)
+		{
+			if(sizes[i] == 0) continue;
+
+			if(sizes[i] > MIN_TILE && (cheapest == count ||
+			   requests[i].importance * sizes[cheapest] < requests[cheapest].importance * sizes[i]))
+				cheapest = i;
+
+			if(weakest == count || requests[i].importance < requests[weakest].importance)
+				weakest = i;
+		}
+
+		UINT light = cheapest < count ? cheapest : weakest;
+		area -= (double)sizes[light] * sizes[light];
+		sizes[light] = cheapest < count ? sizes[light] / 2 : 0;
+		area += (double)sizes[light] * sizes[light];
+		shrunk[light] = true;
+	}
+
+	for(UINT i=0; i<count; i++)
+	{
+		if(shrunk[i]) m_Shrunk++;
+	}
+
+	//the lights whose size changed give their tiles back
+	for(UINT i=0; i<count; i++)
+	{
+		Tile &tile = m_Tiles[i];
+		if(tile.size && tile.size != sizes[i])
+		{
+			Block block = {tile.x, tile.y};
+			FreeBlock(block, tile.size);
+			tile.size = 0;
+		}
+	}
+
+	if(!Pack(sizes, requests))
+	{
+		ClearBlocks();
+		for(UINT i=0; i<count; i++)
+			m_Tiles[i].size = 0;
+
+		Pack(sizes, requests);
+		m_Repacks++;
+	}
+
+	for(UINT i=0; i<count; i++)
+	{
+		if(m_Tiles[i].fresh) m_Fresh++;
+	}
+}
+
+///----------------------------------------------------------------------------
+///@returns the tile of a light (size 0 if it has none or it wasn't
+///			allocated yet)
+///----------------------------------------------------------------------------
+const ShadowAtlas::Tile& ShadowAtlas::GetTile(UINT light) const
+{
+	static const Tile None = {0, 0, 0, false};
+	if(light >= m_Tiles.size()) return None;
+
+	return m_Tiles[light];
+}
+
+///----------------------------------------------------------------------------
+///Gets where the [0,1] texture coordinates of a light's shadow map go in
+///the atlas: u' = offsetX + u * scale
+///@param	light - the light
+///@param	transform - returned offset x, offset y and scale
+///----------------------------------------------------------------------------
+void ShadowAtlas::GetTileTransform(UINT light, GLdouble transform[3]) const
+{
+	const Tile &tile = m_Tiles[light];
+	transform[0] = (GLdouble)tile.x / m_Size;
+	transform[1] = (GLdouble)tile.y / m_Size;
+	transform[2] = (GLdouble)tile.size / m_Size;
+}
+
+///----------------------------------------------------------------------------
+///Starts drawing tiles, the caller sets the shadow pass state and restores
+///the viewport when done
+///----------------------------------------------------------------------------
+void ShadowAtlas::BeginRender()
+{
+	//never leave the atlas bound while drawing into it
+	g_GLState.BindTexture(GL_TEXTURE_2D, 0);
+	g_GLState.DepthMask(GL_TRUE);
+
+	if(m_Framebuffer) glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	g_GLState.Enable(GL_SCISSOR_TEST);
+}
+
+///----------------------------------------------------------------------------
+///Sets the viewport and scissor to a light's tile and clears its depth.
+///Without a framebuffer object the tile is drawn at the lower-left corner
+///of the back buffer.
+///@param	light - light with a tile
+///----------------------------------------------------------------------------
+void ShadowAtlas::BeginTile(UINT light)
+{
+	const Tile &tile = m_Tiles[light];
+	GLint x = m_Framebuffer ? tile.x : 0;
+	GLint y = m_Framebuffer ? tile.y : 0;
+
+	glViewport(x, y, tile.size, tile.size);
+	glScissor(x, y, tile.size, tile.size);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+///----------------------------------------------------------------------------
+///Finishes a light's tile, copying it from the back buffer without a
+///framebuffer object
+///@param	light - light with a tile
+///----------------------------------------------------------------------------
+void ShadowAtlas::EndTile(UINT light)
+{
+	if(m_Framebuffer) return;
+
+	const Tile &tile = m_Tiles[light];
+	g_GLState.BindTexture(GL_TEXTURE_2D, m_Texture);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, tile.x, tile.y, 0, 0, tile.size, tile.size);
+	g_GLState.BindTexture(GL_TEXTURE_2D, 0);
+}
+
+///----------------------------------------------------------------------------
+///Goes back to drawing into the window
+///----------------------------------------------------------------------------
+void ShadowAtlas::EndRender()
+{
+	g_GLState.Disable(GL_SCISSOR_TEST);
+	if(m_Framebuffer) glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+///----------------------------------------------------------------------------
+///@returns the atlas depth texture
+///----------------------------------------------------------------------------
+GLuint ShadowAtlas::GetTexture() const
+{
+	return m_Texture;
+}
+
+///----------------------------------------------------------------------------
+///@returns the atlas size in texels
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetSize() const
+{
+	return m_Size;
+}
+
+///----------------------------------------------------------------------------
+///@returns the largest tile a light may ask for: a quarter of the atlas, or
+///			what fits in the window when the tiles are drawn in the back
+///			buffer (0 if not even MIN_TILE fits)
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetMaxTileSize(UINT windowWidth, UINT windowHeight) const
+{
+	UINT limit = m_Size / 2;
+	if(!m_Framebuffer) limit = (std::min)(limit, (std::min)(windowWidth, windowHeight));
+	if(limit < MIN_TILE) return 0;
+
+	UINT size = MIN_TILE;
+	while(size * 2 <= limit) size *= 2;
+
+	return size;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the tiles are drawn straight into the atlas (or drawn in
+///			the back buffer and copied)
+///----------------------------------------------------------------------------
+bool ShadowAtlas::IsRenderedDirectly() const
+{
+	return m_Framebuffer != 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of lights with a tile
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetTileCount() const
+{
+	UINT count = 0;
+	for(UINT i=0; i<m_Tiles.size(); i++)
+	{
+		if(m_Tiles[i].size) count++;
+	}
+
+	return count;
+}
+
+///----------------------------------------------------------------------------
+///@returns the texels covered by tiles
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetUsedArea() const
+{
+	UINT area = 0;
+	for(UINT i=0; i<m_Tiles.size(); i++)
+		area += m_Tiles[i].size * m_Tiles[i].size;
+
+	return area;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of free blocks (how fragmented the free space is)
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetFreeBlockCount() const
+{
+	UINT count = 0;
+	for(UINT i=0; i<m_Levels; i++)
+		count += (UINT)m_Free[i].size();
+
+	return count;
+}
+
+///----------------------------------------------------------------------------
+///@returns how many times the whole atlas was packed again
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetRepackCount() const
+{
+	return m_Repacks;
+}
+
+///----------------------------------------------------------------------------
+///@returns the tiles allocated or moved by the last Allocate
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetFreshCount() const
+{
+	return m_Fresh;
+}
+
+///----------------------------------------------------------------------------
+///@returns the requests the last Allocate shrunk or dropped to fit
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetShrunkCount() const
+{
+	return m_Shrunk;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes of the atlas texture (24 bit depth stored in 32 bits)
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetTextureBytes() const
+{
+	return m_Size * m_Size * 4;
+}
+
+///----------------------------------------------------------------------------
+///Writes the atlas usage and the tile of every light
+///@param	file - output file (i.e. the benchmark report)
+///----------------------------------------------------------------------------
+void ShadowAtlas::WriteReport(FILE *file) const
+{
+	if(!IsValid()) return;
+
+	fprintf(file, "Shadow atlas: %ux%u (%.1f KB), %s\n", m_Size, m_Size, GetTextureBytes() / 1024.0,
+			m_Framebuffer ? "drawn through a framebuffer object" : "drawn in the back buffer and copied");
+	fprintf(file, "%u tiles, %.1f%% used, %u free blocks, %u repacks\n", GetTileCount(),
+			100.0 * GetUsedArea() / ((double)m_Size * m_Size), GetFreeBlockCount(), m_Repacks);
+
+	fprintf(file, "%-6s %6s %6s %6s\n", "Light", "X", "Y", "Size");
+	for(UINT i=0; i<m_Tiles.size(); i++)
+	{
+		const Tile &tile = m_Tiles[i];
+		if(tile.size)
+			fprintf(file, "%-6u %6u %6u %6u\n", i, tile.x, tile.y, tile.size);
+		else
+			fprintf(file, "%-6u %6s\n", i, "none");
+	}
+}
+
+///----------------------------------------------------------------------------
+///Picks the tile size for a light. The size is the importance (the
+///fraction of the screen the light covers) times the largest tile, rounded
+///down to a power of two, and the current size is kept while the
+///importance stays within TILE_HYSTERESIS of it so the tiles don't move
+///back and forth.
+///@param	importance - 0 for a light that lights nothing on screen, 1 for
+///			one that covers the screen
+///@param	maxTile - the largest tile (GetMaxTileSize)
+///@param	current - the light's current tile size (0 if none)
+///@returns the tile size (0 for no shadow)
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetTileSize(GLfloat importance, UINT maxTile, UINT current)
+{
+	if(importance <= 0.0f || maxTile < MIN_TILE) return 0;
+
+	GLfloat texels = importance * maxTile;
+	if(current >= MIN_TILE && current <= maxTile &&
+	   texels >= current * (1.0f - TILE_HYSTERESIS) &&
+	   texels < current * 2.0f * (1.0f + TILE_HYSTERESIS))
+		return current;
+
+	UINT size = MIN_TILE;
+	while(size * 2 <= texels && size * 2 <= maxTile) size *= 2;
+
+	return size;
+}
+
+///----------------------------------------------------------------------------
+///@returns the quadtree level of a tile size (0 is the whole atlas)
+///----------------------------------------------------------------------------
+UINT ShadowAtlas::GetLevel(UINT size) const
+{
+	UINT level = 0;
+	while((m_Size >> level) > size && level + 1 < m_Levels) level++;
+
+	return level;
+}
+
+///----------------------------------------------------------------------------
+///Takes a free block of a size, splitting the smallest larger block when
+///there is none
+///@param	size - block size
+///@param	block - returned block
+///@returns false if no free block is large enough
+///----------------------------------------------------------------------------
+bool ShadowAtlas::AllocateBlock(UINT size, Block &block)
+{
+	int level = (int)GetLevel(size);
+	int l = level;
+	while(l >= 0 && m_Free[l].empty()) l--;
+	if(l < 0) return false;
+
+	block = m_Free[l].back();
+	m_Free[l].pop_back();
+
+	//keep the lower-left quarter, the other three stay free
+	for(UINT half = m_Size >> (l + 1); l < level; l++, half /= 2)
+	{
+		Block b;
+		b.x = block.x + half;	b.y = block.y;			m_Free[l + 1].push_back(b);
+		b.x = block.x;			b.y = block.y + half;	m_Free[l + 1].push_back(b);
+		b.x = block.x + half;	b.y = block.y + half;	m_Free[l + 1].push_back(b);
+	}
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Gives a block back, merging it with its siblings while all four are free
+///@param	block - the block
+///@param	size - its size
+///----------------------------------------------------------------------------
+void ShadowAtlas::FreeBlock(Block block, UINT size)
+{
+	UINT level = GetLevel(size);
+
+	while(level > 0)
+	{
+		UINT parent = size * 2;
+		UINT px = block.x & ~(parent - 1);
+		UINT py = block.y & ~(parent - 1);
+
+		//the free blocks of a level inside the parent are the siblings
+		std::vector<Block> &free = m_Free[level];
+		UINT siblings[3], found = 0;
+		for(UINT i=0; i<free.size() && found < 3; i++)
+		{
+			if(free[i].x >= px && free[i].x < px + parent &&
+			   free[i].y >= py && free[i].y < py + parent)
+				siblings[found++] = i;
+		}
+
+		if(found < 3) break;
+
+		//remove them from the back so the indices stay valid
+		for(int i=2; i>=0; i--)
+		{
+			free[siblings[i]] = free.back();
+			free.pop_back();
+		}
+
+		block.x = px;
+		block.y = py;
+		size = parent;
+		level--;
+	}
+
+	m_Free[level].push_back(block);
+}
+
+///----------------------------------------------------------------------------
+///Makes the whole atlas one free block
+///----------------------------------------------------------------------------
+void ShadowAtlas::ClearBlocks()
+{
+	for(UINT i=0; i<MAX_LEVELS; i++)
+		m_Free[i].clear();
+
+	Block all = {0, 0};
+	m_Free[0].push_back(all);
+}
+
+///----------------------------------------------------------------------------
+///Allocates the tiles of the lights that have none, largest first
+///@param	sizes - tile size of each light (0 for no shadow)
+///@param	requests - importance of each light
+///@returns false if a tile didn't fit (the ones that fit keep theirs)
+///----------------------------------------------------------------------------
+bool ShadowAtlas::Pack(const std::vector<UINT> &sizes, const std::vector<Request> &requests)
+{
+	std::vector<UINT> order;
+	for(UINT i=0; i<sizes.size(); i++)
+	{
+		if(sizes[i] && m_Tiles[i].size == 0) order.push_back(i);
+	}
+
+	if(order.empty()) return true;
+
+	PackOrder less = {&sizes[0], &requests[0]};
+	std::sort(order.begin(), order.end(), less);
+
+	for(UINT i=0; i<order.size(); i++)
+	{
+		Block block;
+		if(!AllocateBlock(sizes[order[i]], block)) return false;
+
+		Tile &tile = m_Tiles[order[i]];
+		tile.x = block.x;
+		tile.y = block.y;
+		tile.size = sizes[order[i]];
+		tile.fresh = true;
+	}
+
+	return true;
+}
@@ -0,0 +1,126 @@
+///============================================================================
+///@file	ShadowAtlas.h
+///@brief	One large depth texture shared by the shadow maps of many lights.
+///			Every light asks for a square tile whose size follows how much
+///			of the screen it lights, and the tiles are handed out by a
+///			quadtree (buddy) allocator: a tile is a power of two, freeing
+///			one merges it with its three siblings when they are free too,
+///			and a light keeps its tile while its size doesn't change. When
+///			a request doesn't fit the whole atlas is packed again, largest
+///			tiles first, which never fails once the requested area fits, so
+///			reallocating every frame can't fragment the atlas. The shadows
+///			are drawn into their tiles with viewport and scissor, straight
+///			into the atlas with a framebuffer object or, without one, into
+///			the back buffer and copied.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef SHADOWATLAS_H
+#define SHADOWATLAS_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include <GL/gl.h>
+
+class ShadowAtlas
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///Tile a light asks for
+	struct Request
+	{
+		UINT	size;			///> Tile size in texels (0 for no shadow)
+		GLfloat	importance;		///> The less important lights shrink first
+	};
+
+	///Tile given to a light
+	struct Tile
+	{
+		UINT	x;				///> Lower-left corner in texels
+		UINT	y;
+		UINT	size;			///> Size in texels (0 if the light has none)
+		bool	fresh;			///> Allocated or moved by the last Allocate,
+								///> its texels are undefined
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	ShadowAtlas();
+	virtual ~ShadowAtlas();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(UINT size);
+	void Release();
+	bool IsValid() const;
+	void Allocate(const std::vector<Request> &requests);
+	const Tile& GetTile(UINT light) const;
+	void GetTileTransform(UINT light, GLdouble transform[3]) const;
+	void BeginRender();
+	void BeginTile(UINT light);
+	void EndTile(UINT light);
+	void EndRender();
+	GLuint GetTexture() const;
+	UINT GetSize() const;
+	UINT GetMaxTileSize(UINT windowWidth, UINT windowHeight) const;
+	bool IsRenderedDirectly() const;
+	UINT GetTileCount() const;
+	UINT GetUsedArea() const;
+	UINT GetFreeBlockCount() const;
+	UINT GetRepackCount() const;
+	UINT GetFreshCount() const;
+	UINT GetShrunkCount() const;
+	UINT GetTextureBytes() const;
+	void WriteReport(FILE *file) const;
+
+	static UINT GetTileSize(GLfloat importance, UINT maxTile, UINT current);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT DEFAULT_SIZE = 2048;	///> Atlas size in texels
+	static const UINT MIN_TILE = 64;		///> Smallest tile
+	static const UINT MAX_LEVELS = 16;		///> Quadtree levels (8192 / MIN_TILE fits)
+	static const GLfloat TILE_HYSTERESIS;	///> Importance margin before resizing a tile
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///Free block of the quadtree
+	struct Block
+	{
+		UINT	x;				///> Lower-left corner in texels
+		UINT	y;
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	UINT GetLevel(UINT size) const;
+	bool AllocateBlock(UINT size, Block &block);
+	void FreeBlock(Block block, UINT size);
+	void ClearBlocks();
+	bool Pack(const std::vector<UINT> &sizes, const std::vector<Request> &requests);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	GLuint				m_Texture;		///> Depth texture of the atlas
+	GLuint				m_Framebuffer;	///> Renders into m_Texture (0 without FBOs)
+	UINT				m_Size;			///> Atlas size in texels
+	UINT				m_Levels;		///> Quadtree levels down to MIN_TILE
+	std::vector<Block>	m_Free[MAX_LEVELS];	///> Free blocks of each level
+	std::vector<Tile>	m_Tiles;		///> Tile of each light
+	UINT				m_Repacks;		///> Whole atlas packs since Create
+	UINT				m_Fresh;		///> Tiles (re)allocated by the last Allocate
+	UINT				m_Shrunk;		///> Requests shrunk to fit by the last Allocate
+};
+
+#endif
@@ -0,0 +1,284 @@
+///============================================================================
+///@file	ShadowAtlasTests.cpp
+///@brief	Checks the tiles handed out by the shadow atlas: they never
+///			overlap, keep their place while their size doesn't change,
+///			shrink by importance when the atlas is full and merge back
+///			into one free block once every light is gone.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "Tests.h"
+#include "ShadowAtlas.h"
+
+static const UINT AtlasSize = 2048;	//size of the tested atlas
+static const UINT FrameCount = 300;	//random frames of the stress check
+
+///----------------------------------------------------------------------------
+///Checks that the tiles are aligned quadtree blocks inside the atlas and
+///that no two of them overlap
+///@param	atlas - the atlas
+///@param	count - number of lights
+///----------------------------------------------------------------------------
+static void CheckTiles(const ShadowAtlas &atlas, UINT count)
+{
+	bool valid = true, disjoint = true;
+	UINT area = 0, tiles = 0;
+
+	for(UINT i=0; i<count; i++)
+	{
+		const ShadowAtlas::Tile &a = atlas.GetTile(i);
+		if(!a.size) continue;
+
+		tiles++;
+		area += a.size * a.size;
+		if(a.size < ShadowAtlas::MIN_TILE || (a.size & (a.size - 1)) || a.x % a.size || a.y % a.size ||
+		   a.x + a.size > atlas.GetSize() || a.y + a.size > atlas.GetSize())
+			valid = false;
+
+		for(UINT j=0; j<i; j++)
+		{
+			const ShadowAtlas::Tile &b = atlas.GetTile(j);
+			if(b.size && a.x < b.x + b.size && b.x < a.x + a.size &&
+			   a.y < b.y + b.size && b.y < a.y + a.size)
+				disjoint = false;
+		}
+	}
+
+	CHECK(valid);
+	CHECK(disjoint);
+	CHECK(atlas.GetTileCount() == tiles);
+	CHECK(atlas.GetUsedArea() == area);
+}
+
+///----------------------------------------------------------------------------
+///@returns the tile size the atlas gives for a request that fits
+///----------------------------------------------------------------------------
+static UINT GetRoundedSize(UINT size)
+{
+	if(!size) return 0;
+
+	UINT rounded = ShadowAtlas::MIN_TILE;
+	while(rounded * 2 <= size && rounded * 2 <= AtlasSize) rounded *= 2;
+
+	return rounded;
+}
+
+///----------------------------------------------------------------------------
+///Fills the atlas exactly, keeps the tiles, then frees and reuses them
+///----------------------------------------------------------------------------
+static void CheckPacking(ShadowAtlas &atlas)
+{
+	//two quarters and four sixteenths of the atlas area
+	std::vector<ShadowAtlas::Request> requests;
+	ShadowAtlas::Request large = {AtlasSize / 2, 1.0f}, small = {AtlasSize / 4, 1.0f};
+	requests.push_back(large);
+	requests.push_back(large);
+	requests.insert(requests.end(), 4, small);
+
+	atlas.Allocate(requests);
+	CheckTiles(atlas, 6);
+	CHECK(atlas.GetTileCount() == 6);
+	CHECK(atlas.GetUsedArea() == AtlasSize * AtlasSize / 4 * 3);
+	CHECK(atlas.GetFreshCount() == 6);
+	CHECK(atlas.GetShrunkCount() == 0);
+
+	//unchanged requests keep their tiles
+	ShadowAtlas::Tile first = atlas.GetTile(0), last = atlas.GetTile(5);
+	atlas.Allocate(requests);
+	CHECK(atlas.GetFreshCount() == 0);
+	CHECK(atlas.GetTile(0).x == first.x && atlas.GetTile(0).y == first.y);
+	CHECK(atlas.GetTile(5).x == last.x && atlas.GetTile(5).y == last.y);
+
+	//the last quarter fills the atlas
+	requests.push_back(large);
+	atlas.Allocate(requests);
+	CheckTiles(atlas, 7);
+	CHECK(atlas.GetUsedArea() == AtlasSize * AtlasSize);
+	CHECK(atlas.GetFreeBlockCount() == 0);
+	CHECK(atlas.GetFreshCount() == 1);
+
+	//the lights that are gone give their tiles to the new ones, which fit
+	//without packing the atlas again
+	UINT repacks = atlas.GetRepackCount();
+	requests.resize(3);
+	atlas.Allocate(requests);
+	CHECK(atlas.GetTileCount() == 3);
+
+	requests.insert(requests.end(), 3, small);
+	requests.push_back(large);
+	atlas.Allocate(requests);
+	CheckTiles(atlas, 7);
+	CHECK(atlas.GetRepackCount() == repacks);
+	CHECK(atlas.GetTileCount() == 7);
+	CHECK(atlas.GetUsedArea() == AtlasSize * AtlasSize);
+
+	//everything merges back into the whole atlas
+	requests.clear();
+	atlas.Allocate(requests);
+	CHECK(atlas.GetTileCount() == 0);
+	CHECK(atlas.GetFreeBlockCount() == 1);
+}
+
+///----------------------------------------------------------------------------
+///Frees a small tile in every quadrant so a large one only fits once the
+///atlas is packed again
+///----------------------------------------------------------------------------
+static void CheckRepack(ShadowAtlas &atlas)
+{
+	ShadowAtlas::Request request = {AtlasSize / 4, 1.0f};
+	std::vector<ShadowAtlas::Request> requests(16, request);
+	atlas.Allocate(requests);
+	CHECK(atlas.GetFreeBlockCount() == 0);
+
+	//a free quarter in every quadrant, none of them merge
+	std::vector<bool> freed(16, false);
+	for(UINT q=0; q<4; q++)
+	{
+		for(UINT i=0; i<16; i++)
+		{
+			const ShadowAtlas::Tile &tile = atlas.GetTile(i);
+			UINT quadrant = (tile.x >= AtlasSize / 2 ? 1 : 0) + (tile.y >= AtlasSize / 2 ? 2 : 0);
+			if(quadrant != q) continue;
+
+			requests[i].size = 0;
+			freed[i] = true;
+			break;
+		}
+	}
+
+	atlas.Allocate(requests);
+	CHECK(atlas.GetTileCount() == 12);
+	CHECK(atlas.GetFreeBlockCount() == 4);
+
+	UINT repacks = atlas.GetRepackCount();
+	for(UINT i=0; i<16; i++)
+	{
+		if(!freed[i]) continue;
+
+		requests[i].size = AtlasSize / 2;
+		break;
+	}
+
+	atlas.Allocate(requests);
+	CheckTiles(atlas, 16);
+	CHECK(atlas.GetRepackCount() == repacks + 1);
+	CHECK(atlas.GetTileCount() == 13);
+	CHECK(atlas.GetShrunkCount() == 0);
+	CHECK(atlas.GetUsedArea() == AtlasSize * AtlasSize);
+
+	requests.clear();
+	atlas.Allocate(requests);
+	CHECK(atlas.GetFreeBlockCount() == 1);
+}
+
+///----------------------------------------------------------------------------
+///Asks for more than the atlas holds: the least important lights shrink
+///first and lose their shadow once every tile is MIN_TILE
+///----------------------------------------------------------------------------
+static void CheckShrink(ShadowAtlas &atlas)
+{
+	std::vector<ShadowAtlas::Request> requests;
+	for(UINT i=0; i<8; i++)
+	{
+		ShadowAtlas::Request request = {AtlasSize, 1.0f + i};
+		requests.push_back(request);
+	}
+
+	atlas.Allocate(requests);
+	CheckTiles(atlas, 8);
+	CHECK(atlas.GetShrunkCount() == 8);
+	CHECK(atlas.GetTileCount() == 8);
+
+	bool ordered = true;
+	for(UINT i=1; i<8; i++)
+		if(atlas.GetTile(i).size < atlas.GetTile(i - 1).size) ordered = false;
+	CHECK(ordered);
+
+	//one more light than MIN_TILE tiles fit, the weakest one goes
+	UINT fit = (AtlasSize / ShadowAtlas::MIN_TILE) * (AtlasSize / ShadowAtlas::MIN_TILE);
+	requests.clear();
+	for(UINT i=0; i<=fit; i++)
+	{
+		ShadowAtlas::Request request = {ShadowAtlas::MIN_TILE, i == fit / 2 ? 0.5f : 1.0f};
+		requests.push_back(request);
+	}
+
+	atlas.Allocate(requests);
+	CheckTiles(atlas, fit + 1);
+	CHECK(atlas.GetTileCount() == fit);
+	CHECK(atlas.GetTile(fit / 2).size == 0);
+	CHECK(atlas.GetUsedArea() == AtlasSize * AtlasSize);
+
+	requests.clear();
+	atlas.Allocate(requests);
+	CHECK(atlas.GetFreeBlockCount() == 1);
+}
+
+///----------------------------------------------------------------------------
+///Lights come and go and change their size every frame
+///----------------------------------------------------------------------------
+static void CheckRandomFrames(ShadowAtlas &atlas)
+{
+	std::vector<ShadowAtlas::Request> requests;
+	bool exact = true;
+
+	for(UINT frame=0; frame<FrameCount; frame++)
+	{
+		UINT previous = (UINT)requests.size();
+		UINT count = (UINT)RandomFloat(0.0f, 40.0f);
+		requests.resize(count);
+
+		double area = 0.0;
+		for(UINT i=0; i<count; i++)
+		{
+			//most lights keep their request from one frame to the next
+			if(i >= previous || RandomFloat(0.0f, 1.0f) < 0.3f)
+			{
+				requests[i].size = RandomFloat(0.0f, 1.0f) < 0.1f ? 0 : (UINT)RandomFloat(16.0f, 700.0f);
+				requests[i].importance = RandomFloat(0.1f, 10.0f);
+			}
+
+			area += (double)GetRoundedSize(requests[i].size) * GetRoundedSize(requests[i].size);
+		}
+
+		atlas.Allocate(requests);
+		CheckTiles(atlas, count);
+
+		//what fits is given as asked
+		if(area <= (double)AtlasSize * AtlasSize)
+		{
+			for(UINT i=0; i<count; i++)
+				if(atlas.GetTile(i).size != GetRoundedSize(requests[i].size)) exact = false;
+		}
+	}
+
+	CHECK(exact);
+
+	requests.clear();
+	atlas.Allocate(requests);
+	CHECK(atlas.GetTileCount() == 0);
+	CHECK(atlas.GetFreeBlockCount() == 1);
+}
+
+///----------------------------------------------------------------------------
+///Checks the ShadowAtlas
+///----------------------------------------------------------------------------
+void TestShadowAtlas()
+{
+	ShadowAtlas atlas;
+
+	//the size is rounded down to a power of two
+	CHECK(atlas.Create(AtlasSize + AtlasSize / 2));
+	CHECK(atlas.IsValid());
+	CHECK(atlas.GetSize() == AtlasSize);
+	CHECK(atlas.GetFreeBlockCount() == 1);
+
+	CheckPacking(atlas);
+	CheckRepack(atlas);
+	CheckShrink(atlas);
+	CheckRandomFrames(atlas);
+
+	atlas.Release();
+	CHECK(!atlas.IsValid());
+}
@@ -0,0 +1,379 @@
+///============================================================================
+///@file	ShadowScheduler.cpp
+///@brief	Decides which shadow maps of the atlas are drawn every frame.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "ShadowScheduler.h"
+#include "Profiler.h"
+#include <string.h>
+#include <algorithm>
+
+const double ShadowScheduler::DEFAULT_BUDGET = 1.0;
+const double ShadowScheduler::TILE_COST = 2.0;
+
+//weight of a new measurement in the cost per caster, and the cost assumed
+//before the first one
+static const double CostSmoothing = 0.1;
+static const double InitialCasterCost = 0.02;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+ShadowScheduler::ShadowScheduler() : m_FrameCount(0), m_Frame(0), m_Budget(DEFAULT_BUDGET),
+									 m_CasterCost(InitialCasterCost), m_UpdateStart(0.0),
+									 m_MeasuredTime(0.0), m_EstimatedTime(0.0), m_Updates(0),
+									 m_Forced(0), m_Skipped(0), m_Cached(0), m_MaxStaleness(0)
+{
+	memset(m_Timings, 0, sizeof(m_Timings));
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+ShadowScheduler::~ShadowScheduler()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///Creates the timestamp queries of every frame in flight (the context must
+///be current). Without them, or without a frame pacer that tells when a
+///frame is done, the updates are timed on the CPU.
+///@param	frames - frames in flight of the pacer (0 if it isn't valid)
+///----------------------------------------------------------------------------
+void ShadowScheduler::Create(UINT frames)
+{
+	Release();
+
+	if(!g_GLCaps.timerQuery) return;
+
+	m_FrameCount = (std::min)(frames, (UINT)MAX_FRAMES);
+	for(UINT i=0; i<m_FrameCount; i++)
+		glGenQueriesARB(2, m_Timings[i].queries);
+}
+
+///----------------------------------------------------------------------------
+///Deletes the queries and forgets every tile (the context must be current)
+///----------------------------------------------------------------------------
+void ShadowScheduler::Release()
+{
+	for(UINT i=0; i<m_FrameCount; i++)
+		glDeleteQueriesARB(2, m_Timings[i].queries);
+
+	memset(m_Timings, 0, sizeof(m_Timings));
+	m_FrameCount = 0;
+	m_Frame = 0;
+	m_CasterCost = InitialCasterCost;
+	m_MeasuredTime = 0.0;
+	m_Lights.clear();
+	ResetStatistics();
+}
+
+///----------------------------------------------------------------------------
+///Sets the milliseconds of shadow updates per frame
+///@param	ms - the budget, 0 draws every shadow every frame
+///----------------------------------------------------------------------------
+void ShadowScheduler::SetBudget(double ms)
+{
+	m_Budget = ms;
+}
+
+///----------------------------------------------------------------------------
+///@returns the milliseconds of shadow updates per frame (0 for no limit)
+///----------------------------------------------------------------------------
+double ShadowScheduler::GetBudget() const
+{
+	return m_Budget;
+}
+
+///----------------------------------------------------------------------------
+///Reads the time the updates of the frame that last used this slot took,
+///call after the frame pacer waited for it
+///@param	frame - slot of the current frame (FramePacer::GetFrame)
+///----------------------------------------------------------------------------
+void ShadowScheduler::BeginFrame(UINT frame)
+{
+	if(frame >= m_FrameCount) return;
+
+	Timing &timing = m_Timings[frame];
+	if(!timing.timed) return;
+
+	GLuint64 start = 0, end = 0;
+	glGetQueryObjectui64v(timing.queries[0], GL_QUERY_RESULT_ARB, &start);
+	glGetQueryObjectui64v(timing.queries[1], GL_QUERY_RESULT_ARB, &end);
+	timing.timed = false;
+
+	AddSample(end > start ? (double)(end - start) / 1000000.0 : 0.0, timing.units);
+}
+
+///----------------------------------------------------------------------------
+///Picks the tiles to draw this frame. The tiles without a shadow are always
+///drawn; the stale ones are sorted by importance times the frames they
+///have been stale, and taken while their estimated cost fits the budget
+///(the first one is taken as long as there is budget left, so an
+///expensive light isn't starved). The picked tiles are assumed to be drawn.
+///@param	requests - state of every light's shadow this frame
+///@param	updates - returned lights whose tiles have to be drawn
+///----------------------------------------------------------------------------
+void ShadowScheduler::Schedule(const std::vector<Request> &requests, std::vector<UINT> &updates)
+{
+	m_Frame++;
+	updates.clear();
+	m_Candidates.clear();
+	m_EstimatedTime = 0.0;
+	m_Updates = m_Forced = m_Skipped = m_Cached = m_MaxStaleness = 0;
+
+	if(m_Lights.size() != requests.size())
+	{
+		LightState none;
+		memset(&none, 0, sizeof(none));
+		m_Lights.resize(requests.size(), none);
+	}
+
+	for(UINT i=0; i<requests.size(); i++)
+	{
+		const Request &request = requests[i];
+		LightState &state = m_Lights[i];
+
+		//a light without a tile loses its shadow
+		if(!request.shadowed)
+		{
+			state.valid = state.stale = false;
+			continue;
+		}
+
+		Candidate candidate;
+		candidate.light = i;
+		candidate.cost = m_CasterCost * (request.casters + TILE_COST);
+		candidate.priority = 0.0f;
+
+		if(!state.valid || request.fresh)
+		{
+			updates.push_back(i);
+			m_EstimatedTime += candidate.cost;
+			m_Forced++;
+			continue;
+		}
+
+		bool changed = state.lightHash != request.lightHash || state.casterHash != request.casterHash;
+		if(!changed && m_Budget > 0.0)
+		{
+			m_Cached++;
+			continue;
+		}
+
+		if(!state.stale)
+		{
+			state.stale = true;
+			state.staleSince = m_Frame;
+		}
+
+		candidate.priority = request.importance * (GLfloat)(m_Frame - state.staleSince + 1);
+		m_Candidates.push_back(candidate);
+	}
+
+	std::sort(m_Candidates.begin(), m_Candidates.end(), PriorityGreater());
+
+	bool first = true;
+	for(UINT i=0; i<m_Candidates.size(); i++)
+	{
+		const Candidate &candidate = m_Candidates[i];
+		LightState &state = m_Lights[candidate.light];
+
+		bool fits = m_Budget <= 0.0 || m_EstimatedTime + candidate.cost <= m_Budget ||
+					(first && m_EstimatedTime < m_Budget);
+		if(!fits)
+		{
+			state.skips++;
+			m_Skipped++;
+			m_MaxStaleness = (std::max)(m_MaxStaleness, m_Frame - state.staleSince + 1);
+			continue;
+		}
+
+		updates.push_back(candidate.light);
+		m_EstimatedTime += candidate.cost;
+		first = false;
+	}
+
+	//the tiles drawn are up to date with what they were drawn from
+	for(UINT i=0; i<updates.size(); i++)
+	{
+		const Request &request = requests[updates[i]];
+		LightState &state = m_Lights[updates[i]];
+
+		if(state.stale)
+			state.maxStaleness = (std::max)(state.maxStaleness, m_Frame - state.staleSince);
+
+		state.valid = true;
+		state.stale = false;
+		state.lightHash = request.lightHash;
+		state.casterHash = request.casterHash;
+		state.updates++;
+	}
+	m_Updates = (UINT)updates.size();
+}
+
+///----------------------------------------------------------------------------
+///Starts timing the updates of the frame
+///@param	frame - slot of the current frame (FramePacer::GetFrame)
+///----------------------------------------------------------------------------
+void ShadowScheduler::BeginUpdates(UINT frame)
+{
+	if(frame < m_FrameCount)
+		glQueryCounter(m_Timings[frame].queries[0], GL_TIMESTAMP);
+	else
+		m_UpdateStart = Profiler::GetTime();
+}
+
+///----------------------------------------------------------------------------
+///Ends timing the updates of the frame. The GPU time is read when the
+///frame is done, the CPU time is used at once.
+///@param	frame - slot of the current frame (FramePacer::GetFrame)
+///@param	casters - casters drawn by the updates
+///@param	tiles - tiles drawn by the updates
+///----------------------------------------------------------------------------
+void ShadowScheduler::EndUpdates(UINT frame, UINT casters, UINT tiles)
+{
+	double units = casters + tiles * TILE_COST;
+
+	if(frame < m_FrameCount)
+	{
+		Timing &timing = m_Timings[frame];
+		glQueryCounter(timing.queries[1], GL_TIMESTAMP);
+		timing.units = units;
+		timing.timed = true;
+	}
+	else
+		AddSample(Profiler::GetTime() - m_UpdateStart, units);
+}
+
+///----------------------------------------------------------------------------
+///Folds a measured update time into the cost per caster
+///@param	ms - milliseconds the updates took
+///@param	units - casters they drew plus TILE_COST per tile
+///----------------------------------------------------------------------------
+void ShadowScheduler::AddSample(double ms, double units)
+{
+	m_MeasuredTime = ms;
+	if(units <= 0.0) return;
+
+	m_CasterCost += (ms / units - m_CasterCost) * CostSmoothing;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of tiles drawn this frame
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::GetUpdateCount() const
+{
+	return m_Updates;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of tiles drawn this frame because they held no shadow
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::GetForcedCount() const
+{
+	return m_Forced;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of stale tiles left for a later frame
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::GetSkippedCount() const
+{
+	return m_Skipped;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of tiles that were up to date
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::GetCachedCount() const
+{
+	return m_Cached;
+}
+
+///----------------------------------------------------------------------------
+///@returns the frames the oldest stale tile left this frame has been stale
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::GetMaxStaleness() const
+{
+	return m_MaxStaleness;
+}
+
+///----------------------------------------------------------------------------
+///@returns the estimated milliseconds of this frame's updates
+///----------------------------------------------------------------------------
+double ShadowScheduler::GetEstimatedTime() const
+{
+	return m_EstimatedTime;
+}
+
+///----------------------------------------------------------------------------
+///@returns the milliseconds the last timed updates took
+///----------------------------------------------------------------------------
+double ShadowScheduler::GetMeasuredTime() const
+{
+	return m_MeasuredTime;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the updates are timed with GPU timestamps
+///----------------------------------------------------------------------------
+bool ShadowScheduler::IsTimedOnGPU() const
+{
+	return m_FrameCount != 0;
+}
+
+///----------------------------------------------------------------------------
+///Clears the per-light statistics (i.e. after the benchmark warm-up)
+///----------------------------------------------------------------------------
+void ShadowScheduler::ResetStatistics()
+{
+	for(UINT i=0; i<m_Lights.size(); i++)
+	{
+		LightState &state = m_Lights[i];
+		state.updates = state.skips = state.maxStaleness = 0;
+	}
+
+	m_EstimatedTime = 0.0;
+	m_Updates = m_Forced = m_Skipped = m_Cached = m_MaxStaleness = 0;
+}
+
+///----------------------------------------------------------------------------
+///Writes the budget, the cost model and the updates of every light
+///@param	file - output file (i.e. an opened report file)
+///----------------------------------------------------------------------------
+void ShadowScheduler::WriteReport(FILE *file) const
+{
+	fprintf(file, "Shadow updates: %.3f ms budget%s, %.4f ms per caster (timed on the %s)\n",
+			m_Budget, m_Budget > 0.0 ? "" : " (none, every shadow every frame)",
+			m_CasterCost, IsTimedOnGPU() ? "GPU" : "CPU");
+
+	fprintf(file, "%-6s %8s %8s %10s\n", "Light", "Updates", "Skips", "Max stale");
+	for(UINT i=0; i<m_Lights.size(); i++)
+	{
+		const LightState &state = m_Lights[i];
+		fprintf(file, "%-6u %8u %8u %10u\n", i, state.updates, state.skips, state.maxStaleness);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Hashes a block of memory (FNV-1a), chain calls to hash several blocks
+///@param	data - the bytes to hash
+///@param	bytes - number of bytes
+///@param	hash - hash of the previous blocks (HASH_SEED for the first one)
+///@returns the hash
+///----------------------------------------------------------------------------
+UINT ShadowScheduler::Hash(const void *data, UINT bytes, UINT hash)
+{
+	const BYTE *p = (const BYTE *)data;
+	for(UINT i=0; i<bytes; i++)
+	{
+		hash ^= p[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
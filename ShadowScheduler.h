@@ -0,0 +1,148 @@
+///============================================================================
+///@file	ShadowScheduler.h
+///@brief	Decides which shadow maps of the atlas are drawn every frame. A
+///			tile keeps its depth until the light or one of the casters in
+///			its frustum changes (the caller hashes both), and the stale
+///			tiles are updated most important and oldest first until the
+///			estimated cost reaches a per-frame budget in milliseconds. The
+///			tiles the atlas just (re)allocated are always drawn, they hold
+///			no shadow yet. The cost of a tile is estimated from the number
+///			of casters it draws, with a cost per caster measured from the
+///			time the updates took on the GPU (timestamp queries read once
+///			the frame pacer has waited for the frame) or on the CPU.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef SHADOWSCHEDULER_H
+#define SHADOWSCHEDULER_H
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include <GL/gl.h>
+#include "GLExtensions.h"
+
+class ShadowScheduler
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///State of a light's shadow in the current frame
+	struct Request
+	{
+		bool	shadowed;		///> The light has a tile this frame
+		bool	fresh;			///> The tile was just (re)allocated
+		GLfloat	importance;		///> Fraction of the screen the light covers
+		UINT	lightHash;		///> Hash of the light's matrices
+		UINT	casterHash;		///> Hash of the casters, their levels and transforms
+		UINT	casters;		///> Casters drawn if the tile is updated
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	ShadowScheduler();
+	virtual ~ShadowScheduler();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	void Create(UINT frames);
+	void Release();
+	void SetBudget(double ms);
+	double GetBudget() const;
+	void BeginFrame(UINT frame);
+	void Schedule(const std::vector<Request> &requests, std::vector<UINT> &updates);
+	void BeginUpdates(UINT frame);
+	void EndUpdates(UINT frame, UINT casters, UINT tiles);
+	UINT GetUpdateCount() const;
+	UINT GetForcedCount() const;
+	UINT GetSkippedCount() const;
+	UINT GetCachedCount() const;
+	UINT GetMaxStaleness() const;
+	double GetEstimatedTime() const;
+	double GetMeasuredTime() const;
+	bool IsTimedOnGPU() const;
+	void ResetStatistics();
+	void WriteReport(FILE *file) const;
+
+	static UINT Hash(const void *data, UINT bytes, UINT hash = HASH_SEED);
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT HASH_SEED = 2166136261U;	///> FNV-1a offset basis
+	static const UINT MAX_FRAMES = 4;			///> Frames in flight timed at once
+	static const double DEFAULT_BUDGET;			///> Milliseconds of updates per frame
+	static const double TILE_COST;				///> Cost of a tile in casters (clear, setup)
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///What is known about the depth in a light's tile
+	struct LightState
+	{
+		bool	valid;			///> The tile holds the light's shadow
+		bool	stale;			///> The shadow no longer matches the scene
+		UINT	lightHash;		///> Hashes the tile was drawn with
+		UINT	casterHash;
+		UINT	staleSince;		///> Frame the shadow became stale
+		UINT	updates;		///> Times the tile was drawn
+		UINT	skips;			///> Frames it was stale and not drawn
+		UINT	maxStaleness;	///> Most frames it stayed stale
+	};
+
+	///Stale shadow waiting for an update
+	struct Candidate
+	{
+		UINT	light;			///> Index of the light
+		GLfloat	priority;		///> Importance times frames stale
+		double	cost;			///> Estimated milliseconds
+	};
+
+	///Orders the candidates by decreasing priority
+	struct PriorityGreater
+	{
+		bool operator()(const Candidate &a, const Candidate &b) const
+		{
+			return a.priority > b.priority;
+		}
+	};
+
+	///Timestamps of one frame in flight's updates
+	struct Timing
+	{
+		GLuint	queries[2];		///> Start and end (0 without timer queries)
+		bool	timed;			///> The queries hold results not read yet
+		double	units;			///> Casters drawn between them plus the tiles
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	void AddSample(double ms, double units);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	std::vector<LightState>	m_Lights;		///> One per light
+	std::vector<Candidate>	m_Candidates;	///> Stale shadows of the frame
+	Timing		m_Timings[MAX_FRAMES];	///> One per frame in flight
+	UINT		m_FrameCount;			///> Frames in flight timed on the GPU
+	UINT		m_Frame;				///> Frames scheduled so far
+	double		m_Budget;				///> Milliseconds of updates per frame
+	double		m_CasterCost;			///> Estimated milliseconds per caster
+	double		m_UpdateStart;			///> CPU time the updates started
+	double		m_MeasuredTime;			///> Milliseconds of the last timed updates
+	double		m_EstimatedTime;		///> Milliseconds of the frame's updates
+	UINT		m_Updates;				///> Tiles drawn this frame
+	UINT		m_Forced;				///> Of them, tiles that held no shadow
+	UINT		m_Skipped;				///> Stale tiles left for later
+	UINT		m_Cached;				///> Tiles up to date
+	UINT		m_MaxStaleness;			///> Oldest stale tile left, in frames
+};
+
+#endif
@@ -0,0 +1,529 @@
+///============================================================================
+///@file	SoftwareOcclusion.cpp
+///@brief	CPU occlusion culling with a low resolution depth buffer.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "SoftwareOcclusion.h"
+#include <emmintrin.h>
+#include <malloc.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+//corners of a box are numbered with bit 0=x, bit 1=y, bit 2=z (0=min, 1=max)
+static const int BoxTriangles[12][3] =
+{
+	{0,2,3}, {0,3,1},	//-z
+	{4,5,7}, {4,7,6},	//+z
+	{0,4,6}, {0,6,2},	//-x
+	{1,3,7}, {1,7,5},	//+x
+	{0,1,5}, {0,5,4},	//-y
+	{2,6,7}, {2,7,3}	//+y
+};
+
+///----------------------------------------------------------------------------
+///Functor used to pick the occluders with the largest projected size
+///----------------------------------------------------------------------------
+struct OccluderGreater
+{
+	bool operator()(const std::pair<GLfloat, UINT> &a, const std::pair<GLfloat, UINT> &b) const
+	{
+		return a.first > b.first;
+	}
+};
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+SoftwareOcclusion::SoftwareOcclusion() :
+	m_Depth(NULL), m_HiZ(NULL), m_WorkerCount(0), m_Quit(0), m_Busy(false),
+	m_Occluders(0), m_Culled(0), m_Profiler(NULL)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+SoftwareOcclusion::~SoftwareOcclusion()
+{
+	Shutdown();
+}
+
+///----------------------------------------------------------------------------
+///Allocates the depth buffers and starts the worker threads.
+///@param	profiler - receives the rasterization times (may be NULL)
+///@returns false if the threads could not be created
+///----------------------------------------------------------------------------
+bool SoftwareOcclusion::Init(Profiler *profiler)
+{
+	m_Profiler = profiler;
+
+	//SSE loads and stores need 16 byte aligned rows
+	m_Depth = (GLfloat *)_aligned_malloc(WIDTH * HEIGHT * sizeof(GLfloat), 16);
+	m_HiZ = (GLfloat *)_aligned_malloc((WIDTH/TILE_SIZE) * (HEIGHT/TILE_SIZE) * sizeof(GLfloat), 16);
+	if(!m_Depth || !m_HiZ) return false;
+
+	//leave one core for the render thread
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	UINT count = info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors - 1 : 1;
+	if(count > MAX_WORKERS) count = MAX_WORKERS;
+
+	//split the tile rows evenly between the threads so every thread
+	//can build the hierarchical Z of its own band
+	const int tileRows = HEIGHT / TILE_SIZE;
+	m_Quit = 0;
+
+	for(UINT i=0; i<count; i++)
+	{
+		Worker &w = m_Workers[i];
+		w.owner		= this;
+		w.firstRow	= (int)(tileRows * i / count) * TILE_SIZE;
+		w.lastRow	= (int)(tileRows * (i+1) / count) * TILE_SIZE;
+		w.start		= CreateEvent(NULL, FALSE, FALSE, NULL);
+		w.done		= CreateEvent(NULL, FALSE, FALSE, NULL);
+		w.thread	= CreateThread(NULL, 0, WorkerProc, &w, 0, NULL);
+
+		if(!w.thread)
+		{
+			CloseHandle(w.start);
+			CloseHandle(w.done);
+			break;
+		}
+
+		m_WorkerCount++;
+	}
+
+	return m_WorkerCount > 0;
+}
+
+///----------------------------------------------------------------------------
+///Stops the worker threads and frees the buffers
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::Shutdown()
+{
+	Wait();
+
+	InterlockedExchange(&m_Quit, 1);
+	for(UINT i=0; i<m_WorkerCount; i++)
+		SetEvent(m_Workers[i].start);
+
+	for(UINT i=0; i<m_WorkerCount; i++)
+	{
+		WaitForSingleObject(m_Workers[i].thread, INFINITE);
+		CloseHandle(m_Workers[i].thread);
+		CloseHandle(m_Workers[i].start);
+		CloseHandle(m_Workers[i].done);
+	}
+	m_WorkerCount = 0;
+
+	if(m_Depth) _aligned_free(m_Depth);
+	if(m_HiZ) _aligned_free(m_HiZ);
+	m_Depth = NULL;
+	m_HiZ = NULL;
+}
+
+///----------------------------------------------------------------------------
+///Worker thread main loop
+///----------------------------------------------------------------------------
+DWORD WINAPI SoftwareOcclusion::WorkerProc(LPVOID param)
+{
+	Worker *w = (Worker *)param;
+
+	while(true)
+	{
+		WaitForSingleObject(w->start, INFINITE);
+		if(w->owner->m_Quit) break;
+
+		double start = Profiler::GetTime();
+		w->owner->RasterizeBand(w->firstRow, w->lastRow);
+		w->owner->BuildHiZ(w->firstRow, w->lastRow);
+
+		if(w->owner->m_Profiler)
+			w->owner->m_Profiler->AddTime("SW occlusion raster (all threads)", Profiler::GetTime() - start);
+
+		SetEvent(w->done);
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Selects the occluders for this frame and wakes the workers up. Returns
+///immediately, the caller must Wait() before calling Cull().
+///@param	geometry - the scene
+///@param	candidates - objects inside the camera frustum
+///@param	projection - camera projection matrix
+///@param	view - camera view matrix
+///@param	cameraPos - camera position
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::Begin(const Geometry &geometry, const std::vector<UINT> &candidates,
+							  const GLdouble projection[16], const GLdouble view[16],
+							  const GLfloat cameraPos[3])
+{
+	if(!m_WorkerCount) return;
+
+	Matrix4 P, V;
+	P.Set(projection);
+	V.Set(view);
+	Matrix4::Multiply(P, V, m_ViewProj);
+
+	//rank the occluders in view by their approximate projected area
+	std::vector< std::pair<GLfloat, UINT> > ranked;
+	for(UINT i=0; i<candidates.size(); i++)
+	{
+		Matrix4 world;
+		AABB local, box;
+		if(!geometry.GetOccluder(candidates[i], world, local)) continue;
+
+		local.Transform(world, box);
+
+		GLfloat c[3], d2 = 0.0f, size2 = 0.0f;
+		box.GetCenter(c);
+		for(int k=0; k<3; k++)
+		{
+			d2 += (c[k] - cameraPos[k]) * (c[k] - cameraPos[k]);
+			size2 += (box.max[k] - box.min[k]) * (box.max[k] - box.min[k]);
+		}
+
+		//an occluder around the camera would hide everything
+		bool inside = true;
+		for(int k=0; k<3; k++)
+			inside = inside && cameraPos[k] >= box.min[k] && cameraPos[k] <= box.max[k];
+		if(inside) continue;
+
+		ranked.push_back(std::make_pair(size2 / (d2 + 1e-4f), candidates[i]));
+	}
+
+	m_Occluders = (UINT)ranked.size();
+	if(m_Occluders > MAX_OCCLUDERS)
+	{
+		std::partial_sort(ranked.begin(), ranked.begin() + MAX_OCCLUDERS, ranked.end(), OccluderGreater());
+		m_Occluders = MAX_OCCLUDERS;
+	}
+
+	//transform the occluder corners to clip space once for all the workers
+	m_ClipVerts.resize(m_Occluders * 8 * 4);
+	for(UINT i=0; i<m_Occluders; i++)
+	{
+		Matrix4 world, M;
+		AABB local;
+		geometry.GetOccluder(ranked[i].second, world, local);
+		Matrix4::Multiply(m_ViewProj, world, M);
+
+		for(int c=0; c<8; c++)
+		{
+			GLfloat x = (c & 1) ? local.max[0] : local.min[0];
+			GLfloat y = (c & 2) ? local.max[1] : local.min[1];
+			GLfloat z = (c & 4) ? local.max[2] : local.min[2];
+
+			GLfloat *out = &m_ClipVerts[(i*8 + c) * 4];
+			out[0] = M.m[0]*x + M.m[4]*y + M.m[8]*z  + M.m[12];
+			out[1] = M.m[1]*x + M.m[5]*y + M.m[9]*z  + M.m[13];
+			out[2] = M.m[2]*x + M.m[6]*y + M.m[10]*z + M.m[14];
+			out[3] = M.m[3]*x + M.m[7]*y + M.m[11]*z + M.m[15];
+		}
+	}
+
+	m_Busy = true;
+	for(UINT i=0; i<m_WorkerCount; i++)
+		SetEvent(m_Workers[i].start);
+}
+
+///----------------------------------------------------------------------------
+///Waits until the workers finished the depth buffer of this frame
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::Wait()
+{
+	if(!m_Busy) return;
+
+	HANDLE done[MAX_WORKERS];
+	for(UINT i=0; i<m_WorkerCount; i++)
+		done[i] = m_Workers[i].done;
+
+	WaitForMultipleObjects(m_WorkerCount, done, TRUE, INFINITE);
+	m_Busy = false;
+}
+
+///----------------------------------------------------------------------------
+///Clears a band of the depth buffer and rasterizes every occluder into it
+///@param	firstRow - first row of the band
+///@param	lastRow - one past the last row of the band
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::RasterizeBand(int firstRow, int lastRow)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	for(int i=firstRow*WIDTH; i<lastRow*WIDTH; i+=4)
+		_mm_store_ps(&m_Depth[i], one);
+
+	for(UINT o=0; o<m_Occluders; o++)
+	{
+		const GLfloat *corners = &m_ClipVerts[o * 8 * 4];
+
+		for(int t=0; t<12; t++)
+		{
+			//clip the triangle against the near plane (z >= -w)
+			GLfloat in[3][4], poly[4][4];
+			int count = 0;
+
+			for(int k=0; k<3; k++)
+				memcpy(in[k], &corners[BoxTriangles[t][k] * 4], sizeof(in[k]));
+
+			for(int k=0; k<3; k++)
+			{
+				const GLfloat *a = in[k];
+				const GLfloat *b = in[(k+1) % 3];
+				GLfloat da = a[2] + a[3];
+				GLfloat db = b[2] + b[3];
+
+				if(da >= 0.0f)
+					memcpy(poly[count++], a, sizeof(poly[0]));
+
+				if((da >= 0.0f) != (db >= 0.0f))
+				{
+					GLfloat s = da / (da - db);
+					for(int j=0; j<4; j++)
+						poly[count][j] = a[j] + s * (b[j] - a[j]);
+					count++;
+				}
+			}
+
+			if(count < 3) continue;
+
+			//project to depth buffer coordinates
+			GLfloat screen[4][3];
+			for(int k=0; k<count; k++)
+			{
+				GLfloat invW = 1.0f / poly[k][3];
+				screen[k][0] = (poly[k][0] * invW * 0.5f + 0.5f) * WIDTH;
+				screen[k][1] = (poly[k][1] * invW * 0.5f + 0.5f) * HEIGHT;
+				screen[k][2] =  poly[k][2] * invW * 0.5f + 0.5f;
+			}
+
+			//the clipped polygon is convex, draw it as a fan
+			for(int k=1; k+1<count; k++)
+			{
+				GLfloat tri[3][3];
+				memcpy(tri[0], screen[0], sizeof(tri[0]));
+				memcpy(tri[1], screen[k], sizeof(tri[1]));
+				memcpy(tri[2], screen[k+1], sizeof(tri[2]));
+				RasterizeTriangle(tri, firstRow, lastRow);
+			}
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Rasterizes a screen space triangle four pixels at a time, keeping the
+///nearest depth. Only rows inside [firstRow, lastRow) are touched.
+///@param	v - vertices (x, y in pixels, depth in [0,1])
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::RasterizeTriangle(const GLfloat v[3][3], int firstRow, int lastRow)
+{
+	GLfloat area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) -
+				   (v[2][0] - v[0][0]) * (v[1][1] - v[0][1]);
+	if(fabs(area) < 1e-8f) return;
+
+	//make the triangle counter-clockwise so inside means all edges >= 0
+	const GLfloat *p0 = v[0];
+	const GLfloat *p1 = area > 0.0f ? v[1] : v[2];
+	const GLfloat *p2 = area > 0.0f ? v[2] : v[1];
+	area = fabs(area);
+
+	//pixel bounds, x aligned to the SSE width
+	GLfloat minX = (std::min)(p0[0], (std::min)(p1[0], p2[0]));
+	GLfloat maxX = (std::max)(p0[0], (std::max)(p1[0], p2[0]));
+	GLfloat minY = (std::min)(p0[1], (std::min)(p1[1], p2[1]));
+	GLfloat maxY = (std::max)(p0[1], (std::max)(p1[1], p2[1]));
+
+	int x0 = (std::max)(0, (int)floor(minX)) & ~3;
+	int x1 = (std::min)(WIDTH - 1, (int)ceil(maxX));
+	int y0 = (std::max)(firstRow, (int)floor(minY));
+	int y1 = (std::min)(lastRow - 1, (int)ceil(maxY));
+	if(x0 > x1 || y0 > y1) return;
+
+	//edge functions E(x,y) = A*x + B*y + C, edge i is opposite vertex i
+	GLfloat A0 = p1[1] - p2[1], B0 = p2[0] - p1[0], C0 = p1[0]*p2[1] - p1[1]*p2[0];
+	GLfloat A1 = p2[1] - p0[1], B1 = p0[0] - p2[0], C1 = p2[0]*p0[1] - p2[1]*p0[0];
+	GLfloat A2 = p0[1] - p1[1], B2 = p1[0] - p0[0], C2 = p0[0]*p1[1] - p0[1]*p1[0];
+
+	//depth plane from the barycentric weights
+	GLfloat invArea = 1.0f / area;
+	GLfloat zA = (A0*p0[2] + A1*p1[2] + A2*p2[2]) * invArea;
+	GLfloat zB = (B0*p0[2] + B1*p1[2] + B2*p2[2]) * invArea;
+	GLfloat zC = (C0*p0[2] + C1*p1[2] + C2*p2[2]) * invArea;
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	__m128 a0 = _mm_set1_ps(A0), a1 = _mm_set1_ps(A1), a2 = _mm_set1_ps(A2), za = _mm_set1_ps(zA);
+
+	for(int y=y0; y<=y1; y++)
+	{
+		GLfloat py = y + 0.5f;
+		__m128 row0 = _mm_set1_ps(B0*py + C0);
+		__m128 row1 = _mm_set1_ps(B1*py + C1);
+		__m128 row2 = _mm_set1_ps(B2*py + C2);
+		__m128 rowZ = _mm_set1_ps(zB*py + zC);
+
+		GLfloat *depth = &m_Depth[y * WIDTH];
+
+		for(int x=x0; x<=x1; x+=4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((GLfloat)x), offsets);
+
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+
+			__m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+									 _mm_cmpge_ps(e2, zero));
+			if(_mm_movemask_ps(mask) == 0) continue;
+
+			__m128 z = _mm_add_ps(_mm_mul_ps(za, px), rowZ);
+			__m128 old = _mm_load_ps(&depth[x]);
+			__m128 nearest = _mm_min_ps(old, z);
+
+			_mm_store_ps(&depth[x], _mm_or_ps(_mm_and_ps(mask, nearest), _mm_andnot_ps(mask, old)));
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Builds the hierarchical Z (farthest depth per tile) of a band of rows
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::BuildHiZ(int firstRow, int lastRow)
+{
+	const int tilesX = WIDTH / TILE_SIZE;
+
+	for(int ty=firstRow/TILE_SIZE; ty<lastRow/TILE_SIZE; ty++)
+	{
+		for(int tx=0; tx<tilesX; tx++)
+		{
+			__m128 farthest = _mm_setzero_ps();
+
+			for(int y=0; y<TILE_SIZE; y++)
+			{
+				const GLfloat *row = &m_Depth[(ty*TILE_SIZE + y) * WIDTH + tx*TILE_SIZE];
+				for(int x=0; x<TILE_SIZE; x+=4)
+					farthest = _mm_max_ps(farthest, _mm_load_ps(&row[x]));
+			}
+
+			GLfloat lanes[4];
+			_mm_storeu_ps(lanes, farthest);
+			m_HiZ[ty*tilesX + tx] = (std::max)((std::max)(lanes[0], lanes[1]), (std::max)(lanes[2], lanes[3]));
+		}
+	}
+}
+
+///----------------------------------------------------------------------------
+///Removes the objects hidden behind the occluders.
+///@param	geometry - the scene
+///@param	objects - frustum visible objects, hidden ones are removed
+///----------------------------------------------------------------------------
+void SoftwareOcclusion::Cull(const Geometry &geometry, std::vector<UINT> &objects)
+{
+	m_Culled = 0;
+	if(!m_WorkerCount || !m_Occluders) return;
+
+	UINT kept = 0;
+	for(UINT i=0; i<objects.size(); i++)
+	{
+		if(IsVisible(geometry.GetBounds(objects[i])))
+			objects[kept++] = objects[i];
+	}
+
+	m_Culled = (UINT)objects.size() - kept;
+	objects.resize(kept);
+}
+
+///----------------------------------------------------------------------------
+///Tests a box against the hierarchical Z first and the depth buffer next.
+///@param	box - world space bounds
+///@returns true if some part of the box may be visible
+///----------------------------------------------------------------------------
+bool SoftwareOcclusion::IsVisible(const AABB &box) const
+{
+	GLfloat minX = 1.0f, maxX = -1.0f, minY = 1.0f, maxY = -1.0f, minZ = 1.0f;
+
+	for(int c=0; c<8; c++)
+	{
+		GLfloat p[3], clip[4];
+		p[0] = (c & 1) ? box.max[0] : box.min[0];
+		p[1] = (c & 2) ? box.max[1] : box.min[1];
+		p[2] = (c & 4) ? box.max[2] : box.min[2];
+
+		const GLfloat *m = m_ViewProj.m;
+		clip[0] = m[0]*p[0] + m[4]*p[1] + m[8]*p[2]  + m[12];
+		clip[1] = m[1]*p[0] + m[5]*p[1] + m[9]*p[2]  + m[13];
+		clip[2] = m[2]*p[0] + m[6]*p[1] + m[10]*p[2] + m[14];
+		clip[3] = m[3]*p[0] + m[7]*p[1] + m[11]*p[2] + m[15];
+
+		//crosses the near plane, we can't tell
+		if(clip[2] < -clip[3]) return true;
+
+		GLfloat invW = 1.0f / clip[3];
+		GLfloat x = clip[0] * invW, y = clip[1] * invW, z = clip[2] * invW * 0.5f + 0.5f;
+
+		minX = (std::min)(minX, x); maxX = (std::max)(maxX, x);
+		minY = (std::min)(minY, y); maxY = (std::max)(maxY, y);
+		minZ = (std::min)(minZ, z);
+	}
+
+	int x0 = (std::max)(0, (int)floor((minX * 0.5f + 0.5f) * WIDTH));
+	int x1 = (std::min)(WIDTH - 1, (int)floor((maxX * 0.5f + 0.5f) * WIDTH));
+	int y0 = (std::max)(0, (int)floor((minY * 0.5f + 0.5f) * HEIGHT));
+	int y1 = (std::min)(HEIGHT - 1, (int)floor((maxY * 0.5f + 0.5f) * HEIGHT));
+	if(x0 > x1 || y0 > y1) return true;
+
+	const int tilesX = WIDTH / TILE_SIZE;
+
+	for(int ty=y0/TILE_SIZE; ty<=y1/TILE_SIZE; ty++)
+	{
+		for(int tx=x0/TILE_SIZE; tx<=x1/TILE_SIZE; tx++)
+		{
+			//everything in the tile is nearer than the box
+			if(m_HiZ[ty*tilesX + tx] < minZ) continue;
+
+			//refine with the pixels of the tile covered by the box
+			int px0 = (std::max)(x0, tx*TILE_SIZE), px1 = (std::min)(x1, tx*TILE_SIZE + TILE_SIZE - 1);
+			int py0 = (std::max)(y0, ty*TILE_SIZE), py1 = (std::min)(y1, ty*TILE_SIZE + TILE_SIZE - 1);
+
+			for(int y=py0; y<=py1; y++)
+			{
+				for(int x=px0; x<=px1; x++)
+				{
+					if(m_Depth[y*WIDTH + x] >= minZ) return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of occluders rasterized this frame
+///----------------------------------------------------------------------------
+UINT SoftwareOcclusion::GetOccluderCount() const
+{
+	return m_Occluders;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of objects culled this frame
+///----------------------------------------------------------------------------
+UINT SoftwareOcclusion::GetCulledCount() const
+{
+	return m_Culled;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of rasterizer threads
+///----------------------------------------------------------------------------
+UINT SoftwareOcclusion::GetWorkerCount() const
+{
+	return m_WorkerCount;
+}
@@ -0,0 +1,91 @@
+///============================================================================
+///@file	SoftwareOcclusion.h
+///@brief	CPU occlusion culling. The biggest occluders in view are
+///			rasterized with SSE into a small depth buffer by worker threads
+///			(each thread owns a band of rows) while the render thread keeps
+///			submitting the shadow pass. A hierarchical Z buffer built from it
+///			is then used to test the bounds of every object in the camera
+///			frustum before they are submitted.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef SOFTWAREOCCLUSION_H
+#define SOFTWAREOCCLUSION_H
+
+#include <vector>
+#include "Geometry.h"
+#include "Profiler.h"
+
+class SoftwareOcclusion
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	SoftwareOcclusion();
+	virtual ~SoftwareOcclusion();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Init(Profiler *profiler);
+	void Shutdown();
+	void Begin(const Geometry &geometry, const std::vector<UINT> &candidates,
+			   const GLdouble projection[16], const GLdouble view[16],
+			   const GLfloat cameraPos[3]);
+	void Wait();
+	void Cull(const Geometry &geometry, std::vector<UINT> &objects);
+	UINT GetOccluderCount() const;
+	UINT GetCulledCount() const;
+	UINT GetWorkerCount() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const int WIDTH = 256;			///> Depth buffer width (multiple of TILE_SIZE)
+	static const int HEIGHT = 192;			///> Depth buffer height (multiple of TILE_SIZE)
+	static const int TILE_SIZE = 8;			///> Pixels per side of a hierarchical Z tile
+	static const UINT MAX_OCCLUDERS = 32;	///> Occluders rasterized per frame
+	static const UINT MAX_WORKERS = 4;		///> Rasterizer threads
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	struct Worker
+	{
+		SoftwareOcclusion	*owner;		///> The culler this thread works for
+		HANDLE				thread;		///> Thread handle
+		HANDLE				start;		///> Signaled when there is a frame to raster
+		HANDLE				done;		///> Signaled when the band is finished
+		int					firstRow;	///> First row of the band
+		int					lastRow;	///> One past the last row of the band
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	static DWORD WINAPI WorkerProc(LPVOID param);
+	void RasterizeBand(int firstRow, int lastRow);
+	void RasterizeTriangle(const GLfloat v[3][3], int firstRow, int lastRow);
+	void BuildHiZ(int firstRow, int lastRow);
+	bool IsVisible(const AABB &box) const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	GLfloat				*m_Depth;		///> WIDTH x HEIGHT depth (0=near, 1=far)
+	GLfloat				*m_HiZ;			///> Farthest depth of every tile
+	Matrix4				m_ViewProj;		///> Camera projection * view
+	std::vector<GLfloat> m_ClipVerts;	///> Occluder box corners in clip space
+	Worker				m_Workers[MAX_WORKERS];	///> Rasterizer threads
+	UINT				m_WorkerCount;	///> Number of running threads
+	volatile LONG		m_Quit;			///> Tells the threads to exit
+	bool				m_Busy;			///> Workers are rasterizing a frame
+	UINT				m_Occluders;	///> Occluders rasterized this frame
+	UINT				m_Culled;		///> Objects culled this frame
+	Profiler			*m_Profiler;	///> Receives the rasterization times
+};
+
+#endif
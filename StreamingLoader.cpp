@@ -0,0 +1,347 @@
+///============================================================================
+///@file	StreamingLoader.cpp
+///@brief	Loads meshes in the background.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "StreamingLoader.h"
+#include "Geometry.h"
+#include "Profiler.h"
+#include <string.h>
+#include <limits.h>
+#include <malloc.h>
+#include <algorithm>
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+StreamingLoader::StreamingLoader() : m_WorkerCount(0), m_Semaphore(NULL), m_Quit(0),
+	m_Pending(0), m_NextId(0), m_Failed(0), m_Uploaded(0), m_Geometry(NULL)
+{
+	InitializeSListHead(&m_Requests);
+	InitializeSListHead(&m_Done);
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+StreamingLoader::~StreamingLoader()
+{
+}
+
+///----------------------------------------------------------------------------
+///Starts the worker threads
+///@param	geometry - prepares the meshes in its vertex format
+///@returns false if no thread could be created
+///----------------------------------------------------------------------------
+bool StreamingLoader::Start(const Geometry *geometry)
+{
+	m_Geometry = geometry;
+	m_Quit = 0;
+
+	m_Semaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	if(!m_Semaphore) return false;
+
+	//leave one core for the render thread
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	UINT count = info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors - 1 : 1;
+	if(count > MAX_WORKERS) count = MAX_WORKERS;
+
+	for(UINT i=0; i<count; i++)
+	{
+		m_Workers[m_WorkerCount] = CreateThread(NULL, 0, WorkerProc, this, 0, NULL);
+		if(!m_Workers[m_WorkerCount]) break;
+
+		//loading must not slow down the frames
+		SetThreadPriority(m_Workers[m_WorkerCount], THREAD_PRIORITY_BELOW_NORMAL);
+		m_WorkerCount++;
+	}
+
+	return m_WorkerCount > 0;
+}
+
+///----------------------------------------------------------------------------
+///Stops the worker threads and deletes the meshes nobody took (the
+///rendering context must still be current)
+///----------------------------------------------------------------------------
+void StreamingLoader::Stop()
+{
+	InterlockedExchange(&m_Quit, 1);
+	if(m_WorkerCount) ReleaseSemaphore(m_Semaphore, m_WorkerCount, NULL);
+
+	if(m_WorkerCount) WaitForMultipleObjects(m_WorkerCount, m_Workers, TRUE, INFINITE);
+	for(UINT i=0; i<m_WorkerCount; i++)
+		CloseHandle(m_Workers[i]);
+	m_WorkerCount = 0;
+
+	if(m_Semaphore) CloseHandle(m_Semaphore);
+	m_Semaphore = NULL;
+
+	PSLIST_ENTRY entry = InterlockedFlushSList(&m_Requests);
+	while(entry)
+	{
+		PSLIST_ENTRY next = entry->Next;
+		FreeRequest((Request *)entry);
+		entry = next;
+	}
+
+	entry = InterlockedFlushSList(&m_Done);
+	while(entry)
+	{
+		PSLIST_ENTRY next = entry->Next;
+		FreeRequest((Request *)entry);
+		entry = next;
+	}
+
+	for(UINT i=0; i<m_Uploads.size(); i++)
+		FreeRequest(m_Uploads[i]);
+	for(UINT i=0; i<m_Loaded.size(); i++)
+		FreeRequest(m_Loaded[i]);
+
+	m_Uploads.clear();
+	m_Loaded.clear();
+	m_Pending = 0;
+
+	m_Staging.Release();
+}
+
+///----------------------------------------------------------------------------
+///Creates the persistently mapped ring the uploads are staged in, one
+///budget per frame in flight (the rendering context must be current)
+///@param	byteBudget - bytes Update uploads per frame
+///@param	frames - frames in flight, FramePacer must make sure the GPU is
+///			done with a frame before Update is called with it again
+///@returns false if the ring isn't supported (glBufferSubData is used)
+///----------------------------------------------------------------------------
+bool StreamingLoader::CreateStaging(UINT byteBudget, UINT frames)
+{
+	return m_Staging.Create(byteBudget, frames);
+}
+
+///----------------------------------------------------------------------------
+///Queues a model to load (OBJ or PLY)
+///@param	path - file name
+///@returns the id given back with the loaded mesh
+///----------------------------------------------------------------------------
+UINT StreamingLoader::Load(LPCSTR path)
+{
+	Request *request = (Request *)_aligned_malloc(sizeof(Request), MEMORY_ALLOCATION_ALIGNMENT);
+	if(!request) return 0;
+
+	memset(request, 0, sizeof(Request));
+	strncpy(request->path, path, MAX_PATH - 1);
+	request->id = ++m_NextId;
+	request->start = Profiler::GetTime();
+
+	InterlockedIncrement(&m_Pending);
+
+	//without threads the request is decoded right away
+	if(!m_WorkerCount)
+	{
+		Decode(request);
+		InterlockedPushEntrySList(&m_Done, &request->entry);
+		return request->id;
+	}
+
+	InterlockedPushEntrySList(&m_Requests, &request->entry);
+	ReleaseSemaphore(m_Semaphore, 1, NULL);
+
+	return request->id;
+}
+
+///----------------------------------------------------------------------------
+///Worker thread main loop, decodes one request every time the semaphore
+///is released
+///----------------------------------------------------------------------------
+DWORD WINAPI StreamingLoader::WorkerProc(LPVOID param)
+{
+	StreamingLoader *loader = (StreamingLoader *)param;
+
+	while(true)
+	{
+		WaitForSingleObject(loader->m_Semaphore, INFINITE);
+		if(loader->m_Quit) break;
+
+		Request *request = (Request *)InterlockedPopEntrySList(&loader->m_Requests);
+		if(!request) continue;
+
+		loader->Decode(request);
+		InterlockedPushEntrySList(&loader->m_Done, &request->entry);
+	}
+
+	return 0;
+}
+
+///----------------------------------------------------------------------------
+///Reads and parses the file and builds the streams (no GL calls)
+///@param	request - the request, mesh is left NULL if it fails
+///----------------------------------------------------------------------------
+void StreamingLoader::Decode(Request *request) const
+{
+	double start = Profiler::GetTime();
+	MeshImporter importer;
+	Mesh *mesh = new Mesh();
+
+	if(importer.Import(request->path, *mesh) && mesh->GetTriangleCount())
+	{
+		m_Geometry->PrepareMesh(*mesh);
+		request->mesh = mesh;
+	}
+	else
+	{
+		delete mesh;
+	}
+
+	request->import = importer.GetStats();
+	request->decodeMs = Profiler::GetTime() - start;
+}
+
+///----------------------------------------------------------------------------
+///Uploads the decoded meshes, in the order they were decoded, until the
+///budget is spent. Call once per frame from the render thread.
+///@param	byteBudget - most bytes copied to buffer objects this frame
+///@param	frame - the frame in flight (FramePacer::GetFrame), selects the
+///			segment of the staging ring
+///----------------------------------------------------------------------------
+void StreamingLoader::Update(UINT byteBudget, UINT frame)
+{
+	m_Staging.BeginFrame(frame);
+	Upload(byteBudget, m_Staging.IsValid() ? &m_Staging : NULL);
+}
+
+///----------------------------------------------------------------------------
+///Copies the decoded meshes to their buffer objects until the budget is
+///spent
+///@param	byteBudget - most bytes to copy
+///@param	ring - staging memory of this frame (NULL to copy from the streams)
+///----------------------------------------------------------------------------
+void StreamingLoader::Upload(UINT byteBudget, UploadRing *ring)
+{
+	m_Uploaded = 0;
+
+	//the list returns the last decoded first
+	UINT first = (UINT)m_Uploads.size();
+	for(PSLIST_ENTRY entry = InterlockedFlushSList(&m_Done); entry; entry = entry->Next)
+		m_Uploads.push_back((Request *)entry);
+	std::reverse(m_Uploads.begin() + first, m_Uploads.end());
+
+	UINT done = 0;
+	for(; done<m_Uploads.size(); done++)
+	{
+		Request *request = m_Uploads[done];
+
+		if(!request->mesh)
+		{
+			FreeRequest(request);
+			InterlockedDecrement(&m_Pending);
+			m_Failed++;
+			continue;
+		}
+
+		if(m_Uploaded >= byteBudget) break;
+
+		if(!request->staging)
+		{
+			request->mesh->BeginStaging();
+			request->staging = true;
+		}
+
+		m_Uploaded += request->mesh->Stage(byteBudget - m_Uploaded, ring);
+		request->frames++;
+
+		if(!request->mesh->IsStaged()) break;
+		m_Loaded.push_back(request);
+	}
+
+	m_Uploads.erase(m_Uploads.begin(), m_Uploads.begin() + done);
+}
+
+///----------------------------------------------------------------------------
+///Waits until every queued mesh is loaded, uploading without a budget
+///(i.e. before a benchmark, so every run draws the same scene). No frame
+///ends in between, so the staging ring isn't used.
+///----------------------------------------------------------------------------
+void StreamingLoader::Flush()
+{
+	while(GetPendingCount() > m_Loaded.size())
+	{
+		Upload(UINT_MAX, NULL);
+		if(GetPendingCount() > m_Loaded.size()) Sleep(1);
+	}
+}
+
+///----------------------------------------------------------------------------
+///Gets the next mesh that is completely uploaded
+///@param	loaded - returned mesh and statistics
+///@returns false if there are none
+///----------------------------------------------------------------------------
+bool StreamingLoader::PopLoaded(Loaded &loaded)
+{
+	if(m_Loaded.empty()) return false;
+
+	Request *request = m_Loaded.front();
+	m_Loaded.erase(m_Loaded.begin());
+
+	loaded.mesh			= request->mesh;
+	loaded.id			= request->id;
+	loaded.import		= request->import;
+	loaded.decodeMs		= request->decodeMs;
+	loaded.latencyMs	= Profiler::GetTime() - request->start;
+	loaded.frames		= request->frames;
+
+	request->mesh = NULL;
+	FreeRequest(request);
+	InterlockedDecrement(&m_Pending);
+
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes a request and its mesh
+///----------------------------------------------------------------------------
+void StreamingLoader::FreeRequest(Request *request)
+{
+	if(request->mesh)
+	{
+		request->mesh->Release();
+		delete request->mesh;
+	}
+
+	_aligned_free(request);
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of requests not popped yet (including failed ones
+///that Update hasn't seen)
+///----------------------------------------------------------------------------
+UINT StreamingLoader::GetPendingCount() const
+{
+	return (UINT)m_Pending;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of models that couldn't be loaded
+///----------------------------------------------------------------------------
+UINT StreamingLoader::GetFailedCount() const
+{
+	return m_Failed;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes copied to buffer objects by the last Update
+///----------------------------------------------------------------------------
+UINT StreamingLoader::GetUploadedBytes() const
+{
+	return m_Uploaded;
+}
+
+///----------------------------------------------------------------------------
+///@returns the number of loading threads
+///----------------------------------------------------------------------------
+UINT StreamingLoader::GetWorkerCount() const
+{
+	return m_WorkerCount;
+}
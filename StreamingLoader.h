@@ -0,0 +1,114 @@
+///============================================================================
+///@file	StreamingLoader.h
+///@brief	Loads meshes in the background. Reading, parsing and preparing
+///			the streams run on a pool of worker threads; the finished meshes
+///			are handed to the render thread through a lock-free list and
+///			copied to buffer objects a few kilobytes per frame, so a big
+///			model never stalls a frame. The copies go through a persistently
+///			mapped ring when the context supports it.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef STREAMINGLOADER_H
+#define STREAMINGLOADER_H
+
+#include <windows.h>
+#include <vector>
+#include "Mesh.h"
+#include "MeshImporter.h"
+#include "UploadRing.h"
+
+class Geometry;
+
+class StreamingLoader
+{
+public:
+	//-------------------------------------------------------------------------
+	//Public types
+	//-------------------------------------------------------------------------
+	///A mesh ready to be drawn
+	struct Loaded
+	{
+		Mesh*				mesh;		///> The mesh, owned by the caller now
+		UINT				id;			///> Value returned by Load
+		MeshImporter::Stats	import;		///> Parsing statistics
+		double				decodeMs;	///> Time spent on the worker thread
+		double				latencyMs;	///> Time from Load to ready
+		UINT				frames;		///> Frames spent uploading it
+	};
+
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	StreamingLoader();
+	virtual ~StreamingLoader();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Start(const Geometry *geometry);
+	void Stop();
+	bool CreateStaging(UINT byteBudget, UINT frames);
+	UINT Load(LPCSTR path);
+	void Update(UINT byteBudget, UINT frame);
+	void Flush();
+	bool PopLoaded(Loaded &loaded);
+	UINT GetPendingCount() const;
+	UINT GetFailedCount() const;
+	UINT GetUploadedBytes() const;
+	UINT GetWorkerCount() const;
+
+	//-------------------------------------------------------------------------
+	//Public members
+	//-------------------------------------------------------------------------
+	static const UINT MAX_WORKERS = 4;				///> Loading threads
+	static const UINT DEFAULT_BUDGET = 256 * 1024;	///> Upload bytes per frame
+
+private:
+	//-------------------------------------------------------------------------
+	//Private types
+	//-------------------------------------------------------------------------
+	///The SLIST_ENTRY must come first and the request must be allocated
+	///with MEMORY_ALLOCATION_ALIGNMENT
+	struct Request
+	{
+		SLIST_ENTRY			entry;		///> Link in the request or done list
+		char				path[MAX_PATH];	///> File to load
+		UINT				id;			///> Value returned by Load
+		Mesh*				mesh;		///> Loaded mesh (NULL if it failed)
+		MeshImporter::Stats	import;		///> Parsing statistics
+		double				start;		///> Time of the Load call
+		double				decodeMs;	///> Time spent on the worker thread
+		UINT				frames;		///> Frames spent uploading
+		bool				staging;	///> BeginStaging was called
+	};
+
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	static DWORD WINAPI WorkerProc(LPVOID param);
+	void Decode(Request *request) const;
+	void Upload(UINT byteBudget, UploadRing *ring);
+	static void FreeRequest(Request *request);
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	SLIST_HEADER		m_Requests;		///> Requests waiting for a worker
+	SLIST_HEADER		m_Done;			///> Decoded requests waiting for upload
+	std::vector<Request*> m_Uploads;	///> Requests being uploaded (render thread)
+	std::vector<Request*> m_Loaded;		///> Uploaded requests (render thread)
+	HANDLE				m_Workers[MAX_WORKERS];	///> Loading threads
+	UINT				m_WorkerCount;	///> Number of running threads
+	HANDLE				m_Semaphore;	///> Counts the queued requests
+	volatile LONG		m_Quit;			///> Tells the threads to exit
+	volatile LONG		m_Pending;		///> Requests not popped yet
+	UINT				m_NextId;		///> Id of the next request
+	UINT				m_Failed;		///> Requests that couldn't be loaded
+	UINT				m_Uploaded;		///> Bytes uploaded by the last Update
+	UploadRing			m_Staging;		///> Staging memory of the uploads (may be invalid)
+	const Geometry*		m_Geometry;		///> Prepares the meshes like its own
+};
+
+#endif
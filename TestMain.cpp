@@ -0,0 +1,145 @@
+///============================================================================
+///@file	TestMain.cpp
+///@brief	Runs the checks of every module (built by the Tests project).
+///
+///			Tests [data directory]
+///			data directory	where the fixtures are (default: TestData)
+///
+///			The shadow atlas needs a rendering context, a hidden window
+///			is created for it.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include <windows.h>
+#include <stdio.h>
+#include <GL/gl.h>
+#include "Tests.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+///----------------------------------------------------------------------------
+///A suite and its name
+///----------------------------------------------------------------------------
+struct Suite
+{
+	LPCSTR	name;		///> Printed before the results
+	void	(*run)();	///> Runs the checks
+};
+
+static const Suite Suites[] =
+{
+	{"BVH",				TestBVH},
+	{"DrawQueue",		TestDrawQueue},
+	{"ShadowAtlas",		TestShadowAtlas},
+	{"SceneFile",		TestSceneFile},
+	{"MeshImporter",	TestMeshImporter}
+};
+
+static UINT s_Checks = 0;					///> Checks run so far
+static UINT s_Failures = 0;					///> Checks failed so far
+static LPCSTR s_DataDirectory = "TestData";	///> Directory of the fixtures
+static UINT s_Seed = 1;						///> State of RandomFloat
+
+///----------------------------------------------------------------------------
+///Records the result of a check, failures are printed in the format of the
+///compiler messages so the IDE jumps to them
+///@param	passed - result of the check
+///@param	expression - the checked expression
+///@param	file - source file of the check
+///@param	line - line of the check
+///----------------------------------------------------------------------------
+void CheckCondition(bool passed, LPCSTR expression, LPCSTR file, int line)
+{
+	s_Checks++;
+	if(passed) return;
+
+	s_Failures++;
+	printf("%s(%d) : check failed: %s\n", file, line, expression);
+}
+
+///----------------------------------------------------------------------------
+///Gets the path of a fixture (or of a scratch file next to them)
+///@param	name - file name
+///@param	path - returned path
+///----------------------------------------------------------------------------
+void GetTestFile(LPCSTR name, char path[MAX_PATH])
+{
+	_snprintf(path, MAX_PATH, "%s/%s", s_DataDirectory, name);
+	path[MAX_PATH - 1] = '\0';
+}
+
+///----------------------------------------------------------------------------
+///Linear congruential generator, the same sequence on every run and with
+///every runtime library
+///@param	min - smallest value
+///@param	max - largest value
+///@returns a value in [min, max)
+///----------------------------------------------------------------------------
+GLfloat RandomFloat(GLfloat min, GLfloat max)
+{
+	s_Seed = s_Seed * 1664525u + 1013904223u;
+	return min + (max - min) * (GLfloat)(s_Seed >> 8) / 16777216.0f;
+}
+
+///----------------------------------------------------------------------------
+///Creates a hidden window and makes a rendering context current on it
+///@returns false if there is no context
+///----------------------------------------------------------------------------
+static bool CreateContext()
+{
+	WNDCLASS wc;
+	memset(&wc, 0, sizeof(wc));
+	wc.style			= CS_OWNDC;
+	wc.lpfnWndProc		= DefWindowProc;
+	wc.hInstance		= GetModuleHandle(NULL);
+	wc.lpszClassName	= "Tests";
+	RegisterClass(&wc);
+
+	HWND hWnd = CreateWindow("Tests", "Tests", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT,
+							 256, 256, NULL, NULL, wc.hInstance, NULL);
+	if(!hWnd) return false;
+
+	PIXELFORMATDESCRIPTOR pfd;
+	memset(&pfd, 0, sizeof(PIXELFORMATDESCRIPTOR));
+	pfd.nSize		= sizeof(PIXELFORMATDESCRIPTOR);
+	pfd.nVersion	= 1;
+	pfd.dwFlags		= PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+	pfd.iPixelType	= PFD_TYPE_RGBA;
+	pfd.cColorBits	= 32;
+	pfd.cDepthBits	= 24;
+
+	HDC hDC = GetDC(hWnd);
+	int format = ChoosePixelFormat(hDC, &pfd);
+	if(!format || !SetPixelFormat(hDC, format, &pfd)) return false;
+
+	HGLRC hRC = wglCreateContext(hDC);
+	if(!hRC || !wglMakeCurrent(hDC, hRC)) return false;
+
+	InitExtensions();
+	g_GLState.Reset();
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc > 1) s_DataDirectory = argv[1];
+
+	if(!CreateContext())
+	{
+		fprintf(stderr, "Couldn't create a rendering context\n");
+		return 1;
+	}
+
+	for(UINT i=0; i<sizeof(Suites) / sizeof(Suites[0]); i++)
+	{
+		UINT checks = s_Checks, failures = s_Failures;
+		Suites[i].run();
+
+		printf("%-16s %5u checks, %u failed\n", Suites[i].name,
+			   s_Checks - checks, s_Failures - failures);
+	}
+
+	printf("%u of %u checks failed\n", s_Failures, s_Checks);
+	return s_Failures ? 1 : 0;
+}
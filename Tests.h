@@ -0,0 +1,32 @@
+///============================================================================
+///@file	Tests.h
+///@brief	Checks of the Tests project. Every suite exercises one module
+///			against a brute-force or hand-built reference and reports each
+///			failed check with its file and line; the program returns non
+///			zero if any check failed, which fails the build (the project
+///			runs it after linking).
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <windows.h>
+#include <GL/gl.h>
+
+///Records the result of a check, the suite goes on after a failure
+#define CHECK(condition) CheckCondition((condition) != 0, #condition, __FILE__, __LINE__)
+
+void CheckCondition(bool passed, LPCSTR expression, LPCSTR file, int line);
+void GetTestFile(LPCSTR name, char path[MAX_PATH]);
+GLfloat RandomFloat(GLfloat min, GLfloat max);
+
+//suites, one per module
+void TestBVH();
+void TestDrawQueue();
+void TestShadowAtlas();
+void TestSceneFile();
+void TestMeshImporter();
+
+#endif
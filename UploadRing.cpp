@@ -0,0 +1,195 @@
+///============================================================================
+///@file	UploadRing.cpp
+///@brief	Per-frame upload buffer, one segment per frame in flight.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#include "UploadRing.h"
+#include "GLStateCache.h"
+
+//the segments start at a multiple of this, enough for any binding
+static const UINT SegmentAlignment = 256;
+
+///----------------------------------------------------------------------------
+///Default constructor
+///----------------------------------------------------------------------------
+UploadRing::UploadRing() : m_Buffer(0), m_Memory(NULL), m_FrameBytes(0), m_FrameCount(0),
+						   m_Frame(0), m_Used(0), m_Failed(0), m_UniformAlignment(SegmentAlignment),
+						   m_StorageAlignment(SegmentAlignment)
+{
+}
+
+///----------------------------------------------------------------------------
+///Default destructor
+///----------------------------------------------------------------------------
+UploadRing::~UploadRing()
+{
+	Release();
+}
+
+///----------------------------------------------------------------------------
+///@returns true if the context can map a buffer persistently
+///----------------------------------------------------------------------------
+bool UploadRing::IsSupported()
+{
+	return g_GLCaps.persistentMapping;
+}
+
+///----------------------------------------------------------------------------
+///Creates and maps the buffer (the context must be current)
+///@param	frameBytes - bytes a frame can allocate
+///@param	frames - frames in flight (one segment each)
+///@returns false if the ring isn't supported or the buffer can't be mapped
+///----------------------------------------------------------------------------
+bool UploadRing::Create(UINT frameBytes, UINT frames)
+{
+	Release();
+	if(!IsSupported() || frameBytes == 0 || frames == 0) return false;
+
+	m_FrameBytes = (frameBytes + SegmentAlignment - 1) / SegmentAlignment * SegmentAlignment;
+	m_FrameCount = frames;
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_UniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_StorageAlignment);
+	if(m_UniformAlignment < 1) m_UniformAlignment = SegmentAlignment;
+	if(m_StorageAlignment < 1) m_StorageAlignment = SegmentAlignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr size = (GLsizeiptr)m_FrameBytes * m_FrameCount;
+
+	glGenBuffersARB(1, &m_Buffer);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, m_Buffer);
+	glBufferStorage(GL_ARRAY_BUFFER_ARB, size, NULL, flags);
+	m_Memory = (BYTE *)glMapBufferRange(GL_ARRAY_BUFFER_ARB, 0, size, flags);
+	g_GLState.BindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+
+	if(!m_Memory)
+	{
+		Release();
+		return false;
+	}
+
+	m_Frame = 0;
+	m_Used = 0;
+	m_Failed = 0;
+	return true;
+}
+
+///----------------------------------------------------------------------------
+///Deletes the buffer, which also unmaps it (the context must be current)
+///----------------------------------------------------------------------------
+void UploadRing::Release()
+{
+	if(m_Buffer)
+	{
+		g_GLState.DeleteBuffer(m_Buffer);
+		glDeleteBuffersARB(1, &m_Buffer);
+	}
+
+	m_Buffer = 0;
+	m_Memory = NULL;
+	m_FrameBytes = 0;
+	m_FrameCount = 0;
+	m_Used = 0;
+}
+
+///----------------------------------------------------------------------------
+///@returns true if Create succeeded
+///----------------------------------------------------------------------------
+bool UploadRing::IsValid() const
+{
+	return m_Memory != NULL;
+}
+
+///----------------------------------------------------------------------------
+///Starts allocating from the segment of a frame, the GPU must be done with
+///the frame that used it last (FramePacer::BeginFrame waited for it)
+///@param	frame - the frame in flight (FramePacer::GetFrame)
+///----------------------------------------------------------------------------
+void UploadRing::BeginFrame(UINT frame)
+{
+	if(!IsValid()) return;
+
+	m_Frame = frame % m_FrameCount;
+	m_Used = 0;
+	m_Failed = 0;
+}
+
+///----------------------------------------------------------------------------
+///Sub-allocates memory in the current segment
+///@param	target - binding the memory is used with (sets the alignment)
+///@param	bytes - size of the allocation
+///@param	offset - returned offset of the allocation in the buffer
+///@returns where to write the data, NULL if the segment is full (the
+///			caller falls back to its own buffer)
+///----------------------------------------------------------------------------
+void* UploadRing::Allocate(GLenum target, UINT bytes, GLintptr *offset)
+{
+	if(!IsValid() || bytes == 0) return NULL;
+
+	UINT alignment = GetAlignment(target);
+	UINT start = (m_Used + alignment - 1) / alignment * alignment;
+	if(start + bytes > m_FrameBytes)
+	{
+		m_Failed++;
+		return NULL;
+	}
+
+	m_Used = start + bytes;
+	*offset = (GLintptr)m_Frame * m_FrameBytes + start;
+	return m_Memory + *offset;
+}
+
+///----------------------------------------------------------------------------
+///@returns the ring buffer (bind it with the offsets Allocate returns)
+///----------------------------------------------------------------------------
+GLuint UploadRing::GetBuffer() const
+{
+	return m_Buffer;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes a frame can allocate
+///----------------------------------------------------------------------------
+UINT UploadRing::GetFrameBytes() const
+{
+	return m_FrameBytes;
+}
+
+///----------------------------------------------------------------------------
+///@returns the size of the whole buffer
+///----------------------------------------------------------------------------
+UINT UploadRing::GetBufferBytes() const
+{
+	return m_FrameBytes * m_FrameCount;
+}
+
+///----------------------------------------------------------------------------
+///@returns the bytes allocated in the current frame (alignment included)
+///----------------------------------------------------------------------------
+UINT UploadRing::GetUsedBytes() const
+{
+	return m_Used;
+}
+
+///----------------------------------------------------------------------------
+///@returns the allocations of the current frame that didn't fit
+///----------------------------------------------------------------------------
+UINT UploadRing::GetFailedCount() const
+{
+	return m_Failed;
+}
+
+///----------------------------------------------------------------------------
+///@returns the offset alignment required by a binding
+///----------------------------------------------------------------------------
+UINT UploadRing::GetAlignment(GLenum target) const
+{
+	switch(target)
+	{
+		case GL_UNIFORM_BUFFER:			return (UINT)m_UniformAlignment;
+		case GL_SHADER_STORAGE_BUFFER:	return (UINT)m_StorageAlignment;
+		default:						return sizeof(GLuint);
+	}
+}
@@ -0,0 +1,67 @@
+///============================================================================
+///@file	UploadRing.h
+///@brief	Per-frame upload buffer. One buffer is mapped once for the life
+///			of the ring (persistent and coherent mapping) and split in one
+///			segment per frame in flight; every frame writes its data in its
+///			own segment while the GPU still reads the others. FramePacer
+///			makes sure the GPU is done with a frame before its segment is
+///			written again, so the driver never has to copy or rename the
+///			buffer (no orphaning). Allocations are aligned for the binding
+///			they are used with.
+///
+///@date	October 18, 2026
+///============================================================================
+
+#ifndef UPLOADRING_H
+#define UPLOADRING_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include "GLExtensions.h"
+
+class UploadRing
+{
+public:
+	//-------------------------------------------------------------------------
+	//Constructors and destructors
+	//-------------------------------------------------------------------------
+	UploadRing();
+	virtual ~UploadRing();
+
+	//-------------------------------------------------------------------------
+	//Public methods
+	//-------------------------------------------------------------------------
+	bool Create(UINT frameBytes, UINT frames);
+	void Release();
+	bool IsValid() const;
+	void BeginFrame(UINT frame);
+	void* Allocate(GLenum target, UINT bytes, GLintptr *offset);
+	GLuint GetBuffer() const;
+	UINT GetFrameBytes() const;
+	UINT GetBufferBytes() const;
+	UINT GetUsedBytes() const;
+	UINT GetFailedCount() const;
+
+	static bool IsSupported();
+
+private:
+	//-------------------------------------------------------------------------
+	//Private methods
+	//-------------------------------------------------------------------------
+	UINT GetAlignment(GLenum target) const;
+
+	//-------------------------------------------------------------------------
+	//Private members
+	//-------------------------------------------------------------------------
+	GLuint	m_Buffer;					///> The ring buffer
+	BYTE*	m_Memory;					///> Persistent mapping of the whole buffer
+	UINT	m_FrameBytes;				///> Size of a segment
+	UINT	m_FrameCount;				///> Segments (frames in flight)
+	UINT	m_Frame;					///> Segment of the current frame
+	UINT	m_Used;						///> Bytes allocated in the current segment
+	UINT	m_Failed;					///> Allocations that didn't fit this frame
+	GLint	m_UniformAlignment;			///> Offset alignment of uniform buffers
+	GLint	m_StorageAlignment;			///> Offset alignment of storage buffers
+};
+
+#endif